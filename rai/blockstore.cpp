@@ -88,16 +88,83 @@ rai::store_entry & rai::store_iterator::operator-> ()
 	return current;
 }
 
-rai::store_iterator::store_iterator (MDB_txn * transaction_a, MDB_dbi db_a) :
-cursor (nullptr)
+rai::bulk_load::bulk_load (rai::store_backend & backend_a, MDB_txn * transaction_a, size_t batch_entries_a) :
+backend (backend_a),
+transaction (transaction_a),
+batch_entries (batch_entries_a),
+buffered (0),
+appended (0),
+inserted (0)
 {
-	auto status (mdb_cursor_open (transaction_a, db_a, &cursor));
-	assert (status == 0);
-	auto status2 (mdb_cursor_get (cursor, &current.first.value, &current.second.value, MDB_FIRST));
+}
+
+rai::bulk_load::~bulk_load ()
+{
+	flush ();
+}
+
+void rai::bulk_load::put (MDB_dbi table_a, MDB_val const & key_a, MDB_val const & value_a)
+{
+	auto key (static_cast<uint8_t const *> (key_a.mv_data));
+	auto value (static_cast<uint8_t const *> (value_a.mv_data));
+	tables[table_a].push_back (std::make_pair (std::vector<uint8_t> (key, key + key_a.mv_size), std::vector<uint8_t> (value, value + value_a.mv_size)));
+	if (++buffered >= batch_entries)
+	{
+		flush ();
+	}
+}
+
+void rai::bulk_load::flush ()
+{
+	for (auto & table : tables)
+	{
+		auto & entries (table.second);
+		unsigned flags (0);
+		auto status (backend.flags (transaction, table.first, &flags));
+		assert (status == 0);
+		auto dupsort ((flags & MDB_DUPSORT) != 0);
+		// Byte wise ordering matches LMDB's default comparison, stable so the last put of a key wins
+		std::stable_sort (entries.begin (), entries.end (), [dupsort](std::pair<std::vector<uint8_t>, std::vector<uint8_t>> const & lhs_a, std::pair<std::vector<uint8_t>, std::vector<uint8_t>> const & rhs_a) {
+			return lhs_a.first < rhs_a.first || (dupsort && lhs_a.first == rhs_a.first && lhs_a.second < rhs_a.second);
+		});
+		auto cursor (backend.cursor (transaction, table.first));
+		rai::mdb_val last_key;
+		rai::mdb_val last_value;
+		auto append (cursor->get (last_key, last_value, MDB_LAST) == MDB_NOTFOUND);
+		std::vector<uint8_t> last (static_cast<uint8_t const *> (last_key.data ()), static_cast<uint8_t const *> (last_key.data ()) + last_key.size ());
+		for (auto i (entries.begin ()), n (entries.end ()); i != n; ++i)
+		{
+			auto next (i + 1);
+			if (next != n && next->first == i->first && (!dupsort || next->second == i->second))
+			{
+				// Superseded by a later put of the same key
+				continue;
+			}
+			append = append || last < i->first;
+			auto status2 (cursor->put (rai::mdb_val (i->first.size (), i->first.data ()), rai::mdb_val (i->second.size (), i->second.data ()), append ? (dupsort ? MDB_APPENDDUP : MDB_APPEND) : 0));
+			assert (status2 == 0 || (dupsort && status2 == MDB_KEYEXIST));
+			if (append)
+			{
+				++appended;
+			}
+			else
+			{
+				++inserted;
+			}
+		}
+		entries.clear ();
+	}
+	buffered = 0;
+}
+
+rai::store_iterator::store_iterator (rai::store_backend & backend_a, MDB_txn * transaction_a, MDB_dbi db_a) :
+cursor (backend_a.cursor (transaction_a, db_a))
+{
+	auto status2 (cursor->get (&current.first.value, &current.second.value, MDB_FIRST));
 	assert (status2 == 0 || status2 == MDB_NOTFOUND);
 	if (status2 != MDB_NOTFOUND)
 	{
-		auto status3 (mdb_cursor_get (cursor, &current.first.value, &current.second.value, MDB_GET_CURRENT));
+		auto status3 (cursor->get (&current.first.value, &current.second.value, MDB_GET_CURRENT));
 		assert (status3 == 0 || status3 == MDB_NOTFOUND);
 	}
 	else
@@ -106,22 +173,19 @@ cursor (nullptr)
 	}
 }
 
-rai::store_iterator::store_iterator (std::nullptr_t) :
-cursor (nullptr)
+rai::store_iterator::store_iterator (std::nullptr_t)
 {
 }
 
-rai::store_iterator::store_iterator (MDB_txn * transaction_a, MDB_dbi db_a, MDB_val const & val_a) :
-cursor (nullptr)
+rai::store_iterator::store_iterator (rai::store_backend & backend_a, MDB_txn * transaction_a, MDB_dbi db_a, MDB_val const & val_a) :
+cursor (backend_a.cursor (transaction_a, db_a))
 {
-	auto status (mdb_cursor_open (transaction_a, db_a, &cursor));
-	assert (status == 0);
 	current.first.value = val_a;
-	auto status2 (mdb_cursor_get (cursor, &current.first.value, &current.second.value, MDB_SET_RANGE));
+	auto status2 (cursor->get (&current.first.value, &current.second.value, MDB_SET_RANGE));
 	assert (status2 == 0 || status2 == MDB_NOTFOUND);
 	if (status2 != MDB_NOTFOUND)
 	{
-		auto status3 (mdb_cursor_get (cursor, &current.first.value, &current.second.value, MDB_GET_CURRENT));
+		auto status3 (cursor->get (&current.first.value, &current.second.value, MDB_GET_CURRENT));
 		assert (status3 == 0 || status3 == MDB_NOTFOUND);
 	}
 	else
@@ -132,23 +196,14 @@ cursor (nullptr)
 
 rai::store_iterator::store_iterator (rai::store_iterator && other_a)
 {
-	cursor = other_a.cursor;
-	other_a.cursor = nullptr;
+	cursor = std::move (other_a.cursor);
 	current = other_a.current;
 }
 
-rai::store_iterator::~store_iterator ()
-{
-	if (cursor != nullptr)
-	{
-		mdb_cursor_close (cursor);
-	}
-}
-
 rai::store_iterator & rai::store_iterator::operator++ ()
 {
 	assert (cursor != nullptr);
-	auto status (mdb_cursor_get (cursor, &current.first.value, &current.second.value, MDB_NEXT));
+	auto status (cursor->get (&current.first.value, &current.second.value, MDB_NEXT));
 	if (status == MDB_NOTFOUND)
 	{
 		current.clear ();
@@ -159,7 +214,7 @@ rai::store_iterator & rai::store_iterator::operator++ ()
 void rai::store_iterator::next_dup ()
 {
 	assert (cursor != nullptr);
-	auto status (mdb_cursor_get (cursor, &current.first.value, &current.second.value, MDB_NEXT_DUP));
+	auto status (cursor->get (&current.first.value, &current.second.value, MDB_NEXT_DUP));
 	if (status == MDB_NOTFOUND)
 	{
 		current.clear ();
@@ -168,12 +223,7 @@ void rai::store_iterator::next_dup ()
 
 rai::store_iterator & rai::store_iterator::operator= (rai::store_iterator && other_a)
 {
-	if (cursor != nullptr)
-	{
-		mdb_cursor_close (cursor);
-	}
-	cursor = other_a.cursor;
-	other_a.cursor = nullptr;
+	cursor = std::move (other_a.cursor);
 	current = other_a.current;
 	other_a.current.clear ();
 	return *this;
@@ -195,13 +245,13 @@ bool rai::store_iterator::operator!= (rai::store_iterator const & other_a) const
 
 rai::store_iterator rai::block_store::block_info_begin (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	rai::store_iterator result (transaction_a, blocks_info, rai::mdb_val (hash_a));
+	rai::store_iterator result (backend, transaction_a, blocks_info, rai::mdb_val (hash_a));
 	return result;
 }
 
 rai::store_iterator rai::block_store::block_info_begin (MDB_txn * transaction_a)
 {
-	rai::store_iterator result (transaction_a, blocks_info);
+	rai::store_iterator result (backend, transaction_a, blocks_info);
 	return result;
 }
 
@@ -213,7 +263,7 @@ rai::store_iterator rai::block_store::block_info_end ()
 
 rai::store_iterator rai::block_store::representation_begin (MDB_txn * transaction_a)
 {
-	rai::store_iterator result (transaction_a, representation);
+	rai::store_iterator result (backend, transaction_a, representation);
 	return result;
 }
 
@@ -225,13 +275,13 @@ rai::store_iterator rai::block_store::representation_end ()
 
 rai::store_iterator rai::block_store::unchecked_begin (MDB_txn * transaction_a)
 {
-	rai::store_iterator result (transaction_a, unchecked);
+	rai::store_iterator result (backend, transaction_a, unchecked);
 	return result;
 }
 
 rai::store_iterator rai::block_store::unchecked_begin (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	rai::store_iterator result (transaction_a, unchecked, rai::mdb_val (hash_a));
+	rai::store_iterator result (backend, transaction_a, unchecked, rai::mdb_val (hash_a));
 	return result;
 }
 
@@ -243,7 +293,7 @@ rai::store_iterator rai::block_store::unchecked_end ()
 
 rai::store_iterator rai::block_store::vote_begin (MDB_txn * transaction_a)
 {
-	return rai::store_iterator (transaction_a, vote);
+	return rai::store_iterator (backend, transaction_a, vote);
 }
 
 rai::store_iterator rai::block_store::vote_end ()
@@ -251,8 +301,9 @@ rai::store_iterator rai::block_store::vote_end ()
 	return rai::store_iterator (nullptr);
 }
 
-rai::block_store::block_store (bool & error_a, boost::filesystem::path const & path_a, int lmdb_max_dbs) :
-environment (error_a, path_a, lmdb_max_dbs),
+rai::block_store::block_store (bool & error_a, boost::filesystem::path const & path_a, int lmdb_max_dbs, rai::lmdb_config const & lmdb_config_a) :
+environment (error_a, path_a, lmdb_max_dbs, lmdb_config_a),
+backend (environment),
 frontiers (0),
 accounts (0),
 send_blocks (0),
@@ -271,38 +322,92 @@ abi (0)
 {
 	if (!error_a)
 	{
-		rai::transaction transaction (environment, nullptr, true);
-		error_a |= mdb_dbi_open (transaction, "frontiers", MDB_CREATE, &frontiers) != 0;
-		error_a |= mdb_dbi_open (transaction, "accounts", MDB_CREATE, &accounts) != 0;
-		error_a |= mdb_dbi_open (transaction, "send", MDB_CREATE, &send_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "receive", MDB_CREATE, &receive_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "open", MDB_CREATE, &open_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "change", MDB_CREATE, &change_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "state", MDB_CREATE, &state_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "pending", MDB_CREATE, &pending) != 0;
-		error_a |= mdb_dbi_open (transaction, "blocks_info", MDB_CREATE, &blocks_info) != 0;
-		error_a |= mdb_dbi_open (transaction, "representation", MDB_CREATE, &representation) != 0;
-		error_a |= mdb_dbi_open (transaction, "unchecked", MDB_CREATE | MDB_DUPSORT, &unchecked) != 0;
-		error_a |= mdb_dbi_open (transaction, "checksum", MDB_CREATE, &checksum) != 0;
-		error_a |= mdb_dbi_open (transaction, "vote", MDB_CREATE, &vote) != 0;
-		error_a |= mdb_dbi_open (transaction, "meta", MDB_CREATE, &meta) != 0;
-		error_a |= mdb_dbi_open (transaction, "token_accounts", MDB_CREATE, &token_accounts) != 0;
-		error_a |= mdb_dbi_open (transaction, "assets", MDB_CREATE, &assets) != 0;
-		error_a |= mdb_dbi_open (transaction, "smart_contract", MDB_CREATE, &smart_contract) != 0;
-		error_a |= mdb_dbi_open (transaction, "abi", MDB_CREATE, &abi) != 0;
-		if (!error_a)
-		{
-			do_upgrades (transaction);
-			checksum_put (transaction, 0, 0, 0);
-		}
+		initialize (error_a);
+	}
+}
+
+rai::block_store::block_store (bool & error_a, std::unique_ptr<rai::store_backend> backend_a) :
+alternate (std::move (backend_a)),
+backend (*alternate),
+frontiers (0),
+accounts (0),
+send_blocks (0),
+receive_blocks (0),
+open_blocks (0),
+change_blocks (0),
+pending (0),
+blocks_info (0),
+representation (0),
+unchecked (0),
+checksum (0),
+token_accounts (0),
+smart_contract (0),
+assets (0),
+abi (0)
+{
+	initialize (error_a);
+}
+
+void rai::block_store::initialize (bool & error_a)
+{
+	rai::transaction transaction (backend, nullptr, true);
+	error_a |= backend.open (transaction, "frontiers", MDB_CREATE, &frontiers) != 0;
+	error_a |= backend.open (transaction, "accounts", MDB_CREATE, &accounts) != 0;
+	error_a |= backend.open (transaction, "send", MDB_CREATE, &send_blocks) != 0;
+	error_a |= backend.open (transaction, "receive", MDB_CREATE, &receive_blocks) != 0;
+	error_a |= backend.open (transaction, "open", MDB_CREATE, &open_blocks) != 0;
+	error_a |= backend.open (transaction, "change", MDB_CREATE, &change_blocks) != 0;
+	error_a |= backend.open (transaction, "state", MDB_CREATE, &state_blocks) != 0;
+	error_a |= backend.open (transaction, "pending", MDB_CREATE, &pending) != 0;
+	error_a |= backend.open (transaction, "blocks_info", MDB_CREATE, &blocks_info) != 0;
+	error_a |= backend.open (transaction, "representation", MDB_CREATE, &representation) != 0;
+	error_a |= backend.open (transaction, "unchecked", MDB_CREATE | MDB_DUPSORT, &unchecked) != 0;
+	error_a |= backend.open (transaction, "checksum", MDB_CREATE, &checksum) != 0;
+	error_a |= backend.open (transaction, "vote", MDB_CREATE, &vote) != 0;
+	error_a |= backend.open (transaction, "meta", MDB_CREATE, &meta) != 0;
+	error_a |= backend.open (transaction, "token_accounts", MDB_CREATE, &token_accounts) != 0;
+	error_a |= backend.open (transaction, "assets", MDB_CREATE, &assets) != 0;
+	error_a |= backend.open (transaction, "smart_contract", MDB_CREATE, &smart_contract) != 0;
+	error_a |= backend.open (transaction, "abi", MDB_CREATE, &abi) != 0;
+	error_a |= backend.open (transaction, "delegators", MDB_CREATE, &delegators) != 0;
+	error_a |= backend.open (transaction, "history", MDB_CREATE, &history) != 0;
+	error_a |= backend.open (transaction, "heights", MDB_CREATE, &heights) != 0;
+	error_a |= backend.open (transaction, "confirmed", MDB_CREATE, &confirmed) != 0;
+	error_a |= backend.open (transaction, "pruned", MDB_CREATE, &pruned) != 0;
+	if (!error_a)
+	{
+		do_upgrades (transaction);
+		checksum_put (transaction, 0, 0, 0);
 	}
 }
 
+void rai::block_store::checkpoint_put (MDB_txn * transaction_a, rai::checkpoint checkpoint_a, std::vector<uint8_t> const & value_a)
+{
+	rai::uint256_union key (static_cast<uint8_t> (checkpoint_a));
+	auto status (backend.put (transaction_a, meta, rai::mdb_val (key), rai::mdb_val (value_a.size (), const_cast<uint8_t *> (value_a.data ())), 0));
+	assert (status == 0);
+}
+
+bool rai::block_store::checkpoint_get (MDB_txn * transaction_a, rai::checkpoint checkpoint_a, std::vector<uint8_t> & value_a)
+{
+	rai::uint256_union key (static_cast<uint8_t> (checkpoint_a));
+	rai::mdb_val data;
+	auto status (backend.get (transaction_a, meta, rai::mdb_val (key), data));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	auto result (status != 0);
+	if (!result)
+	{
+		auto begin (reinterpret_cast<uint8_t const *> (data.data ()));
+		value_a.assign (begin, begin + data.size ());
+	}
+	return result;
+}
+
 void rai::block_store::version_put (MDB_txn * transaction_a, int version_a)
 {
 	rai::uint256_union version_key (1);
 	rai::uint256_union version_value (version_a);
-	auto status (mdb_put (transaction_a, meta, rai::mdb_val (version_key), rai::mdb_val (version_value), 0));
+	auto status (backend.put (transaction_a, meta, rai::mdb_val (version_key), rai::mdb_val (version_value), 0));
 	assert (status == 0);
 }
 
@@ -310,7 +415,7 @@ int rai::block_store::version_get (MDB_txn * transaction_a)
 {
 	rai::uint256_union version_key (1);
 	rai::mdb_val data;
-	auto error (mdb_get (transaction_a, meta, rai::mdb_val (version_key), data));
+	auto error (backend.get (transaction_a, meta, rai::mdb_val (version_key), data));
 	int result;
 	if (error == MDB_NOTFOUND)
 	{
@@ -350,6 +455,10 @@ void rai::block_store::do_upgrades (MDB_txn * transaction_a)
 		case 10:
 			upgrade_v10_to_v11 (transaction_a);
 		case 11:
+			upgrade_v11_to_v12 (transaction_a);
+		case 12:
+			upgrade_v12_to_v13 (transaction_a);
+		case 13:
 			break;
 		default:
 			assert (false);
@@ -362,7 +471,7 @@ void rai::block_store::upgrade_v1_to_v2 (MDB_txn * transaction_a)
 	rai::account account (1);
 	while (!account.is_zero ())
 	{
-		rai::store_iterator i (transaction_a, accounts, rai::mdb_val (account));
+		rai::store_iterator i (backend, transaction_a, accounts, rai::mdb_val (account));
 		std::cerr << std::hex;
 		if (i != rai::store_iterator (nullptr))
 		{
@@ -379,7 +488,7 @@ void rai::block_store::upgrade_v1_to_v2 (MDB_txn * transaction_a)
 				block = block_get (transaction_a, block->previous ());
 			}
 			v2.open_block = block->hash ();
-			auto status (mdb_put (transaction_a, accounts, rai::mdb_val (account), v2.val (), 0));
+			auto status (backend.put (transaction_a, accounts, rai::mdb_val (account), v2.val (), 0));
 			assert (status == 0);
 			account = account.number () + 1;
 		}
@@ -393,7 +502,7 @@ void rai::block_store::upgrade_v1_to_v2 (MDB_txn * transaction_a)
 void rai::block_store::upgrade_v2_to_v3 (MDB_txn * transaction_a)
 {
 	version_put (transaction_a, 3);
-	mdb_drop (transaction_a, representation, 0);
+	backend.drop (transaction_a, representation, 0);
 	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
 	{
 		rai::account account_l (i->first.uint256 ());
@@ -402,7 +511,7 @@ void rai::block_store::upgrade_v2_to_v3 (MDB_txn * transaction_a)
 		visitor.compute (info.head);
 		assert (!visitor.result.is_zero ());
 		info.rep_block = visitor.result;
-		mdb_cursor_put (i.cursor, rai::mdb_val (account_l), info.val (), MDB_CURRENT);
+		i.cursor->put (rai::mdb_val (account_l), info.val (), MDB_CURRENT);
 		representation_add (transaction_a, visitor.result, info.balance.number ());
 	}
 }
@@ -417,10 +526,11 @@ void rai::block_store::upgrade_v3_to_v4 (MDB_txn * transaction_a)
 		rai::pending_info_v3 info (i->second);
 		items.push (std::make_pair (rai::pending_key (info.destination, hash), rai::pending_info (info.source, info.amount, rai::chain_token_type)));
 	}
-	mdb_drop (transaction_a, pending, 0);
+	backend.drop (transaction_a, pending, 0);
+	rai::bulk_load bulk (backend, transaction_a);
 	while (!items.empty ())
 	{
-		pending_put (transaction_a, items.front ().first, items.front ().second);
+		bulk.put (pending, items.front ().first.val (), items.front ().second.val ());
 		items.pop ();
 	}
 }
@@ -476,25 +586,26 @@ void rai::block_store::upgrade_v5_to_v6 (MDB_txn * transaction_a)
 void rai::block_store::upgrade_v6_to_v7 (MDB_txn * transaction_a)
 {
 	version_put (transaction_a, 7);
-	mdb_drop (transaction_a, unchecked, 0);
+	backend.drop (transaction_a, unchecked, 0);
 }
 
 void rai::block_store::upgrade_v7_to_v8 (MDB_txn * transaction_a)
 {
 	version_put (transaction_a, 8);
-	mdb_drop (transaction_a, unchecked, 1);
-	mdb_dbi_open (transaction_a, "unchecked", MDB_CREATE | MDB_DUPSORT, &unchecked);
+	backend.drop (transaction_a, unchecked, 1);
+	backend.open (transaction_a, "unchecked", MDB_CREATE | MDB_DUPSORT, &unchecked);
 }
 
 void rai::block_store::upgrade_v8_to_v9 (MDB_txn * transaction_a)
 {
 	version_put (transaction_a, 9);
 	MDB_dbi sequence;
-	mdb_dbi_open (transaction_a, "sequence", MDB_CREATE | MDB_DUPSORT, &sequence);
+	backend.open (transaction_a, "sequence", MDB_CREATE | MDB_DUPSORT, &sequence);
 	rai::genesis genesis (rai::rai_live_genesis);
 	std::shared_ptr<rai::block> block (std::move (genesis.state));
 	rai::keypair junk;
-	for (rai::store_iterator i (transaction_a, sequence), n (nullptr); i != n; ++i)
+	rai::bulk_load bulk (backend, transaction_a);
+	for (rai::store_iterator i (backend, transaction_a, sequence), n (nullptr); i != n; ++i)
 	{
 		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
 		uint64_t sequence;
@@ -506,11 +617,11 @@ void rai::block_store::upgrade_v8_to_v9 (MDB_txn * transaction_a)
 			rai::vectorstream stream (vector);
 			dummy->serialize (stream);
 		}
-		auto status1 (mdb_put (transaction_a, vote, i->first, rai::mdb_val (vector.size (), vector.data ()), 0));
-		assert (status1 == 0);
+		bulk.put (vote, i->first, rai::mdb_val (vector.size (), vector.data ()));
 		assert (!error);
 	}
-	mdb_drop (transaction_a, sequence, 1);
+	bulk.flush ();
+	backend.drop (transaction_a, sequence, 1);
 }
 
 void rai::block_store::upgrade_v9_to_v10 (MDB_txn * transaction_a)
@@ -547,14 +658,37 @@ void rai::block_store::upgrade_v9_to_v10 (MDB_txn * transaction_a)
 void rai::block_store::upgrade_v10_to_v11 (MDB_txn * transaction_a)
 {
 	MDB_dbi unsynced;
-	mdb_dbi_open (transaction_a, "unsynced", MDB_CREATE | MDB_DUPSORT, &unsynced);
-	mdb_drop (transaction_a, unsynced, 1);
+	backend.open (transaction_a, "unsynced", MDB_CREATE | MDB_DUPSORT, &unsynced);
+	backend.drop (transaction_a, unsynced, 1);
+	version_put (transaction_a, 11);
+}
+
+void rai::block_store::upgrade_v11_to_v12 (MDB_txn * transaction_a)
+{
+	version_put (transaction_a, 12);
+	backend.drop (transaction_a, delegators, 0);
+	rai::bulk_load bulk (backend, transaction_a);
+	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
+	{
+		rai::account_info info (i->second);
+		auto block (block_get (transaction_a, info.rep_block));
+		if (block != nullptr)
+		{
+			bulk.put (delegators, rai::delegator_key (block->representative (), i->first.uint256 ()).val (), rai::mdb_val (0, nullptr));
+		}
+	}
+}
+
+void rai::block_store::upgrade_v12_to_v13 (MDB_txn * transaction_a)
+{
+	version_put (transaction_a, 13);
+	block_heights_build (transaction_a);
 }
 
 void rai::block_store::clear (MDB_dbi db_a)
 {
-	rai::transaction transaction (environment, nullptr, true);
-	auto status (mdb_drop (transaction, db_a, 0));
+	rai::transaction transaction (backend, nullptr, true);
+	auto status (backend.drop (transaction, db_a, 0));
 	assert (status == 0);
 }
 
@@ -608,7 +742,7 @@ MDB_dbi rai::block_store::block_database (rai::block_type type_a)
 
 void rai::block_store::block_put_raw (MDB_txn * transaction_a, MDB_dbi database_a, rai::block_hash const & hash_a, MDB_val value_a)
 {
-	auto status2 (mdb_put (transaction_a, database_a, rai::mdb_val (hash_a), &value_a, 0));
+	auto status2 (backend.put (transaction_a, database_a, rai::mdb_val (hash_a), &value_a, 0));
 	assert (status2 == 0);
 }
 
@@ -630,27 +764,27 @@ void rai::block_store::block_put (MDB_txn * transaction_a, rai::block_hash const
 MDB_val rai::block_store::block_get_raw (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_type & type_a)
 {
 	rai::mdb_val result;
-	auto status (mdb_get (transaction_a, send_blocks, rai::mdb_val (hash_a), result));
+	auto status (backend.get (transaction_a, send_blocks, rai::mdb_val (hash_a), result));
 	assert (status == 0 || status == MDB_NOTFOUND);
 	if (status != 0)
 	{
-		auto status (mdb_get (transaction_a, receive_blocks, rai::mdb_val (hash_a), result));
+		auto status (backend.get (transaction_a, receive_blocks, rai::mdb_val (hash_a), result));
 		assert (status == 0 || status == MDB_NOTFOUND);
 		if (status != 0)
 		{
-			auto status (mdb_get (transaction_a, open_blocks, rai::mdb_val (hash_a), result));
+			auto status (backend.get (transaction_a, open_blocks, rai::mdb_val (hash_a), result));
 			assert (status == 0 || status == MDB_NOTFOUND);
 			if (status != 0)
 			{
-				auto status (mdb_get (transaction_a, change_blocks, rai::mdb_val (hash_a), result));
+				auto status (backend.get (transaction_a, change_blocks, rai::mdb_val (hash_a), result));
 				assert (status == 0 || status == MDB_NOTFOUND);
 				if (status != 0)
 				{
-					auto status (mdb_get (transaction_a, state_blocks, rai::mdb_val (hash_a), result));
+					auto status (backend.get (transaction_a, state_blocks, rai::mdb_val (hash_a), result));
 					assert (status == 0 || status == MDB_NOTFOUND);
 					if (status != 0)
 					{
-						auto status (mdb_get (transaction_a, smart_contract, rai::mdb_val (hash_a), result));
+						auto status (backend.get (transaction_a, smart_contract, rai::mdb_val (hash_a), result));
 						assert (status == 0 || status == MDB_NOTFOUND);
 						if (status != 0)
 						{
@@ -692,10 +826,10 @@ std::unique_ptr<rai::block> rai::block_store::block_random (MDB_txn * transactio
 {
 	rai::block_hash hash;
 	rai::random_pool.GenerateBlock (hash.bytes.data (), hash.bytes.size ());
-	rai::store_iterator existing (transaction_a, database, rai::mdb_val (hash));
+	rai::store_iterator existing (backend, transaction_a, database, rai::mdb_val (hash));
 	if (existing == rai::store_iterator (nullptr))
 	{
-		existing = rai::store_iterator (transaction_a, database);
+		existing = rai::store_iterator (backend, transaction_a, database);
 	}
 	assert (existing != rai::store_iterator (nullptr));
 	return block_get (transaction_a, rai::block_hash (existing->first.uint256 ()));
@@ -780,25 +914,37 @@ std::unique_ptr<rai::block> rai::block_store::block_get (MDB_txn * transaction_a
 	return result;
 }
 
+rai::block_view rai::block_store::block_view_get (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+{
+	rai::block_type type;
+	auto value (block_get_raw (transaction_a, hash_a, type));
+	rai::block_view result;
+	if (value.mv_size != 0)
+	{
+		result = rai::block_view (hash_a, type, reinterpret_cast<uint8_t const *> (value.mv_data), value.mv_size);
+	}
+	return result;
+}
+
 void rai::block_store::block_del (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	auto status (mdb_del (transaction_a, state_blocks, rai::mdb_val (hash_a), nullptr));
+	auto status (backend.del (transaction_a, state_blocks, rai::mdb_val (hash_a), nullptr));
 	assert (status == 0 || status == MDB_NOTFOUND);
 	if (status != 0)
 	{
-		auto status (mdb_del (transaction_a, send_blocks, rai::mdb_val (hash_a), nullptr));
+		auto status (backend.del (transaction_a, send_blocks, rai::mdb_val (hash_a), nullptr));
 		assert (status == 0 || status == MDB_NOTFOUND);
 		if (status != 0)
 		{
-			auto status (mdb_del (transaction_a, receive_blocks, rai::mdb_val (hash_a), nullptr));
+			auto status (backend.del (transaction_a, receive_blocks, rai::mdb_val (hash_a), nullptr));
 			assert (status == 0 || status == MDB_NOTFOUND);
 			if (status != 0)
 			{
-				auto status (mdb_del (transaction_a, open_blocks, rai::mdb_val (hash_a), nullptr));
+				auto status (backend.del (transaction_a, open_blocks, rai::mdb_val (hash_a), nullptr));
 				assert (status == 0 || status == MDB_NOTFOUND);
 				if (status != 0)
 				{
-					auto status (mdb_del (transaction_a, change_blocks, rai::mdb_val (hash_a), nullptr));
+					auto status (backend.del (transaction_a, change_blocks, rai::mdb_val (hash_a), nullptr));
 					assert (status == 0);
 					// FXIME: remove smart contract block??
 					if (status != 0)
@@ -806,7 +952,7 @@ void rai::block_store::block_del (MDB_txn * transaction_a, rai::block_hash const
 						auto block (block_get (transaction_a, hash_a));
 						if (block != nullptr)
 						{
-							auto status (mdb_del (transaction_a, smart_contract, rai::mdb_val (hash_a), nullptr));
+							auto status (backend.del (transaction_a, smart_contract, rai::mdb_val (hash_a), nullptr));
 							assert (status == 0);
 							auto abi_hash = static_cast<smart_contract_block *> (block.get ())->hashables.abi_hash;
 							abi_del (transaction_a, abi_hash);
@@ -822,32 +968,32 @@ bool rai::block_store::block_exists (MDB_txn * transaction_a, rai::block_hash co
 {
 	auto exists (true);
 	rai::mdb_val junk;
-	auto status (mdb_get (transaction_a, send_blocks, rai::mdb_val (hash_a), junk));
+	auto status (backend.get (transaction_a, send_blocks, rai::mdb_val (hash_a), junk));
 	assert (status == 0 || status == MDB_NOTFOUND);
 	exists = status == 0;
 	if (!exists)
 	{
-		auto status (mdb_get (transaction_a, receive_blocks, rai::mdb_val (hash_a), junk));
+		auto status (backend.get (transaction_a, receive_blocks, rai::mdb_val (hash_a), junk));
 		assert (status == 0 || status == MDB_NOTFOUND);
 		exists = status == 0;
 		if (!exists)
 		{
-			auto status (mdb_get (transaction_a, open_blocks, rai::mdb_val (hash_a), junk));
+			auto status (backend.get (transaction_a, open_blocks, rai::mdb_val (hash_a), junk));
 			assert (status == 0 || status == MDB_NOTFOUND);
 			exists = status == 0;
 			if (!exists)
 			{
-				auto status (mdb_get (transaction_a, change_blocks, rai::mdb_val (hash_a), junk));
+				auto status (backend.get (transaction_a, change_blocks, rai::mdb_val (hash_a), junk));
 				assert (status == 0 || status == MDB_NOTFOUND);
 				exists = status == 0;
 				if (!exists)
 				{
-					auto status (mdb_get (transaction_a, state_blocks, rai::mdb_val (hash_a), junk));
+					auto status (backend.get (transaction_a, state_blocks, rai::mdb_val (hash_a), junk));
 					assert (status == 0 || status == MDB_NOTFOUND);
 					exists = status == 0;
 					if (!exists)
 					{
-						auto status (mdb_get (transaction_a, smart_contract, rai::mdb_val (hash_a), junk));
+						auto status (backend.get (transaction_a, smart_contract, rai::mdb_val (hash_a), junk));
 						assert (status == 0 || status == MDB_NOTFOUND);
 						exists = status == 0;
 					}
@@ -862,22 +1008,22 @@ rai::block_counts rai::block_store::block_count (MDB_txn * transaction_a)
 {
 	rai::block_counts result;
 	MDB_stat send_stats;
-	auto status1 (mdb_stat (transaction_a, send_blocks, &send_stats));
+	auto status1 (backend.stat (transaction_a, send_blocks, &send_stats));
 	assert (status1 == 0);
 	MDB_stat receive_stats;
-	auto status2 (mdb_stat (transaction_a, receive_blocks, &receive_stats));
+	auto status2 (backend.stat (transaction_a, receive_blocks, &receive_stats));
 	assert (status2 == 0);
 	MDB_stat open_stats;
-	auto status3 (mdb_stat (transaction_a, open_blocks, &open_stats));
+	auto status3 (backend.stat (transaction_a, open_blocks, &open_stats));
 	assert (status3 == 0);
 	MDB_stat change_stats;
-	auto status4 (mdb_stat (transaction_a, change_blocks, &change_stats));
+	auto status4 (backend.stat (transaction_a, change_blocks, &change_stats));
 	assert (status4 == 0);
 	MDB_stat state_stats;
-	auto status5 (mdb_stat (transaction_a, state_blocks, &state_stats));
+	auto status5 (backend.stat (transaction_a, state_blocks, &state_stats));
 	assert (status5 == 0);
 	MDB_stat smart_contract_stats;
-	auto status6 (mdb_stat (transaction_a, smart_contract, &smart_contract_stats));
+	auto status6 (backend.stat (transaction_a, smart_contract, &smart_contract_stats));
 	assert (status6 == 0);
 	result.send = send_stats.ms_entries;
 	result.receive = receive_stats.ms_entries;
@@ -897,6 +1043,10 @@ void rai::block_store::account_del (MDB_txn * transaction_a, rai::account const
 {
 	rai::account_info info;
 	auto flag = account_get (transaction_a, token_account_a, info);
+	if (!flag)
+	{
+		delegators_update (transaction_a, token_account_a, info.rep_block, 0);
+	}
 	if (flag)
 	{
 		std::vector<rai::account_info> infos;
@@ -909,19 +1059,19 @@ void rai::block_store::account_del (MDB_txn * transaction_a, rai::account const
 		assert (flag == true);
 	}
 
-	auto status (mdb_del (transaction_a, token_accounts, rai::mdb_val (token_account_a), nullptr));
+	auto status (backend.del (transaction_a, token_accounts, rai::mdb_val (token_account_a), nullptr));
 	assert (status == 0);
 }
 
 bool rai::block_store::abi_put (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	auto status (mdb_put (transaction_a, abi, rai::mdb_val (hash_a), nullptr, 0));
+	auto status (backend.put (transaction_a, abi, rai::mdb_val (hash_a), nullptr, 0));
 	return (status == 0);
 }
 
 void rai::block_store::abi_del (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	auto status (mdb_del (transaction_a, abi, rai::mdb_val (hash_a), nullptr));
+	auto status (backend.del (transaction_a, abi, rai::mdb_val (hash_a), nullptr));
 	assert (status == 0 || status == MDB_NOTFOUND);
 }
 
@@ -936,14 +1086,14 @@ void rai::block_store::accounts_del (MDB_txn * transaction_a, rai::account const
 			account_del (transaction_a, info.open_block);
 		}
 	}
-	auto status (mdb_del (transaction_a, accounts, rai::mdb_val (account_a), nullptr));
+	auto status (backend.del (transaction_a, accounts, rai::mdb_val (account_a), nullptr));
 	assert (status == 0);
 }
 
 bool rai::block_store::accounts_get (MDB_txn * transaction_a, rai::account const & account_a, std::vector<rai::account_info> & infos_a)
 {
 	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, accounts, rai::mdb_val (account_a), value));
+	auto status (backend.get (transaction_a, accounts, rai::mdb_val (account_a), value));
 	assert (status == 0 || status == MDB_NOTFOUND);
 	bool result;
 	if (status == MDB_NOTFOUND)
@@ -1025,7 +1175,7 @@ bool rai::block_store::accounts_put (MDB_txn * transaction_a, rai::account const
 			rai::write (stream, info.open_block);
 		}
 	}
-	auto status (mdb_put (transaction_a, accounts, rai::mdb_val (account_a), rai::mdb_val (vector.size (), vector.data ()), 0));
+	auto status (backend.put (transaction_a, accounts, rai::mdb_val (account_a), rai::mdb_val (vector.size (), vector.data ()), 0));
 	return status == 0;
 }
 
@@ -1038,7 +1188,7 @@ bool rai::block_store::account_exists (MDB_txn * transaction_a, rai::account con
 bool rai::block_store::account_get (MDB_txn * transaction_a, rai::account const & token_account_a, rai::account_info & info_a)
 {
 	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, token_accounts, rai::mdb_val (token_account_a), value));
+	auto status (backend.get (transaction_a, token_accounts, rai::mdb_val (token_account_a), value));
 	assert (status == 0 || status == MDB_NOTFOUND);
 	bool result = false;
 	if (status == MDB_NOTFOUND)
@@ -1054,14 +1204,14 @@ bool rai::block_store::account_get (MDB_txn * transaction_a, rai::account const
 
 void rai::block_store::assets_put (MDB_txn * transaction_a, rai::asset_key const & key_a, rai::asset_value const & asset_a)
 {
-	auto status (mdb_put (transaction_a, assets, key_a.val (), asset_a.val (), 0));
+	auto status (backend.put (transaction_a, assets, key_a.val (), asset_a.val (), 0));
 	assert (status == 0);
 }
 
 bool rai::block_store::assets_get (MDB_txn * transaction_a, rai::asset_key const & key_a, rai::asset_value & asset_a)
 {
 	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, assets, key_a.val (), value));
+	auto status (backend.get (transaction_a, assets, key_a.val (), value));
 	assert (status == 0 || status == MDB_NOTFOUND);
 	bool result;
 	if (status == MDB_NOTFOUND)
@@ -1080,20 +1230,20 @@ bool rai::block_store::assets_get (MDB_txn * transaction_a, rai::asset_key const
 
 void rai::block_store::assets_delete (MDB_txn * transaction_a, rai::asset_key const & key_a)
 {
-	auto status (mdb_del (transaction_a, assets, key_a.val (), nullptr));
+	auto status (backend.del (transaction_a, assets, key_a.val (), nullptr));
 	assert (status == 0);
 }
 
 void rai::block_store::frontier_put (MDB_txn * transaction_a, rai::block_hash const & block_a, rai::account const & account_a)
 {
-	auto status (mdb_put (transaction_a, frontiers, rai::mdb_val (block_a), rai::mdb_val (account_a), 0));
+	auto status (backend.put (transaction_a, frontiers, rai::mdb_val (block_a), rai::mdb_val (account_a), 0));
 	assert (status == 0);
 }
 
 rai::account rai::block_store::frontier_get (MDB_txn * transaction_a, rai::block_hash const & block_a)
 {
 	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, frontiers, rai::mdb_val (block_a), value));
+	auto status (backend.get (transaction_a, frontiers, rai::mdb_val (block_a), value));
 	assert (status == 0 || status == MDB_NOTFOUND);
 	rai::account result (0);
 	if (status == 0)
@@ -1105,14 +1255,14 @@ rai::account rai::block_store::frontier_get (MDB_txn * transaction_a, rai::block
 
 void rai::block_store::frontier_del (MDB_txn * transaction_a, rai::block_hash const & block_a)
 {
-	auto status (mdb_del (transaction_a, frontiers, rai::mdb_val (block_a), nullptr));
+	auto status (backend.del (transaction_a, frontiers, rai::mdb_val (block_a), nullptr));
 	assert (status == 0);
 }
 
 size_t rai::block_store::account_count (MDB_txn * transaction_a)
 {
 	MDB_stat frontier_stats;
-	auto status (mdb_stat (transaction_a, accounts, &frontier_stats));
+	auto status (backend.stat (transaction_a, accounts, &frontier_stats));
 	assert (status == 0);
 	auto result (frontier_stats.ms_entries);
 	return result;
@@ -1121,12 +1271,18 @@ size_t rai::block_store::account_count (MDB_txn * transaction_a)
 bool rai::block_store::abi_exists (MDB_txn * transaction_a, rai::block_hash const & block_hash_a)
 {
 	rai::mdb_val junk;
-	auto status (mdb_get (transaction_a, abi, rai::mdb_val (block_hash_a), junk));
+	auto status (backend.get (transaction_a, abi, rai::mdb_val (block_hash_a), junk));
 	return (status == 0);
 }
 
 void rai::block_store::account_put (MDB_txn * transaction_a, rai::account const & token_account_a, rai::account_info const & info_a)
 {
+	rai::account_info existing;
+	if (account_get (transaction_a, token_account_a, existing))
+	{
+		existing.rep_block.clear ();
+	}
+	delegators_update (transaction_a, token_account_a, existing.rep_block, info_a.rep_block);
 	std::vector<rai::account_info> infos;
 	accounts_get (transaction_a, info_a.account, infos);
 
@@ -1140,19 +1296,19 @@ void rai::block_store::account_put (MDB_txn * transaction_a, rai::account const
 		assert (flag);
 	}
 
-	auto status (mdb_put (transaction_a, token_accounts, rai::mdb_val (token_account_a), info_a.val (), 0));
+	auto status (backend.put (transaction_a, token_accounts, rai::mdb_val (token_account_a), info_a.val (), 0));
 	assert (status == 0);
 }
 
 void rai::block_store::pending_put (MDB_txn * transaction_a, rai::pending_key const & key_a, rai::pending_info const & pending_a)
 {
-	auto status (mdb_put (transaction_a, pending, key_a.val (), pending_a.val (), 0));
+	auto status (backend.put (transaction_a, pending, key_a.val (), pending_a.val (), 0));
 	assert (status == 0);
 }
 
 void rai::block_store::pending_del (MDB_txn * transaction_a, rai::pending_key const & key_a)
 {
-	auto status (mdb_del (transaction_a, pending, key_a.val (), nullptr));
+	auto status (backend.del (transaction_a, pending, key_a.val (), nullptr));
 	assert (status == 0);
 }
 
@@ -1165,7 +1321,7 @@ bool rai::block_store::pending_exists (MDB_txn * transaction_a, rai::pending_key
 bool rai::block_store::pending_get (MDB_txn * transaction_a, rai::pending_key const & key_a, rai::pending_info & pending_a)
 {
 	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, pending, key_a.val (), value));
+	auto status (backend.get (transaction_a, pending, key_a.val (), value));
 	assert (status == 0 || status == MDB_NOTFOUND);
 	bool result;
 	if (status == MDB_NOTFOUND)
@@ -1184,13 +1340,13 @@ bool rai::block_store::pending_get (MDB_txn * transaction_a, rai::pending_key co
 
 rai::store_iterator rai::block_store::pending_begin (MDB_txn * transaction_a, rai::pending_key const & key_a)
 {
-	rai::store_iterator result (transaction_a, pending, key_a.val ());
+	rai::store_iterator result (backend, transaction_a, pending, key_a.val ());
 	return result;
 }
 
 rai::store_iterator rai::block_store::pending_begin (MDB_txn * transaction_a)
 {
-	rai::store_iterator result (transaction_a, pending);
+	rai::store_iterator result (backend, transaction_a, pending);
 	return result;
 }
 
@@ -1200,15 +1356,239 @@ rai::store_iterator rai::block_store::pending_end ()
 	return result;
 }
 
+void rai::block_store::delegator_put (MDB_txn * transaction_a, rai::delegator_key const & key_a)
+{
+	auto status (backend.put (transaction_a, delegators, key_a.val (), rai::mdb_val (0, nullptr), 0));
+	assert (status == 0);
+}
+
+void rai::block_store::delegator_del (MDB_txn * transaction_a, rai::delegator_key const & key_a)
+{
+	auto status (backend.del (transaction_a, delegators, key_a.val (), nullptr));
+	assert (status == 0 || status == MDB_NOTFOUND);
+}
+
+void rai::block_store::delegators_update (MDB_txn * transaction_a, rai::account const & token_account_a, rai::block_hash const & old_rep_block_a, rai::block_hash const & new_rep_block_a)
+{
+	// Same representative block means same representative, skip the block reads
+	if (old_rep_block_a != new_rep_block_a)
+	{
+		if (!old_rep_block_a.is_zero ())
+		{
+			auto block (block_get (transaction_a, old_rep_block_a));
+			if (block != nullptr)
+			{
+				delegator_del (transaction_a, rai::delegator_key (block->representative (), token_account_a));
+			}
+		}
+		if (!new_rep_block_a.is_zero ())
+		{
+			auto block (block_get (transaction_a, new_rep_block_a));
+			if (block != nullptr)
+			{
+				delegator_put (transaction_a, rai::delegator_key (block->representative (), token_account_a));
+			}
+		}
+	}
+}
+
+rai::store_iterator rai::block_store::delegators_begin (MDB_txn * transaction_a, rai::delegator_key const & key_a)
+{
+	rai::store_iterator result (backend, transaction_a, delegators, key_a.val ());
+	return result;
+}
+
+rai::store_iterator rai::block_store::delegators_begin (MDB_txn * transaction_a)
+{
+	rai::store_iterator result (backend, transaction_a, delegators);
+	return result;
+}
+
+rai::store_iterator rai::block_store::delegators_end ()
+{
+	rai::store_iterator result (nullptr);
+	return result;
+}
+
+void rai::block_store::history_put (MDB_txn * transaction_a, rai::history_key const & key_a, rai::block_hash const & hash_a)
+{
+	auto status (backend.put (transaction_a, history, key_a.val (), rai::mdb_val (hash_a), 0));
+	assert (status == 0);
+}
+
+void rai::block_store::history_del (MDB_txn * transaction_a, rai::history_key const & key_a)
+{
+	auto status (backend.del (transaction_a, history, key_a.val (), nullptr));
+	assert (status == 0 || status == MDB_NOTFOUND);
+}
+
+bool rai::block_store::history_get (MDB_txn * transaction_a, rai::history_key const & key_a, rai::block_hash & hash_a)
+{
+	rai::mdb_val value;
+	auto status (backend.get (transaction_a, history, key_a.val (), value));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	bool result (true);
+	if (status == 0)
+	{
+		hash_a = value.uint256 ();
+		result = false;
+	}
+	return result;
+}
+
+void rai::block_store::block_height_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::history_key const & key_a)
+{
+	auto status (backend.put (transaction_a, heights, rai::mdb_val (hash_a), key_a.val (), 0));
+	assert (status == 0);
+}
+
+void rai::block_store::block_height_del (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+{
+	auto status (backend.del (transaction_a, heights, rai::mdb_val (hash_a), nullptr));
+	assert (status == 0 || status == MDB_NOTFOUND);
+}
+
+bool rai::block_store::block_height_get (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::history_key & key_a)
+{
+	rai::mdb_val value;
+	auto status (backend.get (transaction_a, heights, rai::mdb_val (hash_a), value));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	bool result (true);
+	if (status == 0)
+	{
+		key_a = rai::history_key (value);
+		result = false;
+	}
+	return result;
+}
+
+void rai::block_store::block_heights_build (MDB_txn * transaction_a)
+{
+	backend.drop (transaction_a, heights, 0);
+	rai::bulk_load bulk (backend, transaction_a);
+	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
+	{
+		rai::account token_account (i->first.uint256 ());
+		rai::account_info info (i->second);
+		auto hash (info.head);
+		for (auto height (info.block_count); height > 0 && !hash.is_zero (); --height)
+		{
+			bulk.put (heights, rai::mdb_val (hash), rai::history_key (token_account, height).val ());
+			auto block (block_view_get (transaction_a, hash));
+			assert (block.exists ());
+			hash = block.previous ();
+		}
+	}
+}
+
+void rai::block_store::confirmed_height_put (MDB_txn * transaction_a, rai::account const & account_a, uint64_t height_a)
+{
+	auto status (backend.put (transaction_a, confirmed, rai::mdb_val (account_a), rai::mdb_val (sizeof (height_a), &height_a), 0));
+	assert (status == 0);
+}
+
+void rai::block_store::confirmed_height_del (MDB_txn * transaction_a, rai::account const & account_a)
+{
+	auto status (backend.del (transaction_a, confirmed, rai::mdb_val (account_a), nullptr));
+	assert (status == 0 || status == MDB_NOTFOUND);
+}
+
+uint64_t rai::block_store::confirmed_height_get (MDB_txn * transaction_a, rai::account const & account_a)
+{
+	rai::mdb_val value;
+	auto status (backend.get (transaction_a, confirmed, rai::mdb_val (account_a), value));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	uint64_t result (0);
+	if (status == 0)
+	{
+		assert (value.size () == sizeof (result));
+		std::copy (reinterpret_cast<uint8_t const *> (value.data ()), reinterpret_cast<uint8_t const *> (value.data ()) + sizeof (result), reinterpret_cast<uint8_t *> (&result));
+	}
+	return result;
+}
+
+void rai::block_store::pruned_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::account const & account_a)
+{
+	auto status (backend.put (transaction_a, pruned, rai::mdb_val (hash_a), rai::mdb_val (account_a), 0));
+	assert (status == 0);
+}
+
+bool rai::block_store::pruned_get (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::account & account_a)
+{
+	rai::mdb_val value;
+	auto status (backend.get (transaction_a, pruned, rai::mdb_val (hash_a), value));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	auto result (status != 0 || value.size () != sizeof (rai::account));
+	if (!result)
+	{
+		account_a = value.uint256 ();
+	}
+	return result;
+}
+
+void rai::block_store::pruned_del (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+{
+	auto status (backend.del (transaction_a, pruned, rai::mdb_val (hash_a), nullptr));
+	assert (status == 0 || status == MDB_NOTFOUND);
+}
+
+bool rai::block_store::pruned_exists (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+{
+	rai::mdb_val junk;
+	auto status (backend.get (transaction_a, pruned, rai::mdb_val (hash_a), junk));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	return status == 0;
+}
+
+size_t rai::block_store::pruned_count (MDB_txn * transaction_a)
+{
+	MDB_stat stats;
+	auto status (backend.stat (transaction_a, pruned, &stats));
+	assert (status == 0);
+	return stats.ms_entries;
+}
+
+bool rai::block_store::history_indexed (MDB_txn * transaction_a)
+{
+	rai::uint256_union indexed_key (2);
+	rai::mdb_val data;
+	auto status (backend.get (transaction_a, meta, rai::mdb_val (indexed_key), data));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	return status == 0;
+}
+
+void rai::block_store::history_build (MDB_txn * transaction_a)
+{
+	history_clear (transaction_a);
+	// Every block already has its height, the index is the heights table inverted
+	rai::bulk_load bulk (backend, transaction_a);
+	for (rai::store_iterator i (backend, transaction_a, heights), n (nullptr); i != n; ++i)
+	{
+		bulk.put (history, i->second, i->first);
+	}
+	bulk.flush ();
+	rai::uint256_union indexed_key (2);
+	auto status (backend.put (transaction_a, meta, rai::mdb_val (indexed_key), rai::mdb_val (rai::uint256_union (1)), 0));
+	assert (status == 0);
+}
+
+void rai::block_store::history_clear (MDB_txn * transaction_a)
+{
+	backend.drop (transaction_a, history, 0);
+	rai::uint256_union indexed_key (2);
+	auto status (backend.del (transaction_a, meta, rai::mdb_val (indexed_key), nullptr));
+	assert (status == 0 || status == MDB_NOTFOUND);
+}
+
 void rai::block_store::block_info_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_info const & block_info_a)
 {
-	auto status (mdb_put (transaction_a, blocks_info, rai::mdb_val (hash_a), block_info_a.val (), 0));
+	auto status (backend.put (transaction_a, blocks_info, rai::mdb_val (hash_a), block_info_a.val (), 0));
 	assert (status == 0);
 }
 
 void rai::block_store::block_info_del (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	auto status (mdb_del (transaction_a, blocks_info, rai::mdb_val (hash_a), nullptr));
+	auto status (backend.del (transaction_a, blocks_info, rai::mdb_val (hash_a), nullptr));
 	assert (status == 0);
 }
 
@@ -1221,7 +1601,7 @@ bool rai::block_store::block_info_exists (MDB_txn * transaction_a, rai::block_ha
 bool rai::block_store::block_info_get (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_info & block_info_a)
 {
 	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, blocks_info, rai::mdb_val (hash_a), value));
+	auto status (backend.get (transaction_a, blocks_info, rai::mdb_val (hash_a), value));
 	assert (status == 0 || status == MDB_NOTFOUND);
 	bool result;
 	if (status == MDB_NOTFOUND)
@@ -1244,7 +1624,7 @@ bool rai::block_store::block_info_get (MDB_txn * transaction_a, rai::block_hash
 rai::uint128_t rai::block_store::representation_get (MDB_txn * transaction_a, rai::account const & account_a)
 {
 	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, representation, rai::mdb_val (account_a), value));
+	auto status (backend.get (transaction_a, representation, rai::mdb_val (account_a), value));
 	assert (status == 0 || status == MDB_NOTFOUND);
 	rai::uint128_t result;
 	if (status == 0)
@@ -1265,13 +1645,13 @@ rai::uint128_t rai::block_store::representation_get (MDB_txn * transaction_a, ra
 void rai::block_store::representation_put (MDB_txn * transaction_a, rai::account const & account_a, rai::uint128_t const & representation_a)
 {
 	rai::uint128_union rep (representation_a);
-	auto status (mdb_put (transaction_a, representation, rai::mdb_val (account_a), rai::mdb_val (rep), 0));
+	auto status (backend.put (transaction_a, representation, rai::mdb_val (account_a), rai::mdb_val (rep), 0));
 	assert (status == 0);
 }
 
 void rai::block_store::unchecked_clear (MDB_txn * transaction_a)
 {
-	auto status (mdb_drop (transaction_a, unchecked, 0));
+	auto status (backend.drop (transaction_a, unchecked, 0));
 	assert (status == 0);
 }
 
@@ -1300,7 +1680,7 @@ std::shared_ptr<rai::vote> rai::block_store::vote_get (MDB_txn * transaction_a,
 {
 	std::shared_ptr<rai::vote> result;
 	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, vote, rai::mdb_val (account_a), value));
+	auto status (backend.get (transaction_a, vote, rai::mdb_val (account_a), value));
 	assert (status == 0 || status == MDB_NOTFOUND);
 	if (status == 0)
 	{
@@ -1349,14 +1729,14 @@ void rai::block_store::unchecked_del (MDB_txn * transaction_a, rai::block_hash c
 		rai::vectorstream stream (vector);
 		rai::serialize_block (stream, block_a);
 	}
-	auto status (mdb_del (transaction_a, unchecked, rai::mdb_val (hash_a), rai::mdb_val (vector.size (), vector.data ())));
+	auto status (backend.del (transaction_a, unchecked, rai::mdb_val (hash_a), rai::mdb_val (vector.size (), vector.data ())));
 	assert (status == 0 || status == MDB_NOTFOUND);
 }
 
 size_t rai::block_store::unchecked_count (MDB_txn * transaction_a)
 {
 	MDB_stat unchecked_stats;
-	auto status (mdb_stat (transaction_a, unchecked, &unchecked_stats));
+	auto status (backend.stat (transaction_a, unchecked, &unchecked_stats));
 	assert (status == 0);
 	auto result (unchecked_stats.ms_entries);
 	return result;
@@ -1366,7 +1746,7 @@ void rai::block_store::checksum_put (MDB_txn * transaction_a, uint64_t prefix, u
 {
 	assert ((prefix & 0xff) == 0);
 	uint64_t key (prefix | mask);
-	auto status (mdb_put (transaction_a, checksum, rai::mdb_val (sizeof (key), &key), rai::mdb_val (hash_a), 0));
+	auto status (backend.put (transaction_a, checksum, rai::mdb_val (sizeof (key), &key), rai::mdb_val (hash_a), 0));
 	assert (status == 0);
 }
 
@@ -1375,7 +1755,7 @@ bool rai::block_store::checksum_get (MDB_txn * transaction_a, uint64_t prefix, u
 	assert ((prefix & 0xff) == 0);
 	uint64_t key (prefix | mask);
 	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, checksum, rai::mdb_val (sizeof (key), &key), value));
+	auto status (backend.get (transaction_a, checksum, rai::mdb_val (sizeof (key), &key), value));
 	assert (status == 0 || status == MDB_NOTFOUND);
 	bool result;
 	if (status == 0)
@@ -1396,7 +1776,7 @@ void rai::block_store::checksum_del (MDB_txn * transaction_a, uint64_t prefix, u
 {
 	assert ((prefix & 0xff) == 0);
 	uint64_t key (prefix | mask);
-	auto status (mdb_del (transaction_a, checksum, rai::mdb_val (sizeof (key), &key), nullptr));
+	auto status (backend.del (transaction_a, checksum, rai::mdb_val (sizeof (key), &key), nullptr));
 	assert (status == 0);
 }
 
@@ -1416,7 +1796,7 @@ void rai::block_store::flush (MDB_txn * transaction_a)
 			rai::vectorstream stream (vector);
 			rai::serialize_block (stream, *i.second);
 		}
-		auto status (mdb_put (transaction_a, unchecked, rai::mdb_val (i.first), rai::mdb_val (vector.size (), vector.data ()), 0));
+		auto status (backend.put (transaction_a, unchecked, rai::mdb_val (i.first), rai::mdb_val (vector.size (), vector.data ()), 0));
 		assert (status == 0);
 	}
 	for (auto i (sequence_cache_l.begin ()), n (sequence_cache_l.end ()); i != n; ++i)
@@ -1426,7 +1806,7 @@ void rai::block_store::flush (MDB_txn * transaction_a)
 			rai::vectorstream stream (vector);
 			i->second->serialize (stream);
 		}
-		auto status1 (mdb_put (transaction_a, vote, rai::mdb_val (i->first), rai::mdb_val (vector.size (), vector.data ()), 0));
+		auto status1 (backend.put (transaction_a, vote, rai::mdb_val (i->first), rai::mdb_val (vector.size (), vector.data ()), 0));
 		assert (status1 == 0);
 	}
 }
@@ -1474,25 +1854,25 @@ std::shared_ptr<rai::vote> rai::block_store::vote_max (MDB_txn * transaction_a,
 
 rai::store_iterator rai::block_store::account_latest_begin (MDB_txn * transaction_a, rai::account const & account_a)
 {
-	rai::store_iterator result (transaction_a, accounts, rai::mdb_val (account_a));
+	rai::store_iterator result (backend, transaction_a, accounts, rai::mdb_val (account_a));
 	return result;
 }
 
 rai::store_iterator rai::block_store::account_latest_begin (MDB_txn * transaction_a)
 {
-	rai::store_iterator result (transaction_a, accounts);
+	rai::store_iterator result (backend, transaction_a, accounts);
 	return result;
 }
 
 rai::store_iterator rai::block_store::latest_begin (MDB_txn * transaction_a, rai::account const & token_account_a)
 {
-	rai::store_iterator result (transaction_a, token_accounts, rai::mdb_val (token_account_a));
+	rai::store_iterator result (backend, transaction_a, token_accounts, rai::mdb_val (token_account_a));
 	return result;
 }
 
 rai::store_iterator rai::block_store::latest_begin (MDB_txn * transaction_a)
 {
-	rai::store_iterator result (transaction_a, token_accounts);
+	rai::store_iterator result (backend, transaction_a, token_accounts);
 	return result;
 }
 
@@ -23,12 +23,11 @@ public:
 class store_iterator
 {
 public:
-	store_iterator (MDB_txn *, MDB_dbi);
+	store_iterator (rai::store_backend &, MDB_txn *, MDB_dbi);
 	store_iterator (std::nullptr_t);
-	store_iterator (MDB_txn *, MDB_dbi, MDB_val const &);
+	store_iterator (rai::store_backend &, MDB_txn *, MDB_dbi, MDB_val const &);
 	store_iterator (rai::store_iterator &&);
 	store_iterator (rai::store_iterator const &) = delete;
-	~store_iterator ();
 	rai::store_iterator & operator++ ();
 	void next_dup ();
 	rai::store_iterator & operator= (rai::store_iterator &&);
@@ -36,17 +35,51 @@ public:
 	rai::store_entry & operator-> ();
 	bool operator== (rai::store_iterator const &) const;
 	bool operator!= (rai::store_iterator const &) const;
-	MDB_cursor * cursor;
+	std::unique_ptr<rai::store_cursor> cursor;
 	rai::store_entry current;
 };
 
+/**
+ * Buffers writes per table and applies them sorted by key, keys past the current end of a table go in with
+ * MDB_APPEND / MDB_APPENDDUP instead of a descent and page split each. Buffered writes are not visible until flushed.
+ */
+class bulk_load
+{
+public:
+	bulk_load (rai::store_backend &, MDB_txn *, size_t = 256 * 1024);
+	~bulk_load ();
+	void put (MDB_dbi, MDB_val const &, MDB_val const &);
+	void flush ();
+	rai::store_backend & backend;
+	MDB_txn * transaction;
+	size_t batch_entries;
+	size_t buffered;
+	uint64_t appended;
+	uint64_t inserted;
+	std::map<MDB_dbi, std::vector<std::pair<std::vector<uint8_t>, std::vector<uint8_t>>>> tables;
+};
+
+/**
+ * Node state worth keeping across restarts, stored in meta under these keys next to the version (1) and the history index marker (2)
+ */
+enum class checkpoint : uint8_t
+{
+	peers = 3,
+	online_reps = 4,
+	// Account the next pruning batch starts from
+	pruning = 5
+};
+
 /**
  * Manages block storage and iteration
  */
 class block_store
 {
 public:
-	block_store (bool &, boost::filesystem::path const &, int lmdb_max_dbs = 128);
+	block_store (bool &, boost::filesystem::path const &, int lmdb_max_dbs = 128, rai::lmdb_config const & = rai::lmdb_config ());
+	// Keeps the ledger tables in another backend. environment stays closed, only transactions begun on backend work
+	block_store (bool &, std::unique_ptr<rai::store_backend>);
+	void initialize (bool &);
 
 	MDB_dbi block_database (rai::block_type);
 	void block_put_raw (MDB_txn *, MDB_dbi, rai::block_hash const &, MDB_val);
@@ -55,6 +88,8 @@ public:
 	rai::block_hash block_successor (MDB_txn *, rai::block_hash const &);
 	void block_successor_clear (MDB_txn *, rai::block_hash const &);
 	std::unique_ptr<rai::block> block_get (MDB_txn *, rai::block_hash const &);
+	// Zero copy read, the view references page memory and must not outlive the transaction
+	rai::block_view block_view_get (MDB_txn *, rai::block_hash const &);
 	std::unique_ptr<rai::block> block_random (MDB_txn *);
 	std::unique_ptr<rai::block> block_random (MDB_txn *, MDB_dbi);
 	void block_del (MDB_txn *, rai::block_hash const &);
@@ -138,6 +173,37 @@ public:
 	rai::store_iterator pending_begin (MDB_txn *);
 	rai::store_iterator pending_end ();
 
+	void delegator_put (MDB_txn *, rai::delegator_key const &);
+	void delegator_del (MDB_txn *, rai::delegator_key const &);
+	void delegators_update (MDB_txn *, rai::account const &, rai::block_hash const &, rai::block_hash const &);
+	rai::store_iterator delegators_begin (MDB_txn *, rai::delegator_key const &);
+	rai::store_iterator delegators_begin (MDB_txn *);
+	rai::store_iterator delegators_end ();
+
+	void history_put (MDB_txn *, rai::history_key const &, rai::block_hash const &);
+	void history_del (MDB_txn *, rai::history_key const &);
+	bool history_get (MDB_txn *, rai::history_key const &, rai::block_hash &);
+	void block_height_put (MDB_txn *, rai::block_hash const &, rai::history_key const &);
+	void block_height_del (MDB_txn *, rai::block_hash const &);
+	bool block_height_get (MDB_txn *, rai::block_hash const &, rai::history_key &);
+	void block_heights_build (MDB_txn *);
+	void confirmed_height_put (MDB_txn *, rai::account const &, uint64_t);
+	void confirmed_height_del (MDB_txn *, rai::account const &);
+	// Height of the account's highest confirmed block, 0 if none is
+	uint64_t confirmed_height_get (MDB_txn *, rai::account const &);
+
+	void pruned_put (MDB_txn *, rai::block_hash const &, rai::account const &);
+	bool pruned_get (MDB_txn *, rai::block_hash const &, rai::account &);
+	void pruned_del (MDB_txn *, rai::block_hash const &);
+	bool pruned_exists (MDB_txn *, rai::block_hash const &);
+	size_t pruned_count (MDB_txn *);
+	/**
+	 * Whether the history index is complete, set by history_build and removed by history_clear
+	 */
+	bool history_indexed (MDB_txn *);
+	void history_build (MDB_txn *);
+	void history_clear (MDB_txn *);
+
 	void block_info_put (MDB_txn *, rai::block_hash const &, rai::block_info const &);
 	void block_info_del (MDB_txn *, rai::block_hash const &);
 	bool block_info_get (MDB_txn *, rai::block_hash const &, rai::block_info &);
@@ -192,6 +258,9 @@ public:
 	std::mutex cache_mutex;
 	std::unordered_map<rai::account, std::shared_ptr<rai::vote>> vote_cache;
 
+	void checkpoint_put (MDB_txn *, rai::checkpoint, std::vector<uint8_t> const &);
+	bool checkpoint_get (MDB_txn *, rai::checkpoint, std::vector<uint8_t> &);
+
 	void version_put (MDB_txn *, int);
 	int version_get (MDB_txn *);
 	void do_upgrades (MDB_txn *);
@@ -205,11 +274,19 @@ public:
 	void upgrade_v8_to_v9 (MDB_txn *);
 	void upgrade_v9_to_v10 (MDB_txn *);
 	void upgrade_v10_to_v11 (MDB_txn *);
+	void upgrade_v11_to_v12 (MDB_txn *);
+	void upgrade_v12_to_v13 (MDB_txn *);
 
 	void clear (MDB_dbi);
 
 	rai::mdb_env environment;
 
+	// Set when the store was opened on another backend
+	std::unique_ptr<rai::store_backend> alternate;
+
+	// Holds every ledger table, environment unless the store was opened on another backend
+	rai::store_backend & backend;
+
 	/**
 	 * Maps head block to owning account
 	 * rai::block_hash -> rai::account
@@ -317,5 +394,36 @@ public:
 	 *  abi_hash ->
 	 */
 	MDB_dbi abi;
+
+	/**
+	 * Token accounts delegating to a representative, maintained by account_put and account_del
+	 * rai::account (representative), rai::account (token account) ->
+	 */
+	MDB_dbi delegators;
+
+	/**
+	 * Optional per account history index, maintained by the ledger when enabled
+	 * rai::account (token account), uint64_t (height) -> rai::block_hash
+	 */
+	MDB_dbi history;
+
+	/**
+	 * Position of each block in its account's history, maintained for every block
+	 * rai::block_hash -> rai::account (token account), uint64_t (height)
+	 */
+	MDB_dbi heights;
+
+	/**
+	 * Highest confirmed height of each account chain, every block at or below it is confirmed
+	 * rai::account (token account) -> uint64_t (height)
+	 */
+	MDB_dbi confirmed;
+
+	/**
+	 * Confirmed blocks whose bodies were deleted by pruning, enough to tell they were in the ledger.
+	 * The account is the block's own, a receive being rolled back gives its pending entry back to it
+	 * rai::block_hash -> rai::account
+	 */
+	MDB_dbi pruned;
 };
 }
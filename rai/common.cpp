@@ -5,6 +5,7 @@
 #include <rai/node/common.hpp>
 #include <rai/versioning.hpp>
 
+#include <boost/endian/conversion.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
 #include <queue>
@@ -315,12 +316,15 @@ std::unordered_map<rai::block_hash, std::list<std::string>> rai::map_sc_info (gl
 std::unordered_map<rai::account, std::list<std::string>> rai::map_genesis_blocks (globals.genesis_blocks);
 
 rai::votes::votes (std::shared_ptr<rai::block> block_a) :
-id (block_a->root ())
+id (block_a->root ()),
+sum (0)
 {
 	rep_votes.insert (std::make_pair (rai::not_an_account, block_a));
+	rep_weights.insert (std::make_pair (rai::not_an_account, 0));
+	add (block_a, 0);
 }
 
-rai::tally_result rai::votes::vote (std::shared_ptr<rai::vote> vote_a)
+rai::tally_result rai::votes::vote (std::shared_ptr<rai::vote> vote_a, rai::uint128_t const & weight_a)
 {
 	rai::tally_result result;
 	auto existing (rep_votes.find (vote_a->account));
@@ -329,24 +333,118 @@ rai::tally_result rai::votes::vote (std::shared_ptr<rai::vote> vote_a)
 		// Vote on this block hasn't been seen from rep before
 		result = rai::tally_result::vote;
 		rep_votes.insert (std::make_pair (vote_a->account, vote_a->block));
+		rep_weights[vote_a->account] = weight_a;
+		add (vote_a->block, weight_a);
 	}
 	else
 	{
+		auto & weight_l (rep_weights[vote_a->account]);
 		if (!(*existing->second == *vote_a->block))
 		{
 			// Rep changed their vote
 			result = rai::tally_result::changed;
+			subtract (existing->second, weight_l);
 			existing->second = vote_a->block;
+			add (existing->second, weight_a);
+			weight_l = weight_a;
 		}
 		else
 		{
 			// Rep vote remained the same
 			result = rai::tally_result::confirm;
+			reweigh (vote_a->account, weight_a);
 		}
 	}
 	return result;
 }
 
+void rai::votes::reweigh (rai::account const & account_a, rai::uint128_t const & weight_a)
+{
+	auto existing (rep_weights.find (account_a));
+	if (existing != rep_weights.end () && existing->second != weight_a)
+	{
+		auto & entry (totals[rep_votes[account_a]->hash ()]);
+		assert (entry.weight >= existing->second);
+		entry.weight = entry.weight - existing->second + weight_a;
+		sum = sum - existing->second + weight_a;
+		existing->second = weight_a;
+	}
+}
+
+void rai::votes::add (std::shared_ptr<rai::block> block_a, rai::uint128_t const & weight_a)
+{
+	auto hash (block_a->hash ());
+	auto existing (totals.find (hash));
+	if (existing == totals.end ())
+	{
+		totals.insert (std::make_pair (hash, rai::tally_entry{ block_a, weight_a, 1 }));
+	}
+	else
+	{
+		existing->second.weight += weight_a;
+		++existing->second.reps;
+	}
+	sum += weight_a;
+}
+
+void rai::votes::subtract (std::shared_ptr<rai::block> block_a, rai::uint128_t const & weight_a)
+{
+	auto existing (totals.find (block_a->hash ()));
+	assert (existing != totals.end ());
+	assert (existing->second.weight >= weight_a && existing->second.reps > 0);
+	existing->second.weight -= weight_a;
+	if (--existing->second.reps == 0)
+	{
+		totals.erase (existing);
+	}
+	sum -= weight_a;
+}
+
+std::pair<rai::uint128_t, rai::uint128_t> rai::votes::top () const
+{
+	// Only distinct blocks are scanned, which is the number of forks and not the number of representatives
+	rai::uint128_t first (0);
+	rai::uint128_t second (0);
+	for (auto & i : totals)
+	{
+		if (i.second.weight > first)
+		{
+			second = first;
+			first = i.second.weight;
+		}
+		else if (i.second.weight > second)
+		{
+			second = i.second.weight;
+		}
+	}
+	return std::make_pair (first, second);
+}
+
+std::shared_ptr<rai::block> rai::votes::leader () const
+{
+	std::shared_ptr<rai::block> result;
+	rai::uint128_t weight (0);
+	for (auto & i : totals)
+	{
+		if (result == nullptr || i.second.weight > weight)
+		{
+			result = i.second.block;
+			weight = i.second.weight;
+		}
+	}
+	return result;
+}
+
+rai::tally_t rai::votes::tally () const
+{
+	rai::tally_t result;
+	for (auto & i : totals)
+	{
+		result[i.second.weight] = i.second.block;
+	}
+	return result;
+}
+
 bool rai::votes::uncontested ()
 {
 	bool result (true);
@@ -587,6 +685,57 @@ rai::mdb_val rai::pending_key::val () const
 	return rai::mdb_val (sizeof (*this), const_cast<rai::pending_key *> (this));
 }
 
+rai::delegator_key::delegator_key (rai::account const & representative_a, rai::account const & account_a) :
+representative (representative_a),
+account (account_a)
+{
+}
+
+rai::delegator_key::delegator_key (MDB_val const & val_a)
+{
+	assert (val_a.mv_size == sizeof (*this));
+	static_assert (sizeof (representative) + sizeof (account) == sizeof (*this), "Packed class");
+	std::copy (reinterpret_cast<uint8_t const *> (val_a.mv_data), reinterpret_cast<uint8_t const *> (val_a.mv_data) + sizeof (*this), reinterpret_cast<uint8_t *> (this));
+}
+
+bool rai::delegator_key::operator== (rai::delegator_key const & other_a) const
+{
+	return representative == other_a.representative && account == other_a.account;
+}
+
+rai::mdb_val rai::delegator_key::val () const
+{
+	return rai::mdb_val (sizeof (*this), const_cast<rai::delegator_key *> (this));
+}
+
+rai::history_key::history_key (rai::account const & account_a, uint64_t height_a) :
+account (account_a),
+height_big (boost::endian::native_to_big (height_a))
+{
+}
+
+rai::history_key::history_key (MDB_val const & val_a)
+{
+	assert (val_a.mv_size == sizeof (*this));
+	static_assert (sizeof (account) + sizeof (height_big) == sizeof (*this), "Packed class");
+	std::copy (reinterpret_cast<uint8_t const *> (val_a.mv_data), reinterpret_cast<uint8_t const *> (val_a.mv_data) + sizeof (*this), reinterpret_cast<uint8_t *> (this));
+}
+
+bool rai::history_key::operator== (rai::history_key const & other_a) const
+{
+	return account == other_a.account && height_big == other_a.height_big;
+}
+
+uint64_t rai::history_key::height () const
+{
+	return boost::endian::big_to_native (height_big);
+}
+
+rai::mdb_val rai::history_key::val () const
+{
+	return rai::mdb_val (sizeof (*this), const_cast<rai::history_key *> (this));
+}
+
 rai::asset_key::asset_key (rai::account const & account_a, boost::asio::mutable_buffer const & key_a) :
 sc_account (account_a), key (key_a), key_length (key_a.size ())
 {
@@ -761,23 +910,24 @@ amount (0)
 {
 }
 
-void rai::amount_visitor::send_block (rai::send_block const & block_a)
+void rai::amount_visitor::send_block (rai::block_view const & block_a)
 {
-	current_balance = block_a.hashables.previous;
-	amount = block_a.hashables.balance.number ();
+	current_balance = block_a.previous ();
+	amount = block_a.balance ().number ();
 	current_amount = 0;
 }
 
-void rai::amount_visitor::receive_block (rai::receive_block const & block_a)
+void rai::amount_visitor::receive_block (rai::block_view const & block_a)
 {
-	current_amount = block_a.hashables.source;
+	current_amount = block_a.source ();
 }
 
-void rai::amount_visitor::open_block (rai::open_block const & block_a)
+void rai::amount_visitor::open_block (rai::block_view const & block_a)
 {
-	if (block_a.hashables.source != rai::genesis_account)
+	auto source (block_a.source ());
+	if (source != rai::genesis_account)
 	{
-		current_amount = block_a.hashables.source;
+		current_amount = source;
 	}
 	else
 	{
@@ -786,14 +936,14 @@ void rai::amount_visitor::open_block (rai::open_block const & block_a)
 	}
 }
 
-void rai::amount_visitor::state_block (rai::state_block const & block_a)
+void rai::amount_visitor::state_block (rai::block_view const & block_a)
 {
-	current_balance = block_a.hashables.previous;
-	amount = block_a.hashables.balance.number ();
+	current_balance = block_a.previous ();
+	amount = block_a.balance ().number ();
 	current_amount = 0;
 }
 
-void rai::amount_visitor::change_block (rai::change_block const & block_a)
+void rai::amount_visitor::change_block (rai::block_view const & block_a)
 {
 	amount = 0;
 	current_amount = 0;
@@ -808,10 +958,10 @@ void rai::amount_visitor::compute (rai::block_hash const & block_hash)
 	{
 		if (!current_amount.is_zero ())
 		{
-			auto block (store.block_get (transaction, current_amount));
-			if (block != nullptr)
+			auto block (store.block_view_get (transaction, current_amount));
+			if (block.exists ())
 			{
-				block->visit (*this);
+				block.visit (*this);
 			}
 			else
 			{
@@ -820,6 +970,12 @@ void rai::amount_visitor::compute (rai::block_hash const & block_hash)
 					amount = rai::genesis_amount;
 					current_amount = 0;
 				}
+				else if (store.pruned_exists (transaction, current_amount))
+				{
+					// Amounts sent by pruned blocks are gone with them
+					amount = 0;
+					current_amount = 0;
+				}
 				else
 				{
 					assert (false);
@@ -838,7 +994,7 @@ void rai::amount_visitor::compute (rai::block_hash const & block_hash)
 	}
 }
 
-void rai::amount_visitor::smart_contract_block (rai::smart_contract_block const & block_a)
+void rai::amount_visitor::smart_contract_block (rai::block_view const & block_a)
 {
 	amount = 0;
 	current_amount = 0;
@@ -853,54 +1009,54 @@ balance (0)
 {
 }
 
-void rai::balance_visitor::send_block (rai::send_block const & block_a)
+void rai::balance_visitor::send_block (rai::block_view const & block_a)
 {
-	balance += block_a.hashables.balance.number ();
+	balance += block_a.balance ().number ();
 	current_balance = 0;
 }
 
-void rai::balance_visitor::receive_block (rai::receive_block const & block_a)
+void rai::balance_visitor::receive_block (rai::block_view const & block_a)
 {
 	rai::block_info block_info;
-	if (!store.block_info_get (transaction, block_a.hash (), block_info))
+	if (!store.block_info_get (transaction, block_a.hash, block_info))
 	{
 		balance += block_info.balance.number ();
 		current_balance = 0;
 	}
 	else
 	{
-		current_amount = block_a.hashables.source;
-		current_balance = block_a.hashables.previous;
+		current_amount = block_a.source ();
+		current_balance = block_a.previous ();
 	}
 }
 
-void rai::balance_visitor::open_block (rai::open_block const & block_a)
+void rai::balance_visitor::open_block (rai::block_view const & block_a)
 {
-	current_amount = block_a.hashables.source;
+	current_amount = block_a.source ();
 	current_balance = 0;
 }
 
-void rai::balance_visitor::change_block (rai::change_block const & block_a)
+void rai::balance_visitor::change_block (rai::block_view const & block_a)
 {
 	rai::block_info block_info;
-	if (!store.block_info_get (transaction, block_a.hash (), block_info))
+	if (!store.block_info_get (transaction, block_a.hash, block_info))
 	{
 		balance += block_info.balance.number ();
 		current_balance = 0;
 	}
 	else
 	{
-		current_balance = block_a.hashables.previous;
+		current_balance = block_a.previous ();
 	}
 }
 
-void rai::balance_visitor::state_block (rai::state_block const & block_a)
+void rai::balance_visitor::state_block (rai::block_view const & block_a)
 {
-	balance = block_a.hashables.balance.number ();
+	balance = block_a.balance ().number ();
 	current_balance = 0;
 }
 
-void rai::balance_visitor::smart_contract_block (rai::smart_contract_block const &)
+void rai::balance_visitor::smart_contract_block (rai::block_view const &)
 {
 	current_amount = 0;
 	current_amount = 0;
@@ -920,9 +1076,20 @@ void rai::balance_visitor::compute (rai::block_hash const & block_hash)
 		}
 		else
 		{
-			auto block (store.block_get (transaction, current_balance));
-			assert (block != nullptr);
-			block->visit (*this);
+			auto block (store.block_view_get (transaction, current_balance));
+			if (block.exists ())
+			{
+				block.visit (*this);
+			}
+			else
+			{
+				// Pruned, the newest pruned block of a chain keeps its balance
+				rai::block_info block_info;
+				auto error (store.block_info_get (transaction, current_balance, block_info));
+				assert (!error);
+				balance += block_info.balance.number ();
+				current_balance = 0;
+			}
 		}
 	}
 }
@@ -939,35 +1106,35 @@ void rai::representative_visitor::compute (rai::block_hash const & hash_a)
 	current = hash_a;
 	while (result.is_zero ())
 	{
-		auto block (store.block_get (transaction, current));
-		assert (block != nullptr);
-		block->visit (*this);
+		auto block (store.block_view_get (transaction, current));
+		assert (block.exists ());
+		block.visit (*this);
 	}
 }
 
-void rai::representative_visitor::send_block (rai::send_block const & block_a)
+void rai::representative_visitor::send_block (rai::block_view const & block_a)
 {
 	current = block_a.previous ();
 }
 
-void rai::representative_visitor::receive_block (rai::receive_block const & block_a)
+void rai::representative_visitor::receive_block (rai::block_view const & block_a)
 {
 	current = block_a.previous ();
 }
 
-void rai::representative_visitor::open_block (rai::open_block const & block_a)
+void rai::representative_visitor::open_block (rai::block_view const & block_a)
 {
-	result = block_a.hash ();
+	result = block_a.hash;
 }
 
-void rai::representative_visitor::change_block (rai::change_block const & block_a)
+void rai::representative_visitor::change_block (rai::block_view const & block_a)
 {
-	result = block_a.hash ();
+	result = block_a.hash;
 }
 
-void rai::representative_visitor::state_block (rai::state_block const & block_a)
+void rai::representative_visitor::state_block (rai::block_view const & block_a)
 {
-	result = block_a.hash ();
+	result = block_a.hash;
 }
 
 rai::vote::vote (rai::vote const & other_a) :
@@ -1117,6 +1284,8 @@ void rai::genesis::initialize (MDB_txn * transaction_a, rai::block_store & store
 	store_a.representation_put (transaction_a, rai::genesis_account, rai::genesis_amount);
 	store_a.checksum_put (transaction_a, 0, 0, hash_l);
 	store_a.frontier_put (transaction_a, hash_l, hash_l);
+	store_a.block_height_put (transaction_a, hash_l, rai::history_key (hash_l, 1));
+	store_a.confirmed_height_put (transaction_a, hash_l, 1);
 }
 
 rai::block_hash rai::genesis::hash () const
@@ -5,6 +5,7 @@
 
 #include <boost/property_tree/ptree.hpp>
 
+#include <map>
 #include <unordered_map>
 
 #include <blake2/blake2.h>
@@ -23,25 +24,27 @@ struct hash<rai::uint256_union>
 }
 namespace rai
 {
-const uint8_t protocol_version = 0x0b;
+const uint8_t protocol_version = 0x0c;
 const uint8_t protocol_version_min = 0x07;
+// First version understanding confirm_req_batch
+const uint8_t protocol_version_confirm_req_batch = 0x0c;
 
 class block_store;
 /**
  * Determine the balance as of this block
  */
-class balance_visitor : public rai::block_visitor
+class balance_visitor : public rai::block_view_visitor
 {
 public:
 	balance_visitor (MDB_txn *, rai::block_store &);
 	virtual ~balance_visitor () = default;
 	void compute (rai::block_hash const &);
-	void send_block (rai::send_block const &) override;
-	void receive_block (rai::receive_block const &) override;
-	void open_block (rai::open_block const &) override;
-	void change_block (rai::change_block const &) override;
-	void state_block (rai::state_block const &) override;
-	void smart_contract_block (rai::smart_contract_block const &) override;
+	void send_block (rai::block_view const &) override;
+	void receive_block (rai::block_view const &) override;
+	void open_block (rai::block_view const &) override;
+	void change_block (rai::block_view const &) override;
+	void state_block (rai::block_view const &) override;
+	void smart_contract_block (rai::block_view const &) override;
 
 	MDB_txn * transaction;
 	rai::block_store & store;
@@ -53,19 +56,19 @@ public:
 /**
  * Determine the amount delta resultant from this block
  */
-class amount_visitor : public rai::block_visitor
+class amount_visitor : public rai::block_view_visitor
 {
 public:
 	amount_visitor (MDB_txn *, rai::block_store &);
 	virtual ~amount_visitor () = default;
 	void compute (rai::block_hash const &);
-	void send_block (rai::send_block const &) override;
-	void receive_block (rai::receive_block const &) override;
-	void open_block (rai::open_block const &) override;
-	void change_block (rai::change_block const &) override;
-	void state_block (rai::state_block const &) override;
+	void send_block (rai::block_view const &) override;
+	void receive_block (rai::block_view const &) override;
+	void open_block (rai::block_view const &) override;
+	void change_block (rai::block_view const &) override;
+	void state_block (rai::block_view const &) override;
 	void from_send (rai::block_hash const &);
-	void smart_contract_block (rai::smart_contract_block const &) override;
+	void smart_contract_block (rai::block_view const &) override;
 
 	MDB_txn * transaction;
 	rai::block_store & store;
@@ -77,19 +80,19 @@ public:
 /**
  * Determine the representative for this block
  */
-class representative_visitor : public rai::block_visitor
+class representative_visitor : public rai::block_view_visitor
 {
 public:
 	representative_visitor (MDB_txn * transaction_a, rai::block_store & store_a);
 	virtual ~representative_visitor () = default;
 	void compute (rai::block_hash const & hash_a);
-	void send_block (rai::send_block const & block_a) override;
-	void receive_block (rai::receive_block const & block_a) override;
-	void open_block (rai::open_block const & block_a) override;
-	void change_block (rai::change_block const & block_a) override;
-	void state_block (rai::state_block const & block_a) override;
+	void send_block (rai::block_view const & block_a) override;
+	void receive_block (rai::block_view const & block_a) override;
+	void open_block (rai::block_view const & block_a) override;
+	void change_block (rai::block_view const & block_a) override;
+	void state_block (rai::block_view const & block_a) override;
 
-	void smart_contract_block (rai::smart_contract_block const &) override
+	void smart_contract_block (rai::block_view const &) override
 	{
 	}
 
@@ -174,6 +177,35 @@ public:
 	rai::block_hash hash;
 };
 
+/**
+ * Key of the representative -> delegator index, sorted by representative so one representative's delegators are a range
+ */
+class delegator_key
+{
+public:
+	delegator_key (rai::account const &, rai::account const &);
+	delegator_key (MDB_val const &);
+	bool operator== (rai::delegator_key const &) const;
+	rai::mdb_val val () const;
+	rai::account representative;
+	rai::account account;
+};
+
+/**
+ * Key of the per account history index, the height is held big endian so one account's entries sort by height
+ */
+class history_key
+{
+public:
+	history_key (rai::account const &, uint64_t);
+	history_key (MDB_val const &);
+	bool operator== (rai::history_key const &) const;
+	uint64_t height () const;
+	rai::mdb_val val () const;
+	rai::account account;
+	uint64_t height_big;
+};
+
 /**
  * 资产状态
  */
@@ -316,16 +348,44 @@ enum class tally_result
 	changed,
 	confirm
 };
+using tally_t = std::map<rai::uint128_t, std::shared_ptr<rai::block>, std::greater<rai::uint128_t>>;
+class tally_entry
+{
+public:
+	std::shared_ptr<rai::block> block;
+	rai::uint128_t weight;
+	// Number of representatives voting for this block
+	size_t reps;
+};
 class votes
 {
 public:
 	votes (std::shared_ptr<rai::block>);
-	rai::tally_result vote (std::shared_ptr<rai::vote>);
+	// Record a vote and move the representative's weight onto the voted block
+	rai::tally_result vote (std::shared_ptr<rai::vote>, rai::uint128_t const &);
+	// Change the weight a representative is counted with, its vote stays where it is
+	void reweigh (rai::account const &, rai::uint128_t const &);
+	// Weight of the leading block and of the runner up, from the running totals
+	std::pair<rai::uint128_t, rai::uint128_t> top () const;
+	// Block currently holding the most weight
+	std::shared_ptr<rai::block> leader () const;
+	// Map of weight -> associated block from the running totals, ordered greatest to least
+	rai::tally_t tally () const;
 	bool uncontested ();
 	// Root block of fork
 	rai::block_hash id;
 	// All votes received by account
 	std::unordered_map<rai::account, std::shared_ptr<rai::block>> rep_votes;
+	// Weight each representative is currently counted with
+	std::unordered_map<rai::account, rai::uint128_t> rep_weights;
+	// Running weight per voted block, adjusted by the delta of each vote instead of recounted
+	std::unordered_map<rai::block_hash, rai::tally_entry> totals;
+	// Sum of all weights in totals
+	rai::uint128_t sum;
+
+private:
+	void add (std::shared_ptr<rai::block>, rai::uint128_t const &);
+	void subtract (std::shared_ptr<rai::block>, rai::uint128_t const &);
 };
 extern rai::keypair const & zero_key;
 extern rai::keypair const & test_genesis_key;
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <rai/node/common.hpp>
 #include <rai/node/node.hpp>
+#include <rai/snapshot.hpp>
 #include <rai/versioning.hpp>
 
 #include <fstream>
@@ -957,3 +958,231 @@ TEST (block_store, state_block)
 	auto count2 (store.block_count (transaction));
 	ASSERT_EQ (1, count2.state);
 }
+
+TEST (block_store, delegators_index)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::keypair key1;
+	rai::keypair rep1;
+	rai::keypair rep2;
+	rai::open_block open (0, rep1.pub, key1.pub, key1.prv, key1.pub, 0);
+	rai::change_block change (open.hash (), rep2.pub, key1.prv, key1.pub, 0);
+	rai::transaction transaction (store.environment, nullptr, true);
+	store.block_put (transaction, open.hash (), open);
+	store.block_put (transaction, change.hash (), change);
+	rai::account_info info (open.hash (), open.hash (), open.hash (), 10, 0, 1, rai::chain_token_type, key1.pub);
+	store.account_put (transaction, open.hash (), info);
+	auto i1 (store.delegators_begin (transaction));
+	ASSERT_NE (store.delegators_end (), i1);
+	ASSERT_EQ (rai::delegator_key (rep1.pub, open.hash ()), rai::delegator_key (i1->first));
+	// Balance changes keep the entry, a representative change moves it
+	info.balance = 5;
+	store.account_put (transaction, open.hash (), info);
+	info.head = change.hash ();
+	info.rep_block = change.hash ();
+	store.account_put (transaction, open.hash (), info);
+	auto i2 (store.delegators_begin (transaction, rai::delegator_key (rep2.pub, 0)));
+	ASSERT_NE (store.delegators_end (), i2);
+	ASSERT_EQ (rai::delegator_key (rep2.pub, open.hash ()), rai::delegator_key (i2->first));
+	++i2;
+	ASSERT_EQ (store.delegators_end (), i2);
+	auto i3 (store.delegators_begin (transaction, rai::delegator_key (rep1.pub, 0)));
+	ASSERT_TRUE (i3 == store.delegators_end () || rai::delegator_key (i3->first).representative != rep1.pub);
+	// Rebuilding from the accounts table gives the same index
+	store.upgrade_v11_to_v12 (transaction);
+	ASSERT_EQ (12, store.version_get (transaction));
+	auto i4 (store.delegators_begin (transaction));
+	ASSERT_NE (store.delegators_end (), i4);
+	ASSERT_EQ (rai::delegator_key (rep2.pub, open.hash ()), rai::delegator_key (i4->first));
+	store.account_del (transaction, open.hash ());
+	ASSERT_EQ (store.delegators_end (), store.delegators_begin (transaction));
+}
+
+TEST (ledger_snapshot, round_trip)
+{
+	bool init (false);
+	rai::block_store store1 (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::keypair key1;
+	rai::open_block open (0, key1.pub, key1.pub, key1.prv, key1.pub, 0);
+	std::stringstream stream;
+	{
+		rai::transaction transaction (store1.environment, nullptr, true);
+		store1.block_put (transaction, open.hash (), open);
+		store1.account_put (transaction, open.hash (), { open.hash (), open.hash (), open.hash (), 100, 0, 1, rai::chain_token_type, key1.pub });
+		store1.pending_put (transaction, rai::pending_key (key1.pub, 5), { 6, 7, rai::chain_token_type });
+		store1.representation_put (transaction, key1.pub, 100);
+		store1.frontier_put (transaction, open.hash (), key1.pub);
+		rai::ledger_snapshot snapshot (store1);
+		ASSERT_FALSE (snapshot.write (transaction, stream));
+		ASSERT_LT (0, snapshot.entries);
+	}
+	rai::block_store store2 (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::ledger_snapshot snapshot2 (store2);
+	ASSERT_FALSE (snapshot2.read (stream));
+	rai::transaction transaction (store2.environment, nullptr, false);
+	auto block (store2.block_get (transaction, open.hash ()));
+	ASSERT_NE (nullptr, block);
+	ASSERT_EQ (open, *block);
+	rai::account_info info;
+	ASSERT_FALSE (store2.account_get (transaction, open.hash (), info));
+	ASSERT_EQ (rai::amount (100), info.balance);
+	ASSERT_TRUE (store2.pending_exists (transaction, rai::pending_key (key1.pub, 5)));
+	ASSERT_EQ (100, store2.representation_get (transaction, key1.pub));
+	ASSERT_EQ (key1.pub, store2.frontier_get (transaction, open.hash ()));
+	ASSERT_NE (store2.delegators_end (), store2.delegators_begin (transaction));
+}
+
+TEST (ledger_snapshot, corrupt)
+{
+	bool init (false);
+	rai::block_store store1 (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::keypair key1;
+	rai::open_block open (0, key1.pub, key1.pub, key1.prv, key1.pub, 0);
+	std::string text;
+	{
+		rai::transaction transaction (store1.environment, nullptr, true);
+		store1.block_put (transaction, open.hash (), open);
+		store1.account_put (transaction, open.hash (), { open.hash (), open.hash (), open.hash (), 100, 0, 1, rai::chain_token_type, key1.pub });
+		std::stringstream stream;
+		rai::ledger_snapshot snapshot (store1);
+		ASSERT_FALSE (snapshot.write (transaction, stream));
+		text = stream.str ();
+	}
+	// A flipped byte fails the digest and nothing is left loaded
+	text[text.size () / 2] ^= 1;
+	rai::block_store store2 (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	std::stringstream corrupt (text);
+	rai::ledger_snapshot snapshot2 (store2);
+	ASSERT_TRUE (snapshot2.read (corrupt));
+	{
+		rai::transaction transaction (store2.environment, nullptr, false);
+		ASSERT_EQ (store2.latest_end (), store2.latest_begin (transaction));
+		ASSERT_EQ (nullptr, store2.block_get (transaction, open.hash ()));
+	}
+	// Stores already holding accounts are refused
+	std::stringstream again (text);
+	rai::ledger_snapshot snapshot1 (store1);
+	ASSERT_TRUE (snapshot1.read (again));
+	rai::transaction transaction (store1.environment, nullptr, false);
+	ASSERT_NE (nullptr, store1.block_get (transaction, open.hash ()));
+}
+
+TEST (bulk_load, sorted_append)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::transaction transaction (store.environment, nullptr, true);
+	store.block_info_put (transaction, 5, rai::block_info (5, 5));
+	{
+		rai::bulk_load bulk (store.backend, transaction, 4);
+		for (auto i : { 9, 3, 7, 8, 6, 7 })
+		{
+			bulk.put (store.blocks_info, rai::mdb_val (rai::block_hash (i)), rai::block_info (i, i).val ());
+		}
+		// Later puts of a key replace earlier ones
+		bulk.put (store.blocks_info, rai::mdb_val (rai::block_hash (3)), rai::block_info (3, 30).val ());
+		bulk.flush ();
+		ASSERT_EQ (0, bulk.buffered);
+		ASSERT_LT (0, bulk.appended);
+		ASSERT_LT (0, bulk.inserted);
+	}
+	std::vector<rai::block_hash> hashes;
+	for (auto i (store.block_info_begin (transaction)), n (store.block_info_end ()); i != n; ++i)
+	{
+		hashes.push_back (i->first.uint256 ());
+	}
+	ASSERT_EQ (std::vector<rai::block_hash> ({ 3, 5, 6, 7, 8, 9 }), hashes);
+	rai::block_info info;
+	ASSERT_FALSE (store.block_info_get (transaction, 3, info));
+	ASSERT_EQ (rai::amount (30), info.balance);
+}
+
+TEST (block_store, map_growth)
+{
+	rai::lmdb_config config;
+	config.map_size = 1024 * 1024;
+	config.map_growth = 1024 * 1024;
+	bool init (false);
+	rai::block_store store (init, rai::unique_path (), 128, config);
+	ASSERT_TRUE (!init);
+	// Several times the initial map, each transaction fits in the growth margin
+	for (auto i (0); i < 20; ++i)
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		for (auto j (0); j < 2000; ++j)
+		{
+			rai::block_hash hash (i * 2000 + j + 1);
+			store.block_info_put (transaction, hash, rai::block_info (hash, j));
+		}
+	}
+	ASSERT_LT (0, store.environment.resizes);
+	MDB_envinfo info;
+	ASSERT_EQ (0, mdb_env_info (store.environment, &info));
+	ASSERT_LT (config.map_size, info.me_mapsize);
+	rai::transaction transaction (store.environment, nullptr, false);
+	rai::block_info info1;
+	ASSERT_FALSE (store.block_info_get (transaction, 40000, info1));
+}
+
+TEST (block_store, online_backup)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		for (auto i (1); i <= 1000; ++i)
+		{
+			rai::block_hash hash (i);
+			store.block_info_put (transaction, hash, rai::block_info (hash, i));
+		}
+	}
+	auto destination (rai::unique_path ());
+	rai::store_backup backup (store.environment, destination, 0);
+	backup.start ();
+	ASSERT_FALSE (backup.join ());
+	ASSERT_TRUE (backup.finished ());
+	ASSERT_LE (1000, backup.entries);
+	ASSERT_EQ (backup.entries_total, backup.entries);
+	ASSERT_TRUE (boost::filesystem::exists (destination));
+	rai::block_store copy (init, destination);
+	ASSERT_TRUE (!init);
+	rai::transaction transaction (copy.environment, nullptr, false);
+	rai::block_info info;
+	ASSERT_FALSE (copy.block_info_get (transaction, 1000, info));
+	ASSERT_EQ (rai::amount (1000), info.balance);
+}
+
+TEST (block_store, compact_at_start)
+{
+	auto path (rai::unique_path ());
+	boost::filesystem::create_directories (path);
+	{
+		bool init (false);
+		rai::block_store store (init, path / "data.ldb");
+		ASSERT_TRUE (!init);
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.block_info_put (transaction, 1, rai::block_info (1, 1));
+	}
+	// Nothing happens until a compaction is scheduled
+	auto data (rai::store_backup::install (path, 128, rai::lmdb_config ()));
+	ASSERT_FALSE (boost::filesystem::exists (path / "backup.compact.ldb"));
+	ASSERT_FALSE (rai::store_backup::schedule_compaction (path));
+	ASSERT_EQ (data, rai::store_backup::install (path, 128, rai::lmdb_config ()));
+	ASSERT_TRUE (boost::filesystem::exists (path / "backup.compact.ldb"));
+	ASSERT_FALSE (boost::filesystem::exists (rai::store_backup::compacted_path (path)));
+	bool init (false);
+	rai::block_store store (init, data);
+	ASSERT_TRUE (!init);
+	rai::transaction transaction (store.environment, nullptr, false);
+	rai::block_info info;
+	ASSERT_FALSE (store.block_info_get (transaction, 1, info));
+	ASSERT_EQ (rai::amount (1), info.balance);
+}
@@ -61,6 +61,148 @@ TEST (conflicts, add_two)
 	ASSERT_EQ (2, node1.active.roots.size ());
 }
 
+TEST (conflicts, backlog_order)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::genesis genesis;
+	rai::keypair key1;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	ASSERT_EQ (rai::process_result::progress, node1.process (*send1).code);
+	auto send2 (std::make_shared<rai::send_block> (send1->hash (), key1.pub, rai::genesis_amount - 200, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	ASSERT_EQ (rai::process_result::progress, node1.process (*send2).code);
+	node1.active.active_size_max = 0;
+	ASSERT_FALSE (node1.active.start (send2));
+	ASSERT_FALSE (node1.active.start (send1));
+	ASSERT_TRUE (node1.active.start (send1));
+	ASSERT_EQ (0, node1.active.roots.size ());
+	ASSERT_EQ (2, node1.active.backlog.size ());
+	auto & by_priority (node1.active.backlog.get<1> ());
+	ASSERT_EQ (send1->root (), by_priority.begin ()->root);
+	ASSERT_EQ (send2->root (), std::next (by_priority.begin ())->root);
+}
+
+TEST (conflicts, backlog_evict)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::genesis genesis;
+	rai::keypair key1;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	ASSERT_EQ (rai::process_result::progress, node1.process (*send1).code);
+	auto send2 (std::make_shared<rai::send_block> (send1->hash (), key1.pub, rai::genesis_amount - 200, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	ASSERT_EQ (rai::process_result::progress, node1.process (*send2).code);
+	// Not in the ledger so it has the lowest priority
+	auto send3 (std::make_shared<rai::send_block> (send2->hash (), key1.pub, rai::genesis_amount - 300, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	node1.active.active_size_max = 0;
+	node1.active.backlog_size_max = 1;
+	std::atomic<bool> evicted (false);
+	ASSERT_FALSE (node1.active.start (send2, [&evicted](std::shared_ptr<rai::block> block_a) {
+		if (block_a == nullptr)
+		{
+			evicted = true;
+		}
+	}));
+	ASSERT_FALSE (node1.active.start (send1));
+	auto iterations (0);
+	while (!evicted)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	// A dropped election is told the same way as an evicted one
+	std::atomic<bool> dropped (false);
+	ASSERT_TRUE (node1.active.start (send3, [&dropped](std::shared_ptr<rai::block> block_a) {
+		if (block_a == nullptr)
+		{
+			dropped = true;
+		}
+	}));
+	iterations = 0;
+	while (!dropped)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	ASSERT_EQ (1, node1.active.backlog.size ());
+	ASSERT_EQ (send1->root (), node1.active.backlog.begin ()->root);
+	ASSERT_EQ (1, node1.stats.count (rai::stat::type::election, rai::stat::detail::evicted));
+	ASSERT_EQ (1, node1.stats.count (rai::stat::type::election, rai::stat::detail::dropped));
+}
+
+TEST (conflicts, backlog_promote)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::genesis genesis;
+	rai::keypair key1;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	ASSERT_EQ (rai::process_result::progress, node1.process (*send1).code);
+	auto send2 (std::make_shared<rai::send_block> (send1->hash (), key1.pub, rai::genesis_amount - 200, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	ASSERT_EQ (rai::process_result::progress, node1.process (*send2).code);
+	{
+		std::lock_guard<std::mutex> lock (node1.active.mutex);
+		node1.active.active_size_max = 0;
+	}
+	ASSERT_FALSE (node1.active.start (send2));
+	ASSERT_FALSE (node1.active.start (send1));
+	{
+		std::lock_guard<std::mutex> lock (node1.active.mutex);
+		node1.active.active_size_max = 1;
+	}
+	auto iterations (0);
+	auto promoted (false);
+	while (!promoted)
+	{
+		system.poll ();
+		std::lock_guard<std::mutex> lock (node1.active.mutex);
+		promoted = !node1.active.roots.empty ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	std::lock_guard<std::mutex> lock (node1.active.mutex);
+	ASSERT_EQ (1, node1.active.roots.size ());
+	ASSERT_NE (node1.active.roots.end (), node1.active.roots.find (send1->root ()));
+	ASSERT_EQ (1, node1.active.backlog.size ());
+	ASSERT_EQ (send2->root (), node1.active.backlog.begin ()->root);
+}
+
+TEST (conflicts, announce_rotation)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::genesis genesis;
+	rai::keypair key1;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	ASSERT_EQ (rai::process_result::progress, node1.process (*send1).code);
+	auto send2 (std::make_shared<rai::send_block> (send1->hash (), key1.pub, rai::genesis_amount - 200, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	ASSERT_EQ (rai::process_result::progress, node1.process (*send2).code);
+	auto send3 (std::make_shared<rai::send_block> (send2->hash (), key1.pub, rai::genesis_amount - 300, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	ASSERT_EQ (rai::process_result::progress, node1.process (*send3).code);
+	{
+		std::lock_guard<std::mutex> lock (node1.active.mutex);
+		node1.active.announcements_per_interval = 2;
+	}
+	node1.active.start (send1);
+	node1.active.start (send2);
+	node1.active.start (send3);
+	// One announcement goes to the highest priority election, the other alternates between the two below it
+	auto iterations (0);
+	auto announced (false);
+	while (!announced)
+	{
+		system.poll ();
+		std::lock_guard<std::mutex> lock (node1.active.mutex);
+		auto existing (node1.active.roots.find (send3->root ()));
+		ASSERT_NE (node1.active.roots.end (), existing);
+		announced = existing->announcements > 0;
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+}
+
 TEST (votes, contested)
 {
 	rai::genesis genesis;
@@ -72,3 +214,30 @@ TEST (votes, contested)
 	votes.rep_votes[rai::test_genesis_key.pub] = block2;
 	ASSERT_FALSE (votes.uncontested ());
 }
+
+TEST (votes, running_totals)
+{
+	rai::keypair key1;
+	rai::keypair key2;
+	auto block1 (std::make_shared<rai::send_block> (0, key1.pub, 1, key1.prv, key1.pub, 0));
+	auto block2 (std::make_shared<rai::send_block> (0, key1.pub, 2, key1.prv, key1.pub, 0));
+	rai::votes votes (block1);
+	ASSERT_EQ (1, votes.totals.size ());
+	ASSERT_EQ (0, votes.sum);
+	votes.vote (std::make_shared<rai::vote> (key1.pub, key1.prv, 0, block1), 100);
+	ASSERT_EQ (rai::tally_result::vote, votes.vote (std::make_shared<rai::vote> (key2.pub, key2.prv, 0, block2), 30));
+	ASSERT_EQ (100, votes.totals[block1->hash ()].weight);
+	ASSERT_EQ (30, votes.totals[block2->hash ()].weight);
+	ASSERT_EQ (std::make_pair (rai::uint128_t (100), rai::uint128_t (30)), votes.top ());
+	ASSERT_EQ (*block1, *votes.leader ());
+	// Changing a vote moves the whole weight of the representative
+	ASSERT_EQ (rai::tally_result::changed, votes.vote (std::make_shared<rai::vote> (key1.pub, key1.prv, 1, block2), 100));
+	ASSERT_EQ (0, votes.totals[block1->hash ()].weight);
+	ASSERT_EQ (130, votes.totals[block2->hash ()].weight);
+	ASSERT_EQ (*block2, *votes.leader ());
+	// Weight changes are applied by delta without moving the vote
+	votes.reweigh (key2.pub, 10);
+	ASSERT_EQ (110, votes.totals[block2->hash ()].weight);
+	ASSERT_EQ (110, votes.sum);
+	ASSERT_EQ (votes.tally (), (rai::tally_t{ { 110, block2 }, { 0, block1 } }));
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <rai/node/json.hpp>
+
+namespace
+{
+std::string boost_write (boost::property_tree::ptree const & tree_a)
+{
+	std::stringstream stream;
+	boost::property_tree::write_json (stream, tree_a);
+	return stream.str ();
+}
+
+boost::property_tree::ptree boost_read (std::string const & text_a)
+{
+	boost::property_tree::ptree result;
+	std::stringstream stream (text_a);
+	boost::property_tree::read_json (stream, result);
+	return result;
+}
+}
+
+TEST (json, write_matches_boost)
+{
+	boost::property_tree::ptree tree;
+	tree.put ("account", "xrb_1111");
+	tree.put ("escapes", "/\"\\\b\f\n\r\t\x01\x7f\xc3\xa9");
+	tree.add_child ("empty", boost::property_tree::ptree ());
+	boost::property_tree::ptree entry;
+	entry.put ("type", "send");
+	entry.put ("amount", "100");
+	boost::property_tree::ptree history;
+	history.push_back (std::make_pair ("", entry));
+	history.push_back (std::make_pair ("", entry));
+	tree.add_child ("history", history);
+	boost::property_tree::ptree values;
+	boost::property_tree::ptree value;
+	value.put ("", "1");
+	values.push_back (std::make_pair ("", value));
+	values.push_back (std::make_pair ("", boost::property_tree::ptree ()));
+	tree.add_child ("values", values);
+	ASSERT_EQ (boost_write (tree), rai::json_write (tree));
+	ASSERT_EQ (boost_write (boost::property_tree::ptree ()), rai::json_write (boost::property_tree::ptree ()));
+}
+
+TEST (json, writer_matches_boost)
+{
+	rai::json_writer writer;
+	writer.value ("account", "xrb_1111");
+	writer.begin_object ("accounts");
+	writer.begin_object ("xrb_2222");
+	writer.value ("balance", "5");
+	writer.end ();
+	writer.end ();
+	writer.begin_array ("history");
+	writer.end ();
+	writer.begin_array ("blocks");
+	writer.value ("1");
+	writer.begin_object ();
+	writer.value ("hash", "2");
+	writer.end ();
+	writer.end ();
+	writer.value ("previous", "3");
+	boost::property_tree::ptree tree;
+	tree.put ("account", "xrb_1111");
+	boost::property_tree::ptree accounts;
+	accounts.put ("xrb_2222.balance", "5");
+	tree.add_child ("accounts", accounts);
+	tree.add_child ("history", boost::property_tree::ptree ());
+	boost::property_tree::ptree blocks;
+	boost::property_tree::ptree value;
+	value.put ("", "1");
+	blocks.push_back (std::make_pair ("", value));
+	boost::property_tree::ptree block;
+	block.put ("hash", "2");
+	blocks.push_back (std::make_pair ("", block));
+	tree.add_child ("blocks", blocks);
+	tree.put ("previous", "3");
+	ASSERT_EQ (boost_write (tree), writer.finish ());
+}
+
+TEST (json, read_matches_boost)
+{
+	std::string text ("{\"action\": \"send\", \"list\": [\"a\", {\"b\": 1.5e-3}, [], {}], \"flag\": true, \"none\": null, \"n\": -10, \"text\": \"\\u00e9\\ud83d\\ude00\\/\\t\", \"action\": \"dup\"}");
+	boost::property_tree::ptree tree;
+	rai::json_read (text, tree);
+	ASSERT_EQ (boost_read (text), tree);
+	ASSERT_EQ ("send", tree.get<std::string> ("action"));
+	ASSERT_EQ (7, tree.size ());
+	ASSERT_EQ (4, tree.get_child ("list").size ());
+	ASSERT_EQ ("\xc3\xa9\xf0\x9f\x98\x80/\t", tree.get<std::string> ("text"));
+}
+
+TEST (json, read_errors)
+{
+	for (auto text : { "", "{", "{\"a\": }", "{\"a\": 01}", "[1, ]", "{} x", "{\"a\": \"\x01\"}", "{\"a\": \"\\ud800\"}", "{\"a\": tru}", "{a: 1}" })
+	{
+		boost::property_tree::ptree tree;
+		ASSERT_THROW (rai::json_read (text, tree), boost::property_tree::json_parser_error) << text;
+	}
+}
+
+TEST (json, writer_sink)
+{
+	std::string streamed;
+	size_t chunks (0);
+	rai::json_writer writer ([&streamed, &chunks](std::string const & chunk_a) {
+		streamed += chunk_a;
+		++chunks;
+		return false;
+	});
+	rai::json_writer buffered;
+	for (auto i (0); i < 10000; ++i)
+	{
+		for (auto writer_l : { &writer, &buffered })
+		{
+			writer_l->begin_object (std::to_string (i));
+			writer_l->value ("balance", std::string (i % 20, 'x'));
+			writer_l->begin_array ("history");
+			writer_l->end ();
+			writer_l->end ();
+		}
+		if (writer.pending ())
+		{
+			ASSERT_FALSE (writer.send ());
+		}
+	}
+	streamed += writer.finish ();
+	ASSERT_FALSE (writer.error ());
+	ASSERT_LT (1, chunks);
+	ASSERT_EQ (buffered.finish (), streamed);
+}
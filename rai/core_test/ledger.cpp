@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 #include <rai/node/stats.hpp>
 #include <rai/node/testing.hpp>
+#include <rai/validator.hpp>
 
 // Init returns an error if it can't open files at the path
 TEST (ledger, store_error)
@@ -331,6 +332,46 @@ TEST (ledger, rollback_representation)
 	ASSERT_EQ (0, ledger.weight (transaction, key3.pub));
 }
 
+TEST (ledger, rollback_change_delegators)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::stat stats;
+	rai::ledger ledger (store, stats);
+	rai::genesis genesis;
+	rai::transaction transaction (store.environment, nullptr, true);
+	genesis.initialize (transaction, store);
+	rai::keypair key1;
+	rai::change_block change1 (genesis.hash (), key1.pub, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, change1).code);
+	rai::keypair key2;
+	rai::change_block change2 (change1.hash (), key2.pub, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, change2).code);
+	rai::account_info info;
+	ASSERT_FALSE (store.account_get (transaction, rai::test_genesis_key.pub, info));
+	auto delegators ([&store, &transaction]() {
+		std::vector<rai::delegator_key> result;
+		for (auto i (store.delegators_begin (transaction)), n (store.delegators_end ()); i != n; ++i)
+		{
+			result.push_back (rai::delegator_key (i->first));
+		}
+		return result;
+	});
+	auto delegators1 (delegators ());
+	ASSERT_EQ (1, delegators1.size ());
+	ASSERT_EQ (rai::delegator_key (key2.pub, info.open_block), delegators1[0]);
+	// Rolling back moves the entry back to the previous representative instead of leaving both
+	ledger.rollback (transaction, change2.hash ());
+	auto delegators2 (delegators ());
+	ASSERT_EQ (1, delegators2.size ());
+	ASSERT_EQ (rai::delegator_key (key1.pub, info.open_block), delegators2[0]);
+	ledger.rollback (transaction, change1.hash ());
+	auto delegators3 (delegators ());
+	ASSERT_EQ (1, delegators3.size ());
+	ASSERT_EQ (rai::delegator_key (rai::test_genesis_key.pub, info.open_block), delegators3[0]);
+}
+
 TEST (ledger, receive_rollback)
 {
 	bool init (false);
@@ -2246,3 +2287,221 @@ TEST (ledger, state_receive_change_rollback)
 	ASSERT_EQ (rai::genesis_amount - rai::Gxrb_ratio, ledger.weight (transaction, rai::genesis_account));
 	ASSERT_EQ (0, ledger.weight (transaction, rep.pub));
 }
+
+TEST (ledger, history_index)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::stat stats;
+	rai::ledger ledger (store, stats);
+	ledger.history_index = true;
+	rai::keypair key1;
+	rai::open_block open (1, key1.pub, key1.pub, key1.prv, key1.pub, 0);
+	rai::change_block change1 (open.hash (), key1.pub, key1.prv, key1.pub, 0);
+	rai::change_block change2 (change1.hash (), key1.pub, key1.prv, key1.pub, 0);
+	rai::transaction transaction (store.environment, nullptr, true);
+	store.block_put (transaction, open.hash (), open);
+	ledger.change_latest (transaction, key1.pub, rai::chain_token_type, open.hash (), open.hash (), 10, 1);
+	store.block_put (transaction, change1.hash (), change1);
+	ledger.change_latest (transaction, key1.pub, rai::chain_token_type, change1.hash (), change1.hash (), 10, 2);
+	store.block_put (transaction, change2.hash (), change2);
+	ledger.change_latest (transaction, key1.pub, rai::chain_token_type, change2.hash (), change2.hash (), 10, 3);
+	rai::block_hash hash;
+	ASSERT_FALSE (store.history_get (transaction, rai::history_key (open.hash (), 2), hash));
+	ASSERT_EQ (change1.hash (), hash);
+	rai::history_key position (0, 0);
+	ASSERT_FALSE (store.block_height_get (transaction, change2.hash (), position));
+	ASSERT_EQ (rai::history_key (open.hash (), 3), position);
+	ASSERT_EQ (3, position.height ());
+	// Moving the head back drops the old head from the index
+	ledger.change_latest (transaction, key1.pub, rai::chain_token_type, change1.hash (), change1.hash (), 10, 2);
+	ASSERT_TRUE (store.history_get (transaction, rai::history_key (open.hash (), 3), hash));
+	ASSERT_TRUE (store.block_height_get (transaction, change2.hash (), position));
+	ASSERT_FALSE (store.history_indexed (transaction));
+	store.history_build (transaction);
+	ASSERT_TRUE (store.history_indexed (transaction));
+	ASSERT_FALSE (store.history_get (transaction, rai::history_key (open.hash (), 1), hash));
+	ASSERT_EQ (open.hash (), hash);
+	ASSERT_FALSE (store.block_height_get (transaction, change1.hash (), position));
+	ASSERT_EQ (2, position.height ());
+	store.history_clear (transaction);
+	ASSERT_FALSE (store.history_indexed (transaction));
+	ASSERT_TRUE (store.history_get (transaction, rai::history_key (open.hash (), 1), hash));
+}
+
+TEST (ledger, confirmation_height)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::stat stats;
+	rai::ledger ledger (store, stats);
+	rai::keypair key1;
+	rai::open_block open (1, key1.pub, key1.pub, key1.prv, key1.pub, 0);
+	rai::change_block change1 (open.hash (), key1.pub, key1.prv, key1.pub, 0);
+	rai::change_block change2 (change1.hash (), key1.pub, key1.prv, key1.pub, 0);
+	rai::transaction transaction (store.environment, nullptr, true);
+	store.block_put (transaction, open.hash (), open);
+	ledger.change_latest (transaction, key1.pub, rai::chain_token_type, open.hash (), open.hash (), 10, 1);
+	store.block_put (transaction, change1.hash (), change1);
+	ledger.change_latest (transaction, key1.pub, rai::chain_token_type, change1.hash (), change1.hash (), 10, 2);
+	store.block_put (transaction, change2.hash (), change2);
+	ledger.change_latest (transaction, key1.pub, rai::chain_token_type, change2.hash (), change2.hash (), 10, 3);
+	ASSERT_EQ (1, ledger.height (transaction, open.hash ()));
+	ASSERT_EQ (3, ledger.height (transaction, change2.hash ()));
+	ASSERT_EQ (0, store.confirmed_height_get (transaction, open.hash ()));
+	ASSERT_FALSE (ledger.block_confirmed (transaction, open.hash ()));
+	ledger.confirm (transaction, change1.hash ());
+	ASSERT_EQ (2, store.confirmed_height_get (transaction, open.hash ()));
+	ASSERT_TRUE (ledger.block_confirmed (transaction, open.hash ()));
+	ASSERT_TRUE (ledger.block_confirmed (transaction, change1.hash ()));
+	ASSERT_FALSE (ledger.block_confirmed (transaction, change2.hash ()));
+	// Confirming an ancestor never lowers the marker
+	ledger.confirm (transaction, open.hash ());
+	ASSERT_EQ (2, store.confirmed_height_get (transaction, open.hash ()));
+	// Rolling back unconfirmed blocks leaves it alone, rolling back confirmed ones lowers it
+	ledger.change_latest (transaction, key1.pub, rai::chain_token_type, change1.hash (), change1.hash (), 10, 2);
+	ASSERT_EQ (0, ledger.height (transaction, change2.hash ()));
+	ASSERT_EQ (2, store.confirmed_height_get (transaction, open.hash ()));
+	ledger.change_latest (transaction, key1.pub, rai::chain_token_type, open.hash (), open.hash (), 10, 1);
+	ASSERT_EQ (1, store.confirmed_height_get (transaction, open.hash ()));
+	ASSERT_FALSE (ledger.block_confirmed (transaction, change1.hash ()));
+	// Heights survive history index rebuilds and can be rebuilt from the account chains
+	store.history_build (transaction);
+	store.history_clear (transaction);
+	ASSERT_EQ (1, ledger.height (transaction, open.hash ()));
+	store.block_heights_build (transaction);
+	ASSERT_EQ (1, ledger.height (transaction, open.hash ()));
+}
+
+TEST (ledger, pruning)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::stat stats;
+	rai::ledger ledger (store, stats);
+	rai::keypair key1;
+	rai::transaction transaction (store.environment, nullptr, true);
+	std::vector<rai::state_block> blocks;
+	rai::block_hash previous (0);
+	for (uint64_t height (1); height <= 5; ++height)
+	{
+		rai::amount balance (height == 1 ? 10 : 9);
+		rai::uint256_union link (height <= 2 ? height : 0);
+		blocks.push_back (rai::state_block (key1.pub, previous, key1.pub, balance, link, rai::chain_token_type, key1.prv, key1.pub, 0));
+		previous = blocks.back ().hash ();
+		store.block_put (transaction, previous, blocks.back ());
+		ledger.change_latest (transaction, key1.pub, rai::chain_token_type, previous, previous, balance, height, true);
+	}
+	auto token_account (blocks[0].hash ());
+	// Nothing is confirmed yet
+	ASSERT_EQ (0, ledger.prune (transaction, token_account, 1));
+	ledger.confirm (transaction, blocks[3].hash ());
+	ASSERT_EQ (3, ledger.prune (transaction, token_account, 1));
+	ASSERT_FALSE (store.block_exists (transaction, blocks[0].hash ()));
+	ASSERT_TRUE (store.pruned_exists (transaction, blocks[0].hash ()));
+	ASSERT_TRUE (ledger.block_or_pruned_exists (transaction, blocks[1].hash ()));
+	ASSERT_TRUE (ledger.block_confirmed (transaction, blocks[1].hash ()));
+	ASSERT_TRUE (store.block_exists (transaction, blocks[3].hash ()));
+	ASSERT_FALSE (ledger.block_confirmed (transaction, blocks[4].hash ()));
+	ASSERT_EQ (3, store.pruned_count (transaction));
+	ASSERT_EQ (4, ledger.height (transaction, blocks[3].hash ()));
+	// Balances of the kept blocks end on the anchor left on the newest pruned block
+	rai::block_info anchor;
+	ASSERT_FALSE (store.block_info_get (transaction, blocks[2].hash (), anchor));
+	ASSERT_EQ (rai::amount (9), anchor.balance);
+	ASSERT_EQ (9, ledger.balance (transaction, blocks[3].hash ()));
+	ASSERT_EQ (0, ledger.amount (transaction, blocks[3].hash ()));
+	ASSERT_EQ (rai::process_result::old, ledger.process (transaction, blocks[1]).code);
+	ASSERT_EQ (0, ledger.prune (transaction, token_account, 1));
+	// The next pass moves the anchor up, the head is never pruned
+	ledger.confirm (transaction, blocks[4].hash ());
+	ASSERT_EQ (1, ledger.prune (transaction, token_account, 0));
+	ASSERT_TRUE (store.block_info_get (transaction, blocks[2].hash (), anchor));
+	ASSERT_FALSE (store.block_info_get (transaction, blocks[3].hash (), anchor));
+	ASSERT_TRUE (store.block_exists (transaction, blocks[4].hash ()));
+	ASSERT_EQ (9, ledger.balance (transaction, blocks[4].hash ()));
+	ASSERT_EQ (0, ledger.amount (transaction, blocks[4].hash ()));
+}
+
+TEST (ledger, rollback_pruned_source)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::stat stats;
+	rai::ledger ledger (store, stats);
+	rai::keypair key1;
+	rai::keypair key2;
+	rai::transaction transaction (store.environment, nullptr, true);
+	rai::state_block send (key1.pub, 0, key1.pub, 5, key2.pub, rai::chain_token_type, key1.prv, key1.pub, 0);
+	store.block_put (transaction, send.hash (), send);
+	ledger.change_latest (transaction, key1.pub, rai::chain_token_type, send.hash (), send.hash (), 5, 1, true);
+	rai::state_block receive (key2.pub, 0, key2.pub, 5, send.hash (), rai::chain_token_type, key2.prv, key2.pub, 0);
+	store.block_put (transaction, receive.hash (), receive);
+	ledger.change_latest (transaction, key2.pub, rai::chain_token_type, receive.hash (), receive.hash (), 5, 1, true);
+	// As pruning leaves it, only the hash of the send and its account are kept
+	store.block_del (transaction, send.hash ());
+	store.pruned_put (transaction, send.hash (), key1.pub);
+	ledger.rollback (transaction, receive.hash ());
+	ASSERT_FALSE (store.block_exists (transaction, receive.hash ()));
+	rai::pending_info pending;
+	ASSERT_FALSE (store.pending_get (transaction, rai::pending_key (key2.pub, send.hash ()), pending));
+	ASSERT_EQ (key1.pub, pending.source);
+	ASSERT_EQ (5, pending.amount.number ());
+	rai::account_info info;
+	ASSERT_TRUE (store.accounts_get (transaction, key2.pub, rai::chain_token_type, info));
+}
+
+TEST (ledger, validate)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::stat stats;
+	rai::ledger ledger (store, stats);
+	rai::keypair key1;
+	std::vector<rai::state_block> blocks;
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		rai::block_hash previous (0);
+		for (uint64_t height (1); height <= 3; ++height)
+		{
+			blocks.push_back (rai::state_block (key1.pub, previous, key1.pub, 10, 0, rai::chain_token_type, key1.prv, key1.pub, 0));
+			previous = blocks.back ().hash ();
+			store.block_put (transaction, previous, blocks.back ());
+			ledger.change_latest (transaction, key1.pub, rai::chain_token_type, previous, previous, 10, height, true);
+		}
+		store.representation_put (transaction, key1.pub, 10);
+		// A pruned chain ends on the balance anchor of its newest pruned block
+		rai::keypair key2;
+		std::vector<rai::block_hash> chain;
+		previous = 0;
+		for (uint64_t height (1); height <= 4; ++height)
+		{
+			rai::state_block block (key2.pub, previous, key2.pub, 5, 0, rai::chain_token_type, key2.prv, key2.pub, 0);
+			previous = block.hash ();
+			chain.push_back (previous);
+			store.block_put (transaction, previous, block);
+			ledger.change_latest (transaction, key2.pub, rai::chain_token_type, previous, previous, 5, height, true);
+		}
+		store.representation_put (transaction, key2.pub, 5);
+		ledger.confirm (transaction, previous);
+		ASSERT_EQ (3, ledger.prune (transaction, chain[0], 0));
+	}
+	rai::ledger_validator validator (ledger);
+	ASSERT_FALSE (validator.validate (4));
+	ASSERT_TRUE (validator.errors.empty ());
+	ASSERT_EQ (2, validator.accounts);
+	ASSERT_EQ (4, validator.blocks);
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.representation_put (transaction, key1.pub, 11);
+		store.block_height_del (transaction, blocks[1].hash ());
+	}
+	ASSERT_TRUE (validator.validate (4));
+	ASSERT_EQ (2, validator.errors.size ());
+	ASSERT_EQ (2, validator.errors_total);
+}
@@ -86,3 +86,26 @@ TEST (message, confirm_ack_serialization)
 	ASSERT_FALSE (error);
 	ASSERT_EQ (con1, con2);
 }
+
+TEST (message, pooled_buffer)
+{
+	rai::publish publish (std::unique_ptr<rai::block> (new rai::send_block (0, 1, 2, rai::keypair ().prv, 4, 5)));
+	std::vector<uint8_t> bytes;
+	{
+		rai::vectorstream stream (bytes);
+		publish.serialize (stream);
+	}
+	auto buffer (rai::message_buffers ().serialize (publish));
+	ASSERT_EQ (bytes, std::vector<uint8_t> (buffer->data (), buffer->data () + buffer->size ()));
+	// Writes past the fixed area move the message to the spill vector
+	rai::message_buffer large;
+	std::vector<uint8_t> data (rai::message_buffer::capacity + 1, 0x5a);
+	{
+		rai::message_stream stream (large);
+		rai::write (stream, data[0]);
+		stream.sputn (data.data (), data.size ());
+	}
+	ASSERT_EQ (data.size () + 1, large.size ());
+	ASSERT_FALSE (large.spill.empty ());
+	ASSERT_EQ (0x5a, large.data ()[large.size () - 1]);
+}
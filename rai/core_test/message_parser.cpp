@@ -11,6 +11,7 @@ public:
 	publish_count (0),
 	confirm_req_count (0),
 	confirm_ack_count (0),
+	confirm_req_batch_count (0),
 	bulk_pull_count (0),
 	bulk_pull_blocks_count (0),
 	bulk_push_count (0),
@@ -33,6 +34,10 @@ public:
 	{
 		++confirm_ack_count;
 	}
+	void confirm_req_batch (rai::confirm_req_batch const &)
+	{
+		++confirm_req_batch_count;
+	}
 	void bulk_pull (rai::bulk_pull const &)
 	{
 		++bulk_pull_count;
@@ -66,6 +71,7 @@ public:
 	uint64_t publish_count;
 	uint64_t confirm_req_count;
 	uint64_t confirm_ack_count;
+	uint64_t confirm_req_batch_count;
 	uint64_t bulk_pull_count;
 	uint64_t bulk_pull_blocks_count;
 	uint64_t bulk_push_count;
@@ -134,6 +140,39 @@ TEST (message_parser, exact_confirm_req_size)
 	ASSERT_NE (parser.status, rai::message_parser::parse_status::success);
 }
 
+TEST (message_parser, exact_confirm_req_batch_size)
+{
+	rai::system system (24000, 1);
+	test_visitor visitor;
+	rai::message_parser parser (visitor, system.work);
+	rai::confirm_req_batch message;
+	for (auto i (0); i < rai::confirm_req_batch::max_requests; ++i)
+	{
+		message.requests.push_back (std::make_pair (rai::block_hash (i), rai::block_hash (i + 1)));
+	}
+	std::vector<uint8_t> bytes;
+	{
+		rai::vectorstream stream (bytes);
+		message.serialize (stream);
+	}
+	ASSERT_GE (512, bytes.size ());
+	ASSERT_EQ (0, visitor.confirm_req_batch_count);
+	auto error (false);
+	rai::bufferstream stream1 (bytes.data (), bytes.size ());
+	rai::message_header header1 (error, stream1);
+	ASSERT_FALSE (error);
+	parser.deserialize_confirm_req_batch (stream1, header1);
+	ASSERT_EQ (1, visitor.confirm_req_batch_count);
+	ASSERT_EQ (parser.status, rai::message_parser::parse_status::success);
+	bytes.push_back (0);
+	rai::bufferstream stream2 (bytes.data (), bytes.size ());
+	rai::message_header header2 (error, stream2);
+	ASSERT_FALSE (error);
+	parser.deserialize_confirm_req_batch (stream2, header2);
+	ASSERT_EQ (1, visitor.confirm_req_batch_count);
+	ASSERT_NE (parser.status, rai::message_parser::parse_status::success);
+}
+
 TEST (message_parser, exact_publish_size)
 {
 	rai::system system (24000, 1);
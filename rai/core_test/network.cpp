@@ -234,6 +234,107 @@ TEST (network, send_valid_publish)
 	ASSERT_EQ (50, system.nodes[1]->balance (rai::test_genesis_key.pub));
 }
 
+TEST (confirm_req_batcher, full_batch)
+{
+	rai::system system (24000, 2);
+	auto & node1 (*system.nodes[0]);
+	auto endpoint (system.nodes[1]->network.endpoint ());
+	for (auto i (0); i < rai::confirm_req_batch::max_requests; ++i)
+	{
+		node1.confirm_req_batcher.add (endpoint, std::make_shared<rai::send_block> (i, 0, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	}
+	// A full batch goes out without waiting for the window
+	ASSERT_EQ (1, node1.stats.count (rai::stat::type::message, rai::stat::detail::confirm_req_batch, rai::stat::dir::out));
+	ASSERT_TRUE (node1.confirm_req_batcher.requests.empty ());
+	auto iterations (0);
+	while (system.nodes[1]->stats.count (rai::stat::type::message, rai::stat::detail::confirm_req_batch, rai::stat::dir::in) == 0)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+}
+
+TEST (confirm_req_batcher, flush)
+{
+	rai::system system (24000, 2);
+	auto & node1 (*system.nodes[0]);
+	auto endpoint (system.nodes[1]->network.endpoint ());
+	auto block1 (std::make_shared<rai::send_block> (1, 0, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	auto block2 (std::make_shared<rai::send_block> (2, 0, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	{
+		std::lock_guard<std::mutex> lock (node1.confirm_req_batcher.mutex);
+		node1.confirm_req_batcher.flush_scheduled = true;
+	}
+	node1.confirm_req_batcher.add (endpoint, block1);
+	node1.confirm_req_batcher.add (endpoint, block1);
+	node1.confirm_req_batcher.add (endpoint, block2);
+	ASSERT_EQ (0, node1.stats.count (rai::stat::type::message, rai::stat::detail::confirm_req_batch, rai::stat::dir::out));
+	{
+		std::lock_guard<std::mutex> lock (node1.confirm_req_batcher.mutex);
+		ASSERT_EQ (1, node1.confirm_req_batcher.requests.size ());
+		ASSERT_EQ (2, node1.confirm_req_batcher.requests[endpoint].requests.size ());
+	}
+	node1.confirm_req_batcher.flush ();
+	ASSERT_EQ (1, node1.stats.count (rai::stat::type::message, rai::stat::detail::confirm_req_batch, rai::stat::dir::out));
+	ASSERT_TRUE (node1.confirm_req_batcher.requests.empty ());
+	ASSERT_FALSE (node1.confirm_req_batcher.flush_scheduled);
+}
+
+TEST (network, confirm_req_batch_votes)
+{
+	rai::system system (24000, 2);
+	system.wallet (1)->insert_adhoc (rai::test_genesis_key.prv);
+	rai::genesis genesis;
+	rai::confirm_req_batch message;
+	message.requests.push_back (std::make_pair (genesis.hash (), rai::test_genesis_key.pub));
+	// Nothing at this root, no vote for it
+	message.requests.push_back (std::make_pair (1, 1));
+	system.nodes[0]->network.send_confirm_req_batch (system.nodes[1]->network.endpoint (), message);
+	auto iterations (0);
+	while (system.nodes[0]->stats.count (rai::stat::type::message, rai::stat::detail::confirm_ack, rai::stat::dir::in) == 0)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+}
+
+TEST (network, confirm_req_batch_throttled)
+{
+	rai::system system (24000, 2);
+	system.wallet (1)->insert_adhoc (rai::test_genesis_key.prv);
+	// Use up the sender's allowance so the batch is dropped
+	system.nodes[1]->confirm_req_limiter.admit (system.nodes[0]->network.endpoint (), rai::confirm_req_limiter::roots_burst);
+	rai::genesis genesis;
+	rai::confirm_req_batch message;
+	message.requests.push_back (std::make_pair (genesis.hash (), rai::test_genesis_key.pub));
+	system.nodes[0]->network.send_confirm_req_batch (system.nodes[1]->network.endpoint (), message);
+	auto iterations (0);
+	while (system.nodes[1]->stats.count (rai::stat::type::error, rai::stat::detail::throttled, rai::stat::dir::in) == 0)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	ASSERT_EQ (1, system.nodes[1]->stats.count (rai::stat::type::error, rai::stat::detail::throttled, rai::stat::dir::in));
+}
+
+TEST (confirm_req_limiter, refill)
+{
+	rai::confirm_req_limiter limiter;
+	rai::endpoint endpoint (boost::asio::ip::address_v6::loopback (), 24000);
+	auto now (std::chrono::steady_clock::now ());
+	ASSERT_EQ (rai::confirm_req_limiter::roots_burst, limiter.admit (endpoint, rai::confirm_req_limiter::roots_burst + 10, now));
+	ASSERT_EQ (0, limiter.admit (endpoint, 1, now));
+	ASSERT_EQ (rai::confirm_req_limiter::roots_per_second, limiter.admit (endpoint, rai::confirm_req_limiter::roots_burst, now + std::chrono::seconds (1)));
+	// Other endpoints have their own allowance
+	rai::endpoint endpoint2 (boost::asio::ip::address_v6::loopback (), 24001);
+	ASSERT_EQ (1, limiter.admit (endpoint2, 1, now));
+	limiter.purge (now + std::chrono::seconds (2));
+	ASSERT_TRUE (limiter.allowances.empty ());
+}
+
 TEST (network, send_insufficient_work)
 {
 	rai::system system (24000, 2);
@@ -43,6 +43,47 @@ TEST (node, password_fanout)
 	node->stop ();
 }
 
+TEST (node, history_index_config)
+{
+	auto path (rai::unique_path ());
+	auto open ([&path](rai::node_config const & config_a, std::function<void(rai::node &)> const & action_a) {
+		rai::node_init init;
+		auto service (boost::make_shared<boost::asio::io_service> ());
+		rai::alarm alarm (*service);
+		rai::work_pool work (std::numeric_limits<unsigned>::max (), nullptr);
+		auto node (std::make_shared<rai::node> (init, *service, path, alarm, config_a, work));
+		ASSERT_FALSE (init.error ());
+		action_a (*node);
+		node->stop ();
+	});
+	rai::node_config config;
+	config.logging.init (path);
+	config.history_index = true;
+	open (config, [](rai::node & node_a) {
+		rai::transaction transaction (node_a.store.environment, nullptr, false);
+		ASSERT_TRUE (node_a.store.history_indexed (transaction));
+	});
+	// A default config, as CLI commands use, keeps the index and maintains it
+	{
+		rai::inactive_node node (path);
+		rai::transaction transaction (node.node->store.environment, nullptr, false);
+		ASSERT_TRUE (node.node->store.history_indexed (transaction));
+		ASSERT_TRUE (node.node->ledger.history_index);
+	}
+	// Turning it off in a config file drops it
+	boost::property_tree::ptree tree;
+	config.serialize_json (tree);
+	tree.put ("history_index", false);
+	auto upgraded (false);
+	ASSERT_FALSE (config.deserialize_json (upgraded, tree));
+	ASSERT_TRUE (config.history_index_configured);
+	open (config, [](rai::node & node_a) {
+		rai::transaction transaction (node_a.store.environment, nullptr, false);
+		ASSERT_FALSE (node_a.store.history_indexed (transaction));
+		ASSERT_FALSE (node_a.ledger.history_index);
+	});
+}
+
 TEST (node, balance)
 {
 	rai::system system (24000, 1);
@@ -517,6 +558,10 @@ TEST (node_config, serialization)
 	config1.callback_port = 10;
 	config1.callback_target = "test";
 	config1.lmdb_max_dbs = 256;
+	config1.lmdb_config.map_size = 10;
+	config1.lmdb_config.map_growth = 0;
+	config1.lmdb_config.read_ahead = false;
+	config1.lmdb_config.sync = false;
 	config1.state_block_parse_canary = 10;
 	config1.state_block_generate_canary = 10;
 	boost::property_tree::ptree tree;
@@ -536,6 +581,10 @@ TEST (node_config, serialization)
 	ASSERT_NE (config2.callback_port, config1.callback_port);
 	ASSERT_NE (config2.callback_target, config1.callback_target);
 	ASSERT_NE (config2.lmdb_max_dbs, config1.lmdb_max_dbs);
+	ASSERT_NE (config2.lmdb_config.map_size, config1.lmdb_config.map_size);
+	ASSERT_NE (config2.lmdb_config.map_growth, config1.lmdb_config.map_growth);
+	ASSERT_NE (config2.lmdb_config.read_ahead, config1.lmdb_config.read_ahead);
+	ASSERT_NE (config2.lmdb_config.sync, config1.lmdb_config.sync);
 	ASSERT_NE (config2.state_block_parse_canary, config1.state_block_parse_canary);
 	ASSERT_NE (config2.state_block_generate_canary, config1.state_block_generate_canary);
 
@@ -553,6 +602,10 @@ TEST (node_config, serialization)
 	ASSERT_EQ (config2.callback_port, config1.callback_port);
 	ASSERT_EQ (config2.callback_target, config1.callback_target);
 	ASSERT_EQ (config2.lmdb_max_dbs, config1.lmdb_max_dbs);
+	ASSERT_EQ (config2.lmdb_config.map_size, config1.lmdb_config.map_size);
+	ASSERT_EQ (config2.lmdb_config.map_growth, config1.lmdb_config.map_growth);
+	ASSERT_EQ (config2.lmdb_config.read_ahead, config1.lmdb_config.read_ahead);
+	ASSERT_EQ (config2.lmdb_config.sync, config1.lmdb_config.sync);
 	ASSERT_EQ (config2.state_block_parse_canary, config1.state_block_parse_canary);
 	ASSERT_EQ (config2.state_block_generate_canary, config1.state_block_generate_canary);
 }
@@ -637,6 +690,58 @@ TEST (node, confirm_locked)
 	system.nodes[0]->network.republish_block (transaction, block);
 }
 
+TEST (node, confirmed_height_batch)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	rai::keypair key;
+	auto send1 (system.wallet (0)->send_action (rai::test_genesis_key.pub, key.pub, rai::chain_token_type, 1));
+	ASSERT_NE (nullptr, send1);
+	auto send2 (system.wallet (0)->send_action (rai::test_genesis_key.pub, key.pub, rai::chain_token_type, 1));
+	ASSERT_NE (nullptr, send2);
+	// Queued confirmations land together in the block processor's next write transaction
+	node1.block_processor.confirm (send2->hash ());
+	node1.block_processor.confirm (send1->hash ());
+	node1.block_processor.flush ();
+	rai::transaction transaction (node1.store.environment, nullptr, false);
+	rai::account_info info;
+	ASSERT_FALSE (node1.store.account_get (transaction, rai::test_genesis_key.pub, info));
+	ASSERT_EQ (send2->hash (), info.head);
+	ASSERT_EQ (info.block_count, node1.store.confirmed_height_get (transaction, info.open_block));
+}
+
+TEST (node, pruning_cursor)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	node1.config.pruning.accounts = 1;
+	std::vector<rai::account> accounts;
+	{
+		rai::transaction transaction (node1.store.environment, nullptr, true);
+		rai::keypair key;
+		rai::keypair token_account;
+		node1.store.account_put (transaction, token_account.pub, rai::account_info (key.pub, key.pub, token_account.pub, 0, 0, 1, rai::chain_token_type, key.pub));
+		for (auto i (node1.store.latest_begin (transaction)), n (node1.store.latest_end ()); i != n; ++i)
+		{
+			accounts.push_back (i->first.uint256 ());
+		}
+	}
+	ASSERT_LE (2, accounts.size ());
+	// One account per batch, the saved position walks the accounts and wraps to the start
+	for (size_t i (1); i <= accounts.size (); ++i)
+	{
+		node1.ongoing_pruning ();
+		rai::transaction transaction (node1.store.environment, nullptr, false);
+		std::vector<uint8_t> position;
+		ASSERT_FALSE (node1.store.checkpoint_get (transaction, rai::checkpoint::pruning, position));
+		ASSERT_EQ (32, position.size ());
+		rai::account account;
+		std::copy (position.begin (), position.end (), account.bytes.begin ());
+		ASSERT_EQ (i < accounts.size () ? accounts[i] : rai::account (0), account);
+	}
+}
+
 TEST (node_config, random_rep)
 {
 	auto path (rai::unique_path ());
@@ -1017,11 +1122,7 @@ TEST (node, fork_no_vote_quorum)
 	ASSERT_FALSE (system.wallet (1)->store.fetch (rai::transaction (system.wallet (1)->store.environment, nullptr, false), key1, key3));
 	auto vote (std::make_shared<rai::vote> (key1, key3, 0, send2));
 	rai::confirm_ack confirm (vote);
-	std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-	{
-		rai::vectorstream stream (*bytes);
-		confirm.serialize (stream);
-	}
+	auto bytes (rai::message_buffers ().serialize (confirm));
 	node2.network.confirm_send (confirm, bytes, node3.network.endpoint ());
 	while (node3.stats.count (rai::stat::type::message, rai::stat::detail::confirm_ack, rai::stat::dir::in) < 3)
 	{
@@ -1644,3 +1745,32 @@ TEST (node, confirm_quorum)
 	}
 	ASSERT_EQ (0, system.nodes[0]->balance (rai::test_genesis_key.pub));
 }
+
+TEST (node, checkpoint)
+{
+	rai::system system (24000, 2);
+	auto node1 (system.nodes[0]);
+	ASSERT_EQ (1, node1->peers.size ());
+	rai::keypair key1;
+	node1->online_reps.restore ({ key1.pub }, std::chrono::seconds (0));
+	node1->checkpoint ();
+	std::vector<uint8_t> peers;
+	{
+		rai::transaction transaction (node1->store.environment, nullptr, false);
+		ASSERT_FALSE (node1->store.checkpoint_get (transaction, rai::checkpoint::peers, peers));
+	}
+	// Time written followed by one address and port
+	ASSERT_EQ (sizeof (uint64_t) + 16 + sizeof (uint16_t), peers.size ());
+	node1->online_reps.reps.clear ();
+	node1->checkpoint_load ();
+	auto reps (node1->online_reps.list ());
+	ASSERT_TRUE (std::find (reps.begin (), reps.end (), key1.pub) != reps.end ());
+	// A rep restored close to the cutoff keeps only the time it had left
+	node1->online_reps.reps.clear ();
+	node1->online_reps.restore ({ key1.pub }, rai::node::cutoff - std::chrono::seconds (1));
+	ASSERT_EQ (1, node1->online_reps.reps.size ());
+	ASSERT_GT (std::chrono::steady_clock::now () - (rai::node::cutoff - std::chrono::seconds (2)), node1->online_reps.reps.begin ()->last_heard);
+	auto phases (node1->startup.phases ());
+	ASSERT_FALSE (phases.empty ());
+	ASSERT_EQ ("start", phases.back ().first);
+}
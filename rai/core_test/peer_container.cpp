@@ -169,3 +169,23 @@ TEST (peer_container, depeer)
 	peers.contacted (endpoint0, rai::protocol_version_min - 1);
 	ASSERT_EQ (0, peers.size ());
 }
+
+TEST (peer_container, contact_snapshot)
+{
+	rai::peer_container peers (rai::endpoint{});
+	rai::endpoint endpoint1 (boost::asio::ip::address_v6::loopback (), 10000);
+	ASSERT_FALSE (peers.insert (endpoint1, rai::protocol_version));
+	ASSERT_EQ (1, peers.snapshot->peers.size ());
+	auto now (std::chrono::steady_clock::now ());
+	// Known peer, only the contact time in the snapshot is touched
+	ASSERT_TRUE (peers.insert (endpoint1, rai::protocol_version));
+	auto remaining (peers.purge_list (now));
+	ASSERT_EQ (1, remaining.size ());
+	ASSERT_EQ (1, peers.snapshot->peers.size ());
+	ASSERT_TRUE (peers.representatives (1).empty ());
+	rai::keypair key1;
+	ASSERT_TRUE (peers.rep_response (endpoint1, key1.pub, rai::amount (100)));
+	auto reps (peers.representatives (1));
+	ASSERT_EQ (1, reps.size ());
+	ASSERT_EQ (key1.pub, reps[0].probable_rep_account);
+}
@@ -290,6 +290,54 @@ TEST (rpc, send)
 	thread2.join ();
 }
 
+TEST (rpc, send_batch)
+{
+	rai::system system (24000, 1);
+	rai::rpc rpc (system.service, *system.nodes[0], rai::rpc_config (true));
+	rpc.start ();
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	rai::keypair key1;
+	rai::keypair key2;
+	boost::property_tree::ptree request;
+	std::string wallet;
+	system.nodes[0]->wallets.items.begin ()->first.encode_hex (wallet);
+	request.put ("wallet", wallet);
+	request.put ("action", "send_batch");
+	request.put ("source", rai::test_genesis_key.pub.to_account ());
+	boost::property_tree::ptree sends;
+	for (auto destination : { key1.pub, key2.pub, key1.pub })
+	{
+		boost::property_tree::ptree entry;
+		entry.put ("destination", destination.to_account ());
+		entry.put ("token", "Root_Token");
+		entry.put ("amount", "100");
+		sends.push_back (std::make_pair ("", entry));
+	}
+	// Repeating an id returns the block created for it the first time
+	sends.front ().second.put ("id", "payout1");
+	sends.back ().second.put ("id", "payout1");
+	request.add_child ("sends", sends);
+	test_response response (request, rpc, system.service);
+	while (response.status == 0)
+	{
+		system.poll ();
+	}
+	ASSERT_EQ (200, response.status);
+	std::vector<rai::block_hash> blocks;
+	for (auto & entry : response.json.get_child ("blocks"))
+	{
+		rai::block_hash block;
+		ASSERT_FALSE (block.decode_hex (entry.second.get<std::string> ("block")));
+		ASSERT_TRUE (system.nodes[0]->ledger.block_exists (block));
+		blocks.push_back (block);
+	}
+	ASSERT_EQ (3, blocks.size ());
+	ASSERT_NE (blocks[0], blocks[1]);
+	ASSERT_EQ (blocks[0], blocks[2]);
+	ASSERT_EQ (system.nodes[0]->latest (rai::test_genesis_key.pub), blocks[1]);
+	ASSERT_EQ (rai::genesis_amount - 200, system.nodes[0]->balance (rai::test_genesis_key.pub));
+}
+
 TEST (rpc, send_fail)
 {
 	rai::system system (24000, 1);
@@ -1508,6 +1556,11 @@ TEST (rpc_config, serialization)
 	config1.enable_control = true;
 	config1.frontier_request_limit = 8192;
 	config1.chain_request_limit = 4096;
+	config1.keepalive_timeout = 5;
+	config1.keepalive_request_limit = 100;
+	config1.handler_threads = 3;
+	config1.expensive_action_limit = 5;
+	config1.action_limits["ledger"] = 1;
 	boost::property_tree::ptree tree;
 	config1.serialize_json (tree);
 	rai::rpc_config config2;
@@ -1516,12 +1569,22 @@ TEST (rpc_config, serialization)
 	ASSERT_NE (config2.enable_control, config1.enable_control);
 	ASSERT_NE (config2.frontier_request_limit, config1.frontier_request_limit);
 	ASSERT_NE (config2.chain_request_limit, config1.chain_request_limit);
+	ASSERT_NE (config2.keepalive_timeout, config1.keepalive_timeout);
+	ASSERT_NE (config2.keepalive_request_limit, config1.keepalive_request_limit);
+	ASSERT_NE (config2.handler_threads, config1.handler_threads);
+	ASSERT_NE (config2.expensive_action_limit, config1.expensive_action_limit);
+	ASSERT_NE (config2.action_limits, config1.action_limits);
 	config2.deserialize_json (tree);
 	ASSERT_EQ (config2.address, config1.address);
 	ASSERT_EQ (config2.port, config1.port);
 	ASSERT_EQ (config2.enable_control, config1.enable_control);
 	ASSERT_EQ (config2.frontier_request_limit, config1.frontier_request_limit);
 	ASSERT_EQ (config2.chain_request_limit, config1.chain_request_limit);
+	ASSERT_EQ (config2.keepalive_timeout, config1.keepalive_timeout);
+	ASSERT_EQ (config2.keepalive_request_limit, config1.keepalive_request_limit);
+	ASSERT_EQ (config2.handler_threads, config1.handler_threads);
+	ASSERT_EQ (config2.expensive_action_limit, config1.expensive_action_limit);
+	ASSERT_EQ (config2.action_limits, config1.action_limits);
 }
 
 TEST (rpc, search_pending)
@@ -1753,6 +1816,152 @@ TEST (rpc, block_count)
 	ASSERT_EQ ("0", response1.json.get<std::string> ("unchecked"));
 }
 
+TEST (rpc, keepalive_pipelined)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::rpc_config config (true);
+	config.keepalive_request_limit = 3;
+	rai::rpc rpc (system.service, node1, config);
+	rpc.start ();
+	std::atomic<bool> done (false);
+	std::vector<bool> keep_alive;
+	std::vector<std::string> counts;
+	std::thread client ([&rpc, &done, &keep_alive, &counts]() {
+		boost::asio::io_service service;
+		boost::asio::ip::tcp::socket socket (service);
+		socket.connect (rai::tcp_endpoint (boost::asio::ip::address_v6::loopback (), rpc.config.port));
+		// All requests are written before any response is read, the server answers them in order over one connection
+		for (auto i (0); i < 3; ++i)
+		{
+			boost::beast::http::request<boost::beast::http::string_body> req (boost::beast::http::verb::post, "/", 11);
+			req.body () = "{\"action\": \"block_count\"}";
+			req.prepare_payload ();
+			boost::beast::http::write (socket, req);
+		}
+		boost::beast::flat_buffer buffer;
+		for (auto i (0); i < 3; ++i)
+		{
+			boost::beast::http::response<boost::beast::http::string_body> res;
+			boost::beast::http::read (socket, buffer, res);
+			keep_alive.push_back (res.keep_alive ());
+			std::stringstream body (res.body ());
+			boost::property_tree::ptree json;
+			boost::property_tree::read_json (body, json);
+			counts.push_back (json.get<std::string> ("count"));
+		}
+		done = true;
+	});
+	auto iterations (0);
+	while (!done)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	client.join ();
+	ASSERT_EQ (3, counts.size ());
+	ASSERT_TRUE (keep_alive[0]);
+	ASSERT_TRUE (keep_alive[1]);
+	// The request limit closes the connection after the third response
+	ASSERT_FALSE (keep_alive[2]);
+}
+
+TEST (rpc, keepalive_idle_timeout)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::rpc_config config (true);
+	config.keepalive_timeout = 1;
+	rai::rpc rpc (system.service, node1, config);
+	rpc.start ();
+	std::atomic<bool> done (false);
+	boost::system::error_code idle_error;
+	std::string count;
+	std::thread client ([&rpc, &done, &idle_error, &count]() {
+		boost::asio::io_service service;
+		boost::asio::ip::tcp::socket socket (service);
+		socket.connect (rai::tcp_endpoint (boost::asio::ip::address_v6::loopback (), rpc.config.port));
+		boost::beast::http::request<boost::beast::http::string_body> req (boost::beast::http::verb::post, "/", 11);
+		req.body () = "{\"action\": \"block_count\"}";
+		req.prepare_payload ();
+		boost::beast::http::write (socket, req);
+		boost::beast::flat_buffer buffer;
+		boost::beast::http::response<boost::beast::http::string_body> res;
+		boost::beast::http::read (socket, buffer, res);
+		std::stringstream body (res.body ());
+		boost::property_tree::ptree json;
+		boost::property_tree::read_json (body, json);
+		count = json.get<std::string> ("count");
+		// No second request, the server closes the kept alive connection once the timeout passes
+		boost::beast::http::response<boost::beast::http::string_body> res2;
+		boost::beast::http::read (socket, buffer, res2, idle_error);
+		done = true;
+	});
+	auto deadline (std::chrono::steady_clock::now () + std::chrono::seconds (10));
+	while (!done)
+	{
+		system.poll ();
+		ASSERT_LT (std::chrono::steady_clock::now (), deadline);
+	}
+	client.join ();
+	ASSERT_FALSE (count.empty ());
+	ASSERT_EQ (boost::beast::http::error::end_of_stream, idle_error);
+}
+
+TEST (rpc_pool, action_limit)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::rpc_pool pool (node1, 4);
+	std::mutex mutex;
+	std::condition_variable condition;
+	auto release (false);
+	std::atomic<unsigned> running (0);
+	std::atomic<unsigned> peak (0);
+	std::atomic<unsigned> finished (0);
+	std::atomic<bool> other (false);
+	for (auto i (0); i < 3; ++i)
+	{
+		pool.add ("ledger", 1, [&]() {
+			auto now (++running);
+			if (now > peak)
+			{
+				peak = now;
+			}
+			std::unique_lock<std::mutex> lock (mutex);
+			condition.wait (lock, [&release]() { return release; });
+			--running;
+			++finished;
+		});
+	}
+	pool.add ("block_count", 0, [&other]() { other = true; });
+	// The cheap action goes ahead of the ledger requests waiting on their limit
+	auto iterations (0);
+	while (!other)
+	{
+		std::this_thread::sleep_for (std::chrono::milliseconds (10));
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	ASSERT_EQ (2, pool.size ());
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		release = true;
+	}
+	condition.notify_all ();
+	iterations = 0;
+	while (finished < 3)
+	{
+		std::this_thread::sleep_for (std::chrono::milliseconds (10));
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	ASSERT_EQ (1, peak);
+	ASSERT_EQ (4, node1.stats.count (rai::stat::type::rpc, rai::stat::detail::queued));
+	ASSERT_EQ (4, node1.stats.count (rai::stat::type::rpc, rai::stat::detail::executed));
+}
+
 TEST (rpc, frontier_count)
 {
 	rai::system system (24000, 1);
@@ -3203,6 +3412,291 @@ TEST (rpc, ledger)
 	}
 }
 
+TEST (rpc, ledger_cursor)
+{
+	rai::system system (24000, 1);
+	rai::keypair key;
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	auto & node1 (*system.nodes[0]);
+	auto latest (node1.latest (rai::test_genesis_key.pub));
+	rai::send_block send (latest, key.pub, 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, node1.work_generate_blocking (latest));
+	node1.process (send);
+	rai::open_block open (send.hash (), rai::test_genesis_key.pub, key.pub, key.prv, key.pub, node1.work_generate_blocking (key.pub));
+	ASSERT_EQ (rai::process_result::progress, node1.process (open).code);
+	rai::rpc rpc (system.service, node1, rai::rpc_config (true));
+	rpc.start ();
+	for (auto sorting : { "false", "true" })
+	{
+		// Pages of one account each, followed until no cursor comes back
+		std::unordered_set<std::string> accounts;
+		boost::optional<std::string> cursor;
+		auto pages (0);
+		do
+		{
+			boost::property_tree::ptree request;
+			request.put ("action", "ledger");
+			request.put ("sorting", sorting);
+			request.put ("count", "1");
+			if (cursor)
+			{
+				request.put ("cursor", *cursor);
+			}
+			test_response response (request, rpc, system.service);
+			while (response.status == 0)
+			{
+				system.poll ();
+			}
+			ASSERT_EQ (200, response.status);
+			ASSERT_FALSE (response.json.get_optional<std::string> ("error").is_initialized ());
+			for (auto & account : response.json.get_child ("accounts"))
+			{
+				ASSERT_TRUE (accounts.insert (account.first).second);
+			}
+			cursor = response.json.get_optional<std::string> ("cursor");
+			++pages;
+			ASSERT_LT (pages, 4);
+		} while (cursor);
+		ASSERT_EQ (2, accounts.size ());
+		ASSERT_NE (accounts.end (), accounts.find (key.pub.to_account ()));
+		ASSERT_NE (accounts.end (), accounts.find (rai::test_genesis_key.pub.to_account ()));
+	}
+	boost::property_tree::ptree request;
+	request.put ("action", "ledger");
+	request.put ("cursor", "xyz");
+	test_response response (request, rpc, system.service);
+	while (response.status == 0)
+	{
+		system.poll ();
+	}
+	ASSERT_EQ ("Invalid cursor", response.json.get<std::string> ("error"));
+}
+
+TEST (rpc, frontiers_cursor)
+{
+	rai::system system (24000, 1);
+	rai::keypair key;
+	auto & node1 (*system.nodes[0]);
+	auto latest (node1.latest (rai::test_genesis_key.pub));
+	rai::send_block send (latest, key.pub, 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, node1.work_generate_blocking (latest));
+	node1.process (send);
+	rai::open_block open (send.hash (), rai::test_genesis_key.pub, key.pub, key.prv, key.pub, node1.work_generate_blocking (key.pub));
+	ASSERT_EQ (rai::process_result::progress, node1.process (open).code);
+	rai::rpc rpc (system.service, node1, rai::rpc_config (true));
+	rpc.start ();
+	std::unordered_set<std::string> accounts;
+	boost::optional<std::string> cursor;
+	auto pages (0);
+	do
+	{
+		boost::property_tree::ptree request;
+		request.put ("action", "frontiers");
+		request.put ("count", "1");
+		if (cursor)
+		{
+			request.put ("cursor", *cursor);
+		}
+		else
+		{
+			request.put ("account", rai::account (0).to_account ());
+		}
+		test_response response (request, rpc, system.service);
+		while (response.status == 0)
+		{
+			system.poll ();
+		}
+		ASSERT_EQ (200, response.status);
+		ASSERT_FALSE (response.json.get_optional<std::string> ("error").is_initialized ());
+		for (auto & account : response.json.get_child ("frontiers"))
+		{
+			ASSERT_TRUE (accounts.insert (account.first).second);
+		}
+		cursor = response.json.get_optional<std::string> ("cursor");
+		++pages;
+		ASSERT_LT (pages, 4);
+	} while (cursor);
+	ASSERT_EQ (2, accounts.size ());
+	ASSERT_NE (accounts.end (), accounts.find (key.pub.to_account ()));
+}
+
+TEST (rpc, delegators_cursor)
+{
+	rai::system system (24000, 1);
+	rai::keypair key;
+	auto & node1 (*system.nodes[0]);
+	auto latest (node1.latest (rai::test_genesis_key.pub));
+	rai::send_block send (latest, key.pub, 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, node1.work_generate_blocking (latest));
+	node1.process (send);
+	rai::open_block open (send.hash (), rai::test_genesis_key.pub, key.pub, key.prv, key.pub, node1.work_generate_blocking (key.pub));
+	ASSERT_EQ (rai::process_result::progress, node1.process (open).code);
+	rai::rpc rpc (system.service, node1, rai::rpc_config (true));
+	rpc.start ();
+	std::unordered_set<std::string> delegators;
+	boost::optional<std::string> cursor;
+	auto pages (0);
+	do
+	{
+		boost::property_tree::ptree request;
+		request.put ("action", "delegators");
+		request.put ("account", rai::test_genesis_key.pub.to_account ());
+		request.put ("count", "1");
+		if (cursor)
+		{
+			request.put ("cursor", *cursor);
+		}
+		test_response response (request, rpc, system.service);
+		while (response.status == 0)
+		{
+			system.poll ();
+		}
+		ASSERT_EQ (200, response.status);
+		ASSERT_FALSE (response.json.get_optional<std::string> ("error").is_initialized ());
+		for (auto & delegator : response.json.get_child ("delegators"))
+		{
+			ASSERT_TRUE (delegators.insert (delegator.first).second);
+		}
+		cursor = response.json.get_optional<std::string> ("cursor");
+		++pages;
+		ASSERT_LT (pages, 4);
+	} while (cursor);
+	ASSERT_EQ (2, delegators.size ());
+	ASSERT_NE (delegators.end (), delegators.find (key.pub.to_account ()));
+	ASSERT_NE (delegators.end (), delegators.find (rai::test_genesis_key.pub.to_account ()));
+}
+
+TEST (rpc, unchecked_keys_cursor)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::keypair key;
+	rai::block_hash dependency1 (1);
+	rai::block_hash dependency2 (2);
+	auto send1 (std::make_shared<rai::send_block> (dependency1, key.pub, 1, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	auto send2 (std::make_shared<rai::send_block> (dependency1, key.pub, 2, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	auto send3 (std::make_shared<rai::send_block> (dependency2, key.pub, 3, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	{
+		rai::transaction transaction (node1.store.environment, nullptr, true);
+		// Two blocks under the same key so a page boundary falls inside a key
+		node1.store.unchecked_put (transaction, dependency1, send1);
+		node1.store.unchecked_put (transaction, dependency1, send2);
+		node1.store.unchecked_put (transaction, dependency2, send3);
+	}
+	rai::rpc rpc (system.service, node1, rai::rpc_config (true));
+	rpc.start ();
+	std::unordered_set<std::string> hashes;
+	boost::optional<std::string> cursor;
+	auto pages (0);
+	do
+	{
+		boost::property_tree::ptree request;
+		request.put ("action", "unchecked_keys");
+		request.put ("count", "1");
+		if (cursor)
+		{
+			request.put ("cursor", *cursor);
+		}
+		test_response response (request, rpc, system.service);
+		while (response.status == 0)
+		{
+			system.poll ();
+		}
+		ASSERT_EQ (200, response.status);
+		ASSERT_FALSE (response.json.get_optional<std::string> ("error").is_initialized ());
+		for (auto & entry : response.json.get_child ("unchecked"))
+		{
+			ASSERT_TRUE (hashes.insert (entry.second.get<std::string> ("hash")).second);
+		}
+		cursor = response.json.get_optional<std::string> ("cursor");
+		++pages;
+		ASSERT_LT (pages, 5);
+	} while (cursor);
+	ASSERT_EQ (3, hashes.size ());
+	ASSERT_NE (hashes.end (), hashes.find (send1->hash ().to_string ()));
+	ASSERT_NE (hashes.end (), hashes.find (send2->hash ().to_string ()));
+	ASSERT_NE (hashes.end (), hashes.find (send3->hash ().to_string ()));
+}
+
+TEST (rpc, account_history_cursor)
+{
+	rai::system system (24000, 1);
+	rai::keypair key;
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	auto & node1 (*system.nodes[0]);
+	auto send1 (system.wallet (0)->send_action (rai::test_genesis_key.pub, key.pub, rai::chain_token_type, 1));
+	ASSERT_NE (nullptr, send1);
+	auto send2 (system.wallet (0)->send_action (rai::test_genesis_key.pub, key.pub, rai::chain_token_type, 2));
+	ASSERT_NE (nullptr, send2);
+	rai::rpc rpc (system.service, node1, rai::rpc_config (true));
+	rpc.start ();
+	std::vector<std::string> hashes;
+	boost::optional<std::string> cursor;
+	auto pages (0);
+	do
+	{
+		boost::property_tree::ptree request;
+		request.put ("action", "account_history");
+		request.put ("account", rai::test_genesis_key.pub.to_account ());
+		request.put ("token", "Root_Token");
+		request.put ("count", "1");
+		if (cursor)
+		{
+			request.put ("cursor", *cursor);
+		}
+		test_response response (request, rpc, system.service);
+		while (response.status == 0)
+		{
+			system.poll ();
+		}
+		ASSERT_EQ (200, response.status);
+		ASSERT_FALSE (response.json.get_optional<std::string> ("error").is_initialized ());
+		for (auto & entry : response.json.get_child ("history"))
+		{
+			hashes.push_back (entry.second.get<std::string> ("hash"));
+		}
+		cursor = response.json.get_optional<std::string> ("cursor");
+		++pages;
+		ASSERT_LT (pages, 5);
+	} while (cursor);
+	// Newest first, each block once
+	ASSERT_LE (2, hashes.size ());
+	ASSERT_EQ (send2->hash ().to_string (), hashes[0]);
+	ASSERT_EQ (send1->hash ().to_string (), hashes[1]);
+	ASSERT_EQ (hashes.size (), std::unordered_set<std::string> (hashes.begin (), hashes.end ()).size ());
+}
+
+TEST (rpc, unchecked_chunked)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::keypair key;
+	// Each listed block is several hundred bytes, enough of them to go past one 64KB chunk
+	std::unordered_set<std::string> expected;
+	{
+		rai::transaction transaction (node1.store.environment, nullptr, true);
+		for (auto i (0); i < 500; ++i)
+		{
+			auto send (std::make_shared<rai::send_block> (rai::block_hash (i + 1), key.pub, i, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+			node1.store.unchecked_put (transaction, send->previous (), send);
+			expected.insert (send->hash ().to_string ());
+		}
+	}
+	rai::rpc rpc (system.service, node1, rai::rpc_config (true));
+	rpc.start ();
+	boost::property_tree::ptree request;
+	request.put ("action", "unchecked");
+	test_response response (request, rpc, system.service);
+	while (response.status == 0)
+	{
+		system.poll ();
+	}
+	ASSERT_EQ (200, response.status);
+	std::unordered_set<std::string> hashes;
+	for (auto & block : response.json.get_child ("blocks"))
+	{
+		hashes.insert (block.first);
+	}
+	ASSERT_EQ (expected, hashes);
+}
+
 TEST (rpc, accounts_create)
 {
 	rai::system system (24000, 1);
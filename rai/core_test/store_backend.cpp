@@ -0,0 +1,358 @@
+#include <gtest/gtest.h>
+#include <rai/memory_backend.hpp>
+#include <rai/node/node.hpp>
+#include <rai/snapshot.hpp>
+
+#include <sstream>
+
+namespace
+{
+// Conformance suite, runs each test against a fresh block_store on every backend
+void each_backend (std::function<void(rai::block_store &)> const & test_a)
+{
+	{
+		SCOPED_TRACE ("lmdb");
+		bool init (false);
+		rai::block_store store (init, rai::unique_path ());
+		ASSERT_FALSE (init);
+		test_a (store);
+	}
+	{
+		SCOPED_TRACE ("memory");
+		bool init (false);
+		rai::block_store store (init, std::unique_ptr<rai::store_backend> (new rai::memory_backend));
+		ASSERT_FALSE (init);
+		test_a (store);
+	}
+}
+}
+
+TEST (store_backend, add_item)
+{
+	each_backend ([](rai::block_store & store) {
+		rai::open_block block (0, 1, 0, rai::keypair ().prv, 0, 0);
+		rai::uint256_union hash1 (block.hash ());
+		rai::transaction transaction (store.backend, nullptr, true);
+		ASSERT_EQ (nullptr, store.block_get (transaction, hash1));
+		ASSERT_FALSE (store.block_exists (transaction, hash1));
+		store.block_put (transaction, hash1, block);
+		auto latest2 (store.block_get (transaction, hash1));
+		ASSERT_NE (nullptr, latest2);
+		ASSERT_EQ (block, *latest2);
+		ASSERT_TRUE (store.block_exists (transaction, hash1));
+		ASSERT_FALSE (store.block_exists (transaction, hash1.number () - 1));
+		ASSERT_EQ (1, store.block_count (transaction).sum ());
+		store.block_del (transaction, hash1);
+		ASSERT_EQ (nullptr, store.block_get (transaction, hash1));
+		ASSERT_EQ (0, store.block_count (transaction).sum ());
+	});
+}
+
+TEST (store_backend, block_successor)
+{
+	each_backend ([](rai::block_store & store) {
+		rai::keypair key1;
+		rai::open_block open (0, 1, key1.pub, key1.prv, key1.pub, 0);
+		rai::change_block change (open.hash (), 2, key1.prv, key1.pub, 0);
+		rai::transaction transaction (store.backend, nullptr, true);
+		store.block_put (transaction, open.hash (), open);
+		store.block_put (transaction, change.hash (), change);
+		ASSERT_EQ (change.hash (), store.block_successor (transaction, open.hash ()));
+		store.block_successor_clear (transaction, open.hash ());
+		ASSERT_TRUE (store.block_successor (transaction, open.hash ()).is_zero ());
+	});
+}
+
+TEST (store_backend, block_view)
+{
+	each_backend ([](rai::block_store & store) {
+		rai::keypair key1;
+		rai::open_block open (1, 2, key1.pub, key1.prv, key1.pub, 0);
+		rai::send_block send (open.hash (), 3, 4, key1.prv, key1.pub, 0);
+		rai::receive_block receive (send.hash (), 5, key1.prv, key1.pub, 0);
+		rai::change_block change (receive.hash (), 6, key1.prv, key1.pub, 0);
+		rai::state_block state (key1.pub, change.hash (), 7, 8, 9, rai::chain_token_type, key1.prv, key1.pub, 10);
+		rai::transaction transaction (store.backend, nullptr, true);
+		ASSERT_FALSE (store.block_view_get (transaction, open.hash ()).exists ());
+		std::vector<rai::block const *> blocks{ &open, &send, &receive, &change, &state };
+		for (auto block : blocks)
+		{
+			store.block_put (transaction, block->hash (), *block);
+		}
+		for (auto block : blocks)
+		{
+			auto view (store.block_view_get (transaction, block->hash ()));
+			ASSERT_TRUE (view.exists ());
+			ASSERT_EQ (block->hash (), view.hash);
+			ASSERT_EQ (block->type (), view.type);
+			ASSERT_EQ (block->previous (), view.previous ());
+			ASSERT_EQ (block->representative (), view.representative ());
+			ASSERT_EQ (store.block_successor (transaction, block->hash ()), view.successor ());
+			ASSERT_EQ (*block, *view.block ());
+		}
+		ASSERT_EQ (rai::block_hash (1), store.block_view_get (transaction, open.hash ()).source ());
+		ASSERT_EQ (key1.pub, store.block_view_get (transaction, open.hash ()).account ());
+		ASSERT_EQ (rai::amount (4), store.block_view_get (transaction, send.hash ()).balance ());
+		ASSERT_EQ (rai::block_hash (5), store.block_view_get (transaction, receive.hash ()).source ());
+		auto state_view (store.block_view_get (transaction, state.hash ()));
+		ASSERT_EQ (key1.pub, state_view.account ());
+		ASSERT_EQ (rai::amount (8), state_view.balance ());
+		ASSERT_EQ (rai::uint256_union (9), state_view.link ());
+		ASSERT_EQ (rai::chain_token_type, state_view.token_hash ());
+		ASSERT_TRUE (state_view.source ().is_zero ());
+	});
+}
+
+TEST (store_backend, pending)
+{
+	each_backend ([](rai::block_store & store) {
+		rai::transaction transaction (store.backend, nullptr, true);
+		ASSERT_EQ (store.pending_end (), store.pending_begin (transaction));
+		store.pending_put (transaction, rai::pending_key (1, 3), { 4, 5, rai::chain_token_type });
+		store.pending_put (transaction, rai::pending_key (1, 2), { 2, 3, rai::chain_token_type });
+		auto current (store.pending_begin (transaction));
+		ASSERT_NE (store.pending_end (), current);
+		ASSERT_EQ (rai::pending_key (1, 2), rai::pending_key (current->first));
+		rai::pending_info pending (current->second);
+		ASSERT_EQ (rai::account (2), pending.source);
+		ASSERT_EQ (rai::amount (3), pending.amount);
+		++current;
+		ASSERT_EQ (rai::pending_key (1, 3), rai::pending_key (current->first));
+		++current;
+		ASSERT_EQ (store.pending_end (), current);
+		ASSERT_TRUE (store.pending_exists (transaction, rai::pending_key (1, 3)));
+		store.pending_del (transaction, rai::pending_key (1, 3));
+		ASSERT_FALSE (store.pending_exists (transaction, rai::pending_key (1, 3)));
+		ASSERT_TRUE (store.pending_exists (transaction, rai::pending_key (1, 2)));
+	});
+}
+
+TEST (store_backend, unchecked_duplicates)
+{
+	each_backend ([](rai::block_store & store) {
+		auto block1 (std::make_shared<rai::send_block> (4, 1, 2, rai::keypair ().prv, 4, 5));
+		auto block2 (std::make_shared<rai::send_block> (4, 1, 3, rai::keypair ().prv, 4, 5));
+		rai::transaction transaction (store.backend, nullptr, true);
+		ASSERT_TRUE (store.unchecked_get (transaction, block1->previous ()).empty ());
+		store.unchecked_put (transaction, block1->previous (), block1);
+		store.unchecked_put (transaction, block1->previous (), block1);
+		store.unchecked_put (transaction, block2->previous (), block2);
+		store.flush (transaction);
+		ASSERT_EQ (2, store.unchecked_get (transaction, block1->previous ()).size ());
+		ASSERT_EQ (2, store.unchecked_count (transaction));
+		store.unchecked_del (transaction, block1->previous (), *block1);
+		auto remaining (store.unchecked_get (transaction, block1->previous ()));
+		ASSERT_EQ (1, remaining.size ());
+		ASSERT_EQ (*block2, *remaining[0]);
+		store.unchecked_clear (transaction);
+		ASSERT_EQ (store.unchecked_end (), store.unchecked_begin (transaction));
+	});
+}
+
+TEST (store_backend, checksum)
+{
+	each_backend ([](rai::block_store & store) {
+		rai::block_hash hash0 (0);
+		rai::transaction transaction (store.backend, nullptr, true);
+		ASSERT_TRUE (store.checksum_get (transaction, 0x100, 0x10, hash0));
+		rai::block_hash hash1 (5);
+		store.checksum_put (transaction, 0x100, 0x10, hash1);
+		rai::block_hash hash2;
+		ASSERT_FALSE (store.checksum_get (transaction, 0x100, 0x10, hash2));
+		ASSERT_EQ (hash1, hash2);
+		store.checksum_del (transaction, 0x100, 0x10);
+		ASSERT_TRUE (store.checksum_get (transaction, 0x100, 0x10, hash2));
+	});
+}
+
+TEST (store_backend, latest_find)
+{
+	each_backend ([](rai::block_store & store) {
+		rai::transaction transaction (store.backend, nullptr, true);
+		ASSERT_EQ (store.latest_end (), store.latest_begin (transaction));
+		store.account_put (transaction, 1, { 2, 1, 2, 100, 0, 300, rai::chain_token_type, 5 });
+		store.account_put (transaction, 3, { 4, 3, 4, 200, 0, 400, rai::chain_token_type, 6 });
+		ASSERT_EQ (2, store.account_count (transaction));
+		auto first (store.latest_begin (transaction));
+		auto second (store.latest_begin (transaction));
+		++second;
+		ASSERT_EQ (first, store.latest_begin (transaction, 1));
+		ASSERT_EQ (second, store.latest_begin (transaction, 3));
+		ASSERT_EQ (second, store.latest_begin (transaction, 2));
+		ASSERT_EQ (store.latest_end (), store.latest_begin (transaction, 4));
+		// Replacing a value in place leaves iteration order alone
+		store.account_put (transaction, 1, { 7, 1, 2, 50, 0, 300, rai::chain_token_type, 5 });
+		rai::account_info info;
+		ASSERT_FALSE (store.account_get (transaction, 1, info));
+		ASSERT_EQ (rai::block_hash (7), info.head);
+		ASSERT_EQ (2, store.account_count (transaction));
+		store.account_del (transaction, 1);
+		ASSERT_TRUE (store.account_get (transaction, 1, info));
+		ASSERT_EQ (rai::account (3), rai::account (store.latest_begin (transaction)->first.uint256 ()));
+	});
+}
+
+TEST (store_backend, delegators)
+{
+	each_backend ([](rai::block_store & store) {
+		rai::keypair key1;
+		rai::keypair rep1;
+		rai::open_block open (0, rep1.pub, key1.pub, key1.prv, key1.pub, 0);
+		rai::transaction transaction (store.backend, nullptr, true);
+		store.block_put (transaction, open.hash (), open);
+		store.account_put (transaction, open.hash (), { open.hash (), open.hash (), open.hash (), 10, 0, 1, rai::chain_token_type, key1.pub });
+		auto i (store.delegators_begin (transaction, rai::delegator_key (rep1.pub, 0)));
+		ASSERT_NE (store.delegators_end (), i);
+		ASSERT_EQ (rai::delegator_key (rep1.pub, open.hash ()), rai::delegator_key (i->first));
+		store.account_del (transaction, open.hash ());
+		ASSERT_EQ (store.delegators_end (), store.delegators_begin (transaction));
+	});
+}
+
+TEST (store_backend, bulk_load)
+{
+	each_backend ([](rai::block_store & store) {
+		rai::transaction transaction (store.backend, nullptr, true);
+		store.block_info_put (transaction, 5, rai::block_info (5, 5));
+		{
+			rai::bulk_load bulk (store.backend, transaction, 4);
+			for (auto i : { 9, 3, 7, 8, 6, 7 })
+			{
+				bulk.put (store.blocks_info, rai::mdb_val (rai::block_hash (i)), rai::block_info (i, i).val ());
+			}
+		}
+		std::vector<rai::block_hash> hashes;
+		for (auto i (store.block_info_begin (transaction)), n (store.block_info_end ()); i != n; ++i)
+		{
+			hashes.push_back (i->first.uint256 ());
+		}
+		ASSERT_EQ (std::vector<rai::block_hash> ({ 3, 5, 6, 7, 8, 9 }), hashes);
+	});
+}
+
+TEST (store_backend, cursor)
+{
+	each_backend ([](rai::block_store & store) {
+		rai::transaction transaction (store.backend, nullptr, true);
+		MDB_dbi table;
+		ASSERT_EQ (0, store.backend.open (transaction, "conformance", MDB_CREATE | MDB_DUPSORT, &table));
+		unsigned flags;
+		ASSERT_EQ (0, store.backend.flags (transaction, table, &flags));
+		ASSERT_NE (0, flags & MDB_DUPSORT);
+		ASSERT_EQ (0, store.backend.put (transaction, table, rai::mdb_val (rai::uint256_union (2)), rai::mdb_val (rai::uint256_union (20)), 0));
+		ASSERT_EQ (0, store.backend.put (transaction, table, rai::mdb_val (rai::uint256_union (2)), rai::mdb_val (rai::uint256_union (10)), 0));
+		ASSERT_EQ (0, store.backend.put (transaction, table, rai::mdb_val (rai::uint256_union (4)), rai::mdb_val (rai::uint256_union (30)), 0));
+		ASSERT_EQ (MDB_KEYEXIST, store.backend.put (transaction, table, rai::mdb_val (rai::uint256_union (2)), rai::mdb_val (rai::uint256_union (40)), MDB_APPENDDUP));
+		MDB_stat stats;
+		ASSERT_EQ (0, store.backend.stat (transaction, table, &stats));
+		ASSERT_EQ (3, stats.ms_entries);
+		rai::mdb_val value;
+		ASSERT_EQ (0, store.backend.get (transaction, table, rai::mdb_val (rai::uint256_union (2)), value));
+		ASSERT_EQ (rai::uint256_union (10), value.uint256 ());
+		ASSERT_EQ (MDB_NOTFOUND, store.backend.get (transaction, table, rai::mdb_val (rai::uint256_union (3)), value));
+		auto cursor (store.backend.cursor (transaction, table));
+		rai::uint256_union search (3);
+		rai::mdb_val key (search);
+		ASSERT_EQ (0, cursor->get (key, value, MDB_SET_RANGE));
+		ASSERT_EQ (rai::uint256_union (4), key.uint256 ());
+		ASSERT_EQ (MDB_NOTFOUND, cursor->get (key, value, MDB_NEXT));
+		ASSERT_EQ (0, cursor->get (key, value, MDB_FIRST));
+		ASSERT_EQ (rai::uint256_union (10), value.uint256 ());
+		ASSERT_EQ (0, cursor->get (key, value, MDB_NEXT_DUP));
+		ASSERT_EQ (rai::uint256_union (20), value.uint256 ());
+		ASSERT_EQ (MDB_NOTFOUND, cursor->get (key, value, MDB_NEXT_DUP));
+		ASSERT_EQ (0, cursor->get (key, value, MDB_LAST));
+		ASSERT_EQ (rai::uint256_union (30), value.uint256 ());
+		ASSERT_EQ (0, store.backend.del (transaction, table, rai::mdb_val (rai::uint256_union (2)), rai::mdb_val (rai::uint256_union (10))));
+		ASSERT_EQ (0, store.backend.get (transaction, table, rai::mdb_val (rai::uint256_union (2)), value));
+		ASSERT_EQ (rai::uint256_union (20), value.uint256 ());
+		ASSERT_EQ (0, store.backend.del (transaction, table, rai::mdb_val (rai::uint256_union (2)), nullptr));
+		ASSERT_EQ (MDB_NOTFOUND, store.backend.del (transaction, table, rai::mdb_val (rai::uint256_union (2)), nullptr));
+		ASSERT_EQ (0, store.backend.drop (transaction, table, 0));
+		ASSERT_EQ (0, store.backend.stat (transaction, table, &stats));
+		ASSERT_EQ (0, stats.ms_entries);
+	});
+}
+
+TEST (store_backend, snapshot_to_memory)
+{
+	bool init (false);
+	rai::block_store store1 (init, rai::unique_path ());
+	ASSERT_FALSE (init);
+	rai::keypair key1;
+	rai::open_block open (0, key1.pub, key1.pub, key1.prv, key1.pub, 0);
+	std::stringstream stream;
+	{
+		rai::transaction transaction (store1.backend, nullptr, true);
+		store1.block_put (transaction, open.hash (), open);
+		store1.account_put (transaction, open.hash (), { open.hash (), open.hash (), open.hash (), 100, 0, 1, rai::chain_token_type, key1.pub });
+		rai::ledger_snapshot snapshot (store1);
+		ASSERT_FALSE (snapshot.write (transaction, stream));
+	}
+	rai::block_store store2 (init, std::unique_ptr<rai::store_backend> (new rai::memory_backend));
+	ASSERT_FALSE (init);
+	rai::ledger_snapshot snapshot2 (store2);
+	ASSERT_FALSE (snapshot2.read (stream));
+	rai::transaction transaction (store2.backend, nullptr, false);
+	auto block (store2.block_get (transaction, open.hash ()));
+	ASSERT_NE (nullptr, block);
+	ASSERT_EQ (open, *block);
+	rai::account_info info;
+	ASSERT_FALSE (store2.account_get (transaction, open.hash (), info));
+	ASSERT_EQ (rai::amount (100), info.balance);
+}
+
+TEST (store_backend, memory_transactions)
+{
+	bool init (false);
+	rai::block_store lmdb (init, rai::unique_path ());
+	ASSERT_FALSE (init);
+	auto backend (new rai::memory_backend);
+	rai::block_store store (init, std::unique_ptr<rai::store_backend> (backend));
+	ASSERT_FALSE (init);
+	// Only the backend is usable, the node's LMDB environment stays closed
+	ASSERT_EQ (backend, &store.backend);
+	ASSERT_EQ (nullptr, store.environment.environment);
+	rai::keypair key1;
+	rai::open_block open (0, key1.pub, key1.pub, key1.prv, key1.pub, 0);
+	{
+		rai::transaction transaction (store.backend, nullptr, true);
+		ASSERT_NE (nullptr, backend->state (transaction));
+		ASSERT_TRUE (backend->state (transaction)->write);
+		store.block_put (transaction, open.hash (), open);
+	}
+	ASSERT_TRUE (backend->transactions.empty ());
+	{
+		rai::transaction transaction (store.backend, nullptr, false);
+		ASSERT_FALSE (backend->state (transaction)->write);
+		ASSERT_TRUE (store.block_exists (transaction, open.hash ()));
+		// Handles from another backend aren't mistaken for its own
+		rai::transaction other (lmdb.backend, nullptr, false);
+		ASSERT_EQ (nullptr, backend->state (other));
+	}
+}
+
+TEST (store_backend, ledger_rollback)
+{
+	each_backend ([](rai::block_store & store) {
+		rai::stat stats;
+		rai::ledger ledger (store, stats);
+		rai::keypair key1;
+		rai::keypair key2;
+		rai::transaction transaction (store.backend, nullptr, true);
+		rai::state_block send (key1.pub, 0, key1.pub, 5, key2.pub, rai::chain_token_type, key1.prv, key1.pub, 0);
+		store.block_put (transaction, send.hash (), send);
+		ledger.change_latest (transaction, key1.pub, rai::chain_token_type, send.hash (), send.hash (), 5, 1, true);
+		rai::state_block receive (key2.pub, 0, key2.pub, 5, send.hash (), rai::chain_token_type, key2.prv, key2.pub, 0);
+		store.block_put (transaction, receive.hash (), receive);
+		ledger.change_latest (transaction, key2.pub, rai::chain_token_type, receive.hash (), receive.hash (), 5, 1, true);
+		ledger.rollback (transaction, receive.hash ());
+		ASSERT_FALSE (store.block_exists (transaction, receive.hash ()));
+		rai::pending_info pending;
+		ASSERT_FALSE (store.pending_get (transaction, rai::pending_key (key2.pub, send.hash ()), pending));
+		ASSERT_EQ (key1.pub, pending.source);
+		ASSERT_EQ (5, pending.amount.number ());
+		rai::account_info info;
+		ASSERT_TRUE (store.accounts_get (transaction, key2.pub, rai::chain_token_type, info));
+	});
+}
@@ -183,6 +183,49 @@ TEST (wallet, send_async)
 	ASSERT_TRUE (success);
 }
 
+TEST (wallet, send_batch_missing_block)
+{
+	rai::system system (24000, 1);
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	rai::keypair key2;
+	std::string id ("payout1");
+	{
+		// An id recorded for a block that never reached the ledger
+		rai::transaction transaction (system.nodes[0]->store.environment, nullptr, true);
+		ASSERT_EQ (0, mdb_put (transaction, system.nodes[0]->wallets.send_action_ids, rai::mdb_val (id.size (), const_cast<char *> (id.data ())), rai::mdb_val (rai::block_hash (1)), 0));
+	}
+	std::vector<rai::send_batch_entry> entries (1);
+	entries[0].destination = key2.pub;
+	entries[0].token = rai::chain_token_type;
+	entries[0].amount = 100;
+	entries[0].id = id;
+	auto blocks (system.wallet (0)->send_batch_action (rai::test_genesis_key.pub, entries));
+	ASSERT_EQ (1, blocks.size ());
+	ASSERT_NE (nullptr, blocks[0]);
+	ASSERT_TRUE (system.nodes[0]->ledger.block_exists (blocks[0]->hash ()));
+	ASSERT_EQ (rai::genesis_amount - 100, system.nodes[0]->balance (rai::test_genesis_key.pub));
+	// The id now refers to the new block
+	auto blocks2 (system.wallet (0)->send_batch_action (rai::test_genesis_key.pub, entries));
+	ASSERT_EQ (blocks[0]->hash (), blocks2[0]->hash ());
+	ASSERT_EQ (rai::genesis_amount - 100, system.nodes[0]->balance (rai::test_genesis_key.pub));
+}
+
+TEST (wallet, send_batch_max)
+{
+	rai::system system (24000, 1);
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	rai::keypair key2;
+	rai::send_batch_entry entry;
+	entry.destination = key2.pub;
+	entry.token = rai::chain_token_type;
+	entry.amount = 1;
+	std::vector<rai::send_batch_entry> entries (rai::wallet::send_batch_max + 1, entry);
+	auto blocks (system.wallet (0)->send_batch_action (rai::test_genesis_key.pub, entries));
+	ASSERT_EQ (entries.size (), blocks.size ());
+	ASSERT_TRUE (std::all_of (blocks.begin (), blocks.end (), [](std::shared_ptr<rai::block> const & block_a) { return block_a == nullptr; }));
+	ASSERT_EQ (rai::genesis_amount, system.nodes[0]->balance (rai::test_genesis_key.pub));
+}
+
 TEST (wallet, spend)
 {
 	rai::system system (24000, 1);
@@ -619,6 +662,38 @@ TEST (wallet, work)
 	}
 }
 
+// Test a send finds its work precomputed and the new frontier is cached again
+TEST (wallet, work_cache_hit)
+{
+	rai::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	auto wallet (system.wallet (0));
+	wallet->insert_adhoc (rai::test_genesis_key.prv);
+	auto cached ([&node, &wallet]() {
+		rai::transaction transaction (node.store.environment, nullptr, false);
+		uint64_t work (0);
+		return !wallet->store.work_get (transaction, rai::test_genesis_key.pub, work) && !rai::work_validate (node.ledger.latest_root (transaction, rai::test_genesis_key.pub), work);
+	});
+	auto iterations1 (0);
+	while (!cached ())
+	{
+		system.poll ();
+		++iterations1;
+		ASSERT_LT (iterations1, 200);
+	}
+	rai::keypair key;
+	ASSERT_NE (nullptr, wallet->send_action (rai::test_genesis_key.pub, key.pub, rai::chain_token_type, 100));
+	ASSERT_EQ (1, node.stats.count (rai::stat::type::work_cache, rai::stat::detail::hit));
+	ASSERT_EQ (0, node.stats.count (rai::stat::type::work_cache, rai::stat::detail::miss));
+	auto iterations2 (0);
+	while (!cached ())
+	{
+		system.poll ();
+		++iterations2;
+		ASSERT_LT (iterations2, 200);
+	}
+}
+
 TEST (wallet, work_generate)
 {
 	rai::system system (24000, 1);
@@ -93,3 +93,90 @@ TEST (wallets, wallet_create_max)
 	auto existing = wallets.items.find (key.pub);
 	ASSERT_TRUE (existing == wallets.items.end ());
 }
+
+TEST (wallets, representatives_cached)
+{
+	rai::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	system.wallet (0)->insert_adhoc (rai::keypair ().prv);
+	ASSERT_TRUE (node.wallets.representatives.empty ());
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	ASSERT_EQ (1, node.wallets.representatives.size ());
+	ASSERT_NE (node.wallets.representatives.end (), node.wallets.representatives.find (rai::test_genesis_key.pub));
+	size_t count (0);
+	{
+		rai::transaction transaction (node.store.environment, nullptr, false);
+		node.wallets.foreach_representative (transaction, [&count](rai::public_key const & pub_a, rai::raw_key const &) {
+			ASSERT_EQ (rai::test_genesis_key.pub, pub_a);
+			++count;
+		});
+	}
+	ASSERT_EQ (1, count);
+	system.wallet (0)->store.password.value_set (rai::keypair ().prv);
+	{
+		rai::transaction transaction (node.store.environment, nullptr, false);
+		node.wallets.foreach_representative (transaction, [&count](rai::public_key const &, rai::raw_key const &) {
+			++count;
+		});
+	}
+	ASSERT_EQ (1, count);
+	ASSERT_FALSE (node.wallets.representatives.find (rai::test_genesis_key.pub)->second.decrypted);
+}
+
+TEST (wallets, representative_keys_clear)
+{
+	rai::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	{
+		rai::transaction transaction (node.store.environment, nullptr, false);
+		node.wallets.foreach_representative (transaction, [](rai::public_key const &, rai::raw_key const &) {});
+	}
+	auto & representative (node.wallets.representatives.find (rai::test_genesis_key.pub)->second);
+	ASSERT_TRUE (representative.decrypted);
+	// Locking drops the decrypted key straight away rather than at the next vote
+	node.wallets.representative_keys_clear (*system.wallet (0));
+	ASSERT_FALSE (representative.decrypted);
+	ASSERT_TRUE (representative.prv.data.is_zero ());
+}
+
+TEST (wallets, action_account_ordering)
+{
+	rai::system system (24000, 1);
+	auto & wallets (system.nodes[0]->wallets);
+	rai::keypair key1;
+	rai::keypair key2;
+	std::promise<void> release;
+	auto released (release.get_future ().share ());
+	std::atomic<int> first (0);
+	std::atomic<int> second (0);
+	std::atomic<int> other (0);
+	wallets.queue_wallet_action (rai::wallets::high_priority, key1.pub, [&first, released]() {
+		++first;
+		released.wait ();
+	});
+	wallets.queue_wallet_action (rai::wallets::high_priority, key1.pub, [&first, &second]() {
+		second = first.load ();
+	});
+	wallets.queue_wallet_action (rai::wallets::high_priority, key2.pub, [&other]() {
+		++other;
+	});
+	auto iterations (0);
+	while (other == 0)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	// The second action for key1 waits behind the first even with idle threads
+	ASSERT_EQ (0, second);
+	release.set_value ();
+	iterations = 0;
+	while (second == 0)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	ASSERT_EQ (1, second);
+}
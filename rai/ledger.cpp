@@ -16,6 +16,21 @@ public:
 	ledger (ledger_a)
 	{
 	}
+	// The pruned table keeps the sending account of each pruned block for the pending entry a receive gives back
+	rai::account sender (rai::block_hash const & source_a)
+	{
+		rai::account result (0);
+		if (ledger.store.block_exists (transaction, source_a))
+		{
+			result = ledger.account (transaction, source_a);
+		}
+		else
+		{
+			auto error (ledger.store.pruned_get (transaction, source_a, result));
+			assert (!error);
+		}
+		return result;
+	}
 	virtual ~rollback_visitor () = default;
 	void send_block (rai::send_block const & block_a) override
 	{
@@ -46,12 +61,13 @@ public:
 	{
 		auto hash (block_a.hash ());
 		auto representative (ledger.representative (transaction, block_a.hashables.previous));
-		auto amount (ledger.amount (transaction, block_a.hashables.source));
 		auto destination_account (ledger.account (transaction, hash));
-		auto source_account (ledger.account (transaction, block_a.hashables.source));
+		auto source_account (sender (block_a.hashables.source));
 		rai::account_info info;
 		auto error (ledger.store.account_get (transaction, destination_account, info));
 		assert (!error);
+		// This block is the head, its balance less the previous one is the amount even when the source is pruned
+		auto amount (info.balance.number () - ledger.balance (transaction, block_a.hashables.previous));
 		ledger.store.representation_add (transaction, ledger.representative (transaction, hash), 0 - amount);
 		ledger.change_latest (transaction, destination_account, rai::chain_token_type, block_a.hashables.previous, representative, ledger.balance (transaction, block_a.hashables.previous), info.block_count - 1);
 		ledger.store.block_del (transaction, hash);
@@ -68,9 +84,12 @@ public:
 	void open_block (rai::open_block const & block_a) override
 	{
 		auto hash (block_a.hash ());
-		auto amount (ledger.amount (transaction, block_a.hashables.source));
 		auto destination_account (ledger.account (transaction, hash));
-		auto source_account (ledger.account (transaction, block_a.hashables.source));
+		auto source_account (sender (block_a.hashables.source));
+		rai::account_info info;
+		auto error (ledger.store.account_get (transaction, destination_account, info));
+		assert (!error);
+		auto amount (info.balance.number ());
 		ledger.store.representation_add (transaction, ledger.representative (transaction, hash), 0 - amount);
 		ledger.change_latest (transaction, destination_account, rai::chain_token_type, 0, 0, 0, 0);
 		ledger.store.block_del (transaction, hash);
@@ -89,8 +108,9 @@ public:
 		auto balance (ledger.balance (transaction, block_a.hashables.previous));
 		ledger.store.representation_add (transaction, representative, balance);
 		ledger.store.representation_add (transaction, hash, 0 - balance);
-		ledger.store.block_del (transaction, hash);
+		// The delegators index reads the outgoing representative from this block, it has to still exist
 		ledger.change_latest (transaction, account, rai::chain_token_type, block_a.hashables.previous, representative, info.balance, info.block_count - 1);
+		ledger.store.block_del (transaction, hash);
 		ledger.store.frontier_del (transaction, hash);
 		ledger.store.frontier_put (transaction, block_a.hashables.previous, account);
 		ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
@@ -110,6 +130,15 @@ public:
 		}
 		auto balance (ledger.balance (transaction, block_a.hashables.previous));
 		auto is_send (block_a.hashables.balance < balance);
+		if (is_send)
+		{
+			// The receiving chain goes back first, before anything of this one changes
+			rai::pending_key key (block_a.hashables.link, hash);
+			while (!ledger.store.pending_exists (transaction, key))
+			{
+				ledger.rollback (transaction, ledger.latest (transaction, block_a.hashables.link, block_a.token_type ()));
+			}
+		}
 		// Add in amount delta
 		ledger.store.representation_add (transaction, hash, 0 - block_a.hashables.balance.number ());
 		if (!representative.is_zero ())
@@ -120,17 +149,12 @@ public:
 
 		if (is_send)
 		{
-			rai::pending_key key (block_a.hashables.link, hash);
-			while (!ledger.store.pending_exists (transaction, key))
-			{
-				ledger.rollback (transaction, ledger.latest (transaction, block_a.hashables.link, block_a.token_type ()));
-			}
-			ledger.store.pending_del (transaction, key);
+			ledger.store.pending_del (transaction, rai::pending_key (block_a.hashables.link, hash));
 			ledger.stats.inc (rai::stat::type::rollback, rai::stat::detail::send);
 		}
 		else if (!block_a.hashables.link.is_zero ())
 		{
-			rai::pending_info info (ledger.account (transaction, block_a.hashables.link), block_a.hashables.balance.number () - balance, rai::chain_token_type);
+			rai::pending_info info (sender (block_a.hashables.link), block_a.hashables.balance.number () - balance, rai::chain_token_type);
 			ledger.store.pending_put (transaction, rai::pending_key (block_a.hashables.account, block_a.hashables.link), info);
 			ledger.stats.inc (rai::stat::type::rollback, rai::stat::detail::receive);
 		}
@@ -192,7 +216,7 @@ void ledger_processor::state_block_impl (rai::state_block const & block_a)
 	// 检查引用的 smart contract token 是否存在
 	auto token_hash (block_a.hashables.token_hash);
 	auto const token_exist = !token_hash.is_zero () && ledger.store.block_exists (transaction, token_hash);
-	auto existing (ledger.store.block_exists (transaction, hash));
+	auto existing (ledger.block_or_pruned_exists (transaction, hash));
 	result.code = existing ? rai::process_result::old : rai::process_result::progress; // Have we seen this block before? (Unambiguous)
 	if (result.code == rai::process_result::progress)
 	{
@@ -216,7 +240,7 @@ void ledger_processor::state_block_impl (rai::state_block const & block_a)
 					if (result.code == rai::process_result::progress)
 					{
 						// 当且仅当账号存在且 token 合约存在
-						result.code = ledger.store.block_exists (transaction, block_a.hashables.previous) ? rai::process_result::progress : rai::process_result::gap_previous; // Does the previous block exist in the ledger? (Unambigious)
+						result.code = ledger.block_or_pruned_exists (transaction, block_a.hashables.previous) ? rai::process_result::progress : rai::process_result::gap_previous; // Does the previous block exist in the ledger? (Unambigious)
 						if (result.code == rai::process_result::progress)
 						{
 							result.code = token_exist ? rai::process_result::progress : rai::process_result::gap_smart_contract;
@@ -250,7 +274,7 @@ void ledger_processor::state_block_impl (rai::state_block const & block_a)
 					{
 						if (!block_a.hashables.link.is_zero ()) // open or receive
 						{
-							result.code = ledger.store.block_exists (transaction, block_a.hashables.link) ? rai::process_result::progress : rai::process_result::gap_source; // Have we seen the source block already? (Harmless)
+							result.code = ledger.block_or_pruned_exists (transaction, block_a.hashables.link) ? rai::process_result::progress : rai::process_result::gap_source; // Have we seen the source block already? (Harmless)
 							if (result.code == rai::process_result::progress)
 							{
 								result.code = token_exist ? rai::process_result::progress : rai::process_result::gap_smart_contract;
@@ -317,7 +341,7 @@ void ledger_processor::state_block_impl (rai::state_block const & block_a)
 void ledger_processor::smart_contract_block (rai::smart_contract_block const & block_a)
 {
 	auto hash (block_a.hash ());
-	auto existing (ledger.store.block_exists (transaction, hash));
+	auto existing (ledger.block_or_pruned_exists (transaction, hash));
 	result.code = existing ? rai::process_result::old : rai::process_result::progress;
 	if (result.code == rai::process_result::progress)
 	{
@@ -347,7 +371,7 @@ void ledger_processor::smart_contract_block (rai::smart_contract_block const & b
 void ledger_processor::change_block (rai::change_block const & block_a)
 {
 	auto hash (block_a.hash ());
-	auto existing (ledger.store.block_exists (transaction, hash));
+	auto existing (ledger.block_or_pruned_exists (transaction, hash));
 	result.code = existing ? rai::process_result::old : rai::process_result::progress; // Have we seen this block before? (Harmless)
 	if (result.code == rai::process_result::progress)
 	{
@@ -389,7 +413,7 @@ void ledger_processor::change_block (rai::change_block const & block_a)
 void ledger_processor::send_block (rai::send_block const & block_a)
 {
 	auto hash (block_a.hash ());
-	auto existing (ledger.store.block_exists (transaction, hash));
+	auto existing (ledger.block_or_pruned_exists (transaction, hash));
 	result.code = existing ? rai::process_result::old : rai::process_result::progress; // Have we seen this block before? (Harmless)
 	if (result.code == rai::process_result::progress)
 	{
@@ -436,7 +460,7 @@ void ledger_processor::send_block (rai::send_block const & block_a)
 void ledger_processor::receive_block (rai::receive_block const & block_a)
 {
 	auto hash (block_a.hash ());
-	auto existing (ledger.store.block_exists (transaction, hash));
+	auto existing (ledger.block_or_pruned_exists (transaction, hash));
 	result.code = existing ? rai::process_result::old : rai::process_result::progress; // Have we seen this block already?  (Harmless)
 	if (result.code == rai::process_result::progress)
 	{
@@ -447,7 +471,7 @@ void ledger_processor::receive_block (rai::receive_block const & block_a)
 			result.code = block_a.valid_predecessor (*previous) ? rai::process_result::progress : rai::process_result::block_position;
 			if (result.code == rai::process_result::progress)
 			{
-				result.code = ledger.store.block_exists (transaction, block_a.hashables.source) ? rai::process_result::progress : rai::process_result::gap_source; // Have we seen the source block already? (Harmless)
+				result.code = ledger.block_or_pruned_exists (transaction, block_a.hashables.source) ? rai::process_result::progress : rai::process_result::gap_source; // Have we seen the source block already? (Harmless)
 				if (result.code == rai::process_result::progress)
 				{
 					auto account (ledger.store.frontier_get (transaction, block_a.hashables.previous));
@@ -486,7 +510,7 @@ void ledger_processor::receive_block (rai::receive_block const & block_a)
 					}
 					else
 					{
-						result.code = ledger.store.block_exists (transaction, block_a.hashables.previous) ? rai::process_result::fork : rai::process_result::gap_previous; // If we have the block but it's not the latest we have a signed fork (Malicious)
+						result.code = ledger.block_or_pruned_exists (transaction, block_a.hashables.previous) ? rai::process_result::fork : rai::process_result::gap_previous; // If we have the block but it's not the latest we have a signed fork (Malicious)
 					}
 				}
 			}
@@ -497,11 +521,11 @@ void ledger_processor::receive_block (rai::receive_block const & block_a)
 void ledger_processor::open_block (rai::open_block const & block_a)
 {
 	auto hash (block_a.hash ());
-	auto existing (ledger.store.block_exists (transaction, hash));
+	auto existing (ledger.block_or_pruned_exists (transaction, hash));
 	result.code = existing ? rai::process_result::old : rai::process_result::progress; // Have we seen this block already? (Harmless)
 	if (result.code == rai::process_result::progress)
 	{
-		auto source_missing (!ledger.store.block_exists (transaction, block_a.hashables.source));
+		auto source_missing (!ledger.block_or_pruned_exists (transaction, block_a.hashables.source));
 		result.code = source_missing ? rai::process_result::gap_source : rai::process_result::progress; // Have we seen the source block? (Harmless)
 		if (result.code == rai::process_result::progress)
 		{
@@ -561,7 +585,8 @@ bool rai::shared_ptr_block_hash::operator() (std::shared_ptr<rai::block> const &
 rai::ledger::ledger (rai::block_store & store_a, rai::stat & stat_a) :
 store (store_a),
 stats (stat_a),
-check_bootstrap_weights (true)
+check_bootstrap_weights (true),
+history_index (false)
 {
 }
 
@@ -657,7 +682,7 @@ rai::block_hash rai::ledger::representative_calculated (MDB_txn * transaction_a,
 
 bool rai::ledger::block_exists (rai::block_hash const & hash_a)
 {
-	rai::transaction transaction (store.environment, nullptr, false);
+	rai::transaction transaction (store.backend, nullptr, false);
 	auto result (store.block_exists (transaction, hash_a));
 	return result;
 }
@@ -670,7 +695,7 @@ std::string rai::ledger::block_text (char const * hash_a)
 std::string rai::ledger::block_text (rai::block_hash const & hash_a)
 {
 	std::string result;
-	rai::transaction transaction (store.environment, nullptr, false);
+	rai::transaction transaction (store.backend, nullptr, false);
 	auto block (store.block_get (transaction, hash_a));
 	if (block != nullptr)
 	{
@@ -760,6 +785,107 @@ void rai::ledger::rollback (MDB_txn * transaction_a, rai::block_hash const & blo
 	}
 }
 
+// Return the position of hash in its account chain, 0 if it isn't in the ledger
+uint64_t rai::ledger::height (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+{
+	rai::history_key position (0, 0);
+	store.block_height_get (transaction_a, hash_a, position);
+	return position.height ();
+}
+
+bool rai::ledger::block_confirmed (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+{
+	rai::history_key position (0, 0);
+	auto result (!store.block_height_get (transaction_a, hash_a, position));
+	if (result)
+	{
+		result = position.height () <= store.confirmed_height_get (transaction_a, position.account);
+	}
+	else
+	{
+		// Only confirmed blocks get pruned
+		result = store.pruned_exists (transaction_a, hash_a);
+	}
+	return result;
+}
+
+bool rai::ledger::block_or_pruned_exists (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+{
+	return store.block_exists (transaction_a, hash_a) || store.pruned_exists (transaction_a, hash_a);
+}
+
+/**
+ * Deletes the bodies of state blocks more than depth_a below the account's confirmed height, returns how many were deleted.
+ * The head and the representative block are always kept. The newest pruned block keeps a blocks_info entry with its
+ * balance so balance and amount lookups from the remaining blocks stop there.
+ */
+uint64_t rai::ledger::prune (MDB_txn * transaction_a, rai::account const & token_account_a, uint64_t depth_a)
+{
+	uint64_t result (0);
+	rai::account_info info;
+	if (!store.account_get (transaction_a, token_account_a, info))
+	{
+		auto confirmed (store.confirmed_height_get (transaction_a, token_account_a));
+		auto target (confirmed > depth_a ? confirmed - depth_a : 0);
+		target = std::min (target, info.block_count - 1);
+		auto rep_height (height (transaction_a, info.rep_block));
+		target = std::min (target, rep_height > 0 ? rep_height - 1 : 0);
+		rai::block_hash hash (0);
+		if (target > 0 && (!history_index || store.history_get (transaction_a, rai::history_key (token_account_a, target), hash)))
+		{
+			hash = info.head;
+			for (auto i (info.block_count); i > target && !hash.is_zero (); --i)
+			{
+				hash = store.block_view_get (transaction_a, hash).previous ();
+			}
+		}
+		// Views point into database pages that writes can move, fields are copied out before anything is written
+		auto block (store.block_view_get (transaction_a, hash));
+		auto prunable (block.exists () && block.type == rai::block_type::state);
+		auto previous (prunable ? block.previous () : rai::block_hash (0));
+		if (prunable)
+		{
+			store.block_info_put (transaction_a, hash, rai::block_info (info.account, balance (transaction_a, hash)));
+			auto height_l (target);
+			while (prunable)
+			{
+				store.block_del (transaction_a, hash);
+				store.block_height_del (transaction_a, hash);
+				if (history_index)
+				{
+					store.history_del (transaction_a, rai::history_key (token_account_a, height_l));
+				}
+				store.pruned_put (transaction_a, hash, info.account);
+				++result;
+				--height_l;
+				hash = previous;
+				block = store.block_view_get (transaction_a, hash);
+				prunable = block.exists () && block.type == rai::block_type::state;
+				previous = prunable ? block.previous () : rai::block_hash (0);
+				if (!block.exists () && store.pruned_exists (transaction_a, hash))
+				{
+					// Reached the previous pass, its anchor is superseded
+					store.block_info_del (transaction_a, hash);
+				}
+			}
+		}
+	}
+	return result;
+}
+
+// Confirming a block confirms everything below it in the same chain
+void rai::ledger::confirm (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+{
+	rai::history_key position (0, 0);
+	if (!store.block_height_get (transaction_a, hash_a, position))
+	{
+		if (position.height () > store.confirmed_height_get (transaction_a, position.account))
+		{
+			store.confirmed_height_put (transaction_a, position.account, position.height ());
+		}
+	}
+}
+
 // Return account containing hash
 rai::account rai::ledger::account (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
@@ -775,20 +901,19 @@ rai::account rai::ledger::account (MDB_txn * transaction_a, rai::block_hash cons
 	auto hash (hash_a);
 	rai::block_hash successor (1);
 	rai::block_info block_info;
-	std::unique_ptr<rai::block> block (store.block_get (transaction_a, hash));
-	while (!successor.is_zero () && block->type () != rai::block_type::state && store.block_info_get (transaction_a, successor, block_info))
+	auto block (store.block_view_get (transaction_a, hash));
+	while (!successor.is_zero () && block.type != rai::block_type::state && store.block_info_get (transaction_a, successor, block_info))
 	{
-		successor = store.block_successor (transaction_a, hash);
+		successor = block.successor ();
 		if (!successor.is_zero ())
 		{
 			hash = successor;
-			block = store.block_get (transaction_a, hash);
+			block = store.block_view_get (transaction_a, hash);
 		}
 	}
-	if (block->type () == rai::block_type::state)
+	if (block.type == rai::block_type::state)
 	{
-		auto state_block (dynamic_cast<rai::state_block *> (block.get ()));
-		result = state_block->hashables.account;
+		result = block.account ();
 	}
 	else if (successor.is_zero ())
 	{
@@ -809,21 +934,20 @@ rai::account rai::ledger::token_account (MDB_txn * transaction_a, rai::block_has
 	auto hash (hash_a);
 	rai::block_hash successor (1);
 	rai::block_info block_info;
-	std::unique_ptr<rai::block> block (store.block_get (transaction_a, hash));
-	while (!successor.is_zero () && block->type () != rai::block_type::state && store.block_info_get (transaction_a, successor, block_info))
+	auto block (store.block_view_get (transaction_a, hash));
+	while (!successor.is_zero () && block.type != rai::block_type::state && store.block_info_get (transaction_a, successor, block_info))
 	{
-		successor = store.block_successor (transaction_a, hash);
+		successor = block.successor ();
 		if (!successor.is_zero ())
 		{
 			hash = successor;
-			block = store.block_get (transaction_a, hash);
+			block = store.block_view_get (transaction_a, hash);
 		}
 	}
-	if (block->type () == rai::block_type::state)
+	if (block.type == rai::block_type::state)
 	{
-		auto state_block (dynamic_cast<rai::state_block *> (block.get ()));
 		rai::account_info info;
-		store.accounts_get (transaction_a, state_block->hashables.account, state_block->hashables.token_hash, info);
+		store.accounts_get (transaction_a, block.account (), block.token_hash (), info);
 		result = info.open_block;
 	}
 	else if (successor.is_zero ())
@@ -881,7 +1005,7 @@ rai::checksum rai::ledger::checksum (MDB_txn * transaction_a, rai::account const
 
 void rai::ledger::dump_account_chain (rai::account const & account_a)
 {
-	rai::transaction transaction (store.environment, nullptr, false);
+	rai::transaction transaction (store.backend, nullptr, false);
 	for (auto entry = rai::map_sc_info.begin (); entry != rai::map_sc_info.end (); ++entry)
 	{
 		auto hash (latest (transaction, account_a, entry->first));
@@ -917,6 +1041,36 @@ void rai::ledger::change_latest (MDB_txn * transaction_a, rai::account const & a
 		assert (store.block_get (transaction_a, hash_a)->previous ().is_zero ());
 		info.open_block = hash_a;
 	}
+	if (exists && block_count_a <= info.block_count)
+	{
+		// Rolling back, the old head loses its height and can't stay confirmed
+		store.block_height_del (transaction_a, info.head);
+		if (history_index)
+		{
+			store.history_del (transaction_a, rai::history_key (info.open_block, info.block_count));
+		}
+		auto confirmed (store.confirmed_height_get (transaction_a, info.open_block));
+		if (confirmed >= info.block_count)
+		{
+			if (hash_a.is_zero ())
+			{
+				store.confirmed_height_del (transaction_a, info.open_block);
+			}
+			else
+			{
+				store.confirmed_height_put (transaction_a, info.open_block, block_count_a);
+			}
+		}
+	}
+	if (!hash_a.is_zero ())
+	{
+		rai::history_key key (info.open_block, block_count_a);
+		store.block_height_put (transaction_a, hash_a, key);
+		if (history_index)
+		{
+			store.history_put (transaction_a, key, hash_a);
+		}
+	}
 	if (!hash_a.is_zero ())
 	{
 		info.head = hash_a;
@@ -13,7 +13,6 @@ public:
 	size_t operator() (std::shared_ptr<rai::block> const &) const;
 	bool operator() (std::shared_ptr<rai::block> const &, std::shared_ptr<rai::block> const &) const;
 };
-using tally_t = std::map<rai::uint128_t, std::shared_ptr<rai::block>, std::greater<rai::uint128_t>>;
 class ledger
 {
 public:
@@ -35,6 +34,11 @@ public:
 	rai::block_hash representative (MDB_txn *, rai::block_hash const &);
 	rai::block_hash representative_calculated (MDB_txn *, rai::block_hash const &);
 	bool block_exists (rai::block_hash const &);
+	uint64_t height (MDB_txn *, rai::block_hash const &);
+	bool block_confirmed (MDB_txn *, rai::block_hash const &);
+	void confirm (MDB_txn *, rai::block_hash const &);
+	bool block_or_pruned_exists (MDB_txn *, rai::block_hash const &);
+	uint64_t prune (MDB_txn *, rai::account const &, uint64_t);
 	std::string block_text (char const *);
 	std::string block_text (rai::block_hash const &);
 	bool is_send (MDB_txn *, rai::state_block const &);
@@ -52,5 +56,7 @@ public:
 	std::unordered_map<rai::account, rai::uint128_t> bootstrap_weights;
 	uint64_t bootstrap_weight_max_blocks;
 	std::atomic<bool> check_bootstrap_weights;
+	// Also maintain the store's per account history index in change_latest, block heights are always kept
+	bool history_index;
 };
 };
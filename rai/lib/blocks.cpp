@@ -1664,6 +1664,198 @@ std::unique_ptr<rai::block> rai::deserialize_block (rai::stream & stream_a, rai:
 	return result;
 }
 
+rai::block_view::block_view () :
+hash (0),
+type (rai::block_type::invalid),
+data (nullptr),
+size (0)
+{
+}
+
+rai::block_view::block_view (rai::block_hash const & hash_a, rai::block_type type_a, uint8_t const * data_a, size_t size_a) :
+hash (hash_a),
+type (type_a),
+data (data_a),
+size (size_a)
+{
+}
+
+bool rai::block_view::exists () const
+{
+	return data != nullptr;
+}
+
+template <typename T>
+T rai::block_view::field (size_t offset_a) const
+{
+	T result;
+	assert (offset_a + sizeof (result.bytes) <= size);
+	// Page memory has no alignment guarantees, copy instead of casting
+	std::copy (data + offset_a, data + offset_a + sizeof (result.bytes), result.bytes.begin ());
+	return result;
+}
+
+rai::block_hash rai::block_view::previous () const
+{
+	rai::block_hash result (0);
+	switch (type)
+	{
+		case rai::block_type::send:
+		case rai::block_type::receive:
+		case rai::block_type::change:
+			result = field<rai::block_hash> (0);
+			break;
+		case rai::block_type::state:
+			result = field<rai::block_hash> (sizeof (rai::account));
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+rai::block_hash rai::block_view::source () const
+{
+	rai::block_hash result (0);
+	switch (type)
+	{
+		case rai::block_type::receive:
+			result = field<rai::block_hash> (sizeof (rai::block_hash));
+			break;
+		case rai::block_type::open:
+			result = field<rai::block_hash> (0);
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+rai::account rai::block_view::representative () const
+{
+	rai::account result (0);
+	switch (type)
+	{
+		case rai::block_type::open:
+			result = field<rai::account> (sizeof (rai::block_hash));
+			break;
+		case rai::block_type::change:
+			result = field<rai::account> (sizeof (rai::block_hash));
+			break;
+		case rai::block_type::state:
+			result = field<rai::account> (sizeof (rai::account) + sizeof (rai::block_hash));
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+rai::amount rai::block_view::balance () const
+{
+	rai::amount result (0);
+	switch (type)
+	{
+		case rai::block_type::send:
+			result = field<rai::amount> (sizeof (rai::block_hash) + sizeof (rai::account));
+			break;
+		case rai::block_type::state:
+			result = field<rai::amount> (sizeof (rai::account) + sizeof (rai::block_hash) + sizeof (rai::account));
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+rai::uint256_union rai::block_view::link () const
+{
+	rai::uint256_union result (0);
+	if (type == rai::block_type::state)
+	{
+		result = field<rai::uint256_union> (sizeof (rai::account) + sizeof (rai::block_hash) + sizeof (rai::account) + sizeof (rai::amount));
+	}
+	return result;
+}
+
+rai::block_hash rai::block_view::token_hash () const
+{
+	rai::block_hash result (0);
+	if (type == rai::block_type::state)
+	{
+		result = field<rai::block_hash> (sizeof (rai::account) + sizeof (rai::block_hash) + sizeof (rai::account) + sizeof (rai::amount) + sizeof (rai::uint256_union));
+	}
+	return result;
+}
+
+rai::account rai::block_view::account () const
+{
+	rai::account result (0);
+	switch (type)
+	{
+		case rai::block_type::open:
+			result = field<rai::account> (sizeof (rai::block_hash) + sizeof (rai::account));
+			break;
+		case rai::block_type::state:
+		case rai::block_type::smart_contract:
+			result = field<rai::account> (0);
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+rai::block_hash rai::block_view::successor () const
+{
+	rai::block_hash result (0);
+	if (exists ())
+	{
+		result = field<rai::block_hash> (size - sizeof (rai::block_hash));
+	}
+	return result;
+}
+
+std::unique_ptr<rai::block> rai::block_view::block () const
+{
+	std::unique_ptr<rai::block> result;
+	if (exists ())
+	{
+		rai::bufferstream stream (data, size);
+		result = rai::deserialize_block (stream, type);
+		assert (result != nullptr);
+	}
+	return result;
+}
+
+void rai::block_view::visit (rai::block_view_visitor & visitor_a) const
+{
+	switch (type)
+	{
+		case rai::block_type::send:
+			visitor_a.send_block (*this);
+			break;
+		case rai::block_type::receive:
+			visitor_a.receive_block (*this);
+			break;
+		case rai::block_type::open:
+			visitor_a.open_block (*this);
+			break;
+		case rai::block_type::change:
+			visitor_a.change_block (*this);
+			break;
+		case rai::block_type::state:
+			visitor_a.state_block (*this);
+			break;
+		case rai::block_type::smart_contract:
+			visitor_a.smart_contract_block (*this);
+			break;
+		default:
+			assert (false);
+			break;
+	}
+}
+
 void rai::receive_block::visit (rai::block_visitor & visitor_a) const
 {
 	visitor_a.receive_block (*this);
@@ -391,6 +391,50 @@ public:
 	virtual void smart_contract_block (rai::smart_contract_block const &) = 0;
 	virtual ~block_visitor () = default;
 };
+class block_view_visitor;
+/**
+ * Read only access to a serialized block without deserializing it, fields are copied straight out of the referenced memory.
+ * A view from block_store::block_view_get points in to the database pages and is only valid for the lifetime of the transaction.
+ * Fields a block type doesn't have read as zero.
+ */
+class block_view
+{
+public:
+	block_view ();
+	block_view (rai::block_hash const &, rai::block_type, uint8_t const *, size_t);
+	bool exists () const;
+	rai::block_hash previous () const;
+	rai::block_hash source () const;
+	rai::account representative () const;
+	rai::amount balance () const;
+	rai::uint256_union link () const;
+	rai::block_hash token_hash () const;
+	rai::account account () const;
+	// Stored values are followed by the successor hash, only meaningful for views read from a block_store
+	rai::block_hash successor () const;
+	// Full copy for callers that need more than the accessors
+	std::unique_ptr<rai::block> block () const;
+	void visit (rai::block_view_visitor &) const;
+	rai::block_hash hash;
+	rai::block_type type;
+	uint8_t const * data;
+	size_t size;
+
+private:
+	template <typename T>
+	T field (size_t) const;
+};
+class block_view_visitor
+{
+public:
+	virtual void send_block (rai::block_view const &) = 0;
+	virtual void receive_block (rai::block_view const &) = 0;
+	virtual void open_block (rai::block_view const &) = 0;
+	virtual void change_block (rai::block_view const &) = 0;
+	virtual void state_block (rai::block_view const &) = 0;
+	virtual void smart_contract_block (rai::block_view const &) = 0;
+	virtual ~block_view_visitor () = default;
+};
 std::unique_ptr<rai::block> deserialize_block (rai::stream &);
 std::unique_ptr<rai::block> deserialize_block (rai::stream &, rai::block_type);
 std::unique_ptr<rai::block> deserialize_block_json (boost::property_tree::ptree const &);
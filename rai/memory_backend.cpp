@@ -0,0 +1,309 @@
+#include <rai/memory_backend.hpp>
+
+#include <algorithm>
+
+namespace
+{
+std::vector<uint8_t> bytes (MDB_val const * val_a)
+{
+	auto data (static_cast<uint8_t const *> (val_a->mv_data));
+	return std::vector<uint8_t> (data, data + val_a->mv_size);
+}
+
+void assign (MDB_val * val_a, std::vector<uint8_t> const & bytes_a)
+{
+	val_a->mv_size = bytes_a.size ();
+	val_a->mv_data = const_cast<uint8_t *> (bytes_a.data ());
+}
+
+/**
+ * Remembers its position as a copy of the current entry and seeks again on every move,
+ * so puts and deletes through other cursors or the backend never leave it dangling
+ */
+class memory_cursor : public rai::store_cursor
+{
+public:
+	memory_cursor (rai::memory_backend & backend_a, MDB_txn * transaction_a, MDB_dbi table_a) :
+	backend (backend_a),
+	transaction (transaction_a),
+	index (table_a),
+	table (backend_a.table_get (transaction_a, table_a, false)),
+	positioned (false)
+	{
+	}
+	int get (MDB_val * key_a, MDB_val * value_a, MDB_cursor_op op_a) override
+	{
+		auto & entries (table.entries);
+		auto result (0);
+		auto i (entries.end ());
+		switch (op_a)
+		{
+			case MDB_FIRST:
+				i = entries.begin ();
+				break;
+			case MDB_LAST:
+				if (!entries.empty ())
+				{
+					i = std::prev (entries.end ());
+				}
+				break;
+			case MDB_SET_RANGE:
+			{
+				// An empty value sorts first among a key's duplicates
+				i = entries.lower_bound (rai::memory_backend::entry{ bytes (key_a), std::vector<uint8_t> () });
+				break;
+			}
+			case MDB_GET_CURRENT:
+				if (positioned)
+				{
+					i = entries.find (current);
+				}
+				break;
+			case MDB_NEXT:
+			case MDB_NEXT_DUP:
+				if (positioned)
+				{
+					i = entries.upper_bound (current);
+					if (op_a == MDB_NEXT_DUP && i != entries.end () && i->key != current.key)
+					{
+						i = entries.end ();
+					}
+				}
+				else if (op_a == MDB_NEXT)
+				{
+					i = entries.begin ();
+				}
+				break;
+			default:
+				assert (false);
+				result = EINVAL;
+				break;
+		}
+		if (result == 0)
+		{
+			if (i != entries.end ())
+			{
+				current = *i;
+				positioned = true;
+				assign (key_a, i->key);
+				assign (value_a, i->value);
+			}
+			else
+			{
+				result = MDB_NOTFOUND;
+			}
+		}
+		return result;
+	}
+	int put (MDB_val * key_a, MDB_val * value_a, unsigned flags_a) override
+	{
+		auto result (backend.put (transaction, index, key_a, value_a, flags_a));
+		if (result == 0)
+		{
+			current = rai::memory_backend::entry{ bytes (key_a), bytes (value_a) };
+			positioned = true;
+		}
+		return result;
+	}
+	rai::memory_backend & backend;
+	MDB_txn * transaction;
+	MDB_dbi index;
+	rai::memory_backend::table & table;
+	rai::memory_backend::entry current;
+	bool positioned;
+};
+}
+
+bool rai::memory_backend::entry_compare::operator() (rai::memory_backend::entry const & lhs_a, rai::memory_backend::entry const & rhs_a) const
+{
+	return lhs_a.key < rhs_a.key || (dupsort && lhs_a.key == rhs_a.key && lhs_a.value < rhs_a.value);
+}
+
+rai::memory_backend::table::table (unsigned flags_a) :
+flags (flags_a),
+entries (rai::memory_backend::entry_compare{ (flags_a & MDB_DUPSORT) != 0 })
+{
+}
+
+rai::memory_backend::memory_backend ()
+{
+	tables.push_back (std::unique_ptr<rai::memory_backend::table> (new rai::memory_backend::table (0)));
+}
+
+MDB_txn * rai::memory_backend::begin (MDB_txn * parent_a, bool write_a)
+{
+	mutex.lock ();
+	assert (parent_a == nullptr || !write_a || state (parent_a)->write);
+	std::unique_ptr<rai::memory_backend::transaction_state> state_l (new rai::memory_backend::transaction_state{ write_a });
+	auto result (reinterpret_cast<MDB_txn *> (state_l.get ()));
+	transactions[result] = std::move (state_l);
+	return result;
+}
+
+void rai::memory_backend::commit (MDB_txn * transaction_a)
+{
+	auto erased (transactions.erase (transaction_a));
+	assert (erased == 1);
+	mutex.unlock ();
+}
+
+rai::memory_backend::transaction_state * rai::memory_backend::state (MDB_txn * transaction_a)
+{
+	std::lock_guard<std::recursive_mutex> lock (mutex);
+	rai::memory_backend::transaction_state * result (nullptr);
+	auto existing (transactions.find (transaction_a));
+	if (existing != transactions.end ())
+	{
+		result = existing->second.get ();
+	}
+	return result;
+}
+
+rai::memory_backend::table & rai::memory_backend::table_get (MDB_txn * transaction_a, MDB_dbi table_a, bool write_a)
+{
+	auto state_l (state (transaction_a));
+	assert (state_l != nullptr);
+	assert (!write_a || state_l->write);
+	assert (table_a < tables.size () && tables[table_a] != nullptr);
+	return *tables[table_a];
+}
+
+int rai::memory_backend::open (MDB_txn * transaction_a, char const * name_a, unsigned flags_a, MDB_dbi * table_a)
+{
+	auto result (0);
+	if (name_a == nullptr)
+	{
+		*table_a = 0;
+	}
+	else
+	{
+		auto existing (names.find (name_a));
+		if (existing != names.end ())
+		{
+			*table_a = existing->second;
+		}
+		else if ((flags_a & MDB_CREATE) != 0)
+		{
+			assert (state (transaction_a) != nullptr && state (transaction_a)->write);
+			*table_a = tables.size ();
+			names[name_a] = *table_a;
+			tables.push_back (std::unique_ptr<rai::memory_backend::table> (new rai::memory_backend::table (flags_a & ~MDB_CREATE)));
+		}
+		else
+		{
+			result = MDB_NOTFOUND;
+		}
+	}
+	return result;
+}
+
+int rai::memory_backend::flags (MDB_txn * transaction_a, MDB_dbi table_a, unsigned * flags_a)
+{
+	*flags_a = table_get (transaction_a, table_a, false).flags;
+	return 0;
+}
+
+int rai::memory_backend::get (MDB_txn * transaction_a, MDB_dbi table_a, MDB_val * key_a, MDB_val * value_a)
+{
+	auto & entries (table_get (transaction_a, table_a, false).entries);
+	auto result (0);
+	auto key (bytes (key_a));
+	auto existing (entries.lower_bound (rai::memory_backend::entry{ key, std::vector<uint8_t> () }));
+	if (existing != entries.end () && existing->key == key)
+	{
+		// Like LMDB, the first duplicate of the key
+		assign (value_a, existing->value);
+	}
+	else
+	{
+		result = MDB_NOTFOUND;
+	}
+	return result;
+}
+
+int rai::memory_backend::put (MDB_txn * transaction_a, MDB_dbi table_a, MDB_val * key_a, MDB_val * value_a, unsigned flags_a)
+{
+	auto & table (table_get (transaction_a, table_a, true));
+	auto dupsort ((table.flags & MDB_DUPSORT) != 0);
+	auto result (0);
+	rai::memory_backend::entry entry{ bytes (key_a), bytes (value_a) };
+	if ((flags_a & (MDB_APPEND | MDB_APPENDDUP)) != 0 && !table.entries.empty () && !table.entries.key_comp () (*table.entries.rbegin (), entry))
+	{
+		// Appends have to go past the current last entry
+		result = MDB_KEYEXIST;
+	}
+	else
+	{
+		auto existing (table.entries.find (entry));
+		if (existing == table.entries.end ())
+		{
+			table.entries.insert (std::move (entry));
+		}
+		else if ((flags_a & MDB_NOOVERWRITE) != 0 || (dupsort && (flags_a & MDB_NODUPDATA) != 0))
+		{
+			result = MDB_KEYEXIST;
+		}
+		else if (!dupsort)
+		{
+			existing->value = std::move (entry.value);
+		}
+	}
+	return result;
+}
+
+int rai::memory_backend::del (MDB_txn * transaction_a, MDB_dbi table_a, MDB_val * key_a, MDB_val * value_a)
+{
+	auto & table (table_get (transaction_a, table_a, true));
+	auto dupsort ((table.flags & MDB_DUPSORT) != 0);
+	auto result (0);
+	auto key (bytes (key_a));
+	if (dupsort && value_a != nullptr)
+	{
+		result = table.entries.erase (rai::memory_backend::entry{ key, bytes (value_a) }) != 0 ? 0 : MDB_NOTFOUND;
+	}
+	else
+	{
+		auto begin (table.entries.lower_bound (rai::memory_backend::entry{ key, std::vector<uint8_t> () }));
+		auto end (begin);
+		while (end != table.entries.end () && end->key == key)
+		{
+			++end;
+		}
+		result = begin != end ? 0 : MDB_NOTFOUND;
+		table.entries.erase (begin, end);
+	}
+	return result;
+}
+
+int rai::memory_backend::drop (MDB_txn * transaction_a, MDB_dbi table_a, int delete_a)
+{
+	auto & table (table_get (transaction_a, table_a, true));
+	table.entries.clear ();
+	if (delete_a != 0 && table_a != 0)
+	{
+		for (auto i (names.begin ()), n (names.end ()); i != n; ++i)
+		{
+			if (i->second == table_a)
+			{
+				names.erase (i);
+				break;
+			}
+		}
+		// Handles are not reused, a later open of the same name gets a new one
+		tables[table_a].reset ();
+	}
+	return 0;
+}
+
+int rai::memory_backend::stat (MDB_txn * transaction_a, MDB_dbi table_a, MDB_stat * stat_a)
+{
+	auto & table (table_get (transaction_a, table_a, false));
+	*stat_a = MDB_stat ();
+	stat_a->ms_entries = table.entries.size ();
+	return 0;
+}
+
+std::unique_ptr<rai::store_cursor> rai::memory_backend::cursor (MDB_txn * transaction_a, MDB_dbi table_a)
+{
+	return std::unique_ptr<rai::store_cursor> (new memory_cursor (*this, transaction_a, table_a));
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <rai/node/utility.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rai
+{
+/**
+ * store_backend keeping every table in ordered std::sets, for tests and profiling of block_store calls without
+ * LMDB underneath. Nothing is persisted.
+ * Only code that begins its transactions on block_store::backend runs on it. The node, wallets, RPC and most of
+ * the ledger callers begin theirs on block_store::environment, which a store opened on this backend leaves closed.
+ * One transaction runs at a time across threads, nested transactions on the same thread share it.
+ * Transactions always commit so there is no undo log, writes apply in place.
+ */
+class memory_backend : public rai::store_backend
+{
+public:
+	memory_backend ();
+	MDB_txn * begin (MDB_txn *, bool) override;
+	void commit (MDB_txn *) override;
+	int open (MDB_txn *, char const *, unsigned, MDB_dbi *) override;
+	int flags (MDB_txn *, MDB_dbi, unsigned *) override;
+	int get (MDB_txn *, MDB_dbi, MDB_val *, MDB_val *) override;
+	int put (MDB_txn *, MDB_dbi, MDB_val *, MDB_val *, unsigned) override;
+	int del (MDB_txn *, MDB_dbi, MDB_val *, MDB_val *) override;
+	int drop (MDB_txn *, MDB_dbi, int) override;
+	int stat (MDB_txn *, MDB_dbi, MDB_stat *) override;
+	std::unique_ptr<rai::store_cursor> cursor (MDB_txn *, MDB_dbi) override;
+	class entry
+	{
+	public:
+		std::vector<uint8_t> key;
+		// Not part of the ordering of tables without MDB_DUPSORT, so replacing it in place keeps cursors valid
+		mutable std::vector<uint8_t> value;
+	};
+	// Orders by key, then by value in MDB_DUPSORT tables
+	class entry_compare
+	{
+	public:
+		bool operator() (rai::memory_backend::entry const &, rai::memory_backend::entry const &) const;
+		bool dupsort;
+	};
+	class table
+	{
+	public:
+		table (unsigned);
+		unsigned flags;
+		std::set<rai::memory_backend::entry, rai::memory_backend::entry_compare> entries;
+	};
+	// Its address is handed out as the MDB_txn * handle
+	class transaction_state
+	{
+	public:
+		bool write;
+	};
+	// State of a transaction begun on this backend, null for handles it didn't hand out e.g. an LMDB transaction
+	rai::memory_backend::transaction_state * state (MDB_txn *);
+	rai::memory_backend::table & table_get (MDB_txn *, MDB_dbi, bool);
+	std::recursive_mutex mutex;
+	// Handles are looked up here rather than cast back, a foreign handle is caught instead of read as a transaction_state
+	std::unordered_map<MDB_txn *, std::unique_ptr<rai::memory_backend::transaction_state>> transactions;
+	std::map<std::string, MDB_dbi> names;
+	// Indexed by MDB_dbi, 0 is the unnamed table like LMDB's main database
+	std::vector<std::unique_ptr<rai::memory_backend::table>> tables;
+};
+}
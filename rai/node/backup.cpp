@@ -0,0 +1,248 @@
+#include <rai/node/backup.hpp>
+
+#include <rai/blockstore.hpp>
+
+#include <fstream>
+
+size_t constexpr rai::store_backup::batch_bytes;
+unsigned constexpr rai::store_backup::read_seconds_max;
+
+namespace
+{
+boost::filesystem::path compact_flag_path (boost::filesystem::path const & application_path_a)
+{
+	return application_path_a / "compact";
+}
+}
+
+rai::store_backup::store_backup (rai::mdb_env & source_a, boost::filesystem::path const & destination_a, uint64_t bytes_per_second_a) :
+source (source_a),
+destination (destination_a),
+bytes_per_second (bytes_per_second_a),
+entries (0),
+entries_total (0),
+bytes (0),
+running (false),
+cancelled (false),
+error (false),
+elapsed_ms (0)
+{
+}
+
+rai::store_backup::~store_backup ()
+{
+	cancel ();
+	join ();
+}
+
+void rai::store_backup::start ()
+{
+	assert (!thread.joinable ());
+	running = true;
+	started = std::chrono::steady_clock::now ();
+	thread = std::thread ([this]() {
+		error = copy ();
+		elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now () - started).count ();
+		running = false;
+	});
+}
+
+void rai::store_backup::cancel ()
+{
+	cancelled = true;
+}
+
+bool rai::store_backup::join ()
+{
+	if (thread.joinable ())
+	{
+		thread.join ();
+	}
+	return error || cancelled;
+}
+
+bool rai::store_backup::finished () const
+{
+	return !running && !error && !cancelled;
+}
+
+bool rai::store_backup::copy ()
+{
+	auto partial (destination);
+	partial += ".partial";
+	auto partial_lock (partial);
+	partial_lock += "-lock";
+	boost::system::error_code ignored;
+	boost::filesystem::remove (partial, ignored);
+	boost::filesystem::remove (partial_lock, ignored);
+	// mdb_dbi_open must not race another open, inside a write transaction it can't. Tables created after this aren't copied.
+	std::vector<std::pair<std::string, MDB_dbi>> tables;
+	auto result (false);
+	{
+		rai::transaction transaction (source, nullptr, true);
+		MDB_dbi main;
+		result = source.open (transaction, nullptr, 0, &main) != 0;
+		if (!result)
+		{
+			for (rai::store_iterator i (source, transaction, main), n (nullptr); i != n; ++i)
+			{
+				std::string name (reinterpret_cast<char const *> (i->first.data ()), i->first.size ());
+				MDB_dbi table;
+				// Keys of the main table that aren't table names fail with MDB_INCOMPATIBLE
+				if (source.open (transaction, name.c_str (), 0, &table) == 0)
+				{
+					tables.push_back (std::make_pair (name, table));
+				}
+			}
+		}
+	}
+	auto read (source.begin (nullptr, false));
+	auto read_started (std::chrono::steady_clock::now ());
+	// Throttling pauses only use the first half of the read transaction's lifetime, the rest copies at full speed
+	auto throttle_end (read_started + std::chrono::seconds (read_seconds_max / 2));
+	auto read_end (read_started + std::chrono::seconds (read_seconds_max));
+	for (auto & i : tables)
+	{
+		MDB_stat stats;
+		auto status (source.stat (read, i.second, &stats));
+		assert (status == 0);
+		entries_total += stats.ms_entries;
+	}
+	if (!result)
+	{
+		// Synced once when the copy is complete instead of on every batch
+		auto config (source.config);
+		config.sync = false;
+		config.meta_sync = false;
+		rai::mdb_env target (result, partial, static_cast<int> (tables.size ()) + 1, config);
+		for (auto t (tables.begin ()), m (tables.end ()); !result && t != m; ++t)
+		{
+			unsigned flags;
+			auto status (source.flags (read, t->second, &flags));
+			assert (status == 0);
+			auto append ((flags & MDB_DUPSORT) ? MDB_APPENDDUP : MDB_APPEND);
+			auto write (target.begin (nullptr, true));
+			MDB_dbi table;
+			result = target.open (write, t->first.c_str (), flags | MDB_CREATE, &table) != 0;
+			size_t batch (0);
+			for (rai::store_iterator i (source, read, t->second), n (nullptr); !result && i != n; ++i)
+			{
+				result = target.put (write, table, i->first, i->second, append) != 0;
+				auto size (i->first.size () + i->second.size ());
+				batch += size;
+				bytes += size;
+				++entries;
+				if (batch >= batch_bytes)
+				{
+					// Short write transactions on the copy, the map can only grow between them
+					target.commit (write);
+					batch = 0;
+					elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now () - started).count ();
+					if (bytes_per_second != 0)
+					{
+						// Sleep in steps so a cancel doesn't wait out a long pause
+						auto due (std::min (started + std::chrono::microseconds (bytes * 1000000 / bytes_per_second), throttle_end));
+						while (!cancelled && std::chrono::steady_clock::now () < due)
+						{
+							std::this_thread::sleep_for (std::min<std::chrono::steady_clock::duration> (due - std::chrono::steady_clock::now (), std::chrono::milliseconds (100)));
+						}
+					}
+					// The source map can't grow while the read transaction is open, give up rather than let writers run out of space
+					result = cancelled || std::chrono::steady_clock::now () > read_end;
+					write = target.begin (nullptr, true);
+				}
+			}
+			target.commit (write);
+		}
+		result = result || cancelled;
+		source.commit (read);
+		read = nullptr;
+		if (!result)
+		{
+			result = mdb_env_sync (target.environment, 1) != 0;
+		}
+	}
+	if (read != nullptr)
+	{
+		source.commit (read);
+	}
+	boost::filesystem::remove (partial_lock, ignored);
+	if (!result)
+	{
+		boost::system::error_code error_l;
+		boost::filesystem::rename (partial, destination, error_l);
+		result = !!error_l;
+	}
+	if (result)
+	{
+		boost::filesystem::remove (partial, ignored);
+	}
+	return result;
+}
+
+void rai::store_backup::serialize_json (boost::property_tree::ptree & tree_a) const
+{
+	std::string state ("running");
+	if (!running)
+	{
+		state = cancelled ? "cancelled" : error ? "failed" : "finished";
+	}
+	tree_a.put ("state", state);
+	tree_a.put ("destination", destination.string ());
+	tree_a.put ("entries", std::to_string (entries));
+	tree_a.put ("entries_total", std::to_string (entries_total));
+	uint64_t elapsed (running ? std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now () - started).count () : elapsed_ms.load ());
+	tree_a.put ("bytes", std::to_string (bytes));
+	tree_a.put ("elapsed", std::to_string (elapsed));
+	tree_a.put ("bytes_per_second", std::to_string (elapsed != 0 ? bytes * 1000 / elapsed : 0));
+	tree_a.put ("limit", std::to_string (bytes_per_second));
+	tree_a.put ("progress", std::to_string (entries_total != 0 ? entries * 100 / entries_total : 100));
+}
+
+boost::filesystem::path rai::store_backup::compacted_path (boost::filesystem::path const & application_path_a)
+{
+	return application_path_a / "compacted.ldb";
+}
+
+bool rai::store_backup::schedule_compaction (boost::filesystem::path const & application_path_a)
+{
+	std::ofstream flag (compact_flag_path (application_path_a).string ());
+	return !flag;
+}
+
+boost::filesystem::path rai::store_backup::install (boost::filesystem::path const & application_path_a, int max_dbs_a, rai::lmdb_config const & config_a)
+{
+	auto result (application_path_a / "data.ldb");
+	auto flag (compact_flag_path (application_path_a));
+	boost::system::error_code error;
+	if (boost::filesystem::exists (flag, error) && boost::filesystem::exists (result, error))
+	{
+		auto compacted (compacted_path (application_path_a));
+		boost::filesystem::remove (compacted, error);
+		auto failed (false);
+		{
+			rai::mdb_env data (failed, result, max_dbs_a, config_a);
+			failed = failed || mdb_env_copy2 (data.environment, compacted.string ().c_str (), MDB_CP_COMPACT) != 0;
+		}
+		if (!failed)
+		{
+			// The replaced file is kept until the next compaction is installed
+			auto previous (application_path_a / "backup.compact.ldb");
+			boost::filesystem::remove (previous, error);
+			error.clear ();
+			boost::filesystem::rename (result, previous, error);
+			if (!error)
+			{
+				boost::filesystem::rename (compacted, result, error);
+				if (error)
+				{
+					boost::filesystem::rename (previous, result, error);
+				}
+			}
+		}
+		boost::filesystem::remove (compacted, error);
+	}
+	// A compaction that failed isn't retried on every start, it has to be scheduled again
+	boost::filesystem::remove (flag, error);
+	return result;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <rai/node/utility.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace rai
+{
+/**
+ * Copies an open LMDB environment to a new, compacted file while the node keeps running.
+ * One read transaction pins a consistent view for the whole copy and every table is rewritten in key order with
+ * MDB_APPEND in to a fresh environment so the copy has no free pages. Writers carry on, while the view is pinned
+ * LMDB can't reuse pages they free and the map isn't grown, so the copy fails once the view is older than
+ * read_seconds_max. Writes to the copy are throttled to bytes_per_second during the first half of that time.
+ * The copy goes to destination.partial and is only renamed to destination once it finished.
+ * Wallets and the ledger share data.ldb so a copy of a running node is behind it as soon as anything is written,
+ * replacing data.ldb with a compacted copy is instead scheduled and done by install when the node next starts.
+ */
+class store_backup
+{
+public:
+	store_backup (rai::mdb_env &, boost::filesystem::path const &, uint64_t);
+	~store_backup ();
+	// Runs the copy on a thread of its own
+	void start ();
+	void cancel ();
+	// Waits for the copy, true if it failed or was cancelled
+	bool join ();
+	bool finished () const;
+	void serialize_json (boost::property_tree::ptree &) const;
+	rai::mdb_env & source;
+	boost::filesystem::path destination;
+	// 0 copies as fast as the disk allows
+	uint64_t bytes_per_second;
+	std::atomic<uint64_t> entries;
+	std::atomic<uint64_t> entries_total;
+	std::atomic<uint64_t> bytes;
+	std::atomic<bool> running;
+	std::atomic<bool> cancelled;
+	std::atomic<bool> error;
+	std::chrono::steady_clock::time_point started;
+	std::atomic<uint64_t> elapsed_ms;
+	// The compacting copy made at start is written here before it's moved in to place
+	static boost::filesystem::path compacted_path (boost::filesystem::path const &);
+	// Marks data.ldb in the application path to be compacted at the next start, true on error
+	static bool schedule_compaction (boost::filesystem::path const &);
+	// Path of data.ldb in the application path. When a compaction is scheduled data.ldb is first copied with
+	// MDB_CP_COMPACT and the copy takes its place, nothing has the store open yet so no write can be lost.
+	static boost::filesystem::path install (boost::filesystem::path const &, int, rai::lmdb_config const &);
+	static size_t constexpr batch_bytes = 4 * 1024 * 1024;
+	static unsigned constexpr read_seconds_max = rai::rai_network == rai::rai_networks::rai_test_network ? 60 : 1800;
+
+private:
+	bool copy ();
+	std::thread thread;
+};
+}
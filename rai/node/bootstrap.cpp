@@ -197,7 +197,7 @@ current (0),
 count (0),
 bulk_push_cost (0)
 {
-	rai::transaction transaction (connection->node->store.environment, nullptr, false);
+	rai::transaction transaction (connection->node->store.backend, nullptr, false);
 	next (transaction);
 }
 
@@ -278,7 +278,7 @@ void rai::frontier_req_client::received_frontier (boost::system::error_code cons
 			while (!current.is_zero () && current < account)
 			{
 				// We know about an account they don't.
-				rai::transaction transaction (connection->node->store.environment, nullptr, true);
+				rai::transaction transaction (connection->node->store.backend, nullptr, true);
 				unsynced (transaction, info.head, 0);
 				next (transaction);
 			}
@@ -286,7 +286,7 @@ void rai::frontier_req_client::received_frontier (boost::system::error_code cons
 			{
 				if (account == current)
 				{
-					rai::transaction transaction (connection->node->store.environment, nullptr, true);
+					rai::transaction transaction (connection->node->store.backend, nullptr, true);
 					if (latest == info.head)
 					{
 						// In sync
@@ -323,7 +323,7 @@ void rai::frontier_req_client::received_frontier (boost::system::error_code cons
 		else
 		{
 			{
-				rai::transaction transaction (connection->node->store.environment, nullptr, true);
+				rai::transaction transaction (connection->node->store.backend, nullptr, true);
 				while (!current.is_zero ())
 				{
 					// We know about an account they don't.
@@ -578,7 +578,7 @@ void rai::bulk_push_client::start ()
 	}
 	auto this_l (shared_from_this ());
 	connection->socket->async_write (buffer, [this_l, buffer](boost::system::error_code const & ec, size_t size_a) {
-		rai::transaction transaction (this_l->connection->node->store.environment, nullptr, false);
+		rai::transaction transaction (this_l->connection->node->store.backend, nullptr, false);
 		if (!ec)
 		{
 			this_l->push (transaction);
@@ -671,7 +671,7 @@ void rai::bulk_push_client::push_block (rai::block const & block_a)
 	connection->socket->async_write (buffer, [this_l, buffer](boost::system::error_code const & ec, size_t size_a) {
 		if (!ec)
 		{
-			rai::transaction transaction (this_l->connection->node->store.environment, nullptr, false);
+			rai::transaction transaction (this_l->connection->node->store.backend, nullptr, false);
 			this_l->push (transaction);
 		}
 		else
@@ -1643,6 +1643,10 @@ public:
 	{
 		assert (false);
 	}
+	void confirm_req_batch (rai::confirm_req_batch const &) override
+	{
+		assert (false);
+	}
 	void bulk_pull (rai::bulk_pull const &) override
 	{
 		auto response (std::make_shared<rai::bulk_pull_server> (connection, std::unique_ptr<rai::bulk_pull> (static_cast<rai::bulk_pull *> (connection->requests.front ().release ()))));
@@ -1696,7 +1700,7 @@ void rai::bootstrap_server::run_next ()
 void rai::bulk_pull_server::set_current_end ()
 {
 	assert (request != nullptr);
-	rai::transaction transaction (connection->node->store.environment, nullptr, false);
+	rai::transaction transaction (connection->node->store.backend, nullptr, false);
 	if (!connection->node->store.block_exists (transaction, request->end))
 	{
 		if (connection->node->config.logging.bulk_pull_logging ())
@@ -1766,7 +1770,7 @@ std::unique_ptr<rai::block> rai::bulk_pull_server::get_next ()
 	std::unique_ptr<rai::block> result;
 	if (current != request->end)
 	{
-		rai::transaction transaction (connection->node->store.environment, nullptr, false);
+		rai::transaction transaction (connection->node->store.backend, nullptr, false);
 		result = connection->node->store.block_get (transaction, current);
 		if (result != nullptr)
 		{
@@ -1782,6 +1786,11 @@ std::unique_ptr<rai::block> rai::bulk_pull_server::get_next ()
 		}
 		else
 		{
+			// A pruned node only has the top of each chain, the client finds the rest elsewhere
+			if (connection->node->config.logging.bulk_pull_logging () && connection->node->store.pruned_exists (transaction, current))
+			{
+				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Bulk pull reached pruned block %1%") % current.to_string ());
+			}
 			current = request->end;
 		}
 	}
@@ -1965,7 +1974,7 @@ std::unique_ptr<rai::block> rai::bulk_pull_blocks_server::get_next ()
 			auto current = stream->first.uint256 ();
 			if (current < request->max_hash)
 			{
-				rai::transaction transaction (connection->node->store.environment, nullptr, false);
+				rai::transaction transaction (connection->node->store.backend, nullptr, false);
 				result = connection->node->store.block_get (transaction, current);
 
 				++stream;
@@ -2025,7 +2034,7 @@ connection (connection_a),
 request (std::move (request_a)),
 send_buffer (std::make_shared<std::vector<uint8_t>> ()),
 stream (nullptr),
-stream_transaction (connection_a->node->store.environment, nullptr, false),
+stream_transaction (connection_a->node->store.backend, nullptr, false),
 sent_count (0),
 checksum (0)
 {
@@ -2240,7 +2249,7 @@ void rai::frontier_req_server::sent_action (boost::system::error_code const & ec
 
 void rai::frontier_req_server::next ()
 {
-	rai::transaction transaction (connection->node->store.environment, nullptr, false);
+	rai::transaction transaction (connection->node->store.backend, nullptr, false);
 	auto iterator (connection->node->store.latest_begin (transaction, current.number () + 1));
 	if (iterator != connection->node->store.latest_end ())
 	{
@@ -2264,7 +2273,7 @@ request (std::move (request_a))
 void rai::smart_contract_req_server::send ()
 {
 	assert (request != nullptr);
-	rai::transaction transaction (connection->node->store.environment, nullptr, false);
+	rai::transaction transaction (connection->node->store.backend, nullptr, false);
 
 	auto block (connection->node->store.block_get (transaction, request->token_type));
 	if (block != nullptr)
@@ -2281,7 +2290,7 @@ void rai::smart_contract_req_server::send ()
 				}
 				auto this_l (shared_from_this ());
 				connection->socket->async_write (buffer, [this_l, buffer](boost::system::error_code const & ec, size_t size_a) {
-					rai::transaction transaction (this_l->connection->node->store.environment, nullptr, false);
+					rai::transaction transaction (this_l->connection->node->store.backend, nullptr, false);
 					if (!ec)
 					{
 						if (this_l->connection->node->config.logging.smart_contract_logging ())
@@ -2374,7 +2383,7 @@ void rai::smart_contract_server::received_block (boost::system::error_code const
 			std::cout << sc_info.smart_contract->to_json () << std::endl;
 			if (!rai::validate_message (sc_info.smart_contract->hashables.sc_owner_account, sc_info.smart_contract->hash (), sc_info.smart_contract->signature) && (sc_info.smart_contract->hashables.hash_abi () == sc_info.smart_contract->hashables.abi_hash))
 			{
-				rai::transaction transaction (connection->node->store.environment, nullptr, true);
+				rai::transaction transaction (connection->node->store.backend, nullptr, true);
 				auto block (connection->node->store.block_get (transaction, sc_info.smart_contract->hash ()));
 				if (block == nullptr)
 				{
@@ -2515,7 +2524,7 @@ void rai::smart_contract_client::receive_block (boost::system::error_code const
 					sc_info.smart_contract->serialize_json (block);
 					BOOST_LOG (this_l->connection->node->log) << boost::str (boost::format ("receive smart contract block %1%: %2%") % sc_info.smart_contract->hash ().to_string () % block);
 				}
-				rai::transaction transaction (connection->node->store.environment, nullptr, true);
+				rai::transaction transaction (connection->node->store.backend, nullptr, true);
 				rai::block_hash successor (0);
 				connection->node->store.block_put (transaction, sc_info.smart_contract->hash (), *sc_info.smart_contract, successor);
 				connection->node->block_processor.queue_unchecked (transaction, sc_info.smart_contract->hash ());
@@ -8,6 +8,126 @@ std::array<uint8_t, 2> constexpr rai::message_header::magic_number;
 size_t constexpr rai::message_header::ipv4_only_position;
 size_t constexpr rai::message_header::bootstrap_server_position;
 std::bitset<16> constexpr rai::message_header::block_type_mask;
+size_t constexpr rai::confirm_req_batch::max_requests;
+size_t constexpr rai::message_buffer::capacity;
+size_t constexpr rai::message_buffer_pool::free_max;
+
+rai::message_buffer::message_buffer () :
+used (0),
+references (0)
+{
+}
+
+uint8_t const * rai::message_buffer::data () const
+{
+	return spill.empty () ? fixed.data () : spill.data ();
+}
+
+size_t rai::message_buffer::size () const
+{
+	return used;
+}
+
+void rai::intrusive_ptr_add_ref (rai::message_buffer * buffer_a)
+{
+	buffer_a->references.fetch_add (1, std::memory_order_relaxed);
+}
+
+void rai::intrusive_ptr_release (rai::message_buffer * buffer_a)
+{
+	if (buffer_a->references.fetch_sub (1, std::memory_order_acq_rel) == 1)
+	{
+		rai::message_buffers ().release (buffer_a);
+	}
+}
+
+rai::message_stream::message_stream (rai::message_buffer & buffer_a) :
+buffer (buffer_a)
+{
+	buffer.spill.clear ();
+	setp (buffer.fixed.data (), buffer.fixed.data () + buffer.fixed.size ());
+}
+
+rai::message_stream::~message_stream ()
+{
+	buffer.used = buffer.spill.empty () ? pptr () - pbase () : buffer.spill.size ();
+}
+
+std::streamsize rai::message_stream::xsputn (char_type const * data_a, std::streamsize size_a)
+{
+	if (buffer.spill.empty () && epptr () - pptr () >= size_a)
+	{
+		std::copy (data_a, data_a + size_a, pptr ());
+		pbump (static_cast<int> (size_a));
+	}
+	else
+	{
+		if (buffer.spill.empty ())
+		{
+			buffer.spill.assign (pbase (), pptr ());
+			setp (nullptr, nullptr);
+		}
+		buffer.spill.insert (buffer.spill.end (), data_a, data_a + size_a);
+	}
+	return size_a;
+}
+
+rai::message_stream::int_type rai::message_stream::overflow (int_type byte_a)
+{
+	if (!traits_type::eq_int_type (byte_a, traits_type::eof ()))
+	{
+		auto byte (traits_type::to_char_type (byte_a));
+		xsputn (&byte, 1);
+	}
+	return traits_type::not_eof (byte_a);
+}
+
+rai::shared_buffer rai::message_buffer_pool::allocate ()
+{
+	std::unique_ptr<rai::message_buffer> result;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		if (!free.empty ())
+		{
+			result = std::move (free.back ());
+			free.pop_back ();
+		}
+	}
+	if (result == nullptr)
+	{
+		result.reset (new rai::message_buffer);
+	}
+	return rai::shared_buffer (result.release ());
+}
+
+rai::shared_buffer rai::message_buffer_pool::serialize (rai::message & message_a)
+{
+	auto result (allocate ());
+	{
+		rai::message_stream stream (*result);
+		message_a.serialize (stream);
+	}
+	return result;
+}
+
+void rai::message_buffer_pool::release (rai::message_buffer * buffer_a)
+{
+	std::unique_ptr<rai::message_buffer> buffer (buffer_a);
+	// Don't hold on to the memory of oversized messages
+	std::vector<uint8_t> ().swap (buffer->spill);
+	buffer->used = 0;
+	std::lock_guard<std::mutex> lock (mutex);
+	if (free.size () < free_max)
+	{
+		free.push_back (std::move (buffer));
+	}
+}
+
+rai::message_buffer_pool & rai::message_buffers ()
+{
+	static auto pool (new rai::message_buffer_pool);
+	return *pool;
+}
 
 rai::message_header::message_header (rai::message_type type_a) :
 version_max (rai::protocol_version),
@@ -121,6 +241,11 @@ void rai::message_parser::deserialize_buffer (uint8_t const * buffer_a, size_t s
 				deserialize_confirm_ack (stream, header);
 				break;
 			}
+			case rai::message_type::confirm_req_batch:
+			{
+				deserialize_confirm_req_batch (stream, header);
+				break;
+			}
 			default:
 			{
 				status = parse_status::invalid_message_type;
@@ -211,6 +336,20 @@ void rai::message_parser::deserialize_confirm_ack (rai::stream & stream_a, rai::
 	}
 }
 
+void rai::message_parser::deserialize_confirm_req_batch (rai::stream & stream_a, rai::message_header const & header_a)
+{
+	auto error (false);
+	rai::confirm_req_batch incoming (error, stream_a, header_a);
+	if (!error && at_end (stream_a))
+	{
+		visitor.confirm_req_batch (incoming);
+	}
+	else
+	{
+		status = parse_status::invalid_confirm_req_batch_message;
+	}
+}
+
 bool rai::message_parser::at_end (rai::stream & stream_a)
 {
 	uint8_t junk;
@@ -361,6 +500,61 @@ bool rai::confirm_req::operator== (rai::confirm_req const & other_a) const
 	return *block == *other_a.block;
 }
 
+rai::confirm_req_batch::confirm_req_batch () :
+message (rai::message_type::confirm_req_batch)
+{
+}
+
+rai::confirm_req_batch::confirm_req_batch (bool & error_a, rai::stream & stream_a, rai::message_header const & header_a) :
+message (header_a)
+{
+	if (!error_a)
+	{
+		error_a = deserialize (stream_a);
+	}
+}
+
+bool rai::confirm_req_batch::deserialize (rai::stream & stream_a)
+{
+	assert (header.type == rai::message_type::confirm_req_batch);
+	uint8_t count;
+	auto result (read (stream_a, count));
+	result = result || count == 0 || count > max_requests;
+	for (auto i (0); !result && i < count; ++i)
+	{
+		rai::block_hash hash;
+		rai::block_hash root;
+		result = read (stream_a, hash) || read (stream_a, root);
+		if (!result)
+		{
+			requests.push_back (std::make_pair (hash, root));
+		}
+	}
+	return result;
+}
+
+void rai::confirm_req_batch::serialize (rai::stream & stream_a)
+{
+	assert (!requests.empty () && requests.size () <= max_requests);
+	header.serialize (stream_a);
+	write (stream_a, static_cast<uint8_t> (requests.size ()));
+	for (auto & i : requests)
+	{
+		write (stream_a, i.first);
+		write (stream_a, i.second);
+	}
+}
+
+void rai::confirm_req_batch::visit (rai::message_visitor & visitor_a) const
+{
+	visitor_a.confirm_req_batch (*this);
+}
+
+bool rai::confirm_req_batch::operator== (rai::confirm_req_batch const & other_a) const
+{
+	return requests == other_a.requests;
+}
+
 rai::confirm_ack::confirm_ack (bool & error_a, rai::stream & stream_a, rai::message_header const & header_a) :
 message (header_a),
 vote (std::make_shared<rai::vote> (error_a, stream_a, header.block_type ()))
@@ -4,6 +4,7 @@
 #include <rai/lib/interface.h>
 
 #include <boost/asio.hpp>
+#include <boost/intrusive_ptr.hpp>
 
 #include <bitset>
 
@@ -97,7 +98,8 @@ enum class message_type : uint8_t
 	// 智能合约
 	smart_contract_req,
 	smart_contract,
-	smart_contract_ack
+	smart_contract_ack,
+	confirm_req_batch
 };
 enum class bulk_pull_blocks_mode : uint8_t
 {
@@ -112,6 +114,52 @@ enum class smart_contract_result : uint8_t
 	success
 };
 class message_visitor;
+class message;
+// Serialized network message, written once and shared by every send of it
+class message_buffer
+{
+public:
+	message_buffer ();
+	uint8_t const * data () const;
+	size_t size () const;
+	// Large enough for every message the UDP receive buffer accepts
+	static size_t constexpr capacity = 512;
+	std::array<uint8_t, capacity> fixed;
+	// Holds messages that outgrow fixed, such as smart contract blocks
+	std::vector<uint8_t> spill;
+	size_t used;
+	std::atomic<unsigned> references;
+};
+void intrusive_ptr_add_ref (rai::message_buffer *);
+void intrusive_ptr_release (rai::message_buffer *);
+using shared_buffer = boost::intrusive_ptr<rai::message_buffer>;
+// Writes straight into a message_buffer instead of growing a vector through boost::iostreams
+class message_stream : public rai::stream
+{
+public:
+	message_stream (rai::message_buffer &);
+	~message_stream ();
+
+protected:
+	std::streamsize xsputn (char_type const *, std::streamsize) override;
+	int_type overflow (int_type) override;
+
+private:
+	rai::message_buffer & buffer;
+};
+// Recycles message buffers so sending a message doesn't allocate
+class message_buffer_pool
+{
+public:
+	rai::shared_buffer allocate ();
+	rai::shared_buffer serialize (rai::message &);
+	void release (rai::message_buffer *);
+	std::mutex mutex;
+	std::vector<std::unique_ptr<rai::message_buffer>> free;
+	static size_t constexpr free_max = 1024;
+};
+// Process wide pool, never destroyed so late send callbacks can still release into it
+rai::message_buffer_pool & message_buffers ();
 class message_header
 {
 public:
@@ -157,7 +205,8 @@ public:
 		invalid_keepalive_message,
 		invalid_publish_message,
 		invalid_confirm_req_message,
-		invalid_confirm_ack_message
+		invalid_confirm_ack_message,
+		invalid_confirm_req_batch_message
 	};
 	message_parser (rai::message_visitor &, rai::work_pool &);
 	void deserialize_buffer (uint8_t const *, size_t);
@@ -165,6 +214,7 @@ public:
 	void deserialize_publish (rai::stream &, rai::message_header const &);
 	void deserialize_confirm_req (rai::stream &, rai::message_header const &);
 	void deserialize_confirm_ack (rai::stream &, rai::message_header const &);
+	void deserialize_confirm_req_batch (rai::stream &, rai::message_header const &);
 	bool at_end (rai::stream &);
 	rai::message_visitor & visitor;
 	rai::work_pool & pool;
@@ -203,6 +253,21 @@ public:
 	bool operator== (rai::confirm_req const &) const;
 	std::shared_ptr<rai::block> block;
 };
+// Asks a representative to vote on several roots at once, by hash instead of carrying the blocks
+class confirm_req_batch : public message
+{
+public:
+	confirm_req_batch ();
+	confirm_req_batch (bool &, rai::stream &, rai::message_header const &);
+	bool deserialize (rai::stream &) override;
+	void serialize (rai::stream &) override;
+	void visit (rai::message_visitor &) const override;
+	bool operator== (rai::confirm_req_batch const &) const;
+	// Pairs of block hash and root
+	std::vector<std::pair<rai::block_hash, rai::block_hash>> requests;
+	// Largest batch fitting the 512 byte datagram the network receives into
+	static size_t constexpr max_requests = 7;
+};
 class confirm_ack : public message
 {
 public:
@@ -318,6 +383,7 @@ public:
 	virtual void publish (rai::publish const &) = 0;
 	virtual void confirm_req (rai::confirm_req const &) = 0;
 	virtual void confirm_ack (rai::confirm_ack const &) = 0;
+	virtual void confirm_req_batch (rai::confirm_req_batch const &) = 0;
 	virtual void bulk_pull (rai::bulk_pull const &) = 0;
 	virtual void bulk_pull_blocks (rai::bulk_pull_blocks const &) = 0;
 	virtual void bulk_push (rai::bulk_push const &) = 0;
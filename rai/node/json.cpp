@@ -0,0 +1,591 @@
+#include <rai/node/json.hpp>
+
+#include <cstring>
+
+namespace
+{
+class json_reader
+{
+public:
+	json_reader (std::string const & text_a) :
+	current (text_a.data ()),
+	end (text_a.data () + text_a.size ()),
+	line (1)
+	{
+	}
+	void parse (boost::property_tree::ptree & tree_a)
+	{
+		skip ();
+		value (tree_a);
+		skip ();
+		if (current != end)
+		{
+			fail ("garbage after data");
+		}
+	}
+
+private:
+	void fail (char const * message_a)
+	{
+		throw boost::property_tree::json_parser_error (message_a, "", line);
+	}
+	void skip ()
+	{
+		while (current != end && (*current == ' ' || *current == '\t' || *current == '\n' || *current == '\r'))
+		{
+			if (*current == '\n')
+			{
+				++line;
+			}
+			++current;
+		}
+	}
+	bool consume (char char_a)
+	{
+		auto result (current != end && *current == char_a);
+		if (result)
+		{
+			++current;
+		}
+		return result;
+	}
+	void value (boost::property_tree::ptree & tree_a)
+	{
+		if (current == end)
+		{
+			fail ("expected value");
+		}
+		switch (*current)
+		{
+			case '{':
+				object (tree_a);
+				break;
+			case '[':
+				array (tree_a);
+				break;
+			case '"':
+				string (tree_a.data ());
+				break;
+			case 't':
+				literal ("true", tree_a.data ());
+				break;
+			case 'f':
+				literal ("false", tree_a.data ());
+				break;
+			case 'n':
+				literal ("null", tree_a.data ());
+				break;
+			default:
+				number (tree_a.data ());
+				break;
+		}
+	}
+	void object (boost::property_tree::ptree & tree_a)
+	{
+		++current;
+		skip ();
+		if (!consume ('}'))
+		{
+			do
+			{
+				skip ();
+				if (current == end || *current != '"')
+				{
+					fail ("expected key string");
+				}
+				std::string key;
+				string (key);
+				skip ();
+				if (!consume (':'))
+				{
+					fail ("expected ':'");
+				}
+				skip ();
+				// Members are appended in document order and duplicates are kept, as read_json does
+				auto & child (tree_a.push_back (std::make_pair (std::move (key), boost::property_tree::ptree ()))->second);
+				value (child);
+				skip ();
+			} while (consume (','));
+			if (!consume ('}'))
+			{
+				fail ("expected '}' or ','");
+			}
+		}
+	}
+	void array (boost::property_tree::ptree & tree_a)
+	{
+		++current;
+		skip ();
+		if (!consume (']'))
+		{
+			do
+			{
+				skip ();
+				auto & child (tree_a.push_back (std::make_pair (std::string (), boost::property_tree::ptree ()))->second);
+				value (child);
+				skip ();
+			} while (consume (','));
+			if (!consume (']'))
+			{
+				fail ("expected ']' or ','");
+			}
+		}
+	}
+	void string (std::string & result_a)
+	{
+		++current;
+		while (true)
+		{
+			// Copy runs of plain characters at once, only quotes, escapes and control characters need a closer look
+			auto run (current);
+			while (current != end && *current != '"' && *current != '\\' && static_cast<unsigned char> (*current) >= 0x20)
+			{
+				++current;
+			}
+			result_a.append (run, current);
+			if (current == end)
+			{
+				fail ("unterminated string");
+			}
+			if (*current == '"')
+			{
+				++current;
+				break;
+			}
+			if (*current != '\\')
+			{
+				fail ("invalid code sequence");
+			}
+			++current;
+			if (current == end)
+			{
+				fail ("invalid escape sequence");
+			}
+			switch (*current++)
+			{
+				case '"':
+					result_a.push_back ('"');
+					break;
+				case '\\':
+					result_a.push_back ('\\');
+					break;
+				case '/':
+					result_a.push_back ('/');
+					break;
+				case 'b':
+					result_a.push_back ('\b');
+					break;
+				case 'f':
+					result_a.push_back ('\f');
+					break;
+				case 'n':
+					result_a.push_back ('\n');
+					break;
+				case 'r':
+					result_a.push_back ('\r');
+					break;
+				case 't':
+					result_a.push_back ('\t');
+					break;
+				case 'u':
+					codepoint (result_a);
+					break;
+				default:
+					fail ("invalid escape sequence");
+					break;
+			}
+		}
+	}
+	unsigned hex4 ()
+	{
+		if (end - current < 4)
+		{
+			fail ("invalid escape sequence");
+		}
+		unsigned result (0);
+		for (auto i (0); i < 4; ++i, ++current)
+		{
+			auto char_l (*current);
+			result <<= 4;
+			if (char_l >= '0' && char_l <= '9')
+			{
+				result |= char_l - '0';
+			}
+			else if (char_l >= 'a' && char_l <= 'f')
+			{
+				result |= char_l - 'a' + 10;
+			}
+			else if (char_l >= 'A' && char_l <= 'F')
+			{
+				result |= char_l - 'A' + 10;
+			}
+			else
+			{
+				fail ("invalid escape sequence");
+			}
+		}
+		return result;
+	}
+	void codepoint (std::string & result_a)
+	{
+		auto code (hex4 ());
+		if (code >= 0xdc00 && code <= 0xdfff)
+		{
+			fail ("stray low surrogate");
+		}
+		if (code >= 0xd800 && code <= 0xdbff)
+		{
+			if (end - current < 2 || current[0] != '\\' || current[1] != 'u')
+			{
+				fail ("invalid codepoint, stray high surrogate");
+			}
+			current += 2;
+			auto low (hex4 ());
+			if (low < 0xdc00 || low > 0xdfff)
+			{
+				fail ("expected low surrogate after high surrogate");
+			}
+			code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+		}
+		if (code < 0x80)
+		{
+			result_a.push_back (static_cast<char> (code));
+		}
+		else if (code < 0x800)
+		{
+			result_a.push_back (static_cast<char> (0xc0 | (code >> 6)));
+			result_a.push_back (static_cast<char> (0x80 | (code & 0x3f)));
+		}
+		else if (code < 0x10000)
+		{
+			result_a.push_back (static_cast<char> (0xe0 | (code >> 12)));
+			result_a.push_back (static_cast<char> (0x80 | ((code >> 6) & 0x3f)));
+			result_a.push_back (static_cast<char> (0x80 | (code & 0x3f)));
+		}
+		else
+		{
+			result_a.push_back (static_cast<char> (0xf0 | (code >> 18)));
+			result_a.push_back (static_cast<char> (0x80 | ((code >> 12) & 0x3f)));
+			result_a.push_back (static_cast<char> (0x80 | ((code >> 6) & 0x3f)));
+			result_a.push_back (static_cast<char> (0x80 | (code & 0x3f)));
+		}
+	}
+	void literal (char const * literal_a, std::string & result_a)
+	{
+		auto size (std::strlen (literal_a));
+		if (static_cast<size_t> (end - current) < size || std::memcmp (current, literal_a, size) != 0)
+		{
+			fail ("expected value");
+		}
+		result_a.assign (current, size);
+		current += size;
+	}
+	bool digits ()
+	{
+		auto start (current);
+		while (current != end && *current >= '0' && *current <= '9')
+		{
+			++current;
+		}
+		return current != start;
+	}
+	void number (std::string & result_a)
+	{
+		auto start (current);
+		consume ('-');
+		if (!consume ('0') && !digits ())
+		{
+			fail ("expected value");
+		}
+		if (consume ('.') && !digits ())
+		{
+			fail ("need at least one digit after '.'");
+		}
+		if (consume ('e') || consume ('E'))
+		{
+			consume ('+') || consume ('-');
+			if (!digits ())
+			{
+				fail ("need at least one digit in exponent");
+			}
+		}
+		result_a.assign (start, current);
+	}
+	char const * current;
+	char const * end;
+	size_t line;
+};
+}
+
+size_t constexpr rai::json_writer::chunk_size;
+
+rai::json_writer::json_writer () :
+sink_error (false)
+{
+	open ('{');
+}
+
+rai::json_writer::json_writer (std::function<bool(std::string const &)> const & sink_a) :
+sink (sink_a),
+sink_error (false)
+{
+	output.reserve (chunk_size + chunk_size / 4);
+	open ('{');
+}
+
+void rai::json_writer::begin_object (std::string const & key_a)
+{
+	key (key_a);
+	open ('{');
+}
+
+void rai::json_writer::begin_object ()
+{
+	item ();
+	open ('{');
+}
+
+void rai::json_writer::begin_array (std::string const & key_a)
+{
+	key (key_a);
+	open ('[');
+}
+
+void rai::json_writer::begin_array ()
+{
+	item ();
+	open ('[');
+}
+
+void rai::json_writer::end ()
+{
+	assert (!levels.empty ());
+	auto level (levels.back ());
+	levels.pop_back ();
+	if (!level.empty)
+	{
+		output.push_back ('\n');
+		output.append (4 * levels.size (), ' ');
+		output.push_back (level.close);
+	}
+	else if (!levels.empty ())
+	{
+		// An empty ptree child has no children to tell an object from an array and is written as a value
+		output.resize (level.start);
+		output.append ("\"\"");
+	}
+	else
+	{
+		output.append ("\n}");
+	}
+}
+
+void rai::json_writer::value (std::string const & key_a, std::string const & value_a)
+{
+	key (key_a);
+	output.push_back ('"');
+	escape (value_a);
+	output.push_back ('"');
+}
+
+void rai::json_writer::value (std::string const & value_a)
+{
+	item ();
+	output.push_back ('"');
+	escape (value_a);
+	output.push_back ('"');
+}
+
+void rai::json_writer::tree (std::string const & key_a, boost::property_tree::ptree const & tree_a)
+{
+	key (key_a);
+	write_tree (tree_a);
+}
+
+void rai::json_writer::tree (boost::property_tree::ptree const & tree_a)
+{
+	item ();
+	write_tree (tree_a);
+}
+
+std::string rai::json_writer::finish ()
+{
+	while (!levels.empty ())
+	{
+		end ();
+	}
+	output.push_back ('\n');
+	if (sink_error)
+	{
+		output.clear ();
+	}
+	return std::move (output);
+}
+
+bool rai::json_writer::error () const
+{
+	return sink_error;
+}
+
+size_t rai::json_writer::final_size () const
+{
+	// A container nothing was written to yet may still be rewritten as "", everything before it is final
+	return levels.empty () || !levels.back ().empty ? output.size () : levels.back ().start;
+}
+
+bool rai::json_writer::pending () const
+{
+	return sink && !levels.empty () && output.size () >= chunk_size && final_size () > 0;
+}
+
+bool rai::json_writer::send ()
+{
+	if (sink && !levels.empty ())
+	{
+		auto keep (final_size ());
+		if (keep > 0)
+		{
+			if (!sink_error)
+			{
+				sink_error = sink (output.substr (0, keep));
+			}
+			output.erase (0, keep);
+			for (auto & i : levels)
+			{
+				i.start = i.start >= keep ? i.start - keep : 0;
+			}
+		}
+	}
+	return sink_error;
+}
+
+void rai::json_writer::item ()
+{
+	assert (!levels.empty ());
+	auto & level (levels.back ());
+	output.append (level.empty ? "\n" : ",\n");
+	level.empty = false;
+	output.append (4 * levels.size (), ' ');
+}
+
+void rai::json_writer::key (std::string const & key_a)
+{
+	item ();
+	output.push_back ('"');
+	escape (key_a);
+	output.append ("\": ");
+}
+
+void rai::json_writer::open (char char_a)
+{
+	levels.push_back (level{ output.size (), char_a == '{' ? '}' : ']', true });
+	output.push_back (char_a);
+}
+
+void rai::json_writer::escape (std::string const & text_a)
+{
+	// Same escaping as write_json: printable ASCII except '"', '/' and '\' plus bytes from 0x7f up are copied as they are
+	static char const * hex ("0123456789ABCDEF");
+	auto begin (text_a.data ());
+	auto end (begin + text_a.size ());
+	while (begin != end)
+	{
+		auto run (begin);
+		while (begin != end)
+		{
+			auto char_l (static_cast<unsigned char> (*begin));
+			if (char_l < 0x20 || char_l == '"' || char_l == '/' || char_l == '\\')
+			{
+				break;
+			}
+			++begin;
+		}
+		output.append (run, begin);
+		if (begin != end)
+		{
+			auto char_l (static_cast<unsigned char> (*begin));
+			output.push_back ('\\');
+			switch (char_l)
+			{
+				case '\b':
+					output.push_back ('b');
+					break;
+				case '\f':
+					output.push_back ('f');
+					break;
+				case '\n':
+					output.push_back ('n');
+					break;
+				case '\r':
+					output.push_back ('r');
+					break;
+				case '\t':
+					output.push_back ('t');
+					break;
+				case '/':
+				case '"':
+				case '\\':
+					output.push_back (static_cast<char> (char_l));
+					break;
+				default:
+					output.append ("u00");
+					output.push_back (hex[char_l >> 4]);
+					output.push_back (hex[char_l & 0xf]);
+					break;
+			}
+			++begin;
+		}
+	}
+}
+
+void rai::json_writer::write_tree (boost::property_tree::ptree const & tree_a)
+{
+	if (tree_a.empty ())
+	{
+		output.push_back ('"');
+		escape (tree_a.data ());
+		output.push_back ('"');
+	}
+	else
+	{
+		if (!tree_a.data ().empty ())
+		{
+			throw boost::property_tree::json_parser_error ("ptree contains data that cannot be represented in JSON format", "", 0);
+		}
+		auto array (tree_a.count (std::string ()) == tree_a.size ());
+		open (array ? '[' : '{');
+		for (auto & child : tree_a)
+		{
+			if (array)
+			{
+				item ();
+			}
+			else
+			{
+				key (child.first);
+			}
+			write_tree (child.second);
+		}
+		end ();
+	}
+}
+
+std::string rai::json_write (boost::property_tree::ptree const & tree_a)
+{
+	if (!tree_a.data ().empty ())
+	{
+		throw boost::property_tree::json_parser_error ("ptree contains data that cannot be represented in JSON format", "", 0);
+	}
+	rai::json_writer writer;
+	for (auto & child : tree_a)
+	{
+		writer.tree (child.first, child.second);
+	}
+	return writer.finish ();
+}
+
+void rai::json_read (std::string const & text_a, boost::property_tree::ptree & tree_a)
+{
+	json_reader reader (text_a);
+	reader.parse (tree_a);
+}
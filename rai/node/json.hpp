@@ -0,0 +1,76 @@
+#pragma once
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace rai
+{
+/**
+ * Streams JSON into a string with the layout boost::property_tree::write_json produces when pretty printing,
+ * so large responses can be written without building a ptree first. Values are always written as strings,
+ * and a container that ends up empty is written as "" the way an empty ptree child is.
+ */
+class json_writer
+{
+public:
+	/** Opens the root object */
+	json_writer ();
+	/**
+	 * Hands the document to the sink in pieces, finish () returns what's left. Nothing is handed over while writing,
+	 * pending () says when about chunk_size bytes are ready and send () passes them on, so callers pick the moment
+	 * e.g. after releasing a read transaction.
+	 * The sink returns true when it can't take more, after which error () is set and later pieces are dropped.
+	 */
+	json_writer (std::function<bool(std::string const &)> const &);
+	void begin_object (std::string const &);
+	void begin_object ();
+	void begin_array (std::string const &);
+	void begin_array ();
+	/** Closes the innermost object or array */
+	void end ();
+	void value (std::string const &, std::string const &);
+	void value (std::string const &);
+	/** Writes a ptree as an object member or, without a key, as an array element */
+	void tree (std::string const &, boost::property_tree::ptree const &);
+	void tree (boost::property_tree::ptree const &);
+	/** Closes the root object and returns the document */
+	std::string finish ();
+	/** True once the sink failed */
+	bool error () const;
+	/** True when a piece of about chunk_size bytes is ready for the sink */
+	bool pending () const;
+	/** Hands everything written so far that can't change any more to the sink, returns error () */
+	bool send ();
+	static size_t constexpr chunk_size = 64 * 1024;
+
+private:
+	class level
+	{
+	public:
+		size_t start;
+		char close;
+		bool empty;
+	};
+	size_t final_size () const;
+	void item ();
+	void key (std::string const &);
+	void open (char);
+	void escape (std::string const &);
+	void write_tree (boost::property_tree::ptree const &);
+	std::string output;
+	std::vector<level> levels;
+	std::function<bool(std::string const &)> sink;
+	bool sink_error;
+};
+/** Same output as boost::property_tree::write_json with pretty printing */
+std::string json_write (boost::property_tree::ptree const &);
+/**
+ * Parses a document into the ptree layout boost::property_tree::read_json builds, scalars kept as their text and array
+ * elements under empty keys. Throws boost::property_tree::json_parser_error on malformed input.
+ */
+void json_read (std::string const &, boost::property_tree::ptree &);
+}
@@ -3,6 +3,7 @@
 #include <rai/lib/interface.h>
 #include <rai/node/common.hpp>
 #include <rai/node/rpc.hpp>
+#include <rai/snapshot.hpp>
 
 #include <algorithm>
 #include <future>
@@ -30,9 +31,14 @@ double constexpr rai::node::free_cutoff;
 std::chrono::seconds constexpr rai::node::period;
 std::chrono::seconds constexpr rai::node::cutoff;
 std::chrono::minutes constexpr rai::node::backup_interval;
+std::chrono::minutes constexpr rai::node::checkpoint_interval;
 int constexpr rai::port_mapping::mapping_timeout;
 int constexpr rai::port_mapping::check_timeout;
 unsigned constexpr rai::active_transactions::announce_interval_ms;
+unsigned constexpr rai::confirm_req_batcher::batch_window_ms;
+size_t constexpr rai::confirm_req_limiter::roots_per_second;
+size_t constexpr rai::confirm_req_limiter::roots_burst;
+unsigned constexpr rai::election::recount_interval_ms;
 size_t constexpr rai::block_arrival::arrival_size_min;
 std::chrono::seconds constexpr rai::block_arrival::arrival_time_min;
 
@@ -68,11 +74,7 @@ void rai::network::send_keepalive (rai::endpoint const & endpoint_a)
 	assert (endpoint_a.address ().is_v6 ());
 	rai::keepalive message;
 	node.peers.random_fill (message.peers);
-	std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-	{
-		rai::vectorstream stream (*bytes);
-		message.serialize (stream);
-	}
+	auto bytes (rai::message_buffers ().serialize (message));
 	if (node.config.logging.network_keepalive_logging ())
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Keepalive req sent to %1%") % endpoint_a);
@@ -116,7 +118,7 @@ void rai::node::keepalive (std::string const & address_a, uint16_t port_a)
 	});
 }
 
-void rai::network::republish (rai::block_hash const & hash_a, std::shared_ptr<std::vector<uint8_t>> buffer_a, rai::endpoint endpoint_a)
+void rai::network::republish (rai::block_hash const & hash_a, rai::shared_buffer buffer_a, rai::endpoint endpoint_a)
 {
 	if (node.config.logging.network_publish_logging ())
 	{
@@ -148,11 +150,7 @@ bool confirm_block (MDB_txn * transaction_a, rai::node & node_a, T & list_a, std
 			result = true;
 			auto vote (node_a.store.vote_generate (transaction_a, pub_a, prv_a, block_a));
 			rai::confirm_ack confirm (vote);
-			std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-			{
-				rai::vectorstream stream (*bytes);
-				confirm.serialize (stream);
-			}
+			auto bytes (rai::message_buffers ().serialize (confirm));
 			for (auto j (list_a.begin ()), m (list_a.end ()); j != m; ++j)
 			{
 				node_a.network.confirm_send (confirm, bytes, *j);
@@ -179,11 +177,7 @@ void rai::network::republish_block (MDB_txn * transaction, std::shared_ptr<rai::
 	if (!confirm_block (transaction, node, list, block))
 	{
 		rai::publish message (block);
-		std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-		{
-			rai::vectorstream stream (*bytes);
-			message.serialize (stream);
-		}
+		auto bytes (rai::message_buffers ().serialize (message));
 		auto hash (block->hash ());
 		for (auto i (list.begin ()), n (list.end ()); i != n; ++i)
 		{
@@ -213,11 +207,7 @@ void rai::network::republish_block (MDB_txn * transaction, std::shared_ptr<rai::
 void rai::network::republish_vote (std::shared_ptr<rai::vote> vote_a)
 {
 	rai::confirm_ack confirm (vote_a);
-	std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-	{
-		rai::vectorstream stream (*bytes);
-		confirm.serialize (stream);
-	}
+	auto bytes (rai::message_buffers ().serialize (confirm));
 	auto list (node.peers.list_fanout ());
 	for (auto j (list.begin ()), m (list.end ()); j != m; ++j)
 	{
@@ -225,13 +215,13 @@ void rai::network::republish_vote (std::shared_ptr<rai::vote> vote_a)
 	}
 }
 
-void rai::network::broadcast_confirm_req (std::shared_ptr<rai::block> block_a)
+void rai::network::broadcast_confirm_req (std::shared_ptr<rai::block> block_a, bool batch_a)
 {
 	auto list (std::make_shared<std::vector<rai::peer_information>> (node.peers.representatives (std::numeric_limits<size_t>::max ())));
-	broadcast_confirm_req_base (block_a, list, 0);
+	broadcast_confirm_req_base (block_a, list, 0, batch_a);
 }
 
-void rai::network::broadcast_confirm_req_base (std::shared_ptr<rai::block> block_a, std::shared_ptr<std::vector<rai::peer_information>> endpoints_a, unsigned delay_a)
+void rai::network::broadcast_confirm_req_base (std::shared_ptr<rai::block> block_a, std::shared_ptr<std::vector<rai::peer_information>> endpoints_a, unsigned delay_a, bool batch_a)
 {
 	if (node.config.logging.network_logging ())
 	{
@@ -240,17 +230,25 @@ void rai::network::broadcast_confirm_req_base (std::shared_ptr<rai::block> block
 	auto count (0);
 	while (!endpoints_a->empty () && count < 10)
 	{
-		send_confirm_req (endpoints_a->back ().endpoint, block_a);
+		auto & peer (endpoints_a->back ());
+		if (batch_a && peer.network_version >= rai::protocol_version_confirm_req_batch)
+		{
+			node.confirm_req_batcher.add (peer.endpoint, block_a);
+		}
+		else
+		{
+			send_confirm_req (peer.endpoint, block_a);
+		}
 		endpoints_a->pop_back ();
 		count++;
 	}
 	if (!endpoints_a->empty ())
 	{
 		std::weak_ptr<rai::node> node_w (node.shared ());
-		node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (delay_a), [node_w, block_a, endpoints_a, delay_a]() {
+		node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (delay_a), [node_w, block_a, endpoints_a, delay_a, batch_a]() {
 			if (auto node_l = node_w.lock ())
 			{
-				node_l->network.broadcast_confirm_req_base (block_a, endpoints_a, delay_a + 50);
+				node_l->network.broadcast_confirm_req_base (block_a, endpoints_a, delay_a + 50, batch_a);
 			}
 		});
 	}
@@ -259,11 +257,7 @@ void rai::network::broadcast_confirm_req_base (std::shared_ptr<rai::block> block
 void rai::network::send_confirm_req (rai::endpoint const & endpoint_a, std::shared_ptr<rai::block> block)
 {
 	rai::confirm_req message (block);
-	std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-	{
-		rai::vectorstream stream (*bytes);
-		message.serialize (stream);
-	}
+	auto bytes (rai::message_buffers ().serialize (message));
 	if (node.config.logging.network_message_logging ())
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Sending confirm req to %1%") % endpoint_a);
@@ -281,10 +275,109 @@ void rai::network::send_confirm_req (rai::endpoint const & endpoint_a, std::shar
 	});
 }
 
+void rai::network::send_confirm_req_batch (rai::endpoint const & endpoint_a, rai::confirm_req_batch & message_a)
+{
+	auto bytes (rai::message_buffers ().serialize (message_a));
+	if (node.config.logging.network_message_logging ())
+	{
+		BOOST_LOG (node.log) << boost::str (boost::format ("Sending confirm req for %1% roots to %2%") % message_a.requests.size () % endpoint_a);
+	}
+	std::weak_ptr<rai::node> node_w (node.shared ());
+	node.stats.inc (rai::stat::type::message, rai::stat::detail::confirm_req_batch, rai::stat::dir::out);
+	send_buffer (bytes->data (), bytes->size (), endpoint_a, [bytes, node_w](boost::system::error_code const & ec, size_t size) {
+		if (auto node_l = node_w.lock ())
+		{
+			if (ec && node_l->config.logging.network_logging ())
+			{
+				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending confirm request: %1%") % ec.message ());
+			}
+		}
+	});
+}
+
+rai::confirm_req_batcher::confirm_req_batcher (rai::node & node_a) :
+node (node_a),
+flush_scheduled (false)
+{
+}
+
+void rai::confirm_req_batcher::add (rai::endpoint const & endpoint_a, std::shared_ptr<rai::block> block_a)
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	auto & batch (requests[endpoint_a]);
+	auto request (std::make_pair (block_a->hash (), block_a->root ()));
+	if (std::find (batch.requests.begin (), batch.requests.end (), request) == batch.requests.end ())
+	{
+		batch.requests.push_back (request);
+	}
+	if (batch.requests.size () >= rai::confirm_req_batch::max_requests)
+	{
+		// Full packet, no reason to wait for the window to close
+		auto full (std::move (batch));
+		requests.erase (endpoint_a);
+		lock.unlock ();
+		node.network.send_confirm_req_batch (endpoint_a, full);
+	}
+	else if (!flush_scheduled)
+	{
+		flush_scheduled = true;
+		std::weak_ptr<rai::node> node_w (node.shared ());
+		node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (batch_window_ms), [node_w]() {
+			if (auto node_l = node_w.lock ())
+			{
+				node_l->confirm_req_batcher.flush ();
+			}
+		});
+	}
+}
+
+void rai::confirm_req_batcher::flush ()
+{
+	std::unordered_map<rai::endpoint, rai::confirm_req_batch> requests_l;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		requests_l.swap (requests);
+		flush_scheduled = false;
+	}
+	for (auto & i : requests_l)
+	{
+		node.network.send_confirm_req_batch (i.first, i.second);
+	}
+}
+
+size_t rai::confirm_req_limiter::admit (rai::endpoint const & endpoint_a, size_t count_a, std::chrono::steady_clock::time_point const & now_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto existing (allowances.find (endpoint_a));
+	if (existing == allowances.end ())
+	{
+		existing = allowances.insert (rai::confirm_req_allowance{ endpoint_a, static_cast<double> (roots_burst), now_a }).first;
+	}
+	size_t result (0);
+	allowances.modify (existing, [count_a, &now_a, &result](rai::confirm_req_allowance & allowance_a) {
+		if (now_a > allowance_a.last_refill)
+		{
+			auto elapsed (std::chrono::duration_cast<std::chrono::duration<double>> (now_a - allowance_a.last_refill).count ());
+			allowance_a.roots = std::min (static_cast<double> (roots_burst), allowance_a.roots + elapsed * roots_per_second);
+			allowance_a.last_refill = now_a;
+		}
+		result = std::min (count_a, static_cast<size_t> (allowance_a.roots));
+		allowance_a.roots -= result;
+	});
+	return result;
+}
+
+void rai::confirm_req_limiter::purge (std::chrono::steady_clock::time_point const & cutoff_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto & by_refill (allowances.get<1> ());
+	by_refill.erase (by_refill.begin (), by_refill.lower_bound (cutoff_a));
+}
+
 template <typename T>
 void rep_query (rai::node & node_a, T const & peers_a)
 {
-	rai::transaction transaction (node_a.store.environment, nullptr, false);
+	rai::transaction transaction (node_a.store.backend, nullptr, false);
 	std::shared_ptr<rai::block> block (node_a.store.block_random (transaction));
 	auto hash (block->hash ());
 	node_a.rep_crawler.add (hash);
@@ -352,13 +445,39 @@ public:
 		node.peers.contacted (sender, message_a.header.version_using);
 		node.peers.insert (sender, message_a.header.version_using);
 		node.process_active (message_a.block);
-		rai::transaction transaction_a (node.store.environment, nullptr, false);
+		rai::transaction transaction_a (node.store.backend, nullptr, false);
 		auto successor (node.ledger.successor (transaction_a, message_a.block->root ()));
 		if (successor != nullptr)
 		{
 			confirm_block (transaction_a, node, sender, std::move (successor));
 		}
 	}
+	void confirm_req_batch (rai::confirm_req_batch const & message_a) override
+	{
+		if (node.config.logging.network_message_logging ())
+		{
+			BOOST_LOG (node.log) << boost::str (boost::format ("Confirm_req message from %1% for %2% roots") % sender % message_a.requests.size ());
+		}
+		node.stats.inc (rai::stat::type::message, rai::stat::detail::confirm_req_batch, rai::stat::dir::in);
+		node.peers.contacted (sender, message_a.header.version_using);
+		node.peers.insert (sender, message_a.header.version_using);
+		// Answer every root from one transaction, voting for whichever block we have at the root
+		// Roots past the sender's allowance are dropped, one small packet shouldn't buy an unbounded number of signed votes
+		auto granted (node.confirm_req_limiter.admit (sender, message_a.requests.size ()));
+		if (granted < message_a.requests.size ())
+		{
+			node.stats.add (rai::stat::type::error, rai::stat::detail::throttled, rai::stat::dir::in, message_a.requests.size () - granted);
+		}
+		rai::transaction transaction_a (node.store.backend, nullptr, false);
+		for (auto i (message_a.requests.begin ()), n (message_a.requests.begin () + granted); i != n; ++i)
+		{
+			auto successor (node.ledger.successor (transaction_a, i->second));
+			if (successor != nullptr)
+			{
+				confirm_block (transaction_a, node, sender, std::move (successor));
+			}
+		}
+	}
 	void confirm_ack (rai::confirm_ack const & message_a) override
 	{
 		if (node.config.logging.network_message_logging ())
@@ -472,6 +591,13 @@ void rai::network::receive_action (boost::system::error_code const & error, size
 						BOOST_LOG (node.log) << "Invalid confirm_ack message";
 					}
 				}
+				else if (parser.status == rai::message_parser::parse_status::invalid_confirm_req_batch_message)
+				{
+					if (node.config.logging.network_logging ())
+					{
+						BOOST_LOG (node.log) << "Invalid confirm_req_batch message";
+					}
+				}
 				else
 				{
 					BOOST_LOG (node.log) << "Could not deserialize buffer";
@@ -795,6 +921,25 @@ bool rai::node_init::error ()
 	return block_store_init || wallet_init;
 }
 
+void rai::pruning_config::serialize_json (boost::property_tree::ptree & tree_a) const
+{
+	tree_a.put ("enabled", enabled);
+	tree_a.put ("depth", std::to_string (depth));
+	tree_a.put ("interval", std::to_string (interval));
+	tree_a.put ("batch", std::to_string (batch));
+	tree_a.put ("accounts", std::to_string (accounts));
+}
+
+bool rai::pruning_config::deserialize_json (boost::property_tree::ptree & tree_a)
+{
+	enabled = tree_a.get<bool> ("enabled", enabled);
+	depth = tree_a.get<uint64_t> ("depth", depth);
+	interval = tree_a.get<unsigned> ("interval", interval);
+	batch = tree_a.get<uint64_t> ("batch", batch);
+	accounts = tree_a.get<uint64_t> ("accounts", accounts);
+	return interval == 0 || batch == 0 || accounts == 0;
+}
+
 rai::node_config::node_config () :
 node_config (rai::network::node_port, rai::logging ())
 {
@@ -814,7 +959,9 @@ enable_voting (true),
 bootstrap_connections (4),
 bootstrap_connections_max (64),
 callback_port (0),
-lmdb_max_dbs (128)
+lmdb_max_dbs (128),
+history_index (false),
+history_index_configured (false)
 {
 	switch (rai::rai_network)
 	{
@@ -853,7 +1000,7 @@ lmdb_max_dbs (128)
 
 void rai::node_config::serialize_json (boost::property_tree::ptree & tree_a) const
 {
-	tree_a.put ("version", "12");
+	tree_a.put ("version", "13");
 	tree_a.put ("peering_port", std::to_string (peering_port));
 	tree_a.put ("bootstrap_fraction_numerator", std::to_string (bootstrap_fraction_numerator));
 	tree_a.put ("receive_minimum", receive_minimum.to_string_dec ());
@@ -896,6 +1043,13 @@ void rai::node_config::serialize_json (boost::property_tree::ptree & tree_a) con
 	tree_a.put ("callback_port", std::to_string (callback_port));
 	tree_a.put ("callback_target", callback_target);
 	tree_a.put ("lmdb_max_dbs", lmdb_max_dbs);
+	tree_a.put ("history_index", history_index);
+	boost::property_tree::ptree lmdb_l;
+	lmdb_config.serialize_json (lmdb_l);
+	tree_a.add_child ("lmdb", lmdb_l);
+	boost::property_tree::ptree pruning_l;
+	pruning.serialize_json (pruning_l);
+	tree_a.add_child ("pruning", pruning_l);
 	tree_a.put ("state_block_parse_canary", state_block_parse_canary.to_string ());
 	tree_a.put ("state_block_generate_canary", state_block_generate_canary.to_string ());
 }
@@ -994,6 +1148,11 @@ bool rai::node_config::upgrade_json (unsigned version, boost::property_tree::ptr
 			result = true;
 		}
 		case 12:
+			tree_a.put ("history_index", history_index);
+			tree_a.erase ("version");
+			tree_a.put ("version", "13");
+			result = true;
+		case 13:
 			break;
 		default:
 			throw std::runtime_error ("Unknown node_config version");
@@ -1066,6 +1225,16 @@ bool rai::node_config::deserialize_json (bool & upgraded_a, boost::property_tree
 		{
 			result |= stat_config.deserialize_json (stat_config_l.get ());
 		}
+		auto lmdb_config_l (tree_a.get_child_optional ("lmdb"));
+		if (lmdb_config_l)
+		{
+			result |= lmdb_config.deserialize_json (lmdb_config_l.get ());
+		}
+		auto pruning_l (tree_a.get_child_optional ("pruning"));
+		if (pruning_l)
+		{
+			result |= pruning.deserialize_json (pruning_l.get ());
+		}
 		auto online_weight_minimum_l (tree_a.get<std::string> ("online_weight_minimum"));
 		auto online_weight_quorum_l (tree_a.get<std::string> ("online_weight_quorum"));
 		auto password_fanout_l (tree_a.get<std::string> ("password_fanout"));
@@ -1078,6 +1247,8 @@ bool rai::node_config::deserialize_json (bool & upgraded_a, boost::property_tree
 		auto callback_port_l (tree_a.get<std::string> ("callback_port"));
 		callback_target = tree_a.get<std::string> ("callback_target");
 		auto lmdb_max_dbs_l = tree_a.get<std::string> ("lmdb_max_dbs");
+		history_index = tree_a.get<bool> ("history_index");
+		history_index_configured = true;
 		result |= parse_port (callback_port_l, callback_port);
 		auto state_block_parse_canary_l = tree_a.get<std::string> ("state_block_parse_canary");
 		auto state_block_generate_canary_l = tree_a.get<std::string> ("state_block_generate_canary");
@@ -1136,7 +1307,7 @@ rai::vote_code rai::vote_processor::vote (std::shared_ptr<rai::vote> vote_a, rai
 		result = rai::vote_code::replay;
 		std::shared_ptr<rai::vote> max_vote;
 		{
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			max_vote = node.store.vote_max (transaction, vote_a);
 		}
 		if (!node.active.vote (vote_a) || max_vote->sequence > vote_a->sequence)
@@ -1154,11 +1325,7 @@ rai::vote_code rai::vote_processor::vote (std::shared_ptr<rai::vote> vote_a, rai
 				if (max_vote->sequence > vote_a->sequence + 10000)
 				{
 					rai::confirm_ack confirm (max_vote);
-					std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-					{
-						rai::vectorstream stream (*bytes);
-						confirm.serialize (stream);
-					}
+					auto bytes (rai::message_buffers ().serialize (confirm));
 					node.network.confirm_send (confirm, bytes, endpoint_a);
 				}
 			case rai::vote_code::invalid:
@@ -1229,7 +1396,7 @@ void rai::block_processor::stop ()
 void rai::block_processor::flush ()
 {
 	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && (!blocks.empty () || active))
+	while (!stopped && (!blocks.empty () || !confirmed.empty () || active))
 	{
 		condition.wait (lock);
 	}
@@ -1263,6 +1430,13 @@ void rai::block_processor::force (std::shared_ptr<rai::block> block_a)
 	condition.notify_all ();
 }
 
+void rai::block_processor::confirm (rai::block_hash const & hash_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	confirmed.push_back (hash_a);
+	condition.notify_all ();
+}
+
 void rai::block_processor::process_blocks ()
 {
 	std::unique_lock<std::mutex> lock (mutex);
@@ -1299,17 +1473,29 @@ bool rai::block_processor::should_log ()
 bool rai::block_processor::have_blocks ()
 {
 	assert (!mutex.try_lock ());
-	return !blocks.empty () || !forced.empty ();
+	return !blocks.empty () || !forced.empty () || !confirmed.empty ();
 }
 
 void rai::block_processor::process_receive_many (std::unique_lock<std::mutex> & lock_a)
 {
 	{
-		rai::transaction transaction (node.store.environment, nullptr, true);
+		rai::transaction transaction (node.store.backend, nullptr, true);
 		auto cutoff (std::chrono::steady_clock::now () + rai::transaction_timeout);
 		lock_a.lock ();
+		if (!confirmed.empty ())
+		{
+			// Confirmations share the batch's write transaction instead of each opening one
+			std::deque<rai::block_hash> confirmed_l;
+			confirmed_l.swap (confirmed);
+			lock_a.unlock ();
+			for (auto & hash : confirmed_l)
+			{
+				node.ledger.confirm (transaction, hash);
+			}
+			lock_a.lock ();
+		}
 		auto count (0);
-		while (have_blocks () && count < 16384)
+		while ((!blocks.empty () || !forced.empty ()) && count < 16384)
 		{
 			if (blocks.size () > 64 && should_log ())
 			{
@@ -1366,8 +1552,17 @@ rai::process_return rai::block_processor::process_receive_one (MDB_txn * transac
 			}
 			if (node.block_arrival.recent (hash))
 			{
-				node.active.start (block_a);
+				node.active.start (transaction_a, std::make_pair (block_a, nullptr));
 			}
+			// Weight may have moved onto one of our wallet accounts, legacy receives credit the account's existing representative
+			auto representative (block_a->representative ());
+			if (representative.is_zero () && block_a->type () == rai::block_type::receive)
+			{
+				auto representative_block (node.store.block_get (transaction_a, node.ledger.representative (transaction_a, hash)));
+				assert (representative_block != nullptr);
+				representative = representative_block->representative ();
+			}
+			node.wallets.observe_representative (transaction_a, representative);
 			queue_unchecked (transaction_a, hash);
 			break;
 		}
@@ -1527,6 +1722,32 @@ void rai::block_processor::queue_unchecked (MDB_txn * transaction_a, rai::block_
 	node.gap_cache.blocks.get<1> ().erase (hash_a);
 }
 
+rai::startup_timing::startup_timing () :
+begin (std::chrono::steady_clock::now ()),
+last (begin)
+{
+}
+
+void rai::startup_timing::phase (std::string const & name_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto now (std::chrono::steady_clock::now ());
+	phases_m.push_back (std::make_pair (name_a, std::chrono::duration_cast<std::chrono::milliseconds> (now - last)));
+	last = now;
+}
+
+std::vector<std::pair<std::string, std::chrono::milliseconds>> rai::startup_timing::phases ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return phases_m;
+}
+
+std::chrono::milliseconds rai::startup_timing::total ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return std::chrono::duration_cast<std::chrono::milliseconds> (last - begin);
+}
+
 rai::node::node (rai::node_init & init_a, boost::asio::io_service & service_a, uint16_t peering_port_a, boost::filesystem::path const & application_path_a, rai::alarm & alarm_a, rai::logging const & logging_a, rai::work_pool & work_a) :
 node (init_a, service_a, application_path_a, alarm_a, rai::node_config (peering_port_a, logging_a), work_a)
 {
@@ -1537,7 +1758,7 @@ service (service_a),
 config (config_a),
 alarm (alarm_a),
 work (work_a),
-store (init_a.block_store_init, application_path_a / "data.ldb", config_a.lmdb_max_dbs),
+store (init_a.block_store_init, rai::store_backup::install (application_path_a, config_a.lmdb_max_dbs, config_a.lmdb_config), config_a.lmdb_max_dbs, config_a.lmdb_config),
 gap_cache (*this),
 ledger (store, stats),
 active (*this),
@@ -1549,6 +1770,7 @@ application_path (application_path_a),
 wallets (init_a.block_store_init, *this),
 port_mapping (*this),
 vote_processor (*this),
+confirm_req_batcher (*this),
 warmed_up (0),
 block_processor (*this),
 block_processor_thread ([this]() { this->block_processor.process_blocks (); }),
@@ -1558,6 +1780,10 @@ stats (config.stat_config)
 	wallets.observer = [this](bool active) {
 		observers.wallet (active);
 	};
+	observers.blocks.add ([this](std::shared_ptr<rai::block> block_a, rai::account const & account_a, rai::amount const &, bool) {
+		// A wallet account's frontier moved, possibly from outside our wallet actions, so its cached work is stale
+		wallets.work.frontier (account_a);
+	});
 	peers.peer_observer = [this](rai::endpoint const & endpoint_a) {
 		observers.endpoint (endpoint_a);
 	};
@@ -1693,7 +1919,7 @@ stats (config.stat_config)
 		rai::uint128_t rep_weight;
 		rai::uint128_t min_rep_weight;
 		{
-			rai::transaction transaction (store.environment, nullptr, false);
+			rai::transaction transaction (store.backend, nullptr, false);
 			rep_weight = ledger.weight (transaction, vote_a->account);
 			min_rep_weight = online_reps.online_stake () / 1000;
 		}
@@ -1726,7 +1952,7 @@ stats (config.stat_config)
 		{
 			BOOST_LOG (log) << "Constructing node";
 		}
-		rai::transaction transaction (store.environment, nullptr, true);
+		rai::transaction transaction (store.backend, nullptr, true);
 		if (store.latest_begin (transaction) == store.latest_end ())
 		{
 			// Store was empty meaning we just created it, add the genesis block
@@ -1738,7 +1964,20 @@ stats (config.stat_config)
 				genesis_sc_block.initialize (transaction, store);
 			}
 		}
+		if (config.history_index && !store.history_indexed (transaction))
+		{
+			BOOST_LOG (log) << "Building account history index";
+			store.history_build (transaction);
+		}
+		else if (!config.history_index && config.history_index_configured && store.history_indexed (transaction))
+		{
+			BOOST_LOG (log) << "Clearing account history index";
+			store.history_clear (transaction);
+		}
+		// A node built from a default config, e.g. for a CLI command, keeps an existing index up to date instead of dropping it
+		ledger.history_index = config.history_index || store.history_indexed (transaction);
 	}
+	startup.phase ("ledger");
 	if (rai::rai_network == rai::rai_networks::rai_live_network)
 	{
 		unsigned char rai_bootstrap_weights[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd5, 0xba, 0x6c, 0x7b, 0xb3, 0xf4, 0xf6, 0x54, 0x5e, 0x08, 0xb0, 0x3d, 0x6d, 0xa1, 0x25, 0x88, 0x40, 0xe0, 0x39, 0x50, 0x80, 0x37, 0x8a, 0x89, 0x06, 0x01, 0x99, 0x1a, 0x2a, 0x9e, 0x31, 0x63, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd5, 0x29, 0xae, 0x9e, 0x86, 0x00, 0x00, 0x00 };
@@ -1748,7 +1987,7 @@ stats (config.stat_config)
 		if (!rai::read (weight_stream, block_height))
 		{
 			auto max_blocks = (uint64_t)block_height.number ();
-			rai::transaction transaction (store.environment, nullptr, false);
+			rai::transaction transaction (store.backend, nullptr, false);
 			if (ledger.store.block_count (transaction).sum () < max_blocks)
 			{
 				ledger.bootstrap_weight_max_blocks = max_blocks;
@@ -1770,6 +2009,7 @@ stats (config.stat_config)
 			}
 		}
 	}
+	startup.phase ("bootstrap_weights");
 }
 
 rai::node::~node ()
@@ -1807,13 +2047,13 @@ void rai::node::process_fork (MDB_txn * transaction_a, std::shared_ptr<rai::bloc
 		if (ledger_block)
 		{
 			std::weak_ptr<rai::node> this_w (shared_from_this ());
-			if (!active.start (std::make_pair (ledger_block, block_a), [this_w, root](std::shared_ptr<rai::block>) {
+			if (!active.start (transaction_a, std::make_pair (ledger_block, block_a), [this_w, root](std::shared_ptr<rai::block>) {
 				    if (auto this_l = this_w.lock ())
 				    {
 					    auto attempt (this_l->bootstrap_initiator.current_attempt ());
 					    if (attempt)
 					    {
-						    rai::transaction transaction (this_l->store.environment, nullptr, false);
+						    rai::transaction transaction (this_l->store.backend, nullptr, false);
 						    auto account (this_l->ledger.store.frontier_get (transaction, root));
 						    if (!account.is_zero ())
 						    {
@@ -1828,7 +2068,8 @@ void rai::node::process_fork (MDB_txn * transaction_a, std::shared_ptr<rai::bloc
 			    }))
 			{
 				BOOST_LOG (log) << boost::str (boost::format ("Resolving fork between our block: %1% and block %2% both with root %3%") % ledger_block->hash ().to_string () % block_a->hash ().to_string () % block_a->root ().to_string ());
-				network.broadcast_confirm_req (ledger_block);
+				// Representatives may hold the other side of the fork, the batched request wouldn't show them ours
+				network.broadcast_confirm_req (ledger_block, false);
 			}
 		}
 	}
@@ -1863,19 +2104,19 @@ void rai::gap_cache::add (MDB_txn * transaction_a, std::shared_ptr<rai::block> b
 void rai::gap_cache::vote (std::shared_ptr<rai::vote> vote_a)
 {
 	std::lock_guard<std::mutex> lock (mutex);
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	auto hash (vote_a->block->hash ());
 	auto existing (blocks.get<1> ().find (hash));
 	if (existing != blocks.get<1> ().end ())
 	{
-		existing->votes->vote (vote_a);
+		existing->votes->vote (vote_a, node.ledger.weight (transaction, vote_a->account));
 		auto winner (node.ledger.winner (transaction, *existing->votes));
 		if (winner.first > bootstrap_threshold (transaction))
 		{
 			auto node_l (node.shared ());
 			auto now (std::chrono::steady_clock::now ());
 			node.alarm.add (rai::rai_network == rai::rai_networks::rai_test_network ? now + std::chrono::milliseconds (5) : now + std::chrono::seconds (5), [node_l, hash]() {
-				rai::transaction transaction (node_l->store.environment, nullptr, false);
+				rai::transaction transaction (node_l->store.backend, nullptr, false);
 				if (!node_l->store.block_exists (transaction, hash))
 				{
 					if (!node_l->bootstrap_initiator.in_progress ())
@@ -1914,7 +2155,7 @@ void rai::gap_cache::purge_old ()
 	}
 }
 
-void rai::network::confirm_send (rai::confirm_ack const & confirm_a, std::shared_ptr<std::vector<uint8_t>> bytes_a, rai::endpoint const & endpoint_a)
+void rai::network::confirm_send (rai::confirm_ack const & confirm_a, rai::shared_buffer bytes_a, rai::endpoint const & endpoint_a)
 {
 	if (node.config.logging.network_publish_logging ())
 	{
@@ -1946,7 +2187,7 @@ void rai::node::process_active (std::shared_ptr<rai::block> incoming)
 
 rai::process_return rai::node::process (rai::block const & block_a)
 {
-	rai::transaction transaction (store.environment, nullptr, true);
+	rai::transaction transaction (store.backend, nullptr, true);
 	auto result (ledger.process (transaction, block_a));
 	return result;
 }
@@ -2097,14 +2338,28 @@ void rai::node::start ()
 	ongoing_keepalive ();
 	ongoing_bootstrap ();
 	ongoing_store_flush ();
+	if (config.pruning.enabled)
+	{
+		ongoing_pruning ();
+	}
 	ongoing_rep_crawl ();
 	bootstrap.start ();
 	backup_wallet ();
 	active.announce_votes ();
+	checkpoint_load ();
+	startup.phase ("checkpoint");
+	ongoing_checkpoint ();
 	online_reps.recalculate_stake ();
 	port_mapping.start ();
 	add_initial_peers ();
 	observers.started ();
+	startup.phase ("start");
+	std::string phases;
+	for (auto & i : startup.phases ())
+	{
+		phases += boost::str (boost::format (" %1% %2%ms") % i.first % i.second.count ());
+	}
+	BOOST_LOG (log) << boost::str (boost::format ("Node started in %1%ms:%2%") % startup.total ().count () % phases);
 }
 
 void rai::node::stop ()
@@ -2121,6 +2376,12 @@ void rai::node::stop ()
 	bootstrap.stop ();
 	port_mapping.stop ();
 	wallets.stop ();
+	std::lock_guard<std::mutex> lock (backup_mutex);
+	if (backup != nullptr)
+	{
+		backup->cancel ();
+		backup->join ();
+	}
 }
 
 void rai::node::keepalive_preconfigured (std::vector<std::string> const & peers_a)
@@ -2133,26 +2394,26 @@ void rai::node::keepalive_preconfigured (std::vector<std::string> const & peers_
 
 rai::block_hash rai::node::latest (rai::account const & account_a, rai::block_hash const & token_hash_a)
 {
-	rai::transaction transaction (store.environment, nullptr, false);
+	rai::transaction transaction (store.backend, nullptr, false);
 	return ledger.latest (transaction, account_a, token_hash_a);
 }
 
 rai::uint128_t rai::node::balance (rai::account const & account_a, rai::block_hash const & token_hash_a)
 {
-	rai::transaction transaction (store.environment, nullptr, false);
+	rai::transaction transaction (store.backend, nullptr, false);
 	return ledger.account_balance (transaction, account_a, token_hash_a);
 }
 
 std::unique_ptr<rai::block> rai::node::block (rai::block_hash const & hash_a)
 {
-	rai::transaction transaction (store.environment, nullptr, false);
+	rai::transaction transaction (store.backend, nullptr, false);
 	return store.block_get (transaction, hash_a);
 }
 
 std::pair<rai::uint128_t, rai::uint128_t> rai::node::balance_pending (rai::account const & account_a, rai::block_hash const & token_hash_a)
 {
 	std::pair<rai::uint128_t, rai::uint128_t> result;
-	rai::transaction transaction (store.environment, nullptr, false);
+	rai::transaction transaction (store.backend, nullptr, false);
 	result.first = ledger.account_balance (transaction, account_a, token_hash_a);
 	result.second = ledger.account_pending (transaction, account_a, token_hash_a);
 	return result;
@@ -2160,13 +2421,13 @@ std::pair<rai::uint128_t, rai::uint128_t> rai::node::balance_pending (rai::accou
 
 rai::uint128_t rai::node::weight (rai::account const & account_a)
 {
-	rai::transaction transaction (store.environment, nullptr, false);
+	rai::transaction transaction (store.backend, nullptr, false);
 	return ledger.weight (transaction, account_a);
 }
 
 rai::account rai::node::representative (rai::account const & account_a)
 {
-	rai::transaction transaction (store.environment, nullptr, false);
+	rai::transaction transaction (store.backend, nullptr, false);
 	rai::account_info info;
 	rai::account result (0);
 	if (!store.account_get (transaction, account_a, info))
@@ -2180,6 +2441,7 @@ void rai::node::ongoing_keepalive ()
 {
 	keepalive_preconfigured (config.preconfigured_peers);
 	auto peers_l (peers.purge_list (std::chrono::steady_clock::now () - cutoff));
+	confirm_req_limiter.purge (std::chrono::steady_clock::now () - cutoff);
 	for (auto i (peers_l.begin ()), j (peers_l.end ()); i != j && std::chrono::steady_clock::now () - i->last_attempt > period; ++i)
 	{
 		network.send_keepalive (i->endpoint);
@@ -2235,7 +2497,7 @@ void rai::node::ongoing_bootstrap ()
 void rai::node::ongoing_store_flush ()
 {
 	{
-		rai::transaction transaction (store.environment, nullptr, true);
+		rai::transaction transaction (store.backend, nullptr, true);
 		store.flush (transaction);
 	}
 	std::weak_ptr<rai::node> node_w (shared_from_this ());
@@ -2247,9 +2509,161 @@ void rai::node::ongoing_store_flush ()
 	});
 }
 
+void rai::node::ongoing_pruning ()
+{
+	uint64_t pruned (0);
+	auto more (false);
+	{
+		rai::transaction transaction (store.backend, nullptr, true);
+		// The pass resumes where the last batch stopped, across restarts too
+		rai::account position (0);
+		std::vector<uint8_t> position_l;
+		if (!store.checkpoint_get (transaction, rai::checkpoint::pruning, position_l) && position_l.size () == sizeof (position.bytes))
+		{
+			std::copy (position_l.begin (), position_l.end (), position.bytes.begin ());
+		}
+		auto i (store.latest_begin (transaction, position));
+		auto n (store.latest_end ());
+		uint64_t visited (0);
+		for (; i != n && pruned < config.pruning.batch && visited < config.pruning.accounts; ++i, ++visited)
+		{
+			pruned += ledger.prune (transaction, i->first.uint256 (), config.pruning.depth);
+		}
+		more = i != n;
+		position = more ? rai::account (i->first.uint256 ()) : rai::account (0);
+		store.checkpoint_put (transaction, rai::checkpoint::pruning, std::vector<uint8_t> (position.bytes.begin (), position.bytes.end ()));
+	}
+	if (pruned > 0 && config.logging.ledger_logging ())
+	{
+		BOOST_LOG (log) << boost::str (boost::format ("Pruned %1% blocks") % pruned);
+	}
+	// Finish a pass without waiting once it started, other writers get the ledger between batches
+	auto next (more ? std::chrono::seconds (0) : std::chrono::seconds (config.pruning.interval));
+	std::weak_ptr<rai::node> node_w (shared_from_this ());
+	alarm.add (std::chrono::steady_clock::now () + next, [node_w]() {
+		if (auto node_l = node_w.lock ())
+		{
+			node_l->ongoing_pruning ();
+		}
+	});
+}
+
+void rai::node::ongoing_checkpoint ()
+{
+	checkpoint ();
+	std::weak_ptr<rai::node> node_w (shared_from_this ());
+	alarm.add (std::chrono::steady_clock::now () + checkpoint_interval, [node_w]() {
+		if (auto node_l = node_w.lock ())
+		{
+			node_l->ongoing_checkpoint ();
+		}
+	});
+}
+
+void rai::node::checkpoint ()
+{
+	auto now (rai::seconds_since_epoch ());
+	std::vector<uint8_t> peers_l;
+	size_t peer_count (0);
+	{
+		rai::vectorstream stream (peers_l);
+		rai::write (stream, now);
+		std::unordered_set<rai::endpoint> written;
+		auto write_peer ([&stream, &written, &peer_count](rai::endpoint const & endpoint_a) {
+			if (written.insert (endpoint_a).second)
+			{
+				rai::write (stream, endpoint_a.address ().to_v6 ().to_bytes ());
+				rai::write (stream, endpoint_a.port ());
+				++peer_count;
+			}
+		});
+		// Heaviest representatives first so they're the first to hear from a restarted node
+		for (auto & i : peers.representatives (std::numeric_limits<size_t>::max ()))
+		{
+			write_peer (i.endpoint);
+		}
+		for (auto & i : peers.list ())
+		{
+			write_peer (i);
+		}
+	}
+	auto reps (online_reps.list ());
+	std::vector<uint8_t> reps_l;
+	{
+		rai::vectorstream stream (reps_l);
+		rai::write (stream, now);
+		for (auto & i : reps)
+		{
+			rai::write (stream, i.bytes);
+		}
+	}
+	// An empty table keeps the previous checkpoint, it's a better start than nothing
+	if (peer_count != 0 || !reps.empty ())
+	{
+		rai::transaction transaction (store.backend, nullptr, true);
+		if (peer_count != 0)
+		{
+			store.checkpoint_put (transaction, rai::checkpoint::peers, peers_l);
+		}
+		if (!reps.empty ())
+		{
+			store.checkpoint_put (transaction, rai::checkpoint::online_reps, reps_l);
+		}
+	}
+}
+
+void rai::node::checkpoint_load ()
+{
+	std::vector<uint8_t> peers_l;
+	std::vector<uint8_t> reps_l;
+	{
+		rai::transaction transaction (store.backend, nullptr, false);
+		store.checkpoint_get (transaction, rai::checkpoint::peers, peers_l);
+		store.checkpoint_get (transaction, rai::checkpoint::online_reps, reps_l);
+	}
+	size_t contacted (0);
+	{
+		rai::bufferstream stream (peers_l.data (), peers_l.size ());
+		uint64_t written;
+		if (!rai::read (stream, written))
+		{
+			std::array<uint8_t, 16> address;
+			uint16_t port;
+			while (!rai::read (stream, address) && !rai::read (stream, port))
+			{
+				rai::endpoint endpoint (boost::asio::ip::address_v6 (address), port);
+				if (!peers.not_a_peer (endpoint))
+				{
+					send_keepalive (endpoint);
+					++contacted;
+				}
+			}
+		}
+	}
+	std::vector<rai::account> reps;
+	std::chrono::seconds age (0);
+	{
+		rai::bufferstream stream (reps_l.data (), reps_l.size ());
+		uint64_t written;
+		auto now (rai::seconds_since_epoch ());
+		// Past the cutoff these reps would have timed out had the node kept running
+		if (!rai::read (stream, written) && now < written + cutoff.count ())
+		{
+			age = std::chrono::seconds (now > written ? now - written : 0);
+			rai::account account;
+			while (!rai::read (stream, account.bytes))
+			{
+				reps.push_back (account);
+			}
+		}
+	}
+	online_reps.restore (reps, age);
+	BOOST_LOG (log) << boost::str (boost::format ("Checkpoint contacted %1% peers and restored %2% online representatives") % contacted % reps.size ());
+}
+
 void rai::node::backup_wallet ()
 {
-	rai::transaction transaction (store.environment, nullptr, false);
+	rai::transaction transaction (store.backend, nullptr, false);
 	for (auto i (wallets.items.begin ()), n (wallets.items.end ()); i != n; ++i)
 	{
 		auto backup_path (application_path / "backup");
@@ -2262,6 +2676,21 @@ void rai::node::backup_wallet ()
 	});
 }
 
+std::shared_ptr<rai::store_backup> rai::node::backup_ledger (boost::filesystem::path const & destination_a, uint64_t bytes_per_second_a)
+{
+	std::shared_ptr<rai::store_backup> result;
+	std::lock_guard<std::mutex> lock (backup_mutex);
+	// Stores on another backend have no LMDB environment to copy
+	if ((backup == nullptr || !backup->running) && store.alternate == nullptr)
+	{
+		BOOST_LOG (log) << boost::str (boost::format ("Copying ledger to %1%") % destination_a.string ());
+		result = std::make_shared<rai::store_backup> (store.environment, destination_a, bytes_per_second_a);
+		result->start ();
+		backup = result;
+	}
+	return result;
+}
+
 int rai::node::price (rai::uint128_t const & balance_a, int amount_a)
 {
 	assert (balance_a >= amount_a * rai::Gqlc_ratio);
@@ -2659,7 +3088,8 @@ public:
 
 void rai::node::process_confirmed (std::shared_ptr<rai::block> block_a)
 {
-	rai::transaction transaction (store.environment, nullptr, false);
+	block_processor.confirm (block_a->hash ());
+	rai::transaction transaction (store.backend, nullptr, false);
 	auto hash (block_a->hash ());
 	if (store.block_exists (transaction, hash))
 	{
@@ -2671,7 +3101,7 @@ void rai::node::process_confirmed (std::shared_ptr<rai::block> block_a)
 		rai::account pending_account (0);
 		if (auto state = dynamic_cast<rai::state_block *> (block_a.get ()))
 		{
-			rai::transaction transaction (store.environment, nullptr, false);
+			rai::transaction transaction (store.backend, nullptr, false);
 			is_state_send = ledger.is_send (transaction, *state);
 			pending_account = state->hashables.link;
 		}
@@ -2752,7 +3182,7 @@ void rai::online_reps::vote (std::shared_ptr<rai::vote> const & vote_a)
 	auto rep (vote_a->account);
 	std::lock_guard<std::mutex> lock (mutex);
 	auto now (std::chrono::steady_clock::now ());
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	auto current (reps.begin ());
 	while (current != reps.end () && current->last_heard + std::chrono::seconds (rai::node::cutoff) < now)
 	{
@@ -2788,7 +3218,7 @@ void rai::online_reps::recalculate_stake ()
 {
 	std::lock_guard<std::mutex> lock (mutex);
 	online_stake_total = 0;
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	for (auto it : reps)
 	{
 		online_stake_total += node.ledger.weight (transaction, it.representative);
@@ -2814,6 +3244,19 @@ rai::uint128_t rai::online_reps::online_stake ()
 	return std::max (online_stake_total, node.config.online_weight_minimum.number ());
 }
 
+void rai::online_reps::restore (std::vector<rai::account> const & reps_a, std::chrono::seconds const & age_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto heard (std::chrono::steady_clock::now () - age_a);
+	for (auto & i : reps_a)
+	{
+		if (reps.get<1> ().find (i) == reps.get<1> ().end ())
+		{
+			reps.insert (rai::rep_last_heard_info{ heard, i });
+		}
+	}
+}
+
 std::deque<rai::account> rai::online_reps::list ()
 {
 	std::deque<rai::account> result;
@@ -2827,24 +3270,27 @@ std::deque<rai::account> rai::online_reps::list ()
 
 std::unordered_set<rai::endpoint> rai::peer_container::random_set (size_t count_a)
 {
+	// random_pool isn't safe to share between threads now that this doesn't run under the mutex
+	thread_local std::mt19937 generator (std::random_device{}());
 	std::unordered_set<rai::endpoint> result;
 	result.reserve (count_a);
-	std::lock_guard<std::mutex> lock (mutex);
+	auto snapshot_l (std::atomic_load (&snapshot));
+	auto & peers_l (snapshot_l->peers);
 	// Stop trying to fill result with random samples after this many attempts
 	auto random_cutoff (count_a * 2);
-	auto peers_size (peers.size ());
+	auto peers_size (peers_l.size ());
 	// Usually count_a will be much smaller than peers.size()
 	// Otherwise make sure we have a cutoff on attempting to randomly fill
-	if (!peers.empty ())
+	if (!peers_l.empty ())
 	{
+		std::uniform_int_distribution<size_t> distribution (0, peers_size - 1);
 		for (auto i (0); i < random_cutoff && result.size () < count_a; ++i)
 		{
-			auto index (random_pool.GenerateWord32 (0, peers_size - 1));
-			result.insert (peers.get<3> ()[index].endpoint);
+			result.insert (peers_l[distribution (generator)].endpoint);
 		}
 	}
 	// Fill the remainder with most recent contact
-	for (auto i (peers.get<1> ().begin ()), n (peers.get<1> ().end ()); i != n && result.size () < count_a; ++i)
+	for (auto i (peers_l.begin ()), n (peers_l.end ()); i != n && result.size () < count_a; ++i)
 	{
 		result.insert (i->endpoint);
 	}
@@ -2870,16 +3316,9 @@ void rai::peer_container::random_fill (std::array<rai::endpoint, 8> & target_a)
 // Request a list of the top known representatives
 std::vector<rai::peer_information> rai::peer_container::representatives (size_t count_a)
 {
-	std::vector<peer_information> result;
-	result.reserve (std::min (count_a, size_t (16)));
-	std::lock_guard<std::mutex> lock (mutex);
-	for (auto i (peers.get<6> ().begin ()), n (peers.get<6> ().end ()); i != n && result.size () < count_a; ++i)
-	{
-		if (!i->rep_weight.is_zero ())
-		{
-			result.push_back (*i);
-		}
-	}
+	auto snapshot_l (std::atomic_load (&snapshot));
+	auto & representatives_l (snapshot_l->representatives);
+	std::vector<peer_information> result (representatives_l.begin (), representatives_l.begin () + std::min (count_a, representatives_l.size ()));
 	return result;
 }
 
@@ -2888,9 +3327,14 @@ std::vector<rai::peer_information> rai::peer_container::purge_list (std::chrono:
 	std::vector<rai::peer_information> result;
 	{
 		std::lock_guard<std::mutex> lock (mutex);
+		sync_contacts ();
 		auto pivot (peers.get<1> ().lower_bound (cutoff));
 		result.assign (pivot, peers.get<1> ().end ());
 		// Remove peers that haven't been heard from past the cutoff
+		for (auto i (peers.get<1> ().begin ()); i != pivot; ++i)
+		{
+			contacts.erase (i->endpoint);
+		}
 		peers.get<1> ().erase (peers.get<1> ().begin (), pivot);
 		for (auto i (peers.begin ()), n (peers.end ()); i != n; ++i)
 		{
@@ -2900,6 +3344,7 @@ std::vector<rai::peer_information> rai::peer_container::purge_list (std::chrono:
 		// Remove keepalive attempt tracking for attempts older than cutoff
 		auto attempts_pivot (attempts.get<1> ().lower_bound (cutoff));
 		attempts.get<1> ().erase (attempts.get<1> ().begin (), attempts_pivot);
+		rebuild_snapshot ();
 	}
 	if (result.empty ())
 	{
@@ -2929,10 +3374,40 @@ size_t rai::peer_container::size ()
 
 size_t rai::peer_container::size_sqrt ()
 {
-	auto result (std::ceil (std::sqrt (size ())));
+	auto result (std::ceil (std::sqrt (std::atomic_load (&snapshot)->peers.size ())));
 	return result;
 }
 
+void rai::peer_container::rebuild_snapshot ()
+{
+	auto snapshot_l (std::make_shared<rai::peer_snapshot> ());
+	snapshot_l->peers.assign (peers.get<1> ().begin (), peers.get<1> ().end ());
+	for (auto i (peers.get<6> ().begin ()), n (peers.get<6> ().end ()); i != n && !i->rep_weight.is_zero (); ++i)
+	{
+		snapshot_l->representatives.push_back (*i);
+	}
+	snapshot_l->contacts = contacts;
+	std::atomic_store (&snapshot, std::shared_ptr<rai::peer_snapshot const> (std::move (snapshot_l)));
+}
+
+void rai::peer_container::sync_contacts ()
+{
+	for (auto & i : contacts)
+	{
+		auto existing (peers.find (i.first));
+		if (existing != peers.end ())
+		{
+			std::chrono::steady_clock::time_point contact (std::chrono::steady_clock::duration (i.second->load ()));
+			if (existing->last_contact < contact)
+			{
+				peers.modify (existing, [contact](rai::peer_information & info) {
+					info.last_contact = contact;
+				});
+			}
+		}
+	}
+}
+
 bool rai::peer_container::empty ()
 {
 	return size () == 0;
@@ -2972,6 +3447,10 @@ bool rai::peer_container::rep_response (rai::endpoint const & endpoint_a, rai::a
 				info.probable_rep_account = rep_account_a;
 			}
 		});
+		if (updated)
+		{
+			rebuild_snapshot ();
+		}
 	}
 	return updated;
 }
@@ -3012,19 +3491,33 @@ bool rai::peer_container::insert (rai::endpoint const & endpoint_a, unsigned ver
 	{
 		if (version_a >= rai::protocol_version_min)
 		{
-			std::lock_guard<std::mutex> lock (mutex);
-			auto existing (peers.find (endpoint_a));
-			if (existing != peers.end ())
+			auto now (std::chrono::steady_clock::now ());
+			// Known peers only have their contact time touched, the mutex is for peers joining
+			auto snapshot_l (std::atomic_load (&snapshot));
+			auto contact (snapshot_l->contacts.find (endpoint_a));
+			if (contact != snapshot_l->contacts.end ())
 			{
-				peers.modify (existing, [](rai::peer_information & info) {
-					info.last_contact = std::chrono::steady_clock::now ();
-				});
+				contact->second->store (now.time_since_epoch ().count ());
 				result = true;
 			}
 			else
 			{
-				peers.insert (rai::peer_information (endpoint_a, version_a));
-				unknown = true;
+				std::lock_guard<std::mutex> lock (mutex);
+				auto existing (peers.find (endpoint_a));
+				if (existing != peers.end ())
+				{
+					peers.modify (existing, [now](rai::peer_information & info) {
+						info.last_contact = now;
+					});
+					result = true;
+				}
+				else
+				{
+					peers.insert (rai::peer_information (endpoint_a, version_a));
+					unknown = true;
+				}
+				contacts[endpoint_a] = std::make_shared<std::atomic<std::chrono::steady_clock::rep>> (now.time_since_epoch ().count ());
+				rebuild_snapshot ();
 			}
 		}
 	}
@@ -3172,6 +3665,7 @@ rep_weight (0)
 }
 
 rai::peer_container::peer_container (rai::endpoint const & self_a) :
+snapshot (std::make_shared<rai::peer_snapshot> ()),
 self (self_a),
 peer_observer ([](rai::endpoint const &) {}),
 disconnect_observer ([]() {})
@@ -3228,7 +3722,8 @@ confirmation_action (confirmation_action_a),
 votes (block_a),
 node (node_a),
 status ({ block_a, 0 }),
-confirmed (false)
+confirmed (false),
+last_recount (std::chrono::steady_clock::now ())
 {
 }
 
@@ -3245,7 +3740,7 @@ void rai::election::compute_rep_votes (MDB_txn * transaction_a)
 
 void rai::election::broadcast_winner ()
 {
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	compute_rep_votes (transaction);
 	node.network.republish_block (transaction, status.winner);
 }
@@ -3255,6 +3750,7 @@ void rai::election::confirm_once (MDB_txn * transaction_a)
 	if (!confirmed.exchange (true))
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("confirmed exchange: %1%->%2%") % &confirmed % confirmed.load ());
+		node.stats.inc (rai::stat::type::election, rai::stat::detail::confirmed);
 		auto winner_l (status.winner);
 		auto node_l (node.shared ());
 		auto confirmation_action_l (confirmation_action);
@@ -3273,12 +3769,11 @@ void rai::election::confirm_once (MDB_txn * transaction_a)
 	}
 }
 
-bool rai::election::have_quorum (rai::tally_t const & tally_a)
+bool rai::election::have_quorum ()
 {
-	auto i (tally_a.begin ());
-	auto first (i->first);
-	++i;
-	auto second (i != tally_a.end () ? i->first : 0);
+	auto top_l (votes.top ());
+	auto first (top_l.first);
+	auto second (top_l.second);
 	auto delta_l (node.delta ());
 	auto result (first > (second + delta_l));
 	if (node.config.logging.vote_logging ())
@@ -3291,16 +3786,10 @@ bool rai::election::have_quorum (rai::tally_t const & tally_a)
 
 void rai::election::confirm_if_quorum (MDB_txn * transaction_a)
 {
-	auto tally_l (node.ledger.tally (transaction_a, votes));
-	assert (tally_l.size () > 0);
-	auto winner (tally_l.begin ());
-	auto block_l (winner->second);
-	status.tally = winner->first;
-	rai::uint128_t sum (0);
-	for (auto & i : tally_l)
-	{
-		sum += i.first;
-	}
+	auto block_l (votes.leader ());
+	assert (block_l != nullptr);
+	status.tally = votes.top ().first;
+	auto sum (votes.sum);
 	if (node.config.logging.vote_logging ())
 	{
 		BOOST_LOG (node.log) << boost::str (
@@ -3312,10 +3801,11 @@ void rai::election::confirm_if_quorum (MDB_txn * transaction_a)
 		node_l->block_processor.force (block_l);
 		status.winner = block_l;
 	}
-	if (have_quorum (tally_l))
+	if (have_quorum ())
 	{
 		if (node.config.logging.vote_logging () || !votes.uncontested ())
 		{
+			auto tally_l (votes.tally ());
 			BOOST_LOG (node.log) << boost::str (boost::format ("Vote tally for root %1%") % status.winner->root ().to_string ());
 			for (auto i (tally_l.begin ()), n (tally_l.end ()); i != n; ++i)
 			{
@@ -3330,11 +3820,20 @@ void rai::election::confirm_if_quorum (MDB_txn * transaction_a)
 	}
 }
 
+void rai::election::recount (MDB_txn * transaction_a)
+{
+	for (auto & i : votes.rep_votes)
+	{
+		votes.reweigh (i.first, node.ledger.weight (transaction_a, i.first));
+	}
+	last_recount = std::chrono::steady_clock::now ();
+}
+
 bool rai::election::vote (std::shared_ptr<rai::vote> vote_a)
 {
 	assert (!vote_a->validate ());
 	// see republish_vote documentation for an explanation of these rules
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	auto replay (false);
 	auto supply (node.online_reps.online_stake ());
 	auto weight (node.ledger.weight (transaction, vote_a->account));
@@ -3396,7 +3895,11 @@ bool rai::election::vote (std::shared_ptr<rai::vote> vote_a)
 		{
 			last_votes[vote_a->account] = { std::chrono::steady_clock::now (), vote_a->sequence, vote_a->block->hash () };
 			node.network.republish_vote (vote_a);
-			votes.vote (vote_a);
+			if (last_recount <= std::chrono::steady_clock::now () - std::chrono::milliseconds (recount_interval_ms))
+			{
+				recount (transaction);
+			}
+			votes.vote (vote_a, weight);
 			confirm_if_quorum (transaction);
 		}
 	}
@@ -3406,14 +3909,37 @@ bool rai::election::vote (std::shared_ptr<rai::vote> vote_a)
 void rai::active_transactions::announce_votes ()
 {
 	std::vector<rai::block_hash> inactive;
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	std::lock_guard<std::mutex> lock (mutex);
 	unsigned unconfirmed_count (0);
 	unsigned unconfirmed_announcements (0);
-
-	for (auto i (roots.begin ()), n (roots.end ()); i != n; ++i)
+	auto & by_priority (roots.get<1> ());
+	// The first half of the budget goes to the highest priority elections, the rest to a window past them that moves every interval
+	size_t top (announcements_per_interval - announcements_per_interval / 2);
+	size_t window (announcements_per_interval / 2);
+	size_t rest (roots.size () > top ? roots.size () - top : 0);
+	if (rotation >= rest)
+	{
+		rotation = 0;
+	}
+	size_t position (0);
+	for (auto i (by_priority.begin ()), n (by_priority.end ()); i != n; ++i, ++position)
 	{
 		auto election_l (i->election);
+		if (position >= top && (position - top + rest - rotation) % rest >= window)
+		{
+			// Over budget, lower priority elections wait for the next interval unless they're already settled
+			if (election_l->confirmed)
+			{
+				confirmed.push_back (election_l->status);
+				if (confirmed.size () > election_history_size)
+				{
+					confirmed.pop_front ();
+				}
+				inactive.push_back (election_l->votes.id);
+			}
+			continue;
+		}
 		if (!node.store.root_exists (transaction, election_l->votes.id) || (election_l->confirmed && i->announcements >= announcement_min - 1))
 		{
 			if (election_l->confirmed)
@@ -3459,24 +3985,40 @@ void rai::active_transactions::announce_votes ()
 				}
 				if (!reps->empty ())
 				{
+					// Forks and representatives still silent after a batched round get the block itself, they may not have it
+					auto batch (!i->confirm_req_options.second && i->announcements < announcement_min);
 					// broadcast_confirm_req_base modifies reps, so we clone it once to avoid aliasing
-					node.network.broadcast_confirm_req_base (i->confirm_req_options.first, std::make_shared<std::vector<rai::peer_information>> (*reps), 0);
+					node.network.broadcast_confirm_req_base (i->confirm_req_options.first, std::make_shared<std::vector<rai::peer_information>> (*reps), 0, batch);
 					if (i->confirm_req_options.second)
 					{
-						node.network.broadcast_confirm_req_base (i->confirm_req_options.second, reps, 0);
+						node.network.broadcast_confirm_req_base (i->confirm_req_options.second, reps, 0, batch);
 					}
 				}
 			}
 		}
-		roots.modify (i, [](rai::conflict_info & info_a) {
+		by_priority.modify (i, [](rai::conflict_info & info_a) {
 			++info_a.announcements;
 		});
 	}
+	if (rest > window)
+	{
+		rotation = (rotation + window) % rest;
+	}
 	for (auto i (inactive.begin ()), n (inactive.end ()); i != n; ++i)
 	{
 		assert (roots.find (*i) != roots.end ());
 		roots.erase (*i);
 	}
+	// Fill the room left by finished elections from the backlog, highest priority first
+	auto & backlog_by_priority (backlog.get<1> ());
+	while (roots.size () < active_size_max && !backlog_by_priority.empty ())
+	{
+		auto candidate (backlog_by_priority.begin ());
+		auto election (std::make_shared<rai::election> (node, candidate->blocks.first, candidate->confirmation_action));
+		roots.insert (rai::conflict_info{ candidate->root, election, 0, candidate->blocks, candidate->priority });
+		backlog_by_priority.erase (candidate);
+		node.stats.inc (rai::stat::type::election, rai::stat::detail::admitted);
+	}
 	if (unconfirmed_count > 0)
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks have been unconfirmed averaging %2% announcements") % unconfirmed_count % (unconfirmed_announcements / unconfirmed_count));
@@ -3495,6 +4037,7 @@ void rai::active_transactions::stop ()
 {
 	std::lock_guard<std::mutex> lock (mutex);
 	roots.clear ();
+	backlog.clear ();
 }
 
 bool rai::active_transactions::start (std::shared_ptr<rai::block> block_a, std::function<void(std::shared_ptr<rai::block>)> const & confirmation_action_a)
@@ -3503,18 +4046,90 @@ bool rai::active_transactions::start (std::shared_ptr<rai::block> block_a, std::
 }
 
 bool rai::active_transactions::start (std::pair<std::shared_ptr<rai::block>, std::shared_ptr<rai::block>> blocks_a, std::function<void(std::shared_ptr<rai::block>)> const & confirmation_action_a)
+{
+	rai::transaction transaction (node.store.backend, nullptr, false);
+	return start (transaction, blocks_a, confirmation_action_a);
+}
+
+bool rai::active_transactions::start (MDB_txn * transaction_a, std::pair<std::shared_ptr<rai::block>, std::shared_ptr<rai::block>> blocks_a, std::function<void(std::shared_ptr<rai::block>)> const & confirmation_action_a)
 {
 	assert (blocks_a.first != nullptr);
-	std::lock_guard<std::mutex> lock (mutex);
-	auto primary_block (blocks_a.first);
-	auto root (primary_block->root ());
-	auto existing (roots.find (root));
-	if (existing == roots.end ())
+	auto priority_l (priority (transaction_a, blocks_a.first));
+	std::function<void(std::shared_ptr<rai::block>)> removed_action;
+	auto result (false);
 	{
-		auto election (std::make_shared<rai::election> (node, primary_block, confirmation_action_a));
-		roots.insert (rai::conflict_info{ root, election, 0, blocks_a });
+		std::lock_guard<std::mutex> lock (mutex);
+		auto primary_block (blocks_a.first);
+		auto root (primary_block->root ());
+		result = roots.find (root) != roots.end () || backlog.find (root) != backlog.end ();
+		if (!result)
+		{
+			if (roots.size () < active_size_max)
+			{
+				auto election (std::make_shared<rai::election> (node, primary_block, confirmation_action_a));
+				roots.insert (rai::conflict_info{ root, election, 0, blocks_a, priority_l });
+				node.stats.inc (rai::stat::type::election, rai::stat::detail::admitted);
+			}
+			else
+			{
+				auto & by_priority (backlog.get<1> ());
+				if (backlog.size () >= backlog_size_max)
+				{
+					auto lowest (std::prev (by_priority.end ()));
+					if (priority_l > lowest->priority)
+					{
+						removed_action = lowest->confirmation_action;
+						by_priority.erase (lowest);
+						node.stats.inc (rai::stat::type::election, rai::stat::detail::evicted);
+					}
+					else
+					{
+						// Nothing waiting ranks lower, this one is dropped instead
+						removed_action = confirmation_action_a;
+						result = true;
+						node.stats.inc (rai::stat::type::election, rai::stat::detail::dropped);
+					}
+				}
+				if (!result)
+				{
+					backlog.insert (rai::election_candidate{ root, blocks_a, confirmation_action_a, priority_l });
+					node.stats.inc (rai::stat::type::election, rai::stat::detail::backlogged);
+				}
+			}
+		}
+	}
+	if (removed_action)
+	{
+		node.background ([removed_action]() {
+			removed_action (nullptr);
+		});
 	}
-	return existing != roots.end ();
+	return result;
+}
+
+rai::uint128_t rai::active_transactions::priority (MDB_txn * transaction_a, std::shared_ptr<rai::block> block_a)
+{
+	rai::uint128_t result (0);
+	auto hash (block_a->hash ());
+	if (node.store.block_exists (transaction_a, hash))
+	{
+		if (node.wallets.exists (transaction_a, node.ledger.account (transaction_a, hash)))
+		{
+			result = std::numeric_limits<rai::uint128_t>::max ();
+		}
+		else
+		{
+			result = node.ledger.balance (transaction_a, hash);
+			rai::history_key position (0, 0);
+			if (!node.store.block_height_get (transaction_a, hash, position))
+			{
+				// Balance is shared out over the account's unconfirmed blocks, a busy account doesn't crowd out the rest
+				auto confirmed (node.store.confirmed_height_get (transaction_a, position.account));
+				result /= std::max<uint64_t> (1, position.height () - std::min (confirmed, position.height ()));
+			}
+		}
+	}
+	return result;
 }
 
 // Validate a vote and apply it to the current election if one exists
@@ -3541,7 +4156,7 @@ bool rai::active_transactions::vote (std::shared_ptr<rai::vote> vote_a)
 bool rai::active_transactions::active (rai::block const & block_a)
 {
 	std::lock_guard<std::mutex> lock (mutex);
-	return roots.find (block_a.root ()) != roots.end ();
+	return roots.find (block_a.root ()) != roots.end () || backlog.find (block_a.root ()) != backlog.end ();
 }
 
 // List of active blocks in elections
@@ -3564,16 +4179,21 @@ void rai::active_transactions::erase (rai::block const & block_a)
 		roots.erase (block_a.root ());
 		BOOST_LOG (node.log) << boost::str (boost::format ("Election erased for block block %1% root %2%") % block_a.hash ().to_string () % block_a.root ().to_string ());
 	}
+	backlog.erase (block_a.root ());
 }
 
 rai::active_transactions::active_transactions (rai::node & node_a) :
-node (node_a)
+node (node_a),
+announcements_per_interval (2048),
+active_size_max (16384),
+backlog_size_max (65536),
+rotation (0)
 {
 }
 
 int rai::node::store_version ()
 {
-	rai::transaction transaction (store.environment, nullptr, false);
+	rai::transaction transaction (store.backend, nullptr, false);
 	return store.version_get (transaction);
 }
 
@@ -3620,6 +4240,8 @@ void rai::add_node_options (boost::program_options::options_description & descri
 		("account_key", "Get the public key for <account>")
 		("vacuum", "Compact database. If data_path is missing, the database in data directory is compacted.")
 		("snapshot", "Compact database and create snapshot, functions similar to vacuum but does not replace the existing database")
+		("ledger_export", "Write the ledger in data directory to a checksummed snapshot <file>")
+		("ledger_import", "Load a ledger snapshot <file> in to a database in data directory holding no accounts")
 		("unchecked_clear", "Clear unchecked blocks")
 		("data_path", boost::program_options::value<std::string> (), "Use the supplied path as the data directory")
 		("diagnostics", "Run internal diagnostics")
@@ -3740,7 +4362,7 @@ bool rai::handle_node_options (boost::program_options::variables_map & vm)
 				inactive_node node (data_path);
 				if (vm.count ("unchecked_clear"))
 				{
-					rai::transaction transaction (node.node->store.environment, nullptr, true);
+					rai::transaction transaction (node.node->store.backend, nullptr, true);
 					node.node->store.unchecked_clear (transaction);
 				}
 				success = node.node->copy_with_compaction (vacuum_path);
@@ -3782,7 +4404,7 @@ bool rai::handle_node_options (boost::program_options::variables_map & vm)
 				inactive_node node (data_path);
 				if (vm.count ("unchecked_clear"))
 				{
-					rai::transaction transaction (node.node->store.environment, nullptr, true);
+					rai::transaction transaction (node.node->store.backend, nullptr, true);
 					node.node->store.unchecked_clear (transaction);
 				}
 				success = node.node->copy_with_compaction (snapshot_path);
@@ -3801,11 +4423,83 @@ bool rai::handle_node_options (boost::program_options::variables_map & vm)
 			std::cerr << "Snapshot Failed" << std::endl;
 		}
 	}
+	else if (vm.count ("ledger_export"))
+	{
+		if (vm.count ("file") == 1)
+		{
+			auto error (false);
+			rai::block_store store (error, data_path / "data.ldb");
+			std::ofstream stream (vm["file"].as<std::string> (), std::ios::binary);
+			if (!error && stream.is_open ())
+			{
+				std::cout << "Exporting ledger from " << data_path << std::endl;
+				auto begin (std::chrono::steady_clock::now ());
+				rai::ledger_snapshot snapshot (store);
+				{
+					rai::transaction transaction (store.backend, nullptr, false);
+					result = snapshot.write (transaction, stream);
+				}
+				if (!result)
+				{
+					std::cout << boost::str (boost::format ("Exported %1% entries in %2% ms\n") % snapshot.entries % std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now () - begin).count ());
+				}
+				else
+				{
+					std::cerr << "Error writing snapshot file\n";
+				}
+			}
+			else
+			{
+				std::cerr << "Unable to open database or snapshot file\n";
+				result = true;
+			}
+		}
+		else
+		{
+			std::cerr << "ledger_export command requires one <file> option\n";
+			result = true;
+		}
+	}
+	else if (vm.count ("ledger_import"))
+	{
+		if (vm.count ("file") == 1)
+		{
+			boost::filesystem::create_directories (data_path);
+			auto error (false);
+			rai::block_store store (error, data_path / "data.ldb");
+			std::ifstream stream (vm["file"].as<std::string> (), std::ios::binary);
+			if (!error && stream.is_open ())
+			{
+				std::cout << "Importing ledger in to " << data_path << std::endl;
+				auto begin (std::chrono::steady_clock::now ());
+				rai::ledger_snapshot snapshot (store);
+				result = snapshot.read (stream);
+				if (!result)
+				{
+					std::cout << boost::str (boost::format ("Imported %1% entries in %2% ms\n") % snapshot.entries % std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now () - begin).count ());
+				}
+				else
+				{
+					std::cerr << "Snapshot is corrupt, from another database version or the database already holds accounts\n";
+				}
+			}
+			else
+			{
+				std::cerr << "Unable to open database or snapshot file\n";
+				result = true;
+			}
+		}
+		else
+		{
+			std::cerr << "ledger_import command requires one <file> option\n";
+			result = true;
+		}
+	}
 	else if (vm.count ("unchecked_clear"))
 	{
 		boost::filesystem::path data_path = vm.count ("data_path") ? boost::filesystem::path (vm["data_path"].as<std::string> ()) : rai::working_path ();
 		inactive_node node (data_path);
-		rai::transaction transaction (node.node->store.environment, nullptr, true);
+		rai::transaction transaction (node.node->store.backend, nullptr, true);
 		node.node->store.unchecked_clear (transaction);
 		std::cerr << "Unchecked blocks deleted" << std::endl;
 	}
@@ -4276,7 +4970,7 @@ bool rai::handle_node_options (boost::program_options::variables_map & vm)
 	else if (vm.count ("vote_dump") == 1)
 	{
 		inactive_node node (data_path);
-		rai::transaction transaction (node.node->store.environment, nullptr, false);
+		rai::transaction transaction (node.node->store.backend, nullptr, false);
 		for (auto i (node.node->store.vote_begin (transaction)), n (node.node->store.vote_end ()); i != n; ++i)
 		{
 			bool error (false);
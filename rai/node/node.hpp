@@ -2,6 +2,7 @@
 
 #include <rai/ledger.hpp>
 #include <rai/lib/work.hpp>
+#include <rai/node/backup.hpp>
 #include <rai/node/bootstrap.hpp>
 #include <rai/node/stats.hpp>
 #include <rai/node/wallet.hpp>
@@ -58,19 +59,23 @@ class election : public std::enable_shared_from_this<rai::election>
 public:
 	election (rai::node &, std::shared_ptr<rai::block>, std::function<void(std::shared_ptr<rai::block>)> const &);
 	bool vote (std::shared_ptr<rai::vote>);
-	// Check if we have vote quorum
-	bool have_quorum (rai::tally_t const &);
+	// Check if we have vote quorum from the running totals
+	bool have_quorum ();
 	// Tell the network our view of the winner
 	void broadcast_winner ();
 	// Change our winner to agree with the network
 	void compute_rep_votes (MDB_txn *);
 	// Confirm this block if quorum is met
 	void confirm_if_quorum (MDB_txn *);
+	// Refresh the weight of every representative that voted, picking up ledger weight changes
+	void recount (MDB_txn *);
 	rai::votes votes;
 	rai::node & node;
 	std::unordered_map<rai::account, rai::vote_info> last_votes;
 	rai::election_status status;
 	std::atomic<bool> confirmed;
+	std::chrono::steady_clock::time_point last_recount;
+	static unsigned constexpr recount_interval_ms = (rai::rai_network == rai::rai_networks::rai_test_network) ? 10 : 16000;
 };
 class conflict_info
 {
@@ -80,6 +85,17 @@ public:
 	// Number of announcements in a row for this fork
 	unsigned announcements;
 	std::pair<std::shared_ptr<rai::block>, std::shared_ptr<rai::block>> confirm_req_options;
+	// Higher priority elections are announced first when the announcement budget is exceeded
+	rai::uint128_t priority;
+};
+// Election waiting for room in the active set
+class election_candidate
+{
+public:
+	rai::block_hash root;
+	std::pair<std::shared_ptr<rai::block>, std::shared_ptr<rai::block>> blocks;
+	std::function<void(std::shared_ptr<rai::block>)> confirmation_action;
+	rai::uint128_t priority;
 };
 // Core class for determining consensus
 // Holds all active blocks i.e. recently added blocks that need confirmation
@@ -94,6 +110,13 @@ public:
 	// Should only be used for old elections
 	// The first block should be the one in the ledger
 	bool start (std::pair<std::shared_ptr<rai::block>, std::shared_ptr<rai::block>>, std::function<void(std::shared_ptr<rai::block>)> const & = [](std::shared_ptr<rai::block>) {});
+	// As above, for callers already holding a transaction the blocks are visible in
+	// If the active set is full the election waits in the backlog until there is room
+	// Returns true without starting if the backlog is full of higher priority elections
+	// A waiting election dropped for a higher priority one has its action called with nullptr instead of a winner
+	bool start (MDB_txn *, std::pair<std::shared_ptr<rai::block>, std::shared_ptr<rai::block>>, std::function<void(std::shared_ptr<rai::block>)> const & = [](std::shared_ptr<rai::block>) {});
+	// Scheduling priority, blocks from accounts in our wallets first and then by account balance over its unconfirmed blocks
+	rai::uint128_t priority (MDB_txn *, std::shared_ptr<rai::block>);
 	// If this returns true, the vote is a replay
 	// If this returns false, the vote may or may not be a replay
 	bool vote (std::shared_ptr<rai::vote>);
@@ -106,13 +129,27 @@ public:
 	boost::multi_index_container<
 	rai::conflict_info,
 	boost::multi_index::indexed_by<
-	boost::multi_index::hashed_unique<boost::multi_index::member<rai::conflict_info, rai::block_hash, &rai::conflict_info::root>>>>
+	boost::multi_index::hashed_unique<boost::multi_index::member<rai::conflict_info, rai::block_hash, &rai::conflict_info::root>>,
+	boost::multi_index::ordered_non_unique<boost::multi_index::member<rai::conflict_info, rai::uint128_t, &rai::conflict_info::priority>, std::greater<rai::uint128_t>>>>
 	roots;
+	boost::multi_index_container<
+	rai::election_candidate,
+	boost::multi_index::indexed_by<
+	boost::multi_index::hashed_unique<boost::multi_index::member<rai::election_candidate, rai::block_hash, &rai::election_candidate::root>>,
+	boost::multi_index::ordered_non_unique<boost::multi_index::member<rai::election_candidate, rai::uint128_t, &rai::election_candidate::priority>, std::greater<rai::uint128_t>>>>
+	backlog;
 	std::deque<rai::election_status> confirmed;
 	rai::node & node;
 	std::mutex mutex;
-	// Maximum number of conflicts to vote on per interval, lowest root hash first
-	static unsigned constexpr announcements_per_interval = 32;
+	// Maximum number of elections to announce per interval
+	// Half goes to the highest priority elections, the other half rotates through the rest so none of them starve
+	unsigned announcements_per_interval;
+	// Maximum number of elections running at once
+	size_t active_size_max;
+	// Maximum number of elections waiting for room in the active set, lowest priority is dropped first
+	size_t backlog_size_max;
+	// Position in priority order, past the top half, the rotating announcements start from next interval
+	size_t rotation;
 	// Minimum number of block announcements
 	static unsigned constexpr announcement_min = 4;
 	// Threshold to start logging blocks haven't yet been confirmed
@@ -187,6 +224,18 @@ public:
 	rai::endpoint endpoint;
 	std::chrono::steady_clock::time_point last_attempt;
 };
+// Immutable view of the peer table, replaced as a whole whenever peers join, leave or change weight
+// Readers load it without taking the peer_container mutex
+class peer_snapshot
+{
+public:
+	// All peers, least recently contacted first
+	std::vector<rai::peer_information> peers;
+	// Peers with a known representative weight, heaviest first
+	std::vector<rai::peer_information> representatives;
+	// Shared with peer_container::contacts so contact times can be touched through any snapshot
+	std::unordered_map<rai::endpoint, std::shared_ptr<std::atomic<std::chrono::steady_clock::rep>>> contacts;
+};
 class peer_container
 {
 public:
@@ -220,6 +269,13 @@ public:
 	size_t size ();
 	size_t size_sqrt ();
 	bool empty ();
+	// Publish a new snapshot of peers, must be called with mutex held
+	void rebuild_snapshot ();
+	// Fold contact times recorded outside the mutex back into peers, must be called with mutex held
+	void sync_contacts ();
+	std::shared_ptr<rai::peer_snapshot const> snapshot;
+	// Last contact per peer, updated lock free on every message from a known peer
+	std::unordered_map<rai::endpoint, std::shared_ptr<std::atomic<std::chrono::steady_clock::rep>>> contacts;
 	std::mutex mutex;
 	rai::endpoint self;
 	boost::multi_index_container<
@@ -326,6 +382,8 @@ public:
 	void recalculate_stake ();
 	rai::uint128_t online_stake ();
 	std::deque<rai::account> list ();
+	// Reps from a checkpoint, counted as heard the given age ago so the checkpoint's age carries over
+	void restore (std::vector<rai::account> const &, std::chrono::seconds const &);
 	boost::multi_index_container<
 	rai::rep_last_heard_info,
 	boost::multi_index::indexed_by<
@@ -348,14 +406,16 @@ public:
 	void rpc_action (boost::system::error_code const &, size_t);
 	void republish_vote (std::shared_ptr<rai::vote>);
 	void republish_block (MDB_txn *, std::shared_ptr<rai::block>);
-	void republish (rai::block_hash const &, std::shared_ptr<std::vector<uint8_t>>, rai::endpoint);
+	void republish (rai::block_hash const &, rai::shared_buffer, rai::endpoint);
 	void publish_broadcast (std::vector<rai::peer_information> &, std::unique_ptr<rai::block>);
-	void confirm_send (rai::confirm_ack const &, std::shared_ptr<std::vector<uint8_t>>, rai::endpoint const &);
+	void confirm_send (rai::confirm_ack const &, rai::shared_buffer, rai::endpoint const &);
 	void merge_peers (std::array<rai::endpoint, 8> const &);
 	void send_keepalive (rai::endpoint const &);
-	void broadcast_confirm_req (std::shared_ptr<rai::block>);
-	void broadcast_confirm_req_base (std::shared_ptr<rai::block>, std::shared_ptr<std::vector<rai::peer_information>>, unsigned);
+	// Batched requests only carry the hash, full ones also give the block to representatives that may not have it
+	void broadcast_confirm_req (std::shared_ptr<rai::block>, bool = true);
+	void broadcast_confirm_req_base (std::shared_ptr<rai::block>, std::shared_ptr<std::vector<rai::peer_information>>, unsigned, bool = true);
 	void send_confirm_req (rai::endpoint const &, std::shared_ptr<rai::block>);
+	void send_confirm_req_batch (rai::endpoint const &, rai::confirm_req_batch &);
 	void send_buffer (uint8_t const *, size_t, rai::endpoint const &, std::function<void(boost::system::error_code const &, size_t)>);
 	rai::endpoint endpoint ();
 	rai::endpoint remote;
@@ -367,6 +427,46 @@ public:
 	bool on;
 	static uint16_t const node_port = rai::rai_network == rai::rai_networks::rai_live_network ? 29734 : 54000;
 };
+// Coalesces confirm_req to the same representative within a short window so several roots share a packet
+class confirm_req_batcher
+{
+public:
+	confirm_req_batcher (rai::node &);
+	void add (rai::endpoint const &, std::shared_ptr<rai::block>);
+	// Send every pending batch regardless of size
+	void flush ();
+	rai::node & node;
+	std::mutex mutex;
+	std::unordered_map<rai::endpoint, rai::confirm_req_batch> requests;
+	bool flush_scheduled;
+	static unsigned constexpr batch_window_ms = (rai::rai_network == rai::rai_networks::rai_test_network) ? 5 : 50;
+};
+class confirm_req_allowance
+{
+public:
+	rai::endpoint endpoint;
+	// Roots that can still be answered, refilled over time up to roots_burst
+	double roots;
+	std::chrono::steady_clock::time_point last_refill;
+};
+// Limits how many roots each endpoint can have us vote on, every root answered costs a signature and a confirm_ack
+class confirm_req_limiter
+{
+public:
+	// Takes up to count roots out of the endpoint's allowance and returns how many were granted
+	size_t admit (rai::endpoint const &, size_t, std::chrono::steady_clock::time_point const & = std::chrono::steady_clock::now ());
+	// Forget endpoints not heard from since cutoff, their allowance would be full again
+	void purge (std::chrono::steady_clock::time_point const &);
+	std::mutex mutex;
+	boost::multi_index_container<
+	rai::confirm_req_allowance,
+	boost::multi_index::indexed_by<
+	boost::multi_index::hashed_unique<boost::multi_index::member<rai::confirm_req_allowance, rai::endpoint, &rai::confirm_req_allowance::endpoint>>,
+	boost::multi_index::ordered_non_unique<boost::multi_index::member<rai::confirm_req_allowance, std::chrono::steady_clock::time_point, &rai::confirm_req_allowance::last_refill>>>>
+	allowances;
+	static size_t constexpr roots_per_second = 64;
+	static size_t constexpr roots_burst = 256;
+};
 class logging
 {
 public:
@@ -420,6 +520,31 @@ public:
 	bool block_store_init;
 	bool wallet_init;
 };
+/**
+ * Ledger pruning from the optional 'pruning' node of config.json, off by default
+ * Pruned nodes keep frontiers, balances, pending entries and weights but can't serve the pruned part of chains
+ */
+class pruning_config
+{
+public:
+	void serialize_json (boost::property_tree::ptree &) const;
+	bool deserialize_json (boost::property_tree::ptree &);
+
+	/** Delete the bodies of confirmed state blocks */
+	bool enabled{ false };
+
+	/** Confirmed blocks kept below each account's confirmed height */
+	uint64_t depth{ 4096 };
+
+	/** Seconds between pruning passes over all accounts */
+	unsigned interval{ 300 };
+
+	/** Blocks deleted per write transaction before the pass yields to other writers */
+	uint64_t batch{ 16384 };
+
+	/** Accounts visited per write transaction, bounds a batch over accounts with nothing to prune */
+	uint64_t accounts{ 65536 };
+};
 class node_config
 {
 public:
@@ -448,7 +573,12 @@ public:
 	uint16_t callback_port;
 	std::string callback_target;
 	int lmdb_max_dbs;
+	bool history_index;
+	// Only a history_index read from a config file clears an existing index when false
+	bool history_index_configured;
 	rai::stat_config stat_config;
+	rai::lmdb_config lmdb_config;
+	rai::pruning_config pruning;
 	rai::block_hash state_block_parse_canary;
 	rai::block_hash state_block_generate_canary;
 	static std::chrono::seconds constexpr keepalive_period = std::chrono::seconds (60);
@@ -498,6 +628,8 @@ public:
 	bool full ();
 	void add (std::shared_ptr<rai::block>);
 	void force (std::shared_ptr<rai::block>);
+	// Raises the confirmed height up to this block in the next batch's write transaction
+	void confirm (rai::block_hash const &);
 	bool should_log ();
 	bool have_blocks ();
 	void process_blocks ();
@@ -512,10 +644,29 @@ private:
 	std::chrono::steady_clock::time_point next_log;
 	std::deque<std::shared_ptr<rai::block>> blocks;
 	std::deque<std::shared_ptr<rai::block>> forced;
+	std::deque<rai::block_hash> confirmed;
 	std::condition_variable condition;
 	rai::node & node;
 	std::mutex mutex;
 };
+/**
+ * Durations of the phases of node construction and start, logged once started and reported by the startup RPC
+ */
+class startup_timing
+{
+public:
+	startup_timing ();
+	// Ends the running phase under this name, the next one starts now
+	void phase (std::string const &);
+	std::vector<std::pair<std::string, std::chrono::milliseconds>> phases ();
+	std::chrono::milliseconds total ();
+
+private:
+	std::mutex mutex;
+	std::chrono::steady_clock::time_point begin;
+	std::chrono::steady_clock::time_point last;
+	std::vector<std::pair<std::string, std::chrono::milliseconds>> phases_m;
+};
 class node : public std::enable_shared_from_this<rai::node>
 {
 public:
@@ -549,7 +700,14 @@ public:
 	void ongoing_rep_crawl ();
 	void ongoing_bootstrap ();
 	void ongoing_store_flush ();
+	void ongoing_pruning ();
+	void ongoing_checkpoint ();
+	// Writes peers and online reps to the store so the next start doesn't begin from nothing
+	void checkpoint ();
+	void checkpoint_load ();
 	void backup_wallet ();
+	// Starts an online copy of the ledger to the path, nullptr while another copy is running or the store isn't in LMDB
+	std::shared_ptr<rai::store_backup> backup_ledger (boost::filesystem::path const &, uint64_t);
 	int price (rai::uint128_t const &, int);
 	void work_generate_blocking (rai::block &);
 	uint64_t work_generate_blocking (rai::uint256_union const &);
@@ -563,6 +721,8 @@ public:
 	rai::alarm & alarm;
 	rai::work_pool & work;
 	boost::log::sources::logger_mt log;
+	// Ahead of store so the first phase includes opening it
+	rai::startup_timing startup;
 	rai::block_store store;
 	rai::gap_cache gap_cache;
 	rai::ledger ledger;
@@ -576,8 +736,13 @@ public:
 	rai::wallets wallets;
 	rai::port_mapping port_mapping;
 	rai::vote_processor vote_processor;
+	rai::confirm_req_batcher confirm_req_batcher;
+	rai::confirm_req_limiter confirm_req_limiter;
 	rai::rep_crawler rep_crawler;
 	unsigned warmed_up;
+	std::mutex backup_mutex;
+	// Last online copy, kept after it's done so its status can still be read
+	std::shared_ptr<rai::store_backup> backup;
 	rai::block_processor block_processor;
 	std::thread block_processor_thread;
 	rai::block_arrival block_arrival;
@@ -588,6 +753,8 @@ public:
 	static std::chrono::seconds constexpr period = std::chrono::seconds (60);
 	static std::chrono::seconds constexpr cutoff = period * 5;
 	static std::chrono::minutes constexpr backup_interval = std::chrono::minutes (5);
+	// Well inside cutoff so a quick restart still finds its online reps fresh
+	static std::chrono::minutes constexpr checkpoint_interval = std::chrono::minutes (1);
 	//QLINK
 	std::deque<std::shared_ptr<rai::smart_contract_block>> sc_blocks;
 	std::deque<rai::block_hash> smart_contract_hashs;
@@ -3,6 +3,7 @@
 #include <rai/node/rpc.hpp>
 
 #include <rai/lib/interface.h>
+#include <rai/node/json.hpp>
 #include <rai/node/node.hpp>
 
 #include <boost/proto/transform/make.hpp>
@@ -54,7 +55,11 @@ address (boost::asio::ip::address_v6::loopback ()),
 port (rai::rpc::rpc_port),
 enable_control (false),
 frontier_request_limit (16384),
-chain_request_limit (16384)
+chain_request_limit (16384),
+keepalive_timeout (30),
+keepalive_request_limit (1000),
+handler_threads (std::max<unsigned> (4, std::thread::hardware_concurrency ())),
+expensive_action_limit (2)
 {
 }
 
@@ -63,7 +68,11 @@ address (boost::asio::ip::address_v6::loopback ()),
 port (rai::rpc::rpc_port),
 enable_control (enable_control_a),
 frontier_request_limit (16384),
-chain_request_limit (16384)
+chain_request_limit (16384),
+keepalive_timeout (30),
+keepalive_request_limit (1000),
+handler_threads (std::max<unsigned> (4, std::thread::hardware_concurrency ())),
+expensive_action_limit (2)
 {
 }
 
@@ -74,6 +83,16 @@ void rai::rpc_config::serialize_json (boost::property_tree::ptree & tree_a) cons
 	tree_a.put ("enable_control", enable_control);
 	tree_a.put ("frontier_request_limit", frontier_request_limit);
 	tree_a.put ("chain_request_limit", chain_request_limit);
+	tree_a.put ("keepalive_timeout", keepalive_timeout);
+	tree_a.put ("keepalive_request_limit", keepalive_request_limit);
+	tree_a.put ("handler_threads", std::to_string (handler_threads));
+	tree_a.put ("expensive_action_limit", expensive_action_limit);
+	boost::property_tree::ptree action_limits_l;
+	for (auto & i : action_limits)
+	{
+		action_limits_l.put (i.first, i.second);
+	}
+	tree_a.add_child ("action_limits", action_limits_l);
 }
 
 bool rai::rpc_config::deserialize_json (boost::property_tree::ptree const & tree_a)
@@ -94,12 +113,43 @@ bool rai::rpc_config::deserialize_json (boost::property_tree::ptree const & tree
 			enable_control = tree_a.get<bool> ("enable_control");
 			auto frontier_request_limit_l (tree_a.get<std::string> ("frontier_request_limit"));
 			auto chain_request_limit_l (tree_a.get<std::string> ("chain_request_limit"));
+			// Added after the other entries, configs without them keep the defaults
+			auto keepalive_timeout_l (tree_a.get_optional<std::string> ("keepalive_timeout"));
+			auto keepalive_request_limit_l (tree_a.get_optional<std::string> ("keepalive_request_limit"));
+			auto handler_threads_l (tree_a.get_optional<std::string> ("handler_threads"));
+			auto expensive_action_limit_l (tree_a.get_optional<std::string> ("expensive_action_limit"));
+			auto action_limits_l (tree_a.get_child_optional ("action_limits"));
 			try
 			{
 				port = std::stoul (port_l);
 				result = port > std::numeric_limits<uint16_t>::max ();
 				frontier_request_limit = std::stoull (frontier_request_limit_l);
 				chain_request_limit = std::stoull (chain_request_limit_l);
+				if (keepalive_timeout_l)
+				{
+					keepalive_timeout = std::stoull (keepalive_timeout_l.get ());
+				}
+				if (keepalive_request_limit_l)
+				{
+					keepalive_request_limit = std::stoull (keepalive_request_limit_l.get ());
+				}
+				if (handler_threads_l)
+				{
+					handler_threads = std::stoul (handler_threads_l.get ());
+					result |= handler_threads == 0;
+				}
+				if (expensive_action_limit_l)
+				{
+					expensive_action_limit = std::stoull (expensive_action_limit_l.get ());
+				}
+				if (action_limits_l)
+				{
+					action_limits.clear ();
+					for (auto & i : action_limits_l.get ())
+					{
+						action_limits[i.first] = std::stoull (i.second.get_value<std::string> ());
+					}
+				}
 			}
 			catch (std::logic_error const &)
 			{
@@ -123,7 +173,8 @@ bool rai::rpc_config::deserialize_json (boost::property_tree::ptree const & tree
 rai::rpc::rpc (boost::asio::io_service & service_a, rai::node & node_a, rai::rpc_config const & config_a) :
 acceptor (service_a),
 config (config_a),
-node (node_a)
+node (node_a),
+pool (node_a, config_a.handler_threads)
 {
 }
 
@@ -168,13 +219,99 @@ void rai::rpc::accept ()
 void rai::rpc::stop ()
 {
 	acceptor.close ();
+	pool.stop ();
+}
+
+rai::rpc_pool::rpc_pool (rai::node & node_a, unsigned threads_a) :
+node (node_a),
+stopped (false)
+{
+	for (auto i (0u); i < threads_a; ++i)
+	{
+		threads.push_back (std::thread ([this]() { run (); }));
+	}
+}
+
+rai::rpc_pool::~rpc_pool ()
+{
+	stop ();
+	for (auto & i : threads)
+	{
+		if (i.joinable ())
+		{
+			i.join ();
+		}
+	}
+}
+
+void rai::rpc_pool::add (std::string const & action_a, uint64_t limit_a, std::function<void()> const & handler_a)
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		queue.push_back (entry{ action_a, limit_a, std::chrono::steady_clock::now (), handler_a });
+	}
+	node.stats.inc (rai::stat::type::rpc, rai::stat::detail::queued);
+	condition.notify_all ();
+}
+
+void rai::rpc_pool::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		queue.clear ();
+	}
+	condition.notify_all ();
+}
+
+size_t rai::rpc_pool::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return queue.size ();
+}
+
+void rai::rpc_pool::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		// Oldest handler whose action is below its limit, requests for a saturated action don't hold up the others
+		auto existing (std::find_if (queue.begin (), queue.end (), [this](entry const & entry_a) {
+			return entry_a.limit == 0 || running[entry_a.action] < entry_a.limit;
+		}));
+		if (existing != queue.end ())
+		{
+			auto entry_l (std::move (*existing));
+			queue.erase (existing);
+			++running[entry_l.action];
+			lock.unlock ();
+			auto latency (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - entry_l.queued));
+			node.stats.inc (rai::stat::type::rpc, rai::stat::detail::executed);
+			node.stats.add (rai::stat::type::rpc, rai::stat::detail::latency_us, rai::stat::dir::in, latency.count (), true);
+			entry_l.handler ();
+			lock.lock ();
+			if (--running[entry_l.action] == 0)
+			{
+				running.erase (entry_l.action);
+			}
+			// Handlers waiting on this action's limit may run now
+			condition.notify_all ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
 }
 
-rai::rpc_handler::rpc_handler (rai::node & node_a, rai::rpc & rpc_a, std::string const & body_a, std::function<void(boost::property_tree::ptree const &)> const & response_a) :
+rai::rpc_handler::rpc_handler (rai::node & node_a, rai::rpc & rpc_a, std::string const & body_a, std::function<void(boost::property_tree::ptree const &)> const & response_a, std::function<bool(std::string const &, bool)> const & response_chunk_a, std::function<void()> const & response_abort_a) :
 body (body_a),
 node (node_a),
 rpc (rpc_a),
-response (response_a)
+response (response_a),
+response_chunk (response_chunk_a),
+response_abort (response_abort_a),
+streaming (false)
 {
 }
 
@@ -224,6 +361,34 @@ bool decode_unsigned (std::string const & text, uint64_t & number)
 	result = result || end != text.size ();
 	return result;
 }
+
+/*
+ * Paged actions hand out a cursor naming the store key the next page starts from. It's the hex of the key,
+ * multi part keys concatenated, and clients pass it back without looking inside.
+ */
+std::string cursor_encode (rai::uint256_union const & key_a)
+{
+	return key_a.to_string ();
+}
+
+bool cursor_decode (std::string const & text_a, rai::uint256_union & key_a)
+{
+	return text_a.size () != 64 || key_a.decode_hex (text_a);
+}
+
+bool cursor_decode (std::string const & text_a, rai::uint256_union & first_a, rai::uint256_union & second_a)
+{
+	return text_a.size () != 128 || first_a.decode_hex (text_a.substr (0, 64)) || second_a.decode_hex (text_a.substr (64));
+}
+}
+
+rai::json_writer rai::rpc_handler::response_writer ()
+{
+	auto this_l (shared_from_this ());
+	return rai::json_writer ([this_l](std::string const & chunk_a) {
+		this_l->streaming = true;
+		return this_l->response_chunk (chunk_a, false);
+	});
 }
 
 void rai::rpc_handler::account_balance ()
@@ -235,7 +400,7 @@ void rai::rpc_handler::account_balance ()
 	boost::property_tree::ptree balances;
 	if (!error)
 	{
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		std::vector<rai::account_info> infos;
 		if (!node.store.accounts_get (transaction, account, infos))
 		{
@@ -272,7 +437,7 @@ void rai::rpc_handler::account_block_count ()
 	auto error (account.decode_account (account_text));
 	if (!error)
 	{
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		std::vector<rai::account_info> infos;
 		if (!node.store.accounts_get (transaction, account, infos))
 		{
@@ -304,42 +469,35 @@ void rai::rpc_handler::account_block_count ()
 
 void rai::rpc_handler::account_create ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
+			const bool generate_work = request.get<bool> ("work", true);
+			rai::account new_key (existing->second->deterministic_insert (generate_work));
+			if (!new_key.is_zero ())
 			{
-				const bool generate_work = request.get<bool> ("work", true);
-				rai::account new_key (existing->second->deterministic_insert (generate_work));
-				if (!new_key.is_zero ())
-				{
-					boost::property_tree::ptree response_l;
-					response_l.put ("account", new_key.to_account ());
-					response (response_l);
-				}
-				else
-				{
-					error_response (response, "Wallet is locked");
-				}
+				boost::property_tree::ptree response_l;
+				response_l.put ("account", new_key.to_account ());
+				response (response_l);
 			}
 			else
 			{
-				error_response (response, "Wallet not found");
+				error_response (response, "Wallet is locked");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
@@ -370,7 +528,7 @@ void rai::rpc_handler::account_info ()
 		const bool representative = request.get<bool> ("representative", false);
 		const bool weight = request.get<bool> ("weight", false);
 		const bool pending = request.get<bool> ("pending", false);
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		std::vector<rai::account_info> infos;
 		if (!node.store.accounts_get (transaction, account, infos))
 		{
@@ -386,6 +544,8 @@ void rai::rpc_handler::account_info ()
 				rai::uint128_union (info.balance).encode_dec (balance);
 				info_l.put ("balance", balance);
 				info_l.put ("modified_timestamp", std::to_string (info.modified));
+				info_l.put ("block_count", std::to_string (info.block_count));
+				info_l.put ("confirmation_height", std::to_string (node.store.confirmed_height_get (transaction, info.open_block)));
 				auto sc_info = rai::get_sc_info (info.token_type);
 				info_l.put ("token", *std::next (sc_info.begin (), 0));
 				info_l.put ("token_hash", info.token_type.to_string ());
@@ -396,9 +556,9 @@ void rai::rpc_handler::account_info ()
 				//				token.put ("create_at", *std::next (sc_info.begin (), 5));
 				if (representative)
 				{
-					auto block (node.store.block_get (transaction, info.rep_block));
-					assert (block != nullptr);
-					info_l.put ("representative", block->representative ().to_account ());
+					auto block (node.store.block_view_get (transaction, info.rep_block));
+					assert (block.exists ());
+					info_l.put ("representative", block.representative ().to_account ());
 				}
 				if (weight)
 				{
@@ -455,7 +615,7 @@ void rai::rpc_handler::account_list ()
 		{
 			boost::property_tree::ptree response_l;
 			boost::property_tree::ptree accounts;
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			for (auto i (existing->second->store.begin (transaction)), j (existing->second->store.end ()); i != j; ++i)
 			{
 				boost::property_tree::ptree entry;
@@ -478,123 +638,109 @@ void rai::rpc_handler::account_list ()
 
 void rai::rpc_handler::account_move ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	std::string source_text (request.get<std::string> ("source"));
+	auto accounts_text (request.get_child ("accounts"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		std::string source_text (request.get<std::string> ("source"));
-		auto accounts_text (request.get_child ("accounts"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
+			auto wallet (existing->second);
+			rai::uint256_union source;
+			auto error (source.decode_hex (source_text));
+			if (!error)
 			{
-				auto wallet (existing->second);
-				rai::uint256_union source;
-				auto error (source.decode_hex (source_text));
-				if (!error)
+				auto existing (node.wallets.items.find (source));
+				if (existing != node.wallets.items.end ())
 				{
-					auto existing (node.wallets.items.find (source));
-					if (existing != node.wallets.items.end ())
-					{
-						auto source (existing->second);
-						std::vector<rai::public_key> accounts;
-						for (auto i (accounts_text.begin ()), n (accounts_text.end ()); i != n; ++i)
-						{
-							rai::public_key account;
-							account.decode_hex (i->second.get<std::string> (""));
-							accounts.push_back (account);
-						}
-						rai::transaction transaction (node.store.environment, nullptr, true);
-						auto error (wallet->store.move (transaction, source->store, accounts));
-						boost::property_tree::ptree response_l;
-						response_l.put ("moved", error ? "0" : "1");
-						response (response_l);
-					}
-					else
+					auto source (existing->second);
+					std::vector<rai::public_key> accounts;
+					for (auto i (accounts_text.begin ()), n (accounts_text.end ()); i != n; ++i)
 					{
-						error_response (response, "Source not found");
+						rai::public_key account;
+						account.decode_hex (i->second.get<std::string> (""));
+						accounts.push_back (account);
 					}
+					rai::transaction transaction (node.store.backend, nullptr, true);
+					auto error (wallet->store.move (transaction, source->store, accounts));
+					boost::property_tree::ptree response_l;
+					response_l.put ("moved", error ? "0" : "1");
+					response (response_l);
 				}
 				else
 				{
-					error_response (response, "Bad source number");
+					error_response (response, "Source not found");
 				}
 			}
 			else
 			{
-				error_response (response, "Wallet not found");
+				error_response (response, "Bad source number");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
 void rai::rpc_handler::account_remove ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	std::string account_text (request.get<std::string> ("account"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		std::string account_text (request.get<std::string> ("account"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
+			auto wallet (existing->second);
+			rai::transaction transaction (node.store.backend, nullptr, true);
+			if (existing->second->store.valid_password (transaction))
 			{
-				auto wallet (existing->second);
-				rai::transaction transaction (node.store.environment, nullptr, true);
-				if (existing->second->store.valid_password (transaction))
+				rai::account account_id;
+				auto error (account_id.decode_account (account_text));
+				if (!error)
 				{
-					rai::account account_id;
-					auto error (account_id.decode_account (account_text));
-					if (!error)
+					auto account (wallet->store.find (transaction, account_id));
+					if (account != wallet->store.end ())
 					{
-						auto account (wallet->store.find (transaction, account_id));
-						if (account != wallet->store.end ())
-						{
-							wallet->store.erase (transaction, account_id);
-							boost::property_tree::ptree response_l;
-							response_l.put ("removed", "1");
-							response (response_l);
-						}
-						else
-						{
-							error_response (response, "Account not found in wallet");
-						}
+						wallet->store.erase (transaction, account_id);
+						boost::property_tree::ptree response_l;
+						response_l.put ("removed", "1");
+						response (response_l);
 					}
 					else
 					{
-						error_response (response, "Bad account number");
+						error_response (response, "Account not found in wallet");
 					}
 				}
 				else
 				{
-					error_response (response, "Wallet locked");
+					error_response (response, "Bad account number");
 				}
 			}
 			else
 			{
-				error_response (response, "Wallet not found");
+				error_response (response, "Wallet locked");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
@@ -605,15 +751,15 @@ void rai::rpc_handler::account_representative ()
 	auto error (account.decode_account (account_text));
 	if (!error)
 	{
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		rai::account_info info;
 		auto error (node.store.accounts_get_first (transaction, account, info));
 		if (!error)
 		{
-			auto block (node.store.block_get (transaction, info.rep_block));
-			assert (block != nullptr);
+			auto block (node.store.block_view_get (transaction, info.rep_block));
+			assert (block.exists ());
 			boost::property_tree::ptree response_l;
-			response_l.put ("representative", block->representative ().to_account ());
+			response_l.put ("representative", block.representative ().to_account ());
 			response (response_l);
 		}
 		else
@@ -629,82 +775,75 @@ void rai::rpc_handler::account_representative ()
 
 void rai::rpc_handler::account_representative_set ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
+			auto wallet (existing->second);
+			std::string account_text (request.get<std::string> ("account"));
+			rai::account account;
+			auto error (account.decode_account (account_text));
+			if (!error)
 			{
-				auto wallet (existing->second);
-				std::string account_text (request.get<std::string> ("account"));
-				rai::account account;
-				auto error (account.decode_account (account_text));
+				std::string representative_text (request.get<std::string> ("representative"));
+				rai::account representative;
+				auto error (representative.decode_account (representative_text));
 				if (!error)
 				{
-					std::string representative_text (request.get<std::string> ("representative"));
-					rai::account representative;
-					auto error (representative.decode_account (representative_text));
-					if (!error)
+					uint64_t work (0);
+					boost::optional<std::string> work_text (request.get_optional<std::string> ("work"));
+					if (work_text.is_initialized ())
 					{
-						uint64_t work (0);
-						boost::optional<std::string> work_text (request.get_optional<std::string> ("work"));
-						if (work_text.is_initialized ())
+						auto work_error (rai::from_string_hex (work_text.get (), work));
+						if (work_error)
 						{
-							auto work_error (rai::from_string_hex (work_text.get (), work));
-							if (work_error)
-							{
-								error_response (response, "Bad work");
-							}
+							error_response (response, "Bad work");
 						}
-						if (work)
+					}
+					if (work)
+					{
+						rai::transaction transaction (node.store.backend, nullptr, true);
+						rai::account_info info;
+						if (!node.store.accounts_get (transaction, account, rai::chain_token_type, info))
 						{
-							rai::transaction transaction (node.store.environment, nullptr, true);
-							rai::account_info info;
-							if (!node.store.accounts_get (transaction, account, rai::chain_token_type, info))
+							if (!rai::work_validate (info.head, work))
 							{
-								if (!rai::work_validate (info.head, work))
-								{
-									existing->second->store.work_put (transaction, account, work);
-								}
-								else
-								{
-									error_response (response, "Invalid work");
-								}
+								existing->second->store.work_put (transaction, account, work);
 							}
 							else
 							{
-								error_response (response, "Account not found");
+								error_response (response, "Invalid work");
 							}
 						}
-						auto response_a (response);
-						wallet->change_async (account, representative, [response_a](std::shared_ptr<rai::block> block) {
-							rai::block_hash hash (0);
-							if (block != nullptr)
-							{
-								hash = block->hash ();
-							}
-							boost::property_tree::ptree response_l;
-							response_l.put ("block", hash.to_string ());
-							response_a (response_l);
-						},
-						work == 0);
+						else
+						{
+							error_response (response, "Account not found");
+						}
 					}
+					auto response_a (response);
+					wallet->change_async (account, representative, [response_a](std::shared_ptr<rai::block> block) {
+						rai::block_hash hash (0);
+						if (block != nullptr)
+						{
+							hash = block->hash ();
+						}
+						boost::property_tree::ptree response_l;
+						response_l.put ("block", hash.to_string ());
+						response_a (response_l);
+					},
+					work == 0);
 				}
-				else
-				{
-					error_response (response, "Bad account number");
-				}
+			}
+			else
+			{
+				error_response (response, "Bad account number");
 			}
 		}
 	}
-	else
-	{
-		error_response (response, "RPC control is disabled");
-	}
 }
 
 void rai::rpc_handler::account_weight ()
@@ -729,7 +868,7 @@ void rai::rpc_handler::accounts_balances ()
 {
 	boost::property_tree::ptree response_l;
 	boost::property_tree::ptree balances;
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	for (auto & accounts : request.get_child ("accounts"))
 	{
 		std::string account_text = accounts.second.data ();
@@ -770,55 +909,48 @@ void rai::rpc_handler::accounts_balances ()
 
 void rai::rpc_handler::accounts_create ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		uint64_t count;
+		std::string count_text (request.get<std::string> ("count"));
+		auto count_error (decode_unsigned (count_text, count));
+		if (!count_error && count != 0)
 		{
-			uint64_t count;
-			std::string count_text (request.get<std::string> ("count"));
-			auto count_error (decode_unsigned (count_text, count));
-			if (!count_error && count != 0)
+			auto existing (node.wallets.items.find (wallet));
+			if (existing != node.wallets.items.end ())
 			{
-				auto existing (node.wallets.items.find (wallet));
-				if (existing != node.wallets.items.end ())
+				const bool generate_work = request.get<bool> ("work", false);
+				boost::property_tree::ptree response_l;
+				boost::property_tree::ptree accounts;
+				for (auto i (0); accounts.size () < count; ++i)
 				{
-					const bool generate_work = request.get<bool> ("work", false);
-					boost::property_tree::ptree response_l;
-					boost::property_tree::ptree accounts;
-					for (auto i (0); accounts.size () < count; ++i)
+					rai::account new_key (existing->second->deterministic_insert (generate_work));
+					if (!new_key.is_zero ())
 					{
-						rai::account new_key (existing->second->deterministic_insert (generate_work));
-						if (!new_key.is_zero ())
-						{
-							boost::property_tree::ptree entry;
-							entry.put ("", new_key.to_account ());
-							accounts.push_back (std::make_pair ("", entry));
-						}
+						boost::property_tree::ptree entry;
+						entry.put ("", new_key.to_account ());
+						accounts.push_back (std::make_pair ("", entry));
 					}
-					response_l.add_child ("accounts", accounts);
-					response (response_l);
-				}
-				else
-				{
-					error_response (response, "Wallet not found");
 				}
+				response_l.add_child ("accounts", accounts);
+				response (response_l);
 			}
 			else
 			{
-				error_response (response, "Invalid count limit");
+				error_response (response, "Wallet not found");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Invalid count limit");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
@@ -826,7 +958,7 @@ void rai::rpc_handler::accounts_frontiers ()
 {
 	boost::property_tree::ptree response_l;
 	boost::property_tree::ptree frontiers;
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	for (auto & accounts : request.get_child ("accounts"))
 	{
 		std::string account_text = accounts.second.data ();
@@ -882,7 +1014,7 @@ void rai::rpc_handler::accounts_pending ()
 	const bool source = request.get<bool> ("source", false);
 	boost::property_tree::ptree response_l;
 	boost::property_tree::ptree pending;
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	for (auto & accounts : request.get_child ("accounts"))
 	{
 		std::string account_text = accounts.second.data ();
@@ -948,31 +1080,107 @@ void rai::rpc_handler::available_supply ()
 	response (response_l);
 }
 
-void rai::rpc_handler::block ()
+void rai::rpc_handler::backup ()
 {
-	std::string hash_text (request.get<std::string> ("hash"));
-	rai::uint256_union hash;
-	auto error (hash.decode_hex (hash_text));
-	if (!error)
+	uint64_t limit (0);
+	auto error (false);
+	boost::optional<std::string> limit_text (request.get_optional<std::string> ("limit"));
+	if (limit_text.is_initialized ())
 	{
-		rai::transaction transaction (node.store.environment, nullptr, false);
-		auto block (node.store.block_get (transaction, hash));
-		if (block != nullptr)
+		error = decode_unsigned (limit_text.get (), limit);
+	}
+	if (!error && request.get<bool> ("compact", false))
+	{
+		// A copy taken while the node runs falls behind data.ldb, the ledger is compacted at the next start instead
+		if (!rai::store_backup::schedule_compaction (node.application_path))
 		{
 			boost::property_tree::ptree response_l;
-			std::string contents;
-			block->serialize_json (contents);
-			response_l.put ("contents", contents);
+			response_l.put ("scheduled", "1");
 			response (response_l);
 		}
 		else
 		{
-			error_response (response, "Block not found");
+			error_response (response, "Unable to schedule compaction");
 		}
 	}
-	else
+	else if (!error)
 	{
-		error_response (response, "Bad hash number");
+		// Copies only go to fixed places in the data directory
+		auto destination (node.application_path / "backup" / boost::str (boost::format ("ledger_%1%.ldb") % std::chrono::system_clock::to_time_t (std::chrono::system_clock::now ())));
+		auto backup_l (node.backup_ledger (destination, limit));
+		if (backup_l != nullptr)
+		{
+			boost::property_tree::ptree response_l;
+			backup_l->serialize_json (response_l);
+			response (response_l);
+		}
+		else
+		{
+			error_response (response, "Backup already running");
+		}
+	}
+	else
+	{
+		error_response (response, "Invalid limit");
+	}
+}
+
+void rai::rpc_handler::backup_cancel ()
+{
+	std::lock_guard<std::mutex> lock (node.backup_mutex);
+	if (node.backup != nullptr)
+	{
+		node.backup->cancel ();
+		boost::property_tree::ptree response_l;
+		response_l.put ("success", "");
+		response (response_l);
+	}
+	else
+	{
+		error_response (response, "No backup");
+	}
+}
+
+void rai::rpc_handler::backup_status ()
+{
+	std::lock_guard<std::mutex> lock (node.backup_mutex);
+	if (node.backup != nullptr)
+	{
+		boost::property_tree::ptree response_l;
+		node.backup->serialize_json (response_l);
+		response (response_l);
+	}
+	else
+	{
+		error_response (response, "No backup");
+	}
+}
+
+void rai::rpc_handler::block ()
+{
+	std::string hash_text (request.get<std::string> ("hash"));
+	rai::uint256_union hash;
+	auto error (hash.decode_hex (hash_text));
+	if (!error)
+	{
+		rai::transaction transaction (node.store.backend, nullptr, false);
+		auto block (node.store.block_get (transaction, hash));
+		if (block != nullptr)
+		{
+			boost::property_tree::ptree response_l;
+			std::string contents;
+			block->serialize_json (contents);
+			response_l.put ("contents", contents);
+			response (response_l);
+		}
+		else
+		{
+			error_response (response, "Block not found");
+		}
+	}
+	else
+	{
+		error_response (response, "Bad hash number");
 	}
 }
 
@@ -982,7 +1190,7 @@ void rai::rpc_handler::block_confirm ()
 	rai::block_hash hash_l;
 	if (!hash_l.decode_hex (hash_text))
 	{
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		auto block_l (node.store.block_get (transaction, hash_l));
 		if (block_l != nullptr)
 		{
@@ -1007,7 +1215,7 @@ void rai::rpc_handler::blocks ()
 	std::vector<std::string> hashes;
 	boost::property_tree::ptree response_l;
 	boost::property_tree::ptree blocks;
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	for (boost::property_tree::ptree::value_type & hashes : request.get_child ("hashes"))
 	{
 		std::string hash_text = hashes.second.data ();
@@ -1044,7 +1252,7 @@ void rai::rpc_handler::blocks_info ()
 	std::vector<std::string> hashes;
 	boost::property_tree::ptree response_l;
 	boost::property_tree::ptree blocks;
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	for (boost::property_tree::ptree::value_type & hashes : request.get_child ("hashes"))
 	{
 		std::string hash_text = hashes.second.data ();
@@ -1063,6 +1271,8 @@ void rai::rpc_handler::blocks_info ()
 				std::string contents;
 				block->serialize_json (contents);
 				entry.put ("contents", contents);
+				entry.put ("height", std::to_string (node.ledger.height (transaction, hash)));
+				entry.put ("confirmed", node.ledger.block_confirmed (transaction, hash) ? "1" : "0");
 				if (pending)
 				{
 					bool exists (false);
@@ -1114,7 +1324,7 @@ void rai::rpc_handler::block_account ()
 	rai::block_hash hash;
 	if (!hash.decode_hex (hash_text))
 	{
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		if (node.store.block_exists (transaction, hash))
 		{
 			boost::property_tree::ptree response_l;
@@ -1135,7 +1345,7 @@ void rai::rpc_handler::block_account ()
 
 void rai::rpc_handler::block_count ()
 {
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	boost::property_tree::ptree response_l;
 	response_l.put ("count", std::to_string (node.store.block_count (transaction).sum ()));
 	response_l.put ("unchecked", std::to_string (node.store.unchecked_count (transaction)));
@@ -1144,7 +1354,7 @@ void rai::rpc_handler::block_count ()
 
 void rai::rpc_handler::transactions_count ()
 {
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	boost::property_tree::ptree response_l;
 	response_l.put ("count", std::to_string (node.store.block_count (transaction).sum () - rai::map_sc_info.size ()));
 	response_l.put ("unchecked", std::to_string (node.store.unchecked_count (transaction)));
@@ -1153,7 +1363,7 @@ void rai::rpc_handler::transactions_count ()
 
 void rai::rpc_handler::block_count_type ()
 {
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	rai::block_counts count (node.store.block_count (transaction));
 	boost::property_tree::ptree response_l;
 	response_l.put ("send", std::to_string (count.send));
@@ -1167,366 +1377,359 @@ void rai::rpc_handler::block_count_type ()
 // FIXME: TOKEN_TYPE
 void rai::rpc_handler::block_create ()
 {
-	if (rpc.config.enable_control)
+	std::string type (request.get<std::string> ("type"));
+	rai::uint256_union wallet (0);
+	boost::optional<std::string> wallet_text (request.get_optional<std::string> ("wallet"));
+	if (wallet_text.is_initialized ())
 	{
-		std::string type (request.get<std::string> ("type"));
-		rai::uint256_union wallet (0);
-		boost::optional<std::string> wallet_text (request.get_optional<std::string> ("wallet"));
-		if (wallet_text.is_initialized ())
+		auto error (wallet.decode_hex (wallet_text.get ()));
+		if (error)
 		{
-			auto error (wallet.decode_hex (wallet_text.get ()));
-			if (error)
-			{
-				error_response (response, "Bad wallet number");
-			}
+			error_response (response, "Bad wallet number");
 		}
-		rai::uint256_union account (0);
-		boost::optional<std::string> account_text (request.get_optional<std::string> ("account"));
-		if (account_text.is_initialized ())
+	}
+	rai::uint256_union account (0);
+	boost::optional<std::string> account_text (request.get_optional<std::string> ("account"));
+	if (account_text.is_initialized ())
+	{
+		auto error_account (account.decode_account (account_text.get ()));
+		if (error_account)
 		{
-			auto error_account (account.decode_account (account_text.get ()));
-			if (error_account)
-			{
-				error_response (response, "Bad account number");
-			}
+			error_response (response, "Bad account number");
 		}
-		rai::uint256_union representative (0);
-		boost::optional<std::string> representative_text (request.get_optional<std::string> ("representative"));
-		if (representative_text.is_initialized ())
+	}
+	rai::uint256_union representative (0);
+	boost::optional<std::string> representative_text (request.get_optional<std::string> ("representative"));
+	if (representative_text.is_initialized ())
+	{
+		auto error_representative (representative.decode_account (representative_text.get ()));
+		if (error_representative)
 		{
-			auto error_representative (representative.decode_account (representative_text.get ()));
-			if (error_representative)
-			{
-				error_response (response, "Bad representative account");
-			}
+			error_response (response, "Bad representative account");
 		}
-		rai::uint256_union destination (0);
-		boost::optional<std::string> destination_text (request.get_optional<std::string> ("destination"));
-		if (destination_text.is_initialized ())
+	}
+	rai::uint256_union destination (0);
+	boost::optional<std::string> destination_text (request.get_optional<std::string> ("destination"));
+	if (destination_text.is_initialized ())
+	{
+		auto error_destination (destination.decode_account (destination_text.get ()));
+		if (error_destination)
 		{
-			auto error_destination (destination.decode_account (destination_text.get ()));
-			if (error_destination)
-			{
-				error_response (response, "Bad destination account");
-			}
+			error_response (response, "Bad destination account");
 		}
-		rai::block_hash token_type (0);
-		boost::optional<std::string> token_text (request.get_optional<std::string> ("token"));
-		if (token_text.is_initialized ())
+	}
+	rai::block_hash token_type (0);
+	boost::optional<std::string> token_text (request.get_optional<std::string> ("token"));
+	if (token_text.is_initialized ())
+	{
+		auto error_destination (token_type.decode_hex (token_text.get ()));
+		if (token_text)
 		{
-			auto error_destination (token_type.decode_hex (token_text.get ()));
-			if (token_text)
-			{
-				error_response (response, "Bad token type");
-			}
+			error_response (response, "Bad token type");
 		}
-		rai::block_hash source (0);
-		boost::optional<std::string> source_text (request.get_optional<std::string> ("source"));
-		if (source_text.is_initialized ())
+	}
+	rai::block_hash source (0);
+	boost::optional<std::string> source_text (request.get_optional<std::string> ("source"));
+	if (source_text.is_initialized ())
+	{
+		auto error_source (source.decode_hex (source_text.get ()));
+		if (error_source)
 		{
-			auto error_source (source.decode_hex (source_text.get ()));
-			if (error_source)
-			{
-				error_response (response, "Invalid source hash");
-			}
+			error_response (response, "Invalid source hash");
 		}
-		rai::uint128_union amount (0);
-		boost::optional<std::string> amount_text (request.get_optional<std::string> ("amount"));
-		if (amount_text.is_initialized ())
+	}
+	rai::uint128_union amount (0);
+	boost::optional<std::string> amount_text (request.get_optional<std::string> ("amount"));
+	if (amount_text.is_initialized ())
+	{
+		auto error_amount (amount.decode_dec (amount_text.get ()));
+		if (error_amount)
 		{
-			auto error_amount (amount.decode_dec (amount_text.get ()));
-			if (error_amount)
-			{
-				error_response (response, "Bad amount number");
-			}
+			error_response (response, "Bad amount number");
 		}
-		uint64_t work (0);
-		boost::optional<std::string> work_text (request.get_optional<std::string> ("work"));
-		if (work_text.is_initialized ())
+	}
+	uint64_t work (0);
+	boost::optional<std::string> work_text (request.get_optional<std::string> ("work"));
+	if (work_text.is_initialized ())
+	{
+		auto work_error (rai::from_string_hex (work_text.get (), work));
+		if (work_error)
 		{
-			auto work_error (rai::from_string_hex (work_text.get (), work));
-			if (work_error)
-			{
-				error_response (response, "Bad work");
-			}
+			error_response (response, "Bad work");
 		}
-		rai::raw_key prv;
-		prv.data.clear ();
-		rai::uint256_union previous (0);
-		rai::uint128_union balance (0);
-		rai::account sc_account (0);
-		rai::account sc_owner_account (0);
-		if (wallet != 0 && account != 0)
+	}
+	rai::raw_key prv;
+	prv.data.clear ();
+	rai::uint256_union previous (0);
+	rai::uint128_union balance (0);
+	rai::account sc_account (0);
+	rai::account sc_owner_account (0);
+	if (wallet != 0 && account != 0)
+	{
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
+			rai::transaction transaction (node.store.backend, nullptr, false);
+			auto unlock_check (existing->second->store.valid_password (transaction));
+			if (unlock_check)
 			{
-				rai::transaction transaction (node.store.environment, nullptr, false);
-				auto unlock_check (existing->second->store.valid_password (transaction));
-				if (unlock_check)
+				auto account_check (existing->second->store.find (transaction, account));
+				if (account_check != existing->second->store.end ())
 				{
-					auto account_check (existing->second->store.find (transaction, account));
-					if (account_check != existing->second->store.end ())
-					{
-						existing->second->store.fetch (transaction, account, prv);
-						previous = node.ledger.latest (transaction, account);
-						balance = node.ledger.account_balance (transaction, account);
-					}
-					else
-					{
-						error_response (response, "Account not found in wallet");
-					}
+					existing->second->store.fetch (transaction, account, prv);
+					previous = node.ledger.latest (transaction, account);
+					balance = node.ledger.account_balance (transaction, account);
 				}
 				else
 				{
-					error_response (response, "Wallet is locked");
+					error_response (response, "Account not found in wallet");
 				}
 			}
 			else
 			{
-				error_response (response, "Wallet not found");
+				error_response (response, "Wallet is locked");
 			}
 		}
-		boost::optional<std::string> key_text (request.get_optional<std::string> ("key"));
-		if (key_text.is_initialized ())
+		else
 		{
-			auto error_key (prv.data.decode_hex (key_text.get ()));
-			if (error_key)
-			{
-				error_response (response, "Bad private key");
-			}
+			error_response (response, "Wallet not found");
 		}
-		boost::optional<std::string> previous_text (request.get_optional<std::string> ("previous"));
-		if (previous_text.is_initialized ())
+	}
+	boost::optional<std::string> key_text (request.get_optional<std::string> ("key"));
+	if (key_text.is_initialized ())
+	{
+		auto error_key (prv.data.decode_hex (key_text.get ()));
+		if (error_key)
 		{
-			auto error_previous (previous.decode_hex (previous_text.get ()));
-			if (error_previous)
-			{
-				error_response (response, "Invalid previous hash");
-			}
+			error_response (response, "Bad private key");
+		}
+	}
+	boost::optional<std::string> previous_text (request.get_optional<std::string> ("previous"));
+	if (previous_text.is_initialized ())
+	{
+		auto error_previous (previous.decode_hex (previous_text.get ()));
+		if (error_previous)
+		{
+			error_response (response, "Invalid previous hash");
 		}
-		boost::optional<std::string> abi_text (request.get_optional<std::string> ("abi"));
-		boost::optional<std::string> sc_owner_account_text (request.get_optional<std::string> ("sc_owner_account"));
-		if (sc_owner_account_text.is_initialized ())
+	}
+	boost::optional<std::string> abi_text (request.get_optional<std::string> ("abi"));
+	boost::optional<std::string> sc_owner_account_text (request.get_optional<std::string> ("sc_owner_account"));
+	if (sc_owner_account_text.is_initialized ())
+	{
+		auto error (sc_owner_account.decode_account (sc_owner_account_text.get ()));
+		if (error)
 		{
-			auto error (sc_owner_account.decode_account (sc_owner_account_text.get ()));
-			if (error)
+			error_response (response, "Invalid sc_owner_account hash");
+		}
+	}
+	boost::optional<std::string> sc_account_text (request.get_optional<std::string> ("sc_account"));
+	if (sc_account_text.is_initialized ())
+	{
+		auto error (sc_account.decode_account (sc_account_text.get ()));
+		if (error)
+		{
+			error_response (response, "Invalid sc_account hash");
+		}
+	}
+	boost::optional<std::string> balance_text (request.get_optional<std::string> ("balance"));
+	if (balance_text.is_initialized ())
+	{
+		auto error_balance (balance.decode_dec (balance_text.get ()));
+		if (error_balance)
+		{
+			error_response (response, "Bad balance number");
+		}
+	}
+	rai::uint256_union link (0);
+	boost::optional<std::string> link_text (request.get_optional<std::string> ("link"));
+	if (link_text.is_initialized ())
+	{
+		auto error_link (link.decode_account (link_text.get ()));
+		if (error_link)
+		{
+			auto error_link (link.decode_hex (link_text.get ()));
+			if (error_link)
 			{
-				error_response (response, "Invalid sc_owner_account hash");
+				error_response (response, "Bad link number");
 			}
 		}
-		boost::optional<std::string> sc_account_text (request.get_optional<std::string> ("sc_account"));
-		if (sc_account_text.is_initialized ())
+	}
+	else
+	{
+		// Retrieve link from source or destination
+		link = source.is_zero () ? destination : source;
+	}
+	if (prv.data != 0)
+	{
+		rai::uint256_union pub;
+		ed25519_publickey (prv.data.bytes.data (), pub.bytes.data ());
+		// Fetching account balance & previous for send blocks (if aren't given directly)
+		if (!previous_text.is_initialized () && !balance_text.is_initialized ())
+		{
+			rai::transaction transaction (node.store.backend, nullptr, false);
+			previous = node.ledger.latest (transaction, pub);
+			balance = node.ledger.account_balance (transaction, pub);
+		}
+		// Double check current balance if previous block is specified
+		else if (previous_text.is_initialized () && balance_text.is_initialized () && type == "send")
 		{
-			auto error (sc_account.decode_account (sc_account_text.get ()));
-			if (error)
+			rai::transaction transaction (node.store.backend, nullptr, false);
+			if (node.store.block_exists (transaction, previous) && node.store.block_balance (transaction, previous) != balance.number ())
 			{
-				error_response (response, "Invalid sc_account hash");
+				error_response (response, "Balance mismatch for previous block");
 			}
 		}
-		boost::optional<std::string> balance_text (request.get_optional<std::string> ("balance"));
-		if (balance_text.is_initialized ())
+		// Check for incorrect account key
+		if (account_text.is_initialized ())
 		{
-			auto error_balance (balance.decode_dec (balance_text.get ()));
-			if (error_balance)
+			if (account != pub)
 			{
-				error_response (response, "Bad balance number");
+				error_response (response, "Incorrect key for given account");
 			}
 		}
-		rai::uint256_union link (0);
-		boost::optional<std::string> link_text (request.get_optional<std::string> ("link"));
-		if (link_text.is_initialized ())
+		if (type == "state")
 		{
-			auto error_link (link.decode_account (link_text.get ()));
-			if (error_link)
+			if (previous_text.is_initialized () && !representative.is_zero () && (!link.is_zero () || link_text.is_initialized ()))
 			{
-				auto error_link (link.decode_hex (link_text.get ()));
-				if (error_link)
+				if (work == 0)
 				{
-					error_response (response, "Bad link number");
+					work = node.work_generate_blocking (previous.is_zero () ? pub : previous);
 				}
+				rai::state_block state (pub, previous, representative, balance, link, token_type, prv, pub, work);
+				boost::property_tree::ptree response_l;
+				response_l.put ("hash", state.hash ().to_string ());
+				std::string contents;
+				state.serialize_json (contents);
+				response_l.put ("block", contents);
+				response (response_l);
 			}
-		}
-		else
-		{
-			// Retrieve link from source or destination
-			link = source.is_zero () ? destination : source;
-		}
-		if (prv.data != 0)
-		{
-			rai::uint256_union pub;
-			ed25519_publickey (prv.data.bytes.data (), pub.bytes.data ());
-			// Fetching account balance & previous for send blocks (if aren't given directly)
-			if (!previous_text.is_initialized () && !balance_text.is_initialized ())
+			else
 			{
-				rai::transaction transaction (node.store.environment, nullptr, false);
-				previous = node.ledger.latest (transaction, pub);
-				balance = node.ledger.account_balance (transaction, pub);
+				error_response (response, "Previous, representative, final balance and link (source or destination) are required");
 			}
-			// Double check current balance if previous block is specified
-			else if (previous_text.is_initialized () && balance_text.is_initialized () && type == "send")
+		}
+		else if (type == "smart_contract")
+		{
+			if (abi_text.is_initialized () && !sc_account.is_zero () && !sc_owner_account.is_zero ())
 			{
-				rai::transaction transaction (node.store.environment, nullptr, false);
-				if (node.store.block_exists (transaction, previous) && node.store.block_balance (transaction, previous) != balance.number ())
+				const auto abi = rai::hex_string_to_stream (abi_text.get ());
+				rai::smart_contract_block block (sc_account, sc_owner_account, abi, prv, pub, work);
+				if (work == 0)
 				{
-					error_response (response, "Balance mismatch for previous block");
+					node.work_generate_blocking (block);
 				}
+				boost::property_tree::ptree response_l;
+				response_l.put ("hash", block.hash ().to_string ());
+				std::string contents;
+				block.serialize_json (contents);
+				response_l.put ("block", contents);
+				response (response_l);
 			}
-			// Check for incorrect account key
-			if (account_text.is_initialized ())
+			else
 			{
-				if (account != pub)
-				{
-					error_response (response, "Incorrect key for given account");
-				}
+				error_response (response, "Sc account, sc owner account, abi are required");
 			}
-			if (type == "state")
+		}
+		else if (type == "open")
+		{
+			if (representative != 0 && source != 0)
 			{
-				if (previous_text.is_initialized () && !representative.is_zero () && (!link.is_zero () || link_text.is_initialized ()))
-				{
-					if (work == 0)
-					{
-						work = node.work_generate_blocking (previous.is_zero () ? pub : previous);
-					}
-					rai::state_block state (pub, previous, representative, balance, link, token_type, prv, pub, work);
-					boost::property_tree::ptree response_l;
-					response_l.put ("hash", state.hash ().to_string ());
-					std::string contents;
-					state.serialize_json (contents);
-					response_l.put ("block", contents);
-					response (response_l);
-				}
-				else
+				if (work == 0)
 				{
-					error_response (response, "Previous, representative, final balance and link (source or destination) are required");
+					work = node.work_generate_blocking (pub);
 				}
+				rai::open_block open (source, representative, pub, prv, pub, work);
+				boost::property_tree::ptree response_l;
+				response_l.put ("hash", open.hash ().to_string ());
+				std::string contents;
+				open.serialize_json (contents);
+				response_l.put ("block", contents);
+				response (response_l);
 			}
-			else if (type == "smart_contract")
+			else
 			{
-				if (abi_text.is_initialized () && !sc_account.is_zero () && !sc_owner_account.is_zero ())
-				{
-					const auto abi = rai::hex_string_to_stream (abi_text.get ());
-					rai::smart_contract_block block (sc_account, sc_owner_account, abi, prv, pub, work);
-					if (work == 0)
-					{
-						node.work_generate_blocking (block);
-					}
-					boost::property_tree::ptree response_l;
-					response_l.put ("hash", block.hash ().to_string ());
-					std::string contents;
-					block.serialize_json (contents);
-					response_l.put ("block", contents);
-					response (response_l);
-				}
-				else
-				{
-					error_response (response, "Sc account, sc owner account, abi are required");
-				}
+				error_response (response, "Representative account and source hash required");
 			}
-			else if (type == "open")
+		}
+		else if (type == "receive")
+		{
+			if (source != 0 && previous != 0)
 			{
-				if (representative != 0 && source != 0)
-				{
-					if (work == 0)
-					{
-						work = node.work_generate_blocking (pub);
-					}
-					rai::open_block open (source, representative, pub, prv, pub, work);
-					boost::property_tree::ptree response_l;
-					response_l.put ("hash", open.hash ().to_string ());
-					std::string contents;
-					open.serialize_json (contents);
-					response_l.put ("block", contents);
-					response (response_l);
-				}
-				else
+				if (work == 0)
 				{
-					error_response (response, "Representative account and source hash required");
+					work = node.work_generate_blocking (previous);
 				}
+				rai::receive_block receive (previous, source, prv, pub, work);
+				boost::property_tree::ptree response_l;
+				response_l.put ("hash", receive.hash ().to_string ());
+				std::string contents;
+				receive.serialize_json (contents);
+				response_l.put ("block", contents);
+				response (response_l);
 			}
-			else if (type == "receive")
+			else
 			{
-				if (source != 0 && previous != 0)
-				{
-					if (work == 0)
-					{
-						work = node.work_generate_blocking (previous);
-					}
-					rai::receive_block receive (previous, source, prv, pub, work);
-					boost::property_tree::ptree response_l;
-					response_l.put ("hash", receive.hash ().to_string ());
-					std::string contents;
-					receive.serialize_json (contents);
-					response_l.put ("block", contents);
-					response (response_l);
-				}
-				else
+				error_response (response, "Previous hash and source hash required");
+			}
+		}
+		else if (type == "change")
+		{
+			if (representative != 0 && previous != 0)
+			{
+				if (work == 0)
 				{
-					error_response (response, "Previous hash and source hash required");
+					work = node.work_generate_blocking (previous);
 				}
+				rai::change_block change (previous, representative, prv, pub, work);
+				boost::property_tree::ptree response_l;
+				response_l.put ("hash", change.hash ().to_string ());
+				std::string contents;
+				change.serialize_json (contents);
+				response_l.put ("block", contents);
+				response (response_l);
 			}
-			else if (type == "change")
+			else
+			{
+				error_response (response, "Representative account and previous hash required");
+			}
+		}
+		else if (type == "send")
+		{
+			if (destination != 0 && previous != 0 && balance != 0 && amount != 0)
 			{
-				if (representative != 0 && previous != 0)
+				if (balance.number () >= amount.number ())
 				{
 					if (work == 0)
 					{
 						work = node.work_generate_blocking (previous);
 					}
-					rai::change_block change (previous, representative, prv, pub, work);
+					rai::send_block send (previous, destination, balance.number () - amount.number (), prv, pub, work);
 					boost::property_tree::ptree response_l;
-					response_l.put ("hash", change.hash ().to_string ());
+					response_l.put ("hash", send.hash ().to_string ());
 					std::string contents;
-					change.serialize_json (contents);
+					send.serialize_json (contents);
 					response_l.put ("block", contents);
 					response (response_l);
 				}
 				else
 				{
-					error_response (response, "Representative account and previous hash required");
-				}
-			}
-			else if (type == "send")
-			{
-				if (destination != 0 && previous != 0 && balance != 0 && amount != 0)
-				{
-					if (balance.number () >= amount.number ())
-					{
-						if (work == 0)
-						{
-							work = node.work_generate_blocking (previous);
-						}
-						rai::send_block send (previous, destination, balance.number () - amount.number (), prv, pub, work);
-						boost::property_tree::ptree response_l;
-						response_l.put ("hash", send.hash ().to_string ());
-						std::string contents;
-						send.serialize_json (contents);
-						response_l.put ("block", contents);
-						response (response_l);
-					}
-					else
-					{
-						error_response (response, "Insufficient balance");
-					}
-				}
-				else
-				{
-					error_response (response, "Destination account, previous hash, current balance and amount required");
+					error_response (response, "Insufficient balance");
 				}
 			}
 			else
 			{
-				error_response (response, "Invalid block type");
+				error_response (response, "Destination account, previous hash, current balance and amount required");
 			}
 		}
 		else
 		{
-			error_response (response, "Private key or local wallet and account required");
+			error_response (response, "Invalid block type");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Private key or local wallet and account required");
 	}
 }
 
@@ -1563,7 +1766,7 @@ void rai::rpc_handler::successors ()
 		{
 			boost::property_tree::ptree response_l;
 			boost::property_tree::ptree blocks;
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			while (!block.is_zero () && blocks.size () < count)
 			{
 				auto block_l (node.store.block_get (transaction, block));
@@ -1640,7 +1843,7 @@ void rai::rpc_handler::chain ()
 		{
 			boost::property_tree::ptree response_l;
 			boost::property_tree::ptree blocks;
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			while (!block.is_zero () && blocks.size () < count)
 			{
 				auto block_l (node.store.block_get (transaction, block));
@@ -1695,23 +1898,69 @@ void rai::rpc_handler::delegators ()
 	auto error (account.decode_account (account_text));
 	if (!error)
 	{
-		boost::property_tree::ptree response_l;
-		boost::property_tree::ptree delegators;
-		rai::transaction transaction (node.store.environment, nullptr, false);
-		for (auto i (node.store.latest_begin (transaction)), n (node.store.latest_end ()); i != n; ++i)
+		uint64_t count (std::numeric_limits<uint64_t>::max ());
+		boost::optional<std::string> count_text (request.get_optional<std::string> ("count"));
+		if (count_text.is_initialized () && decode_unsigned (count_text.get (), count))
 		{
-			rai::account_info info (i->second);
-			auto block (node.store.block_get (transaction, info.rep_block));
-			assert (block != nullptr);
-			if (block->representative () == account)
+			error_response (response, "Invalid count limit");
+			return;
+		}
+		rai::uint256_union start (0);
+		boost::optional<std::string> cursor_text (request.get_optional<std::string> ("cursor"));
+		if (cursor_text.is_initialized () && cursor_decode (cursor_text.get (), start))
+		{
+			error_response (response, "Invalid cursor");
+			return;
+		}
+		auto writer (response_writer ());
+		writer.begin_object ("delegators");
+		uint64_t written (0);
+		boost::optional<rai::uint256_union> next;
+		auto more (true);
+		while (more)
+		{
+			more = false;
 			{
-				std::string balance;
-				rai::uint128_union (info.balance).encode_dec (balance);
-				delegators.put (rai::account (i->first.uint256 ()).to_account (), balance);
+				rai::transaction transaction (node.store.backend, nullptr, false);
+				for (auto i (node.store.delegators_begin (transaction, rai::delegator_key (account, start))), n (node.store.delegators_end ()); i != n; ++i)
+				{
+					rai::delegator_key key (i->first);
+					if (key.representative != account)
+					{
+						break;
+					}
+					if (written == count)
+					{
+						next = key.account;
+						break;
+					}
+					if (writer.pending ())
+					{
+						start = key.account;
+						more = true;
+						break;
+					}
+					rai::account_info info;
+					auto error_l (node.store.account_get (transaction, key.account, info));
+					assert (!error_l);
+					std::string balance;
+					rai::uint128_union (info.balance).encode_dec (balance);
+					writer.value (key.account.to_account (), balance);
+					++written;
+				}
+			}
+			if (more)
+			{
+				// Sent without a transaction open so a slow client doesn't pin one, reading carries on from start
+				more = !writer.send ();
 			}
 		}
-		response_l.add_child ("delegators", delegators);
-		response (response_l);
+		writer.end ();
+		if (next)
+		{
+			writer.value ("cursor", cursor_encode (*next));
+		}
+		response_chunk (writer.finish (), true);
 	}
 	else
 	{
@@ -1727,16 +1976,10 @@ void rai::rpc_handler::delegators_count ()
 	if (!error)
 	{
 		uint64_t count (0);
-		rai::transaction transaction (node.store.environment, nullptr, false);
-		for (auto i (node.store.latest_begin (transaction)), n (node.store.latest_end ()); i != n; ++i)
+		rai::transaction transaction (node.store.backend, nullptr, false);
+		for (auto i (node.store.delegators_begin (transaction, rai::delegator_key (account, 0))), n (node.store.delegators_end ()); i != n && rai::delegator_key (i->first).representative == account; ++i)
 		{
-			rai::account_info info (i->second);
-			auto block (node.store.block_get (transaction, info.rep_block));
-			assert (block != nullptr);
-			if (block->representative () == account)
-			{
-				++count;
-			}
+			++count;
 		}
 		boost::property_tree::ptree response_l;
 		response_l.put ("count", std::to_string (count));
@@ -1787,53 +2030,94 @@ void rai::rpc_handler::deterministic_key ()
 
 void rai::rpc_handler::frontiers ()
 {
-	std::string account_text (request.get<std::string> ("account"));
 	std::string count_text (request.get<std::string> ("count"));
 	rai::account start;
-	if (!start.decode_account (account_text))
+	auto error (false);
+	boost::optional<std::string> cursor_text (request.get_optional<std::string> ("cursor"));
+	if (cursor_text.is_initialized ())
+	{
+		error = cursor_decode (cursor_text.get (), start);
+		if (error)
+		{
+			error_response (response, "Invalid cursor");
+		}
+	}
+	else
+	{
+		error = start.decode_account (request.get<std::string> ("account"));
+		if (error)
+		{
+			error_response (response, "Invalid starting account");
+		}
+	}
+	if (!error)
 	{
 		uint64_t count;
 		if (!decode_unsigned (count_text, count))
 		{
-			boost::property_tree::ptree response_l;
-			boost::property_tree::ptree frontiers;
-			rai::transaction transaction (node.store.environment, nullptr, false);
-			for (auto i (node.store.account_latest_begin (transaction, start)), n (node.store.latest_end ()); i != n && frontiers.size () < count; ++i)
+			auto writer (response_writer ());
+			writer.begin_object ("frontiers");
+			uint64_t written (0);
+			boost::optional<rai::uint256_union> next;
+			auto more (true);
+			while (more)
 			{
-				boost::property_tree::ptree token_frontiers;
-				rai::account account (i->first.uint256 ());
-				std::vector<rai::account_info> infos;
-				if (!node.store.accounts_get (transaction, account, infos))
+				more = false;
 				{
-					boost::property_tree::ptree token_frontier;
-					for (auto & info : infos)
+					rai::transaction transaction (node.store.backend, nullptr, false);
+					for (auto i (node.store.account_latest_begin (transaction, start)), n (node.store.latest_end ()); i != n; ++i)
 					{
-						auto latest (info.head);
-						if (!latest.is_zero ())
+						if (written == count)
+						{
+							next = i->first.uint256 ();
+							break;
+						}
+						rai::account account (i->first.uint256 ());
+						if (writer.pending ())
+						{
+							start = account;
+							more = true;
+							break;
+						}
+						std::vector<rai::account_info> infos;
+						if (!node.store.accounts_get (transaction, account, infos))
 						{
-							token_frontier.put (info.open_block.to_string (), latest.to_string ());
+							writer.begin_object (account.to_account ());
+							for (auto & info : infos)
+							{
+								auto latest (info.head);
+								if (!latest.is_zero ())
+								{
+									writer.value (info.open_block.to_string (), latest.to_string ());
+								}
+							}
+							writer.end ();
+							++written;
 						}
 					}
-					frontiers.add_child (account.to_account (), token_frontier);
+				}
+				if (more)
+				{
+					more = !writer.send ();
 				}
 			}
-			response_l.add_child ("frontiers", frontiers);
-			response (response_l);
+			writer.end ();
+			if (next)
+			{
+				writer.value ("cursor", cursor_encode (*next));
+			}
+			response_chunk (writer.finish (), true);
 		}
 		else
 		{
 			error_response (response, "Invalid count limit");
 		}
 	}
-	else
-	{
-		error_response (response, "Invalid starting account");
-	}
 }
 
 void rai::rpc_handler::account_count ()
 {
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	auto size (node.store.account_count (transaction));
 	boost::property_tree::ptree response_l;
 	response_l.put ("count", std::to_string (size));
@@ -1981,7 +2265,7 @@ void rai::rpc_handler::account_history_topn ()
 	bool output_raw (request.get_optional<bool> ("raw") == true);
 	auto error (false);
 	rai::block_hash hash;
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 
 	account_text = request.get<std::string> ("account");
 	rai::uint256_union account;
@@ -2053,7 +2337,7 @@ void rai::rpc_handler::account_history ()
 	rai::block_hash hash;
 	rai::block_hash token_hash;
 	auto head_str (request.get_optional<std::string> ("head"));
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	auto cursor_str (request.get_optional<std::string> ("cursor"));
 	error = find_token_hash (token_text, token_hash);
 	if (!error)
 	{
@@ -2061,36 +2345,55 @@ void rai::rpc_handler::account_history ()
 		return;
 	}
 
-	if (head_str)
 	{
-		error = hash.decode_hex (*head_str);
-		if (!error)
-		{
-			account_text = node.ledger.account (transaction, hash).to_account ();
-		}
-		else
+		rai::transaction transaction (node.store.backend, nullptr, false);
+		if (cursor_str)
 		{
-			error_response (response, "Failed to decode head block hash");
+			error = cursor_decode (*cursor_str, hash);
+			if (!error)
+			{
+				account_text = node.ledger.account (transaction, hash).to_account ();
+			}
+			else
+			{
+				error_response (response, "Invalid cursor");
+			}
 		}
-	}
-	else
-	{
-		account_text = request.get<std::string> ("account");
-		rai::uint256_union account;
-		error = account.decode_account (account_text);
-		if (!error)
+		else if (head_str)
 		{
-			rai::account_info info;
-			if (!node.store.accounts_get (transaction, account, token_hash, info))
+			error = hash.decode_hex (*head_str);
+			if (!error)
 			{
-				hash = node.ledger.latest (transaction, info.account, info.token_type);
+				account_text = node.ledger.account (transaction, hash).to_account ();
+			}
+			else
+			{
+				error_response (response, "Failed to decode head block hash");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad account number");
+			account_text = request.get<std::string> ("account");
+			rai::uint256_union account;
+			error = account.decode_account (account_text);
+			if (!error)
+			{
+				rai::account_info info;
+				if (!node.store.accounts_get (transaction, account, token_hash, info))
+				{
+					hash = node.ledger.latest (transaction, info.account, info.token_type);
+				}
+			}
+			else
+			{
+				error_response (response, "Bad account number");
+			}
 		}
 	}
+	if (error)
+	{
+		return;
+	}
 
 	uint64_t count;
 	if (!decode_unsigned (count_text, count))
@@ -2099,43 +2402,78 @@ void rai::rpc_handler::account_history ()
 		auto offset_text (request.get_optional<std::string> ("offset"));
 		if (!offset_text || !decode_unsigned (*offset_text, offset))
 		{
-			boost::property_tree::ptree response_l;
-			boost::property_tree::ptree history;
-
-			response_l.put ("account", account_text);
-			auto block (node.store.block_get (transaction, hash));
-			while (block != nullptr && count > 0)
+			auto writer (response_writer ());
+			writer.value ("account", account_text);
+			writer.begin_array ("history");
+			auto more (true);
+			while (more)
 			{
-				if (offset > 0)
+				more = false;
 				{
-					--offset;
-				}
-				else
-				{
-					boost::property_tree::ptree entry;
-					history_visitor visitor (*this, output_raw, transaction, entry, hash);
-					block->visit (visitor);
-					if (!entry.empty ())
+					rai::transaction transaction (node.store.backend, nullptr, false);
+					rai::history_key position (0, 0);
+					if (offset > 0 && node.ledger.history_index && !node.store.block_height_get (transaction, hash, position))
+					{
+						// Seek straight to the page instead of walking the skipped blocks
+						auto height (position.height ());
+						auto skipped (std::min (offset, height));
+						height -= skipped;
+						offset -= skipped;
+						hash.clear ();
+						if (height > 0 && node.store.history_get (transaction, rai::history_key (position.account, height), hash))
+						{
+							// Pruned heights have no history entry, the history ends where pruning started
+							hash.clear ();
+						}
+					}
+					// Skipped blocks are only walked through, views avoid deserializing them
+					auto view (node.store.block_view_get (transaction, hash));
+					while (view.exists () && count > 0)
 					{
-						entry.put ("hash", hash.to_string ());
-						if (output_raw)
+						if (offset > 0)
 						{
-							entry.put ("work", rai::to_string_hex (block->block_work ()));
-							entry.put ("signature", block->block_signature ().to_string ());
+							--offset;
 						}
-						history.push_back (std::make_pair ("", entry));
+						else if (writer.pending ())
+						{
+							more = true;
+							break;
+						}
+						else
+						{
+							auto block (view.block ());
+							boost::property_tree::ptree entry;
+							history_visitor visitor (*this, output_raw, transaction, entry, hash);
+							block->visit (visitor);
+							if (!entry.empty ())
+							{
+								entry.put ("hash", hash.to_string ());
+								if (output_raw)
+								{
+									entry.put ("work", rai::to_string_hex (block->block_work ()));
+									entry.put ("signature", block->block_signature ().to_string ());
+								}
+								writer.tree (entry);
+							}
+							--count;
+						}
+						hash = view.previous ();
+						view = node.store.block_view_get (transaction, hash);
 					}
-					--count;
 				}
-				hash = block->previous ();
-				block = node.store.block_get (transaction, hash);
+				if (more)
+				{
+					// Walking carries on from hash in a new transaction once the piece is out
+					more = !writer.send ();
+				}
 			}
-			response_l.add_child ("history", history);
+			writer.end ();
 			if (!hash.is_zero ())
 			{
-				response_l.put ("previous", hash.to_string ());
+				writer.value ("previous", hash.to_string ());
+				writer.value ("cursor", cursor_encode (hash));
 			}
-			response (response_l);
+			response_chunk (writer.finish (), true);
 		}
 		else
 		{
@@ -2149,25 +2487,18 @@ void rai::rpc_handler::account_history ()
 }
 void rai::rpc_handler::keepalive ()
 {
-	if (rpc.config.enable_control)
+	std::string address_text (request.get<std::string> ("address"));
+	std::string port_text (request.get<std::string> ("port"));
+	uint16_t port;
+	if (!rai::parse_port (port_text, port))
 	{
-		std::string address_text (request.get<std::string> ("address"));
-		std::string port_text (request.get<std::string> ("port"));
-		uint16_t port;
-		if (!rai::parse_port (port_text, port))
-		{
-			node.keepalive (address_text, port);
-			boost::property_tree::ptree response_l;
-			response (response_l);
-		}
-		else
-		{
-			error_response (response, "Invalid port");
-		}
+		node.keepalive (address_text, port);
+		boost::property_tree::ptree response_l;
+		response (response_l);
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Invalid port");
 	}
 }
 
@@ -2204,132 +2535,192 @@ void rai::rpc_handler::key_expand ()
 
 void rai::rpc_handler::ledger ()
 {
-	if (rpc.config.enable_control)
+	rai::account start (0);
+	uint64_t count (std::numeric_limits<uint64_t>::max ());
+	boost::optional<std::string> account_text (request.get_optional<std::string> ("account"));
+	if (account_text.is_initialized ())
 	{
-		rai::account start (0);
-		uint64_t count (std::numeric_limits<uint64_t>::max ());
-		boost::optional<std::string> account_text (request.get_optional<std::string> ("account"));
-		if (account_text.is_initialized ())
-		{
-			auto error (start.decode_account (account_text.get ()));
-			if (error)
-			{
-				error_response (response, "Invalid starting account");
-			}
-		}
-		boost::optional<std::string> count_text (request.get_optional<std::string> ("count"));
-		if (count_text.is_initialized ())
+		auto error (start.decode_account (account_text.get ()));
+		if (error)
 		{
-			auto error_count (decode_unsigned (count_text.get (), count));
-			if (error_count)
-			{
-				error_response (response, "Invalid count limit");
-			}
+			error_response (response, "Invalid starting account");
+			return;
 		}
-		uint64_t modified_since (0);
-		boost::optional<std::string> modified_since_text (request.get_optional<std::string> ("modified_since"));
-		if (modified_since_text.is_initialized ())
+	}
+	boost::optional<std::string> count_text (request.get_optional<std::string> ("count"));
+	if (count_text.is_initialized ())
+	{
+		auto error_count (decode_unsigned (count_text.get (), count));
+		if (error_count)
 		{
-			modified_since = strtoul (modified_since_text.get ().c_str (), NULL, 10);
+			error_response (response, "Invalid count limit");
+			return;
 		}
-		const bool sorting = request.get<bool> ("sorting", false);
-		const bool representative = request.get<bool> ("representative", false);
-		const bool weight = request.get<bool> ("weight", false);
-		const bool pending = request.get<bool> ("pending", false);
-		boost::property_tree::ptree response_a;
-		boost::property_tree::ptree response_l;
-		boost::property_tree::ptree accounts;
-		rai::transaction transaction (node.store.environment, nullptr, false);
-		if (!sorting) // Simple
+	}
+	uint64_t modified_since (0);
+	boost::optional<std::string> modified_since_text (request.get_optional<std::string> ("modified_since"));
+	if (modified_since_text.is_initialized ())
+	{
+		modified_since = strtoul (modified_since_text.get ().c_str (), NULL, 10);
+	}
+	const bool sorting = request.get<bool> ("sorting", false);
+	if (sorting)
+	{
+		count = std::min (count, ledger_sorted_count_max);
+	}
+	const bool representative = request.get<bool> ("representative", false);
+	const bool weight = request.get<bool> ("weight", false);
+	const bool pending = request.get<bool> ("pending", false);
+	// Unsorted pages continue from the cursor's account, sorted ones below the balance and account it names
+	auto cursor (std::make_pair (std::numeric_limits<rai::uint128_t>::max (), std::numeric_limits<rai::uint256_t>::max ()));
+	boost::optional<std::string> cursor_text (request.get_optional<std::string> ("cursor"));
+	if (cursor_text.is_initialized ())
+	{
+		rai::uint256_union balance (0);
+		rai::uint256_union account (0);
+		auto error (sorting ? cursor_decode (cursor_text.get (), balance, account) : cursor_decode (cursor_text.get (), start));
+		if (error || balance.number () > std::numeric_limits<rai::uint128_t>::max ())
+		{
+			error_response (response, "Invalid cursor");
+			return;
+		}
+		cursor = std::make_pair (balance.number ().convert_to<rai::uint128_t> (), account.number ());
+	}
+	auto writer (response_writer ());
+	writer.begin_object ("accounts");
+	uint64_t written (0);
+	boost::optional<std::string> next;
+	auto write_account ([&](MDB_txn * transaction, rai::account const & account, rai::account_info const & info, rai::uint128_union const & balance_a) {
+		writer.begin_object (account.to_account ());
+		writer.value ("frontier", info.head.to_string ());
+		writer.value ("open_block", info.open_block.to_string ());
+		writer.value ("representative_block", info.rep_block.to_string ());
+		std::string balance;
+		balance_a.encode_dec (balance);
+		writer.value ("balance", balance);
+		writer.value ("modified_timestamp", std::to_string (info.modified));
+		writer.value ("block_count", std::to_string (info.block_count));
+		if (representative)
+		{
+			auto block (node.store.block_view_get (transaction, info.rep_block));
+			assert (block.exists ());
+			writer.value ("representative", block.representative ().to_account ());
+		}
+		if (weight)
+		{
+			auto account_weight (node.ledger.weight (transaction, account));
+			writer.value ("weight", account_weight.convert_to<std::string> ());
+		}
+		if (pending)
+		{
+			auto account_pending (node.ledger.account_pending (transaction, account));
+			writer.value ("pending", account_pending.convert_to<std::string> ());
+		}
+		writer.end ();
+		++written;
+	});
+	if (!sorting) // Simple
+	{
+		auto more (true);
+		while (more)
 		{
-			for (auto i (node.store.account_latest_begin (transaction, start)), n (node.store.latest_end ()); i != n && accounts.size () < count; ++i)
+			more = false;
 			{
-				rai::account_info info (i->second);
-				if (info.modified >= modified_since)
+				rai::transaction transaction (node.store.backend, nullptr, false);
+				for (auto i (node.store.account_latest_begin (transaction, start)), n (node.store.latest_end ()); i != n; ++i)
 				{
-					rai::account account (i->first.uint256 ());
-					boost::property_tree::ptree response_l;
-					response_l.put ("frontier", info.head.to_string ());
-					response_l.put ("open_block", info.open_block.to_string ());
-					response_l.put ("representative_block", info.rep_block.to_string ());
-					std::string balance;
-					rai::uint128_union (info.balance).encode_dec (balance);
-					response_l.put ("balance", balance);
-					response_l.put ("modified_timestamp", std::to_string (info.modified));
-					response_l.put ("block_count", std::to_string (info.block_count));
-					if (representative)
+					if (written == count)
 					{
-						auto block (node.store.block_get (transaction, info.rep_block));
-						assert (block != nullptr);
-						response_l.put ("representative", block->representative ().to_account ());
+						next = cursor_encode (i->first.uint256 ());
+						break;
 					}
-					if (weight)
+					if (writer.pending ())
 					{
-						auto account_weight (node.ledger.weight (transaction, account));
-						response_l.put ("weight", account_weight.convert_to<std::string> ());
+						start = i->first.uint256 ();
+						more = true;
+						break;
 					}
-					if (pending)
+					rai::account_info info (i->second);
+					if (info.modified >= modified_since)
 					{
-						auto account_pending (node.ledger.account_pending (transaction, account));
-						response_l.put ("pending", account_pending.convert_to<std::string> ());
+						write_account (transaction, rai::account (i->first.uint256 ()), info, rai::uint128_union (info.balance));
 					}
-					accounts.push_back (std::make_pair (account.to_account (), response_l));
 				}
 			}
+			if (more)
+			{
+				// Sent without a transaction open so a slow client doesn't pin one, reading carries on from start
+				more = !writer.send ();
+			}
 		}
-		else // Sorting
+	}
+	else // Sorting
+	{
+		// Keeps the count largest accounts below the cursor rather than every account, the smallest on top
+		std::priority_queue<std::pair<rai::uint128_t, rai::uint256_t>, std::vector<std::pair<rai::uint128_t, rai::uint256_t>>, std::greater<std::pair<rai::uint128_t, rai::uint256_t>>> ledger_l;
+		auto more (false);
 		{
-			std::vector<std::pair<rai::uint128_union, rai::account>> ledger_l;
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			for (auto i (node.store.account_latest_begin (transaction, start)), n (node.store.latest_end ()); i != n; ++i)
 			{
 				rai::account_info info (i->second);
-				rai::uint128_union balance (info.balance);
-				if (info.modified >= modified_since)
+				auto entry (std::make_pair (info.balance.number (), i->first.uint256 ().number ()));
+				if (info.modified >= modified_since && entry < cursor)
 				{
-					ledger_l.push_back (std::make_pair (balance, rai::account (i->first.uint256 ())));
+					if (ledger_l.size () < count)
+					{
+						ledger_l.push (entry);
+					}
+					else if (count > 0 && ledger_l.top () < entry)
+					{
+						ledger_l.pop ();
+						ledger_l.push (entry);
+						more = true;
+					}
+					else
+					{
+						more = true;
+					}
 				}
 			}
-			std::sort (ledger_l.begin (), ledger_l.end ());
-			std::reverse (ledger_l.begin (), ledger_l.end ());
-			rai::account_info info;
-			for (auto i (ledger_l.begin ()), n (ledger_l.end ()); i != n && accounts.size () < count; ++i)
+		}
+		std::vector<std::pair<rai::uint128_t, rai::uint256_t>> sorted;
+		sorted.reserve (ledger_l.size ());
+		for (; !ledger_l.empty (); ledger_l.pop ())
+		{
+			sorted.push_back (ledger_l.top ());
+		}
+		auto i (sorted.rbegin ()), n (sorted.rend ());
+		while (i != n)
+		{
 			{
-				node.store.account_get (transaction, i->second, info);
-				rai::account account (i->second);
-				response_l.put ("frontier", info.head.to_string ());
-				response_l.put ("open_block", info.open_block.to_string ());
-				response_l.put ("representative_block", info.rep_block.to_string ());
-				std::string balance;
-				(i->first).encode_dec (balance);
-				response_l.put ("balance", balance);
-				response_l.put ("modified_timestamp", std::to_string (info.modified));
-				response_l.put ("block_count", std::to_string (info.block_count));
-				if (representative)
-				{
-					auto block (node.store.block_get (transaction, info.rep_block));
-					assert (block != nullptr);
-					response_l.put ("representative", block->representative ().to_account ());
-				}
-				if (weight)
-				{
-					auto account_weight (node.ledger.weight (transaction, account));
-					response_l.put ("weight", account_weight.convert_to<std::string> ());
-				}
-				if (pending)
+				rai::transaction transaction (node.store.backend, nullptr, false);
+				for (; i != n && !writer.pending (); ++i)
 				{
-					auto account_pending (node.ledger.account_pending (transaction, account));
-					response_l.put ("pending", account_pending.convert_to<std::string> ());
+					rai::account account (i->second);
+					rai::account_info info;
+					if (!node.store.account_get (transaction, account, info))
+					{
+						write_account (transaction, account, info, rai::uint128_union (i->first));
+					}
 				}
-				accounts.push_back (std::make_pair (account.to_account (), response_l));
 			}
+			if (i != n && writer.send ())
+			{
+				break;
+			}
+		}
+		if (more && !sorted.empty ())
+		{
+			next = cursor_encode (rai::uint256_t (sorted.front ().first)) + cursor_encode (sorted.front ().second);
 		}
-		response_a.add_child ("accounts", accounts);
-		response (response_a);
 	}
-	else
+	writer.end ();
+	if (next)
 	{
-		error_response (response, "RPC control is disabled");
+		writer.value ("cursor", *next);
 	}
+	response_chunk (writer.finish (), true);
 }
 
 void rai::rpc_handler::mrai_from_raw ()
@@ -2416,36 +2807,30 @@ void rai::rpc_handler::krai_to_raw ()
 
 void rai::rpc_handler::password_change ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
-			{
-				rai::transaction transaction (node.store.environment, nullptr, true);
-				boost::property_tree::ptree response_l;
-				std::string password_text (request.get<std::string> ("password"));
-				auto error (existing->second->store.rekey (transaction, password_text));
-				response_l.put ("changed", error ? "0" : "1");
-				response (response_l);
-			}
-			else
-			{
-				error_response (response, "Wallet not found");
-			}
+			rai::transaction transaction (node.store.backend, nullptr, true);
+			boost::property_tree::ptree response_l;
+			std::string password_text (request.get<std::string> ("password"));
+			auto error (existing->second->store.rekey (transaction, password_text));
+			node.wallets.representative_keys_clear (*existing->second);
+			response_l.put ("changed", error ? "0" : "1");
+			response (response_l);
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
@@ -2486,7 +2871,7 @@ void rai::rpc_handler::password_valid (bool wallet_locked = false)
 		auto existing (node.wallets.items.find (wallet));
 		if (existing != node.wallets.items.end ())
 		{
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			boost::property_tree::ptree response_l;
 			auto valid (existing->second->store.valid_password (transaction));
 			if (!wallet_locked)
@@ -2554,7 +2939,7 @@ void rai::rpc_handler::pending ()
 		const bool source = request.get<bool> ("source", false);
 		boost::property_tree::ptree response_l;
 		boost::property_tree::ptree peers_l;
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		rai::account end (account.number () + 1);
 		for (auto i (node.store.pending_begin (transaction, rai::pending_key (account, 0))), n (node.store.pending_begin (transaction, rai::pending_key (end, 0))); i != n && peers_l.size () < count; ++i)
 		{
@@ -2605,7 +2990,7 @@ void rai::rpc_handler::pending_exists ()
 	auto error (hash.decode_hex (hash_text));
 	if (!error)
 	{
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		auto block (node.store.block_get (transaction, hash));
 		if (block != nullptr)
 		{
@@ -2639,7 +3024,7 @@ void rai::rpc_handler::payment_begin ()
 		auto existing (node.wallets.items.find (id));
 		if (existing != node.wallets.items.end ())
 		{
-			rai::transaction transaction (node.store.environment, nullptr, true);
+			rai::transaction transaction (node.store.backend, nullptr, true);
 			std::shared_ptr<rai::wallet> wallet (existing->second);
 			if (wallet->store.valid_password (transaction))
 			{
@@ -2704,7 +3089,7 @@ void rai::rpc_handler::payment_init ()
 	rai::uint256_union id;
 	if (!id.decode_hex (id_text))
 	{
-		rai::transaction transaction (node.store.environment, nullptr, true);
+		rai::transaction transaction (node.store.backend, nullptr, true);
 		auto existing (node.wallets.items.find (id));
 		if (existing != node.wallets.items.end ())
 		{
@@ -2743,7 +3128,7 @@ void rai::rpc_handler::payment_end ()
 	rai::uint256_union id;
 	if (!id.decode_hex (id_text))
 	{
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		auto existing (node.wallets.items.find (id));
 		if (existing != node.wallets.items.end ())
 		{
@@ -2840,7 +3225,7 @@ void rai::rpc_handler::process ()
 			node.block_arrival.add (hash);
 			rai::process_return result;
 			{
-				rai::transaction transaction (node.store.environment, nullptr, true);
+				rai::transaction transaction (node.store.backend, nullptr, true);
 				result = node.block_processor.process_receive_one (transaction, block);
 			}
 			switch (result.code)
@@ -2981,161 +3366,140 @@ void rai::rpc_handler::rai_to_raw ()
 
 void rai::rpc_handler::receive ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
+			std::string account_text (request.get<std::string> ("account"));
+			rai::account account;
+			auto error (account.decode_account (account_text));
+			if (!error)
 			{
-				std::string account_text (request.get<std::string> ("account"));
-				rai::account account;
-				auto error (account.decode_account (account_text));
-				if (!error)
+				rai::transaction transaction (node.store.backend, nullptr, false);
+				auto account_check (existing->second->store.find (transaction, account));
+				if (account_check != existing->second->store.end ())
 				{
-					rai::transaction transaction (node.store.environment, nullptr, false);
-					auto account_check (existing->second->store.find (transaction, account));
-					if (account_check != existing->second->store.end ())
+					std::string hash_text (request.get<std::string> ("block"));
+					rai::uint256_union hash;
+					auto error (hash.decode_hex (hash_text));
+					if (!error)
 					{
-						std::string hash_text (request.get<std::string> ("block"));
-						rai::uint256_union hash;
-						auto error (hash.decode_hex (hash_text));
-						if (!error)
+						auto block (node.store.block_get (transaction, hash));
+						if (block != nullptr)
 						{
-							auto block (node.store.block_get (transaction, hash));
-							if (block != nullptr)
+							if (node.store.pending_exists (transaction, rai::pending_key (account, hash)))
 							{
-								if (node.store.pending_exists (transaction, rai::pending_key (account, hash)))
+								uint64_t work (0);
+								boost::optional<std::string> work_text (request.get_optional<std::string> ("work"));
+								auto error (false);
+								if (work_text.is_initialized ())
 								{
-									uint64_t work (0);
-									boost::optional<std::string> work_text (request.get_optional<std::string> ("work"));
-									auto error (false);
-									if (work_text.is_initialized ())
+									error = rai::from_string_hex (work_text.get (), work);
+									if (error)
 									{
-										error = rai::from_string_hex (work_text.get (), work);
-										if (error)
-										{
-											error_response (response, "Bad work");
-										}
+										error_response (response, "Bad work");
 									}
-									if (work)
+								}
+								if (work)
+								{
+									rai::account_info info;
+									rai::uint256_union head;
+									if (!node.store.account_get (transaction, account, info))
 									{
-										rai::account_info info;
-										rai::uint256_union head;
-										if (!node.store.account_get (transaction, account, info))
-										{
-											head = info.head;
-										}
-										else
-										{
-											head = account;
-										}
-										if (!rai::work_validate (head, work))
-										{
-											rai::transaction transaction_a (node.store.environment, nullptr, true);
-											existing->second->store.work_put (transaction_a, account, work);
-										}
-										else
-										{
-											error = true;
-											error_response (response, "Invalid work");
-										}
+										head = info.head;
+									}
+									else
+									{
+										head = account;
+									}
+									if (!rai::work_validate (head, work))
+									{
+										rai::transaction transaction_a (node.store.backend, nullptr, true);
+										existing->second->store.work_put (transaction_a, account, work);
 									}
-									if (!error)
+									else
 									{
-										auto response_a (response);
-										existing->second->receive_async (std::move (block), account, rai::genesis_amount, [response_a](std::shared_ptr<rai::block> block_a) {
-											rai::uint256_union hash_a (0);
-											if (block_a != nullptr)
-											{
-												hash_a = block_a->hash ();
-											}
-											boost::property_tree::ptree response_l;
-											response_l.put ("block", hash_a.to_string ());
-											response_a (response_l);
-										},
-										work == 0);
+										error = true;
+										error_response (response, "Invalid work");
 									}
 								}
-								else
+								if (!error)
 								{
-									error_response (response, "Block is not available to receive");
+									auto response_a (response);
+									existing->second->receive_async (std::move (block), account, rai::genesis_amount, [response_a](std::shared_ptr<rai::block> block_a) {
+										rai::uint256_union hash_a (0);
+										if (block_a != nullptr)
+										{
+											hash_a = block_a->hash ();
+										}
+										boost::property_tree::ptree response_l;
+										response_l.put ("block", hash_a.to_string ());
+										response_a (response_l);
+									},
+									work == 0);
 								}
 							}
 							else
 							{
-								error_response (response, "Block not found");
+								error_response (response, "Block is not available to receive");
 							}
 						}
 						else
 						{
-							error_response (response, "Bad block number");
+							error_response (response, "Block not found");
 						}
 					}
 					else
 					{
-						error_response (response, "Account not found in wallet");
+						error_response (response, "Bad block number");
 					}
 				}
 				else
 				{
-					error_response (response, "Bad account number");
+					error_response (response, "Account not found in wallet");
 				}
 			}
 			else
 			{
-				error_response (response, "Wallet not found");
+				error_response (response, "Bad account number");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
 void rai::rpc_handler::receive_minimum ()
 {
-	if (rpc.config.enable_control)
-	{
-		boost::property_tree::ptree response_l;
-		response_l.put ("amount", node.config.receive_minimum.to_string_dec ());
-		response (response_l);
-	}
-	else
-	{
-		error_response (response, "RPC control is disabled");
-	}
+	boost::property_tree::ptree response_l;
+	response_l.put ("amount", node.config.receive_minimum.to_string_dec ());
+	response (response_l);
 }
 
 void rai::rpc_handler::receive_minimum_set ()
 {
-	if (rpc.config.enable_control)
+	std::string amount_text (request.get<std::string> ("amount"));
+	rai::uint128_union amount;
+	if (!amount.decode_dec (amount_text))
 	{
-		std::string amount_text (request.get<std::string> ("amount"));
-		rai::uint128_union amount;
-		if (!amount.decode_dec (amount_text))
-		{
-			node.config.receive_minimum = amount;
-			boost::property_tree::ptree response_l;
-			response_l.put ("success", "");
-			response (response_l);
-		}
-		else
-		{
-			error_response (response, "Bad amount number");
-		}
+		node.config.receive_minimum = amount;
+		boost::property_tree::ptree response_l;
+		response_l.put ("success", "");
+		response (response_l);
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad amount number");
 	}
 }
 
@@ -3154,7 +3518,7 @@ void rai::rpc_handler::representatives ()
 	const bool sorting = request.get<bool> ("sorting", false);
 	boost::property_tree::ptree response_l;
 	boost::property_tree::ptree representatives;
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	rai::transaction transaction (node.store.backend, nullptr, false);
 	if (!sorting) // Simple
 	{
 		for (auto i (node.store.representation_begin (transaction)), n (node.store.representation_end ()); i != n && representatives.size () < count; ++i)
@@ -3236,7 +3600,7 @@ void rai::rpc_handler::republish ()
 	{
 		boost::property_tree::ptree response_l;
 		boost::property_tree::ptree blocks;
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		auto block (node.store.block_get (transaction, hash));
 		if (block != nullptr)
 		{
@@ -3326,176 +3690,237 @@ void rai::rpc_handler::republish ()
 
 void rai::rpc_handler::search_pending ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
-			{
-				auto error (existing->second->search_pending ());
-				boost::property_tree::ptree response_l;
-				response_l.put ("started", !error);
-				response (response_l);
-			}
-			else
-			{
-				error_response (response, "Wallet not found");
-			}
+			auto error (existing->second->search_pending ());
+			boost::property_tree::ptree response_l;
+			response_l.put ("started", !error);
+			response (response_l);
+		}
+		else
+		{
+			error_response (response, "Wallet not found");
 		}
-	}
-	else
-	{
-		error_response (response, "RPC control is disabled");
 	}
 }
 
 void rai::rpc_handler::search_pending_all ()
 {
-	if (rpc.config.enable_control)
-	{
-		node.wallets.search_pending_all ();
-		boost::property_tree::ptree response_l;
-		response_l.put ("success", "");
-		response (response_l);
-	}
-	else
-	{
-		error_response (response, "RPC control is disabled");
-	}
+	node.wallets.search_pending_all ();
+	boost::property_tree::ptree response_l;
+	response_l.put ("success", "");
+	response (response_l);
 }
 
 void rai::rpc_handler::send ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
+			std::string token_text (request.get<std::string> ("token"));
+			rai::block_hash token_hash;
+			error = find_token_hash (token_text, token_hash);
+			if (!error)
 			{
-				std::string token_text (request.get<std::string> ("token"));
-				rai::block_hash token_hash;
-				error = find_token_hash (token_text, token_hash);
-				if (!error)
-				{
-					error_response (response, "Invalid token name");
-					return;
-				}
-				std::string source_text (request.get<std::string> ("source"));
-				rai::account source;
-				auto error (source.decode_account (source_text));
+				error_response (response, "Invalid token name");
+				return;
+			}
+			std::string source_text (request.get<std::string> ("source"));
+			rai::account source;
+			auto error (source.decode_account (source_text));
+			if (!error)
+			{
+				std::string destination_text (request.get<std::string> ("destination"));
+				rai::account destination;
+				auto error (destination.decode_account (destination_text));
 				if (!error)
 				{
-					std::string destination_text (request.get<std::string> ("destination"));
-					rai::account destination;
-					auto error (destination.decode_account (destination_text));
+					std::string amount_text (request.get<std::string> ("amount"));
+					rai::amount amount;
+					auto error (amount.decode_dec (amount_text));
 					if (!error)
 					{
-						std::string amount_text (request.get<std::string> ("amount"));
-						rai::amount amount;
-						auto error (amount.decode_dec (amount_text));
+						uint64_t work (0);
+						boost::optional<std::string> work_text (request.get_optional<std::string> ("work"));
+						if (work_text.is_initialized ())
+						{
+							error = rai::from_string_hex (work_text.get (), work);
+							if (error)
+							{
+								error_response (response, "Bad work");
+							}
+						}
+						rai::uint128_t balance (0);
 						if (!error)
 						{
-							uint64_t work (0);
-							boost::optional<std::string> work_text (request.get_optional<std::string> ("work"));
-							if (work_text.is_initialized ())
+							rai::transaction transaction (node.store.backend, nullptr, work != 0); // false if no "work" in request, true if work > 0
+							rai::account_info info;
+							if (!node.store.accounts_get (transaction, source, token_hash, info))
 							{
-								error = rai::from_string_hex (work_text.get (), work);
-								if (error)
-								{
-									error_response (response, "Bad work");
-								}
+								balance = (info.balance).number ();
 							}
-							rai::uint128_t balance (0);
-							if (!error)
+							else
+							{
+								error = true;
+								error_response (response, "Account not found");
+							}
+							if (!error && work)
 							{
-								rai::transaction transaction (node.store.environment, nullptr, work != 0); // false if no "work" in request, true if work > 0
-								rai::account_info info;
-								if (!node.store.accounts_get (transaction, source, token_hash, info))
+								if (!rai::work_validate (info.head, work))
 								{
-									balance = (info.balance).number ();
+									existing->second->store.work_put (transaction, source, work);
 								}
 								else
 								{
 									error = true;
-									error_response (response, "Account not found");
+									error_response (response, "Invalid work");
 								}
-								if (!error && work)
-								{
-									if (!rai::work_validate (info.head, work))
+							}
+						}
+						if (!error)
+						{
+							boost::optional<std::string> send_id (request.get_optional<std::string> ("id"));
+							if (balance >= amount.number ())
+							{
+								auto rpc_l (shared_from_this ());
+								auto response_a (response);
+								existing->second->send_async (source, destination, token_hash, amount.number (), [response_a](std::shared_ptr<rai::block> block_a) {
+									if (block_a != nullptr)
 									{
-										existing->second->store.work_put (transaction, source, work);
+										rai::uint256_union hash (block_a->hash ());
+										boost::property_tree::ptree response_l;
+										response_l.put ("block", hash.to_string ());
+										response_a (response_l);
 									}
 									else
 									{
-										error = true;
-										error_response (response, "Invalid work");
+										error_response (response_a, "Error generating block");
 									}
-								}
+								},
+								work == 0, send_id);
 							}
-							if (!error)
+							else
 							{
-								boost::optional<std::string> send_id (request.get_optional<std::string> ("id"));
-								if (balance >= amount.number ())
-								{
-									auto rpc_l (shared_from_this ());
-									auto response_a (response);
-									existing->second->send_async (source, destination, token_hash, amount.number (), [response_a](std::shared_ptr<rai::block> block_a) {
-										if (block_a != nullptr)
-										{
-											rai::uint256_union hash (block_a->hash ());
-											boost::property_tree::ptree response_l;
-											response_l.put ("block", hash.to_string ());
-											response_a (response_l);
-										}
-										else
-										{
-											error_response (response_a, "Error generating block");
-										}
-									},
-									work == 0, send_id);
-								}
-								else
-								{
-									error_response (response, "Insufficient balance");
-								}
+								error_response (response, "Insufficient balance");
 							}
 						}
-						else
-						{
-							error_response (response, "Bad amount format");
-						}
 					}
 					else
 					{
-						error_response (response, "Bad destination account");
+						error_response (response, "Bad amount format");
 					}
 				}
 				else
 				{
-					error_response (response, "Bad source account");
+					error_response (response, "Bad destination account");
 				}
 			}
 			else
 			{
-				error_response (response, "Wallet not found");
+				error_response (response, "Bad source account");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
+		}
+	}
+	else
+	{
+		error_response (response, "Bad wallet number");
+	}
+}
+
+void rai::rpc_handler::send_batch ()
+{
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
+	{
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
+		{
+			std::string source_text (request.get<std::string> ("source"));
+			rai::account source;
+			auto error (source.decode_account (source_text));
+			if (!error)
+			{
+				auto sends (request.get_child ("sends"));
+				if (sends.size () > rai::wallet::send_batch_max)
+				{
+					error_response (response, boost::str (boost::format ("Too many sends, at most %1% per batch") % rai::wallet::send_batch_max));
+					return;
+				}
+				std::vector<rai::send_batch_entry> entries;
+				for (auto & send : sends)
+				{
+					rai::send_batch_entry entry;
+					if (entry.destination.decode_account (send.second.get<std::string> ("destination")))
+					{
+						error_response (response, "Bad destination account");
+						return;
+					}
+					if (!find_token_hash (send.second.get<std::string> ("token"), entry.token))
+					{
+						error_response (response, "Invalid token name");
+						return;
+					}
+					rai::amount amount;
+					if (amount.decode_dec (send.second.get<std::string> ("amount")))
+					{
+						error_response (response, "Bad amount format");
+						return;
+					}
+					entry.amount = amount.number ();
+					entry.id = send.second.get_optional<std::string> ("id");
+					entries.push_back (entry);
+				}
+				auto response_a (response);
+				existing->second->send_batch_async (source, entries, [response_a](std::vector<std::shared_ptr<rai::block>> const & blocks_a) {
+					boost::property_tree::ptree response_l;
+					boost::property_tree::ptree blocks;
+					for (auto & block : blocks_a)
+					{
+						boost::property_tree::ptree entry;
+						if (block != nullptr)
+						{
+							entry.put ("block", block->hash ().to_string ());
+						}
+						else
+						{
+							entry.put ("error", "Error generating block");
+						}
+						blocks.push_back (std::make_pair ("", entry));
+					}
+					response_l.add_child ("blocks", blocks);
+					response_a (response_l);
+				});
+			}
+			else
+			{
+				error_response (response, "Bad source account");
+			}
+		}
+		else
+		{
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
@@ -3512,13 +3937,29 @@ void rai::rpc_handler::stats ()
 	{
 		node.stats.log_samples (*sink);
 	}
-	else
+	else if (type != "startup")
 	{
 		error = true;
 		error_response (response, "Invalid or missing type argument");
 	}
 
-	if (!error)
+	if (!error && type == "startup")
+	{
+		// Phases of the node's construction and start in the order they ran
+		boost::property_tree::ptree response_l;
+		boost::property_tree::ptree phases;
+		for (auto & i : node.startup.phases ())
+		{
+			boost::property_tree::ptree entry;
+			entry.put ("phase", i.first);
+			entry.put ("milliseconds", std::to_string (i.second.count ()));
+			phases.push_back (std::make_pair ("", entry));
+		}
+		response_l.put ("total", std::to_string (node.startup.total ().count ()));
+		response_l.add_child ("phases", phases);
+		response (response_l);
+	}
+	else if (!error)
 	{
 		response (*static_cast<boost::property_tree::ptree *> (sink->to_object ()));
 	}
@@ -3526,18 +3967,11 @@ void rai::rpc_handler::stats ()
 
 void rai::rpc_handler::stop ()
 {
-	if (rpc.config.enable_control)
-	{
-		boost::property_tree::ptree response_l;
-		response_l.put ("success", "");
-		response (response_l);
-		rpc.stop ();
-		node.stop ();
-	}
-	else
-	{
-		error_response (response, "RPC control is disabled");
-	}
+	boost::property_tree::ptree response_l;
+	response_l.put ("success", "");
+	response (response_l);
+	rpc.stop ();
+	node.stop ();
 }
 
 void rai::rpc_handler::unchecked ()
@@ -3550,37 +3984,56 @@ void rai::rpc_handler::unchecked ()
 		if (error)
 		{
 			error_response (response, "Invalid count limit");
+			return;
 		}
 	}
-	boost::property_tree::ptree response_l;
-	boost::property_tree::ptree unchecked;
-	rai::transaction transaction (node.store.environment, nullptr, false);
-	for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
+	auto writer (response_writer ());
+	writer.begin_object ("blocks");
+	// A block waiting on several dependencies is stored once per dependency but listed once
+	std::unordered_set<rai::block_hash> written;
+	rai::block_hash start (0);
+	auto more (true);
+	while (more)
 	{
-		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
-		auto block (rai::deserialize_block (stream));
-		std::string contents;
-		block->serialize_json (contents);
-		unchecked.put (block->hash ().to_string (), contents);
+		more = false;
+		{
+			rai::transaction transaction (node.store.backend, nullptr, false);
+			for (auto i (node.store.unchecked_begin (transaction, start)), n (node.store.unchecked_end ()); i != n && written.size () < count; ++i)
+			{
+				if (writer.pending ())
+				{
+					// Blocks under this key already written are skipped by hash when reading resumes
+					start = i->first.uint256 ();
+					more = true;
+					break;
+				}
+				rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
+				auto block (rai::deserialize_block (stream));
+				auto hash (block->hash ());
+				if (written.insert (hash).second)
+				{
+					std::string contents;
+					block->serialize_json (contents);
+					writer.value (hash.to_string (), contents);
+				}
+			}
+		}
+		if (more)
+		{
+			more = !writer.send ();
+		}
 	}
-	response_l.add_child ("blocks", unchecked);
-	response (response_l);
+	writer.end ();
+	response_chunk (writer.finish (), true);
 }
 
 void rai::rpc_handler::unchecked_clear ()
 {
-	if (rpc.config.enable_control)
-	{
-		rai::transaction transaction (node.store.environment, nullptr, true);
-		node.store.unchecked_clear (transaction);
-		boost::property_tree::ptree response_l;
-		response_l.put ("success", "");
-		response (response_l);
-	}
-	else
-	{
-		error_response (response, "RPC control is disabled");
-	}
+	rai::transaction transaction (node.store.backend, nullptr, true);
+	node.store.unchecked_clear (transaction);
+	boost::property_tree::ptree response_l;
+	response_l.put ("success", "");
+	response (response_l);
 }
 
 void rai::rpc_handler::unchecked_get ()
@@ -3591,7 +4044,7 @@ void rai::rpc_handler::unchecked_get ()
 	if (!error)
 	{
 		boost::property_tree::ptree response_l;
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n; ++i)
 		{
 			rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
@@ -3630,6 +4083,7 @@ void rai::rpc_handler::unchecked_keys ()
 		if (error)
 		{
 			error_response (response, "Invalid count limit");
+			return;
 		}
 	}
 	boost::optional<std::string> hash_text (request.get_optional<std::string> ("key"));
@@ -3639,25 +4093,92 @@ void rai::rpc_handler::unchecked_keys ()
 		if (error_hash)
 		{
 			error_response (response, "Bad key hash number");
+			return;
 		}
 	}
-	boost::property_tree::ptree response_l;
-	boost::property_tree::ptree unchecked;
-	rai::transaction transaction (node.store.environment, nullptr, false);
-	for (auto i (node.store.unchecked_begin (transaction, key)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
+	// Unchecked blocks are stored under the hash they depend on, a cursor names the key and the first block not yet returned
+	boost::optional<rai::block_hash> cursor_hash;
+	boost::optional<std::string> cursor_text (request.get_optional<std::string> ("cursor"));
+	if (cursor_text.is_initialized ())
 	{
-		boost::property_tree::ptree entry;
-		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
-		auto block (rai::deserialize_block (stream));
-		std::string contents;
-		block->serialize_json (contents);
-		entry.put ("key", rai::block_hash (i->first.uint256 ()).to_string ());
-		entry.put ("hash", block->hash ().to_string ());
-		entry.put ("contents", contents);
-		unchecked.push_back (std::make_pair ("", entry));
-	}
-	response_l.add_child ("unchecked", unchecked);
-	response (response_l);
+		rai::block_hash hash;
+		if (cursor_decode (cursor_text.get (), key, hash))
+		{
+			error_response (response, "Invalid cursor");
+			return;
+		}
+		cursor_hash = hash;
+	}
+	auto writer (response_writer ());
+	writer.begin_array ("unchecked");
+	uint64_t written (0);
+	boost::optional<std::string> next;
+	auto more (true);
+	while (more)
+	{
+		more = false;
+		{
+			rai::transaction transaction (node.store.backend, nullptr, false);
+			size_t skip (0);
+			if (cursor_hash)
+			{
+				// Entries under the cursor key ahead of the named block were already returned, unless that block is gone
+				size_t index (0);
+				for (auto i (node.store.unchecked_begin (transaction, key)), n (node.store.unchecked_end ()); i != n && rai::block_hash (i->first.uint256 ()) == key; ++i, ++index)
+				{
+					rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
+					auto block (rai::deserialize_block (stream));
+					if (block->hash () == *cursor_hash)
+					{
+						skip = index;
+						break;
+					}
+				}
+			}
+			for (auto i (node.store.unchecked_begin (transaction, key)), n (node.store.unchecked_end ()); i != n; ++i)
+			{
+				if (skip > 0)
+				{
+					--skip;
+					continue;
+				}
+				rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
+				auto block (rai::deserialize_block (stream));
+				rai::block_hash key_l (i->first.uint256 ());
+				if (written == count)
+				{
+					next = cursor_encode (key_l) + cursor_encode (block->hash ());
+					break;
+				}
+				if (writer.pending ())
+				{
+					// Resumes the same way a cursor does, in a new transaction once the piece is out
+					key = key_l;
+					cursor_hash = block->hash ();
+					more = true;
+					break;
+				}
+				std::string contents;
+				block->serialize_json (contents);
+				writer.begin_object ();
+				writer.value ("key", key_l.to_string ());
+				writer.value ("hash", block->hash ().to_string ());
+				writer.value ("contents", contents);
+				writer.end ();
+				++written;
+			}
+		}
+		if (more)
+		{
+			more = !writer.send ();
+		}
+	}
+	writer.end ();
+	if (next)
+	{
+		writer.value ("cursor", *next);
+	}
+	response_chunk (writer.finish (), true);
 }
 
 void rai::rpc_handler::version ()
@@ -3681,106 +4202,92 @@ void rai::rpc_handler::validate_account_number ()
 
 void rai::rpc_handler::wallet_add ()
 {
-	if (rpc.config.enable_control)
+	std::string key_text (request.get<std::string> ("key"));
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::raw_key key;
+	auto error (key.data.decode_hex (key_text));
+	if (!error)
 	{
-		std::string key_text (request.get<std::string> ("key"));
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::raw_key key;
-		auto error (key.data.decode_hex (key_text));
+		rai::uint256_union wallet;
+		auto error (wallet.decode_hex (wallet_text));
 		if (!error)
 		{
-			rai::uint256_union wallet;
-			auto error (wallet.decode_hex (wallet_text));
-			if (!error)
+			auto existing (node.wallets.items.find (wallet));
+			if (existing != node.wallets.items.end ())
 			{
-				auto existing (node.wallets.items.find (wallet));
-				if (existing != node.wallets.items.end ())
+				const bool generate_work = request.get<bool> ("work", true);
+				auto pub (existing->second->insert_adhoc (key, generate_work));
+				if (!pub.is_zero ())
 				{
-					const bool generate_work = request.get<bool> ("work", true);
-					auto pub (existing->second->insert_adhoc (key, generate_work));
-					if (!pub.is_zero ())
-					{
-						boost::property_tree::ptree response_l;
-						response_l.put ("account", pub.to_account ());
-						response (response_l);
-					}
-					else
-					{
-						error_response (response, "Wallet locked");
-					}
+					boost::property_tree::ptree response_l;
+					response_l.put ("account", pub.to_account ());
+					response (response_l);
 				}
 				else
 				{
-					error_response (response, "Wallet not found");
+					error_response (response, "Wallet locked");
 				}
 			}
 			else
 			{
-				error_response (response, "Bad wallet number");
+				error_response (response, "Wallet not found");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad private key");
+			error_response (response, "Bad wallet number");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad private key");
 	}
 }
 
 void rai::rpc_handler::wallet_add_watch ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
+			rai::transaction transaction (node.store.backend, nullptr, true);
+			if (existing->second->store.valid_password (transaction))
 			{
-				rai::transaction transaction (node.store.environment, nullptr, true);
-				if (existing->second->store.valid_password (transaction))
+				for (auto & accounts : request.get_child ("accounts"))
 				{
-					for (auto & accounts : request.get_child ("accounts"))
+					std::string account_text = accounts.second.data ();
+					rai::uint256_union account;
+					auto error (account.decode_account (account_text));
+					if (!error)
 					{
-						std::string account_text = accounts.second.data ();
-						rai::uint256_union account;
-						auto error (account.decode_account (account_text));
-						if (!error)
-						{
-							existing->second->insert_watch (transaction, account);
-						}
-						else
-						{
-							error_response (response, "Bad account number");
-						}
+						existing->second->insert_watch (transaction, account);
+					}
+					else
+					{
+						error_response (response, "Bad account number");
 					}
-					boost::property_tree::ptree response_l;
-					response_l.put ("success", "");
-					response (response_l);
-				}
-				else
-				{
-					error_response (response, "Wallet locked");
 				}
+				boost::property_tree::ptree response_l;
+				response_l.put ("success", "");
+				response (response_l);
 			}
 			else
 			{
-				error_response (response, "Wallet not found");
+				error_response (response, "Wallet locked");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
@@ -3796,7 +4303,7 @@ void rai::rpc_handler::wallet_balance_total ()
 		{
 			rai::uint128_t balance (0);
 			rai::uint128_t pending (0);
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 			{
 				rai::account account (i->first.uint256 ());
@@ -3841,7 +4348,7 @@ void rai::rpc_handler::wallet_balances ()
 		{
 			boost::property_tree::ptree response_l;
 			boost::property_tree::ptree balances;
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 			{
 				rai::account account (i->first.uint256 ());
@@ -3882,52 +4389,45 @@ void rai::rpc_handler::wallet_balances ()
 
 void rai::rpc_handler::wallet_change_seed ()
 {
-	if (rpc.config.enable_control)
+	std::string seed_text (request.get<std::string> ("seed"));
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::raw_key seed;
+	auto error (seed.data.decode_hex (seed_text));
+	if (!error)
 	{
-		std::string seed_text (request.get<std::string> ("seed"));
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::raw_key seed;
-		auto error (seed.data.decode_hex (seed_text));
+		rai::uint256_union wallet;
+		auto error (wallet.decode_hex (wallet_text));
 		if (!error)
 		{
-			rai::uint256_union wallet;
-			auto error (wallet.decode_hex (wallet_text));
-			if (!error)
+			auto existing (node.wallets.items.find (wallet));
+			if (existing != node.wallets.items.end ())
 			{
-				auto existing (node.wallets.items.find (wallet));
-				if (existing != node.wallets.items.end ())
+				rai::transaction transaction (node.store.backend, nullptr, true);
+				if (existing->second->store.valid_password (transaction))
 				{
-					rai::transaction transaction (node.store.environment, nullptr, true);
-					if (existing->second->store.valid_password (transaction))
-					{
-						existing->second->store.seed_set (transaction, seed);
-						boost::property_tree::ptree response_l;
-						response_l.put ("success", "");
-						response (response_l);
-					}
-					else
-					{
-						error_response (response, "Wallet locked");
-					}
+					existing->second->store.seed_set (transaction, seed);
+					boost::property_tree::ptree response_l;
+					response_l.put ("success", "");
+					response (response_l);
 				}
 				else
 				{
-					error_response (response, "Wallet not found");
+					error_response (response, "Wallet locked");
 				}
 			}
 			else
 			{
-				error_response (response, "Bad wallet number");
+				error_response (response, "Wallet not found");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad seed");
+			error_response (response, "Bad wallet number");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad seed");
 	}
 }
 
@@ -3946,7 +4446,7 @@ void rai::rpc_handler::wallet_contains ()
 			auto existing (node.wallets.items.find (wallet));
 			if (existing != node.wallets.items.end ())
 			{
-				rai::transaction transaction (node.store.environment, nullptr, false);
+				rai::transaction transaction (node.store.backend, nullptr, false);
 				auto exists (existing->second->store.find (transaction, account) != existing->second->store.end ());
 				boost::property_tree::ptree response_l;
 				response_l.put ("exists", exists ? "1" : "0");
@@ -3970,58 +4470,44 @@ void rai::rpc_handler::wallet_contains ()
 
 void rai::rpc_handler::wallet_create ()
 {
-	if (rpc.config.enable_control)
+	rai::keypair wallet_id;
+	node.wallets.create (wallet_id.pub);
+	rai::transaction transaction (node.store.backend, nullptr, false);
+	auto existing (node.wallets.items.find (wallet_id.pub));
+	if (existing != node.wallets.items.end ())
 	{
-		rai::keypair wallet_id;
-		node.wallets.create (wallet_id.pub);
-		rai::transaction transaction (node.store.environment, nullptr, false);
-		auto existing (node.wallets.items.find (wallet_id.pub));
-		if (existing != node.wallets.items.end ())
-		{
-			boost::property_tree::ptree response_l;
-			response_l.put ("wallet", wallet_id.pub.to_string ());
-			response (response_l);
-		}
-		else
-		{
-			error_response (response, "Failed to create wallet. Increase lmdb_max_dbs in node config.");
-		}
+		boost::property_tree::ptree response_l;
+		response_l.put ("wallet", wallet_id.pub.to_string ());
+		response (response_l);
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Failed to create wallet. Increase lmdb_max_dbs in node config.");
 	}
 }
 
 void rai::rpc_handler::wallet_destroy ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
-			{
-				node.wallets.destroy (wallet);
-				boost::property_tree::ptree response_l;
-				response (response_l);
-			}
-			else
-			{
-				error_response (response, "Wallet not found");
-			}
+			node.wallets.destroy (wallet);
+			boost::property_tree::ptree response_l;
+			response (response_l);
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
@@ -4035,7 +4521,7 @@ void rai::rpc_handler::wallet_export ()
 		auto existing (node.wallets.items.find (wallet));
 		if (existing != node.wallets.items.end ())
 		{
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			std::string json;
 			existing->second->store.serialize_json (transaction, json);
 			boost::property_tree::ptree response_l;
@@ -4065,7 +4551,7 @@ void rai::rpc_handler::wallet_frontiers ()
 		{
 			boost::property_tree::ptree response_l;
 			boost::property_tree::ptree frontiers;
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 			{
 				rai::account account (i->first.uint256 ());
@@ -4106,7 +4592,7 @@ void rai::rpc_handler::wallet_key_valid ()
 		auto existing (node.wallets.items.find (wallet));
 		if (existing != node.wallets.items.end ())
 		{
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			auto valid (existing->second->store.valid_password (transaction));
 			boost::property_tree::ptree response_l;
 			response_l.put ("valid", valid ? "1" : "0");
@@ -4144,7 +4630,7 @@ void rai::rpc_handler::wallet_ledger ()
 		{
 			boost::property_tree::ptree response_l;
 			boost::property_tree::ptree accounts;
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 			{
 				rai::account account (i->first.uint256 ());
@@ -4164,9 +4650,9 @@ void rai::rpc_handler::wallet_ledger ()
 						entry.put ("block_count", std::to_string (info.block_count));
 						if (representative)
 						{
-							auto block (node.store.block_get (transaction, info.rep_block));
-							assert (block != nullptr);
-							entry.put ("representative", block->representative ().to_account ());
+							auto block (node.store.block_view_get (transaction, info.rep_block));
+							assert (block.exists ());
+							entry.put ("representative", block.representative ().to_account ());
 						}
 						if (weight)
 						{
@@ -4198,36 +4684,30 @@ void rai::rpc_handler::wallet_ledger ()
 
 void rai::rpc_handler::wallet_lock ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
-			{
-				boost::property_tree::ptree response_l;
-				rai::raw_key empty;
-				empty.data.clear ();
-				existing->second->store.password.value_set (empty);
-				response_l.put ("locked", "1");
-				response (response_l);
-			}
-			else
-			{
-				error_response (response, "Wallet not found");
-			}
+			boost::property_tree::ptree response_l;
+			rai::raw_key empty;
+			empty.data.clear ();
+			existing->second->store.password.value_set (empty);
+			node.wallets.representative_keys_clear (*existing->second);
+			response_l.put ("locked", "1");
+			response (response_l);
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
@@ -4264,7 +4744,7 @@ void rai::rpc_handler::wallet_pending ()
 			const bool source = request.get<bool> ("source", false);
 			boost::property_tree::ptree response_l;
 			boost::property_tree::ptree pending;
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 			{
 				rai::account account (i->first.uint256 ());
@@ -4327,7 +4807,7 @@ void rai::rpc_handler::wallet_representative ()
 		auto existing (node.wallets.items.find (wallet));
 		if (existing != node.wallets.items.end ())
 		{
-			rai::transaction transaction (node.store.environment, nullptr, false);
+			rai::transaction transaction (node.store.backend, nullptr, false);
 			boost::property_tree::ptree response_l;
 			response_l.put ("representative", existing->second->store.representative (transaction).to_account ());
 			response (response_l);
@@ -4345,335 +4825,286 @@ void rai::rpc_handler::wallet_representative ()
 
 void rai::rpc_handler::wallet_representative_set ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
+			std::string representative_text (request.get<std::string> ("representative"));
+			rai::account representative;
+			auto error (representative.decode_account (representative_text));
+			if (!error)
 			{
-				std::string representative_text (request.get<std::string> ("representative"));
-				rai::account representative;
-				auto error (representative.decode_account (representative_text));
-				if (!error)
-				{
-					rai::transaction transaction (node.store.environment, nullptr, true);
-					existing->second->store.representative_set (transaction, representative);
-					boost::property_tree::ptree response_l;
-					response_l.put ("set", "1");
-					response (response_l);
-				}
-				else
-				{
-					error_response (response, "Invalid account number");
-				}
+				rai::transaction transaction (node.store.backend, nullptr, true);
+				existing->second->store.representative_set (transaction, representative);
+				boost::property_tree::ptree response_l;
+				response_l.put ("set", "1");
+				response (response_l);
 			}
 			else
 			{
-				error_response (response, "Wallet not found");
+				error_response (response, "Invalid account number");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad account number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad account number");
 	}
 }
 
 void rai::rpc_handler::wallet_republish ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
+			uint64_t count;
+			std::string count_text (request.get<std::string> ("count"));
+			auto error (decode_unsigned (count_text, count));
+			if (!error)
 			{
-				uint64_t count;
-				std::string count_text (request.get<std::string> ("count"));
-				auto error (decode_unsigned (count_text, count));
-				if (!error)
+				boost::property_tree::ptree response_l;
+				boost::property_tree::ptree blocks;
+				rai::transaction transaction (node.store.backend, nullptr, false);
+				for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 				{
-					boost::property_tree::ptree response_l;
-					boost::property_tree::ptree blocks;
-					rai::transaction transaction (node.store.environment, nullptr, false);
-					for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
+					rai::account account (i->first.uint256 ());
+					auto latest (node.ledger.latest (transaction, account));
+					std::unique_ptr<rai::block> block;
+					std::vector<rai::block_hash> hashes;
+					while (!latest.is_zero () && hashes.size () < count)
 					{
-						rai::account account (i->first.uint256 ());
-						auto latest (node.ledger.latest (transaction, account));
-						std::unique_ptr<rai::block> block;
-						std::vector<rai::block_hash> hashes;
-						while (!latest.is_zero () && hashes.size () < count)
-						{
-							hashes.push_back (latest);
-							block = node.store.block_get (transaction, latest);
-							latest = block->previous ();
-						}
-						std::reverse (hashes.begin (), hashes.end ());
-						for (auto & hash : hashes)
-						{
-							block = node.store.block_get (transaction, hash);
-							node.network.republish_block (transaction, std::move (block));
-							;
-							boost::property_tree::ptree entry;
-							entry.put ("", hash.to_string ());
-							blocks.push_back (std::make_pair ("", entry));
-						}
+						hashes.push_back (latest);
+						block = node.store.block_get (transaction, latest);
+						latest = block->previous ();
+					}
+					std::reverse (hashes.begin (), hashes.end ());
+					for (auto & hash : hashes)
+					{
+						block = node.store.block_get (transaction, hash);
+						node.network.republish_block (transaction, std::move (block));
+						;
+						boost::property_tree::ptree entry;
+						entry.put ("", hash.to_string ());
+						blocks.push_back (std::make_pair ("", entry));
 					}
-					response_l.add_child ("blocks", blocks);
-					response (response_l);
-				}
-				else
-				{
-					error_response (response, "Invalid count limit");
 				}
+				response_l.add_child ("blocks", blocks);
+				response (response_l);
 			}
 			else
 			{
-				error_response (response, "Wallet not found");
+				error_response (response, "Invalid count limit");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
 void rai::rpc_handler::wallet_work_get ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
-			{
-				boost::property_tree::ptree response_l;
-				boost::property_tree::ptree works;
-				rai::transaction transaction (node.store.environment, nullptr, false);
-				for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
-				{
-					rai::account account (i->first.uint256 ());
-					uint64_t work (0);
-					auto error_work (existing->second->store.work_get (transaction, account, work));
-					works.put (account.to_account (), rai::to_string_hex (work));
-				}
-				response_l.add_child ("works", works);
-				response (response_l);
-			}
-			else
+			boost::property_tree::ptree response_l;
+			boost::property_tree::ptree works;
+			rai::transaction transaction (node.store.backend, nullptr, false);
+			for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 			{
-				error_response (response, "Wallet not found");
+				rai::account account (i->first.uint256 ());
+				uint64_t work (0);
+				auto error_work (existing->second->store.work_get (transaction, account, work));
+				works.put (account.to_account (), rai::to_string_hex (work));
 			}
+			response_l.add_child ("works", works);
+			response (response_l);
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
 void rai::rpc_handler::work_generate ()
 {
-	if (rpc.config.enable_control)
+	std::string hash_text (request.get<std::string> ("hash"));
+	bool use_peers (request.get_optional<bool> ("use_peers") == true);
+	rai::block_hash hash;
+	auto error (hash.decode_hex (hash_text));
+	if (!error)
 	{
-		std::string hash_text (request.get<std::string> ("hash"));
-		bool use_peers (request.get_optional<bool> ("use_peers") == true);
-		rai::block_hash hash;
-		auto error (hash.decode_hex (hash_text));
-		if (!error)
-		{
-			auto rpc_l (shared_from_this ());
-			auto callback = [rpc_l](boost::optional<uint64_t> const & work_a) {
-				if (work_a)
-				{
-					boost::property_tree::ptree response_l;
-					response_l.put ("work", rai::to_string_hex (work_a.value ()));
-					rpc_l->response (response_l);
-				}
-				else
-				{
-					error_response (rpc_l->response, "Cancelled");
-				}
-			};
-			if (!use_peers)
+		auto rpc_l (shared_from_this ());
+		auto callback = [rpc_l](boost::optional<uint64_t> const & work_a) {
+			if (work_a)
 			{
-				node.work.generate (hash, callback);
+				boost::property_tree::ptree response_l;
+				response_l.put ("work", rai::to_string_hex (work_a.value ()));
+				rpc_l->response (response_l);
 			}
 			else
 			{
-				node.work_generate (hash, callback);
+				error_response (rpc_l->response, "Cancelled");
 			}
+		};
+		if (!use_peers)
+		{
+			node.work.generate (hash, callback);
 		}
 		else
 		{
-			error_response (response, "Bad block hash");
+			node.work_generate (hash, callback);
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad block hash");
 	}
 }
 
 void rai::rpc_handler::work_cancel ()
 {
-	if (rpc.config.enable_control)
+	std::string hash_text (request.get<std::string> ("hash"));
+	rai::block_hash hash;
+	auto error (hash.decode_hex (hash_text));
+	if (!error)
 	{
-		std::string hash_text (request.get<std::string> ("hash"));
-		rai::block_hash hash;
-		auto error (hash.decode_hex (hash_text));
-		if (!error)
-		{
-			node.work.cancel (hash);
-			boost::property_tree::ptree response_l;
-			response (response_l);
-		}
-		else
-		{
-			error_response (response, "Bad block hash");
-		}
+		node.work.cancel (hash);
+		boost::property_tree::ptree response_l;
+		response (response_l);
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad block hash");
 	}
 }
 
 void rai::rpc_handler::work_get ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
+			std::string account_text (request.get<std::string> ("account"));
+			rai::account account;
+			auto error (account.decode_account (account_text));
+			if (!error)
 			{
-				std::string account_text (request.get<std::string> ("account"));
-				rai::account account;
-				auto error (account.decode_account (account_text));
-				if (!error)
+				rai::transaction transaction (node.store.backend, nullptr, false);
+				auto account_check (existing->second->store.find (transaction, account));
+				if (account_check != existing->second->store.end ())
 				{
-					rai::transaction transaction (node.store.environment, nullptr, false);
-					auto account_check (existing->second->store.find (transaction, account));
-					if (account_check != existing->second->store.end ())
-					{
-						uint64_t work (0);
-						auto error_work (existing->second->store.work_get (transaction, account, work));
-						boost::property_tree::ptree response_l;
-						response_l.put ("work", rai::to_string_hex (work));
-						response (response_l);
-					}
-					else
-					{
-						error_response (response, "Account not found in wallet");
-					}
+					uint64_t work (0);
+					auto error_work (existing->second->store.work_get (transaction, account, work));
+					boost::property_tree::ptree response_l;
+					response_l.put ("work", rai::to_string_hex (work));
+					response (response_l);
 				}
 				else
 				{
-					error_response (response, "Bad account number");
+					error_response (response, "Account not found in wallet");
 				}
 			}
 			else
 			{
-				error_response (response, "Wallet not found");
+				error_response (response, "Bad account number");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
 void rai::rpc_handler::work_set ()
 {
-	if (rpc.config.enable_control)
+	std::string wallet_text (request.get<std::string> ("wallet"));
+	rai::uint256_union wallet;
+	auto error (wallet.decode_hex (wallet_text));
+	if (!error)
 	{
-		std::string wallet_text (request.get<std::string> ("wallet"));
-		rai::uint256_union wallet;
-		auto error (wallet.decode_hex (wallet_text));
-		if (!error)
+		auto existing (node.wallets.items.find (wallet));
+		if (existing != node.wallets.items.end ())
 		{
-			auto existing (node.wallets.items.find (wallet));
-			if (existing != node.wallets.items.end ())
+			std::string account_text (request.get<std::string> ("account"));
+			rai::account account;
+			auto error (account.decode_account (account_text));
+			if (!error)
 			{
-				std::string account_text (request.get<std::string> ("account"));
-				rai::account account;
-				auto error (account.decode_account (account_text));
-				if (!error)
+				rai::transaction transaction (node.store.backend, nullptr, true);
+				auto account_check (existing->second->store.find (transaction, account));
+				if (account_check != existing->second->store.end ())
 				{
-					rai::transaction transaction (node.store.environment, nullptr, true);
-					auto account_check (existing->second->store.find (transaction, account));
-					if (account_check != existing->second->store.end ())
+					std::string work_text (request.get<std::string> ("work"));
+					uint64_t work;
+					auto work_error (rai::from_string_hex (work_text, work));
+					if (!work_error)
 					{
-						std::string work_text (request.get<std::string> ("work"));
-						uint64_t work;
-						auto work_error (rai::from_string_hex (work_text, work));
-						if (!work_error)
-						{
-							existing->second->store.work_put (transaction, account, work);
-							boost::property_tree::ptree response_l;
-							response_l.put ("success", "");
-							response (response_l);
-						}
-						else
-						{
-							error_response (response, "Bad work");
-						}
+						existing->second->store.work_put (transaction, account, work);
+						boost::property_tree::ptree response_l;
+						response_l.put ("success", "");
+						response (response_l);
 					}
 					else
 					{
-						error_response (response, "Account not found in wallet");
+						error_response (response, "Bad work");
 					}
 				}
 				else
 				{
-					error_response (response, "Bad account number");
+					error_response (response, "Account not found in wallet");
 				}
 			}
 			else
 			{
-				error_response (response, "Wallet not found");
+				error_response (response, "Bad account number");
 			}
 		}
 		else
 		{
-			error_response (response, "Bad wallet number");
+			error_response (response, "Wallet not found");
 		}
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Bad wallet number");
 	}
 }
 
@@ -4707,63 +5138,42 @@ void rai::rpc_handler::work_validate ()
 
 void rai::rpc_handler::work_peer_add ()
 {
-	if (rpc.config.enable_control)
+	std::string address_text = request.get<std::string> ("address");
+	std::string port_text = request.get<std::string> ("port");
+	uint16_t port;
+	if (!rai::parse_port (port_text, port))
 	{
-		std::string address_text = request.get<std::string> ("address");
-		std::string port_text = request.get<std::string> ("port");
-		uint16_t port;
-		if (!rai::parse_port (port_text, port))
-		{
-			node.config.work_peers.push_back (std::make_pair (address_text, port));
-			boost::property_tree::ptree response_l;
-			response_l.put ("success", "");
-			response (response_l);
-		}
-		else
-		{
-			error_response (response, "Invalid port");
-		}
+		node.config.work_peers.push_back (std::make_pair (address_text, port));
+		boost::property_tree::ptree response_l;
+		response_l.put ("success", "");
+		response (response_l);
 	}
 	else
 	{
-		error_response (response, "RPC control is disabled");
+		error_response (response, "Invalid port");
 	}
 }
 
 void rai::rpc_handler::work_peers ()
 {
-	if (rpc.config.enable_control)
-	{
-		boost::property_tree::ptree work_peers_l;
-		for (auto i (node.config.work_peers.begin ()), n (node.config.work_peers.end ()); i != n; ++i)
-		{
-			boost::property_tree::ptree entry;
-			entry.put ("", boost::str (boost::format ("%1%:%2%") % i->first % i->second));
-			work_peers_l.push_back (std::make_pair ("", entry));
-		}
-		boost::property_tree::ptree response_l;
-		response_l.add_child ("work_peers", work_peers_l);
-		response (response_l);
-	}
-	else
+	boost::property_tree::ptree work_peers_l;
+	for (auto i (node.config.work_peers.begin ()), n (node.config.work_peers.end ()); i != n; ++i)
 	{
-		error_response (response, "RPC control is disabled");
+		boost::property_tree::ptree entry;
+		entry.put ("", boost::str (boost::format ("%1%:%2%") % i->first % i->second));
+		work_peers_l.push_back (std::make_pair ("", entry));
 	}
+	boost::property_tree::ptree response_l;
+	response_l.add_child ("work_peers", work_peers_l);
+	response (response_l);
 }
 
 void rai::rpc_handler::work_peers_clear ()
 {
-	if (rpc.config.enable_control)
-	{
-		node.config.work_peers.clear ();
-		boost::property_tree::ptree response_l;
-		response_l.put ("success", "");
-		response (response_l);
-	}
-	else
-	{
-		error_response (response, "RPC control is disabled");
-	}
+	node.config.work_peers.clear ();
+	boost::property_tree::ptree response_l;
+	response_l.put ("success", "");
+	response (response_l);
 }
 
 void rai::rpc_handler::chain_utc_epoch_time ()
@@ -4853,7 +5263,7 @@ void rai::rpc_handler::smart_contract_block ()
 	auto error (hash.decode_hex (hash_text));
 	if (!error)
 	{
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		auto block (node.store.block_get (transaction, hash));
 		if (block != nullptr)
 		{
@@ -4890,17 +5300,28 @@ void rai::rpc_handler::tokens ()
 	response (response_l);
 }
 
+unsigned constexpr rai::rpc_connection::chunk_timeout_s;
+uint64_t constexpr rai::rpc_handler::ledger_sorted_count_max;
+
 rai::rpc_connection::rpc_connection (rai::node & node_a, rai::rpc & rpc_a) :
 node (node_a.shared ()),
 rpc (rpc_a),
-socket (node_a.service)
+socket (node_a.service),
+requests (0),
+reading (false),
+strand (node_a.service),
+idle_timer (node_a.service),
+streaming (false)
 {
 	responded.clear ();
 }
 
 void rai::rpc_connection::parse_connection ()
 {
-	read ();
+	auto this_l (shared_from_this ());
+	strand.dispatch ([this_l]() {
+		this_l->read ();
+	});
 }
 
 void rai::rpc_connection::write_result (std::string body, unsigned version)
@@ -4910,10 +5331,10 @@ void rai::rpc_connection::write_result (std::string body, unsigned version)
 		res.set ("Content-Type", "application/json");
 		res.set ("Access-Control-Allow-Origin", "*");
 		res.set ("Access-Control-Allow-Headers", "Accept, Accept-Language, Content-Language, Content-Type");
-		res.set ("Connection", "close");
 		res.result (boost::beast::http::status::ok);
 		res.body () = body;
 		res.version (version);
+		res.keep_alive (request.keep_alive () && requests < rpc.config.keepalive_request_limit);
 		res.prepare_payload ();
 	}
 	else
@@ -4923,541 +5344,376 @@ void rai::rpc_connection::write_result (std::string body, unsigned version)
 	}
 }
 
+void rai::rpc_connection::read_started ()
+{
+	reading = true;
+	std::weak_ptr<rai::rpc_connection> this_w (shared_from_this ());
+	idle_timer.expires_from_now (std::chrono::seconds (rpc.config.keepalive_timeout));
+	idle_timer.async_wait (strand.wrap ([this_w](boost::system::error_code const & ec) {
+		if (!ec)
+		{
+			if (auto this_l = this_w.lock ())
+			{
+				this_l->idle_check ();
+			}
+		}
+	}));
+}
+
+void rai::rpc_connection::idle_check ()
+{
+	// The timer is rearmed for every read, a read that completed while this was queued already took the connection back
+	if (reading)
+	{
+		// Nothing arrived within the timeout, closing aborts the pending read and releases the connection
+		boost::system::error_code ec;
+		socket.close (ec);
+	}
+}
+
+bool rai::rpc_connection::write_chunk (std::string const & chunk_a, bool last_a, unsigned version_a)
+{
+	auto data (std::make_shared<std::string> ());
+	if (!streaming)
+	{
+		streaming = true;
+		write_result (std::string (), version_a);
+		boost::beast::http::response<boost::beast::http::empty_body> header (res.base ());
+		header.erase (boost::beast::http::field::content_length);
+		header.chunked (true);
+		std::ostringstream header_text;
+		header_text << header.base ();
+		*data = header_text.str ();
+	}
+	if (!chunk_a.empty ())
+	{
+		data->append (boost::str (boost::format ("%x\r\n") % chunk_a.size ()));
+		data->append (chunk_a);
+		data->append ("\r\n");
+	}
+	if (last_a)
+	{
+		data->append ("0\r\n\r\n");
+	}
+	auto this_l (shared_from_this ());
+	auto written (std::make_shared<std::promise<boost::system::error_code>> ());
+	auto result (written->get_future ());
+	strand.dispatch ([this_l, data, written]() {
+		this_l->write_buffer (data, [written](boost::system::error_code const & ec) {
+			written->set_value (ec);
+		});
+	});
+	boost::system::error_code ec;
+	if (result.wait_for (std::chrono::seconds (chunk_timeout_s)) == std::future_status::ready)
+	{
+		ec = result.get ();
+	}
+	else
+	{
+		// The client stopped reading, closing the socket aborts the write
+		abort ();
+		ec = boost::asio::error::timed_out;
+	}
+	if (last_a)
+	{
+		strand.post ([this_l, ec]() {
+			if (!ec && this_l->res.keep_alive ())
+			{
+				this_l->next_request ();
+				this_l->read ();
+			}
+			else
+			{
+				this_l->shutdown ();
+			}
+		});
+	}
+	return !!ec;
+}
+
+void rai::rpc_connection::abort ()
+{
+	auto this_l (shared_from_this ());
+	strand.post ([this_l]() {
+		boost::system::error_code ignored;
+		this_l->socket.close (ignored);
+	});
+}
+
+void rai::rpc_connection::write_buffer (std::shared_ptr<std::string> buffer_a, std::function<void(boost::system::error_code const &)> const & callback_a)
+{
+	boost::asio::async_write (socket, boost::asio::buffer (*buffer_a), strand.wrap ([buffer_a, callback_a](boost::system::error_code const & ec, size_t) {
+		callback_a (ec);
+	}));
+}
+
+void rai::rpc_connection::shutdown ()
+{
+	boost::system::error_code ignored;
+	socket.shutdown (boost::asio::ip::tcp::socket::shutdown_send, ignored);
+}
+
+void rai::rpc_connection::next_request ()
+{
+	request = boost::beast::http::request<boost::beast::http::string_body> ();
+	res = boost::beast::http::response<boost::beast::http::string_body> ();
+	responded.clear ();
+	streaming = false;
+}
+
 void rai::rpc_connection::read ()
 {
 	auto this_l (shared_from_this ());
-	boost::beast::http::async_read (socket, buffer, request, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+	read_started ();
+	boost::beast::http::async_read (socket, buffer, request, strand.wrap ([this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+		this_l->reading = false;
+		this_l->idle_timer.cancel ();
 		if (!ec)
 		{
-			this_l->node->background ([this_l]() {
-				auto start (std::chrono::steady_clock::now ());
-				auto version (this_l->request.version ());
-				auto response_handler ([this_l, version, start](boost::property_tree::ptree const & tree_a) {
-					std::stringstream ostream;
-					boost::property_tree::write_json (ostream, tree_a);
-					ostream.flush ();
-					auto body (ostream.str ());
-					this_l->write_result (body, version);
-					boost::beast::http::async_write (this_l->socket, this_l->res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
-					});
-
-					if (this_l->node->config.logging.log_rpc ())
-					{
-						BOOST_LOG (this_l->node->log) << boost::str (boost::format ("RPC request %2% completed in: %1% microseconds") % std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - start).count () % boost::io::group (std::hex, std::showbase, reinterpret_cast<uintptr_t> (this_l.get ())));
-					}
+			++this_l->requests;
+			auto start (std::chrono::steady_clock::now ());
+			auto version (this_l->request.version ());
+			auto write_body ([this_l, version, start](std::string const & body) {
+				this_l->write_result (body, version);
+				// Handlers answer from RPC pool threads, the write is started on the strand
+				this_l->strand.dispatch ([this_l]() {
+					boost::beast::http::async_write (this_l->socket, this_l->res, this_l->strand.wrap ([this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+						if (!ec)
+						{
+							if (this_l->res.keep_alive ())
+							{
+								this_l->next_request ();
+								this_l->read ();
+							}
+							else
+							{
+								boost::system::error_code ignored;
+								this_l->socket.shutdown (boost::asio::ip::tcp::socket::shutdown_send, ignored);
+							}
+						}
+					}));
 				});
-				if (this_l->request.method () == boost::beast::http::verb::post)
+
+				if (this_l->node->config.logging.log_rpc ())
 				{
-					auto handler (std::make_shared<rai::rpc_handler> (*this_l->node, this_l->rpc, this_l->request.body (), response_handler));
-					handler->process_request ();
+					BOOST_LOG (this_l->node->log) << boost::str (boost::format ("RPC request %2% completed in: %1% microseconds") % std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - start).count () % boost::io::group (std::hex, std::showbase, reinterpret_cast<uintptr_t> (this_l.get ())));
+				}
+			});
+			auto response_handler ([write_body](boost::property_tree::ptree const & tree_a) {
+				write_body (rai::json_write (tree_a));
+			});
+			auto write_chunk ([this_l, version, write_body](std::string const & chunk_a, bool last_a) {
+				auto error (false);
+				if (!this_l->streaming && last_a)
+				{
+					// The whole document fit in one piece, it goes out as a plain response
+					write_body (chunk_a);
 				}
 				else
 				{
-					error_response (response_handler, "Can only POST requests");
+					error = this_l->write_chunk (chunk_a, last_a, version);
 				}
+				return error;
 			});
+			if (this_l->request.method () == boost::beast::http::verb::post)
+			{
+				// Parsing and dispatch are cheap enough for the io thread, the handler itself runs on the RPC pool
+				auto handler (std::make_shared<rai::rpc_handler> (*this_l->node, this_l->rpc, this_l->request.body (), response_handler, write_chunk, [this_l]() { this_l->abort (); }));
+				handler->process_request ();
+			}
+			else
+			{
+				error_response (response_handler, "Can only POST requests");
+			}
 		}
-		else
+		else if (ec != boost::beast::http::error::end_of_stream && ec != boost::asio::error::operation_aborted)
 		{
+			// End of stream is a kept alive client hanging up, aborted reads were closed by the idle timeout
 			BOOST_LOG (this_l->node->log) << "RPC read error: " << ec.message ();
 		}
-	});
+	}));
+}
+
+std::unordered_map<std::string, rai::rpc_action> const & rai::rpc_handler::actions ()
+{
+	// clang-format off
+	static std::unordered_map<std::string, rai::rpc_action> const actions_l = {
+		{ "account_balance", { &rai::rpc_handler::account_balance, false, true, rai::rpc_action_cost::cheap } },
+		{ "account_block_count", { &rai::rpc_handler::account_block_count, false, true, rai::rpc_action_cost::cheap } },
+		{ "account_count", { &rai::rpc_handler::account_count, false, true, rai::rpc_action_cost::cheap } },
+		{ "account_create", { &rai::rpc_handler::account_create, true, false, rai::rpc_action_cost::cheap } },
+		{ "account_get", { &rai::rpc_handler::account_get, false, true, rai::rpc_action_cost::cheap } },
+		{ "account_history_topn", { &rai::rpc_handler::account_history_topn, false, true, rai::rpc_action_cost::expensive } },
+		{ "account_history", { &rai::rpc_handler::account_history, false, true, rai::rpc_action_cost::expensive } },
+		{ "account_info", { &rai::rpc_handler::account_info, false, true, rai::rpc_action_cost::cheap } },
+		{ "account_key", { &rai::rpc_handler::account_key, false, true, rai::rpc_action_cost::cheap } },
+		{ "account_list", { &rai::rpc_handler::account_list, false, true, rai::rpc_action_cost::cheap } },
+		{ "account_move", { &rai::rpc_handler::account_move, true, false, rai::rpc_action_cost::cheap } },
+		{ "account_remove", { &rai::rpc_handler::account_remove, true, false, rai::rpc_action_cost::cheap } },
+		{ "account_representative", { &rai::rpc_handler::account_representative, false, true, rai::rpc_action_cost::cheap } },
+		{ "account_representative_set", { &rai::rpc_handler::account_representative_set, true, false, rai::rpc_action_cost::cheap } },
+		{ "account_weight", { &rai::rpc_handler::account_weight, false, true, rai::rpc_action_cost::cheap } },
+		{ "accounts_balances", { &rai::rpc_handler::accounts_balances, false, true, rai::rpc_action_cost::cheap } },
+		{ "accounts_create", { &rai::rpc_handler::accounts_create, true, false, rai::rpc_action_cost::cheap } },
+		{ "accounts_frontiers", { &rai::rpc_handler::accounts_frontiers, false, true, rai::rpc_action_cost::cheap } },
+		{ "accounts_pending", { &rai::rpc_handler::accounts_pending, false, true, rai::rpc_action_cost::expensive } },
+		{ "available_supply", { &rai::rpc_handler::available_supply, false, true, rai::rpc_action_cost::cheap } },
+		{ "backup", { &rai::rpc_handler::backup, true, false, rai::rpc_action_cost::cheap } },
+		{ "backup_cancel", { &rai::rpc_handler::backup_cancel, true, false, rai::rpc_action_cost::cheap } },
+		{ "backup_status", { &rai::rpc_handler::backup_status, true, true, rai::rpc_action_cost::cheap } },
+		{ "block", { &rai::rpc_handler::block, false, true, rai::rpc_action_cost::cheap } },
+		{ "block_confirm", { &rai::rpc_handler::block_confirm, false, false, rai::rpc_action_cost::cheap } },
+		{ "blocks", { &rai::rpc_handler::blocks, false, true, rai::rpc_action_cost::cheap } },
+		{ "blocks_info", { &rai::rpc_handler::blocks_info, false, true, rai::rpc_action_cost::cheap } },
+		{ "block_account", { &rai::rpc_handler::block_account, false, true, rai::rpc_action_cost::cheap } },
+		{ "block_count", { &rai::rpc_handler::block_count, false, true, rai::rpc_action_cost::cheap } },
+		{ "block_count_type", { &rai::rpc_handler::block_count_type, false, true, rai::rpc_action_cost::cheap } },
+		{ "block_create", { &rai::rpc_handler::block_create, true, true, rai::rpc_action_cost::expensive } },
+		{ "block_hash", { &rai::rpc_handler::block_hash, false, true, rai::rpc_action_cost::cheap } },
+		{ "successors", { &rai::rpc_handler::successors, false, true, rai::rpc_action_cost::expensive } },
+		{ "bootstrap", { &rai::rpc_handler::bootstrap, false, false, rai::rpc_action_cost::cheap } },
+		{ "bootstrap_any", { &rai::rpc_handler::bootstrap_any, false, false, rai::rpc_action_cost::cheap } },
+		{ "chain", { &rai::rpc_handler::chain, false, true, rai::rpc_action_cost::expensive } },
+		{ "delegators", { &rai::rpc_handler::delegators, false, true, rai::rpc_action_cost::expensive } },
+		{ "delegators_count", { &rai::rpc_handler::delegators_count, false, true, rai::rpc_action_cost::cheap } },
+		{ "deterministic_key", { &rai::rpc_handler::deterministic_key, false, true, rai::rpc_action_cost::cheap } },
+		{ "confirmation_history", { &rai::rpc_handler::confirmation_history, false, true, rai::rpc_action_cost::expensive } },
+		{ "frontiers", { &rai::rpc_handler::frontiers, false, true, rai::rpc_action_cost::expensive } },
+		{ "frontier_count", { &rai::rpc_handler::account_count, false, true, rai::rpc_action_cost::cheap } },
+		{ "history", { &rai::rpc_handler::history, false, true, rai::rpc_action_cost::expensive } },
+		{ "keepalive", { &rai::rpc_handler::keepalive, true, false, rai::rpc_action_cost::cheap } },
+		{ "key_create", { &rai::rpc_handler::key_create, false, true, rai::rpc_action_cost::cheap } },
+		{ "key_expand", { &rai::rpc_handler::key_expand, false, true, rai::rpc_action_cost::cheap } },
+		{ "krai_from_raw", { &rai::rpc_handler::krai_from_raw, false, true, rai::rpc_action_cost::cheap } },
+		{ "krai_to_raw", { &rai::rpc_handler::krai_to_raw, false, true, rai::rpc_action_cost::cheap } },
+		{ "ledger", { &rai::rpc_handler::ledger, true, true, rai::rpc_action_cost::expensive } },
+		{ "mrai_from_raw", { &rai::rpc_handler::mrai_from_raw, false, true, rai::rpc_action_cost::cheap } },
+		{ "mrai_to_raw", { &rai::rpc_handler::mrai_to_raw, false, true, rai::rpc_action_cost::cheap } },
+		{ "password_change", { &rai::rpc_handler::password_change, true, false, rai::rpc_action_cost::cheap } },
+		{ "password_enter", { &rai::rpc_handler::password_enter, false, false, rai::rpc_action_cost::cheap } },
+		{ "password_valid", { [](rai::rpc_handler & handler_a) { handler_a.password_valid (false); }, false, true, rai::rpc_action_cost::cheap } },
+		{ "payment_begin", { &rai::rpc_handler::payment_begin, false, false, rai::rpc_action_cost::cheap } },
+		{ "payment_init", { &rai::rpc_handler::payment_init, false, false, rai::rpc_action_cost::cheap } },
+		{ "payment_end", { &rai::rpc_handler::payment_end, false, false, rai::rpc_action_cost::cheap } },
+		{ "payment_wait", { &rai::rpc_handler::payment_wait, false, true, rai::rpc_action_cost::cheap } },
+		{ "peers", { &rai::rpc_handler::peers, false, true, rai::rpc_action_cost::cheap } },
+		{ "pending", { &rai::rpc_handler::pending, false, true, rai::rpc_action_cost::expensive } },
+		{ "pending_exists", { &rai::rpc_handler::pending_exists, false, true, rai::rpc_action_cost::cheap } },
+		{ "process", { &rai::rpc_handler::process, false, false, rai::rpc_action_cost::cheap } },
+		{ "rai_from_raw", { &rai::rpc_handler::rai_from_raw, false, true, rai::rpc_action_cost::cheap } },
+		{ "rai_to_raw", { &rai::rpc_handler::rai_to_raw, false, true, rai::rpc_action_cost::cheap } },
+		{ "receive", { &rai::rpc_handler::receive, true, false, rai::rpc_action_cost::cheap } },
+		{ "receive_minimum", { &rai::rpc_handler::receive_minimum, true, true, rai::rpc_action_cost::cheap } },
+		{ "receive_minimum_set", { &rai::rpc_handler::receive_minimum_set, true, false, rai::rpc_action_cost::cheap } },
+		{ "representatives", { &rai::rpc_handler::representatives, false, true, rai::rpc_action_cost::expensive } },
+		{ "representatives_online", { &rai::rpc_handler::representatives_online, false, true, rai::rpc_action_cost::cheap } },
+		{ "republish", { &rai::rpc_handler::republish, false, false, rai::rpc_action_cost::expensive } },
+		{ "search_pending", { &rai::rpc_handler::search_pending, true, false, rai::rpc_action_cost::cheap } },
+		{ "search_pending_all", { &rai::rpc_handler::search_pending_all, true, false, rai::rpc_action_cost::expensive } },
+		{ "send", { &rai::rpc_handler::send, true, false, rai::rpc_action_cost::cheap } },
+		{ "send_batch", { &rai::rpc_handler::send_batch, true, false, rai::rpc_action_cost::expensive } },
+		{ "stats", { &rai::rpc_handler::stats, false, true, rai::rpc_action_cost::cheap } },
+		{ "stop", { &rai::rpc_handler::stop, true, false, rai::rpc_action_cost::cheap } },
+		{ "unchecked", { &rai::rpc_handler::unchecked, false, true, rai::rpc_action_cost::expensive } },
+		{ "unchecked_clear", { &rai::rpc_handler::unchecked_clear, true, false, rai::rpc_action_cost::cheap } },
+		{ "unchecked_get", { &rai::rpc_handler::unchecked_get, false, true, rai::rpc_action_cost::cheap } },
+		{ "unchecked_keys", { &rai::rpc_handler::unchecked_keys, false, true, rai::rpc_action_cost::expensive } },
+		{ "validate_account_number", { &rai::rpc_handler::validate_account_number, false, true, rai::rpc_action_cost::cheap } },
+		{ "version", { &rai::rpc_handler::version, false, true, rai::rpc_action_cost::cheap } },
+		{ "wallet_add", { &rai::rpc_handler::wallet_add, true, false, rai::rpc_action_cost::cheap } },
+		{ "wallet_add_watch", { &rai::rpc_handler::wallet_add_watch, true, false, rai::rpc_action_cost::cheap } },
+		{ "wallet_balance_total", { &rai::rpc_handler::wallet_balance_total, false, true, rai::rpc_action_cost::expensive } },
+		{ "wallet_balances", { &rai::rpc_handler::wallet_balances, false, true, rai::rpc_action_cost::expensive } },
+		{ "wallet_change_seed", { &rai::rpc_handler::wallet_change_seed, true, false, rai::rpc_action_cost::cheap } },
+		{ "wallet_contains", { &rai::rpc_handler::wallet_contains, false, true, rai::rpc_action_cost::cheap } },
+		{ "wallet_create", { &rai::rpc_handler::wallet_create, true, false, rai::rpc_action_cost::cheap } },
+		{ "wallet_destroy", { &rai::rpc_handler::wallet_destroy, true, false, rai::rpc_action_cost::cheap } },
+		{ "wallet_export", { &rai::rpc_handler::wallet_export, false, true, rai::rpc_action_cost::expensive } },
+		{ "wallet_frontiers", { &rai::rpc_handler::wallet_frontiers, false, true, rai::rpc_action_cost::expensive } },
+		{ "wallet_key_valid", { &rai::rpc_handler::wallet_key_valid, false, true, rai::rpc_action_cost::cheap } },
+		{ "wallet_ledger", { &rai::rpc_handler::wallet_ledger, false, true, rai::rpc_action_cost::expensive } },
+		{ "wallet_lock", { &rai::rpc_handler::wallet_lock, true, false, rai::rpc_action_cost::cheap } },
+		{ "wallet_locked", { [](rai::rpc_handler & handler_a) { handler_a.password_valid (true); }, false, true, rai::rpc_action_cost::cheap } },
+		{ "wallet_pending", { &rai::rpc_handler::wallet_pending, false, true, rai::rpc_action_cost::expensive } },
+		{ "wallet_representative", { &rai::rpc_handler::wallet_representative, false, true, rai::rpc_action_cost::cheap } },
+		{ "wallet_representative_set", { &rai::rpc_handler::wallet_representative_set, true, false, rai::rpc_action_cost::cheap } },
+		{ "wallet_republish", { &rai::rpc_handler::wallet_republish, true, false, rai::rpc_action_cost::expensive } },
+		{ "wallet_unlock", { &rai::rpc_handler::password_enter, false, false, rai::rpc_action_cost::cheap } },
+		{ "wallet_work_get", { &rai::rpc_handler::wallet_work_get, true, true, rai::rpc_action_cost::expensive } },
+		{ "work_generate", { &rai::rpc_handler::work_generate, true, true, rai::rpc_action_cost::expensive } },
+		{ "work_cancel", { &rai::rpc_handler::work_cancel, true, false, rai::rpc_action_cost::cheap } },
+		{ "work_get", { &rai::rpc_handler::work_get, true, true, rai::rpc_action_cost::cheap } },
+		{ "work_set", { &rai::rpc_handler::work_set, true, false, rai::rpc_action_cost::cheap } },
+		{ "work_validate", { &rai::rpc_handler::work_validate, false, true, rai::rpc_action_cost::cheap } },
+		{ "work_peer_add", { &rai::rpc_handler::work_peer_add, true, false, rai::rpc_action_cost::cheap } },
+		{ "work_peers", { &rai::rpc_handler::work_peers, true, true, rai::rpc_action_cost::cheap } },
+		{ "work_peers_clear", { &rai::rpc_handler::work_peers_clear, true, false, rai::rpc_action_cost::cheap } },
+		{ "smart_contract_block", { &rai::rpc_handler::smart_contract_block, false, true, rai::rpc_action_cost::cheap } },
+		{ "invokefunction", { &rai::rpc_handler::smart_contract_invoke_function, false, true, rai::rpc_action_cost::cheap } },
+		{ "invoke", { &rai::rpc_handler::smart_contract_invoke, false, true, rai::rpc_action_cost::cheap } },
+		{ "invokescript", { &rai::rpc_handler::smart_contract_invoke_script, false, true, rai::rpc_action_cost::cheap } },
+		{ "tokens", { &rai::rpc_handler::tokens, false, true, rai::rpc_action_cost::cheap } },
+		{ "transactions_count", { &rai::rpc_handler::transactions_count, false, true, rai::rpc_action_cost::cheap } }
+	};
+	// clang-format on
+	return actions_l;
+}
+
+void rai::rpc_handler::history ()
+{
+	request.put ("head", request.get<std::string> ("hash"));
+	account_history ();
+}
+
+uint64_t rai::rpc_handler::action_limit (std::string const & action_a, rai::rpc_action const & action_info_a)
+{
+	auto result (action_info_a.cost == rai::rpc_action_cost::expensive ? rpc.config.expensive_action_limit : 0);
+	auto existing (rpc.config.action_limits.find (action_a));
+	if (existing != rpc.config.action_limits.end ())
+	{
+		result = existing->second;
+	}
+	return result;
 }
 
-namespace
-{
-void reprocess_body (std::string & body, boost::property_tree::ptree & tree_a)
-{
-	std::stringstream stream;
-	boost::property_tree::write_json (stream, tree_a);
-	body = stream.str ();
-}
-}
-
-void rai::rpc_handler::process_request ()
+void rai::rpc_handler::process_request ()
 {
 	try
 	{
-		std::stringstream istream (body);
-		boost::property_tree::read_json (istream, request);
+		rai::json_read (body, request);
 		std::string action (request.get<std::string> ("action"));
-		if (action == "password_enter")
-		{
-			password_enter ();
-			request.erase ("password");
-			reprocess_body (body, request);
-		}
-		else if (action == "password_change")
-		{
-			password_change ();
-			request.erase ("password");
-			reprocess_body (body, request);
-		}
-		else if (action == "wallet_unlock")
-		{
-			password_enter ();
-			request.erase ("password");
-			reprocess_body (body, request);
-		}
 		if (node.config.logging.log_rpc ())
 		{
-			BOOST_LOG (node.log) << body;
-		}
-		if (action == "account_balance")
-		{
-			account_balance ();
-		}
-		else if (action == "account_block_count")
-		{
-			account_block_count ();
-		}
-		else if (action == "account_count")
-		{
-			account_count ();
-		}
-		else if (action == "account_create")
-		{
-			account_create ();
-		}
-		else if (action == "account_get")
-		{
-			account_get ();
-		}
-		else if (action == "account_history_topn")
-		{
-			account_history_topn ();
-		}
-		else if (action == "account_history")
-		{
-			account_history ();
-		}
-		else if (action == "account_info")
-		{
-			account_info ();
-		}
-		else if (action == "account_key")
-		{
-			account_key ();
-		}
-		else if (action == "account_list")
-		{
-			account_list ();
-		}
-		else if (action == "account_move")
-		{
-			account_move ();
-		}
-		else if (action == "account_remove")
-		{
-			account_remove ();
-		}
-		else if (action == "account_representative")
-		{
-			account_representative ();
-		}
-		else if (action == "account_representative_set")
-		{
-			account_representative_set ();
-		}
-		else if (action == "account_weight")
-		{
-			account_weight ();
-		}
-		else if (action == "accounts_balances")
-		{
-			accounts_balances ();
-		}
-		else if (action == "accounts_create")
-		{
-			accounts_create ();
-		}
-		else if (action == "accounts_frontiers")
-		{
-			accounts_frontiers ();
-		}
-		else if (action == "accounts_pending")
-		{
-			accounts_pending ();
-		}
-		else if (action == "available_supply")
-		{
-			available_supply ();
-		}
-		else if (action == "block")
-		{
-			block ();
-		}
-		else if (action == "block_confirm")
-		{
-			block_confirm ();
-		}
-		else if (action == "blocks")
-		{
-			blocks ();
-		}
-		else if (action == "blocks_info")
-		{
-			blocks_info ();
-		}
-		else if (action == "block_account")
-		{
-			block_account ();
-		}
-		else if (action == "block_count")
-		{
-			block_count ();
-		}
-		else if (action == "block_count_type")
-		{
-			block_count_type ();
-		}
-		else if (action == "block_create")
-		{
-			block_create ();
-		}
-		else if (action == "block_hash")
-		{
-			block_hash ();
-		}
-		else if (action == "successors")
-		{
-			successors ();
-		}
-		else if (action == "bootstrap")
-		{
-			bootstrap ();
-		}
-		else if (action == "bootstrap_any")
-		{
-			bootstrap_any ();
-		}
-		else if (action == "chain")
-		{
-			chain ();
-		}
-		else if (action == "delegators")
-		{
-			delegators ();
-		}
-		else if (action == "delegators_count")
-		{
-			delegators_count ();
-		}
-		else if (action == "deterministic_key")
-		{
-			deterministic_key ();
-		}
-		else if (action == "confirmation_history")
-		{
-			confirmation_history ();
-		}
-		else if (action == "frontiers")
-		{
-			frontiers ();
-		}
-		else if (action == "frontier_count")
-		{
-			account_count ();
-		}
-		else if (action == "history")
-		{
-			request.put ("head", request.get<std::string> ("hash"));
-			account_history ();
-		}
-		else if (action == "keepalive")
-		{
-			keepalive ();
-		}
-		else if (action == "key_create")
-		{
-			key_create ();
-		}
-		else if (action == "key_expand")
-		{
-			key_expand ();
-		}
-		else if (action == "krai_from_raw")
-		{
-			krai_from_raw ();
-		}
-		else if (action == "krai_to_raw")
-		{
-			krai_to_raw ();
-		}
-		else if (action == "ledger")
-		{
-			ledger ();
-		}
-		else if (action == "mrai_from_raw")
-		{
-			mrai_from_raw ();
-		}
-		else if (action == "mrai_to_raw")
-		{
-			mrai_to_raw ();
-		}
-		else if (action == "password_change")
-		{
-			// Processed before logging
-		}
-		else if (action == "password_enter")
-		{
-			// Processed before logging
-		}
-		else if (action == "password_valid")
-		{
-			password_valid ();
-		}
-		else if (action == "payment_begin")
-		{
-			payment_begin ();
-		}
-		else if (action == "payment_init")
-		{
-			payment_init ();
-		}
-		else if (action == "payment_end")
-		{
-			payment_end ();
-		}
-		else if (action == "payment_wait")
-		{
-			payment_wait ();
-		}
-		else if (action == "peers")
-		{
-			peers ();
-		}
-		else if (action == "pending")
-		{
-			pending ();
-		}
-		else if (action == "pending_exists")
-		{
-			pending_exists ();
-		}
-		else if (action == "process")
-		{
-			process ();
-		}
-		else if (action == "rai_from_raw")
-		{
-			rai_from_raw ();
-		}
-		else if (action == "rai_to_raw")
-		{
-			rai_to_raw ();
-		}
-		else if (action == "receive")
-		{
-			receive ();
-		}
-		else if (action == "receive_minimum")
-		{
-			receive_minimum ();
-		}
-		else if (action == "receive_minimum_set")
-		{
-			receive_minimum_set ();
-		}
-		else if (action == "representatives")
-		{
-			representatives ();
-		}
-		else if (action == "representatives_online")
-		{
-			representatives_online ();
-		}
-		else if (action == "republish")
-		{
-			republish ();
-		}
-		else if (action == "search_pending")
-		{
-			search_pending ();
-		}
-		else if (action == "search_pending_all")
-		{
-			search_pending_all ();
-		}
-		else if (action == "send")
-		{
-			send ();
-		}
-		else if (action == "stats")
-		{
-			stats ();
-		}
-		else if (action == "stop")
-		{
-			stop ();
-		}
-		else if (action == "unchecked")
-		{
-			unchecked ();
-		}
-		else if (action == "unchecked_clear")
-		{
-			unchecked_clear ();
-		}
-		else if (action == "unchecked_get")
-		{
-			unchecked_get ();
-		}
-		else if (action == "unchecked_keys")
-		{
-			unchecked_keys ();
-		}
-		else if (action == "validate_account_number")
-		{
-			validate_account_number ();
-		}
-		else if (action == "version")
-		{
-			version ();
-		}
-		else if (action == "wallet_add")
-		{
-			wallet_add ();
-		}
-		else if (action == "wallet_add_watch")
-		{
-			wallet_add_watch ();
-		}
-		else if (action == "wallet_balance_total")
-		{
-			wallet_balance_total ();
-		}
-		else if (action == "wallet_balances")
-		{
-			wallet_balances ();
-		}
-		else if (action == "wallet_change_seed")
-		{
-			wallet_change_seed ();
-		}
-		else if (action == "wallet_contains")
-		{
-			wallet_contains ();
-		}
-		else if (action == "wallet_create")
-		{
-			wallet_create ();
-		}
-		else if (action == "wallet_destroy")
-		{
-			wallet_destroy ();
-		}
-		else if (action == "wallet_export")
-		{
-			wallet_export ();
-		}
-		else if (action == "wallet_frontiers")
-		{
-			wallet_frontiers ();
-		}
-		else if (action == "wallet_key_valid")
-		{
-			wallet_key_valid ();
-		}
-		else if (action == "wallet_ledger")
-		{
-			wallet_ledger ();
-		}
-		else if (action == "wallet_lock")
-		{
-			wallet_lock ();
-		}
-		else if (action == "wallet_locked")
-		{
-			password_valid (true);
-		}
-		else if (action == "wallet_pending")
-		{
-			wallet_pending ();
-		}
-		else if (action == "wallet_representative")
-		{
-			wallet_representative ();
-		}
-		else if (action == "wallet_representative_set")
-		{
-			wallet_representative_set ();
-		}
-		else if (action == "wallet_republish")
-		{
-			wallet_republish ();
-		}
-		else if (action == "wallet_unlock")
-		{
-			// Processed before logging
-		}
-		else if (action == "wallet_work_get")
-		{
-			wallet_work_get ();
-		}
-		else if (action == "work_generate")
-		{
-			work_generate ();
-		}
-		else if (action == "work_cancel")
-		{
-			work_cancel ();
-		}
-		else if (action == "work_get")
-		{
-			work_get ();
-		}
-		else if (action == "work_set")
-		{
-			work_set ();
-		}
-		else if (action == "work_validate")
-		{
-			work_validate ();
-		}
-		else if (action == "work_peer_add")
-		{
-			work_peer_add ();
-		}
-		else if (action == "work_peers")
-		{
-			work_peers ();
-		}
-		else if (action == "work_peers_clear")
-		{
-			work_peers_clear ();
-		}
-		else if (action == "smart_contract_block")
-		{
-			smart_contract_block ();
-		}
-		else if (action == "invokefunction")
-		{
-			smart_contract_invoke_function ();
-		}
-		else if (action == "invoke")
-		{
-			smart_contract_invoke ();
-		}
-		else if (action == "invokescript")
-		{
-			smart_contract_invoke_script ();
+			if (request.count ("password") != 0)
+			{
+				auto logged (request);
+				logged.erase ("password");
+				BOOST_LOG (node.log) << rai::json_write (logged);
+			}
+			else
+			{
+				BOOST_LOG (node.log) << body;
+			}
 		}
-		else if (action == "tokens")
+		auto existing (actions ().find (action));
+		if (existing == actions ().end ())
 		{
-			tokens ();
+			error_response (response, "Unknown command");
 		}
-		else if (action == "transactions_count")
+		else if (existing->second.control && !rpc.config.enable_control)
 		{
-			transactions_count ();
+			error_response (response, "RPC control is disabled");
 		}
 		else
 		{
-			error_response (response, "Unknown command");
+			auto this_l (shared_from_this ());
+			auto & action_info (existing->second);
+			rpc.pool.add (action, action_limit (action, action_info), [this_l, &action_info]() {
+				this_l->execute (action_info);
+			});
 		}
 	}
-	catch (std::runtime_error const & err)
+	catch (std::runtime_error const &)
 	{
 		error_response (response, "Unable to parse JSON");
 	}
@@ -5467,6 +5723,36 @@ void rai::rpc_handler::process_request ()
 	}
 }
 
+void rai::rpc_handler::execute (rai::rpc_action const & action_a)
+{
+	try
+	{
+		action_a.handler (*this);
+	}
+	catch (std::runtime_error const &)
+	{
+		fail ("Unable to parse JSON");
+	}
+	catch (...)
+	{
+		fail ("Internal server error in RPC");
+	}
+}
+
+void rai::rpc_handler::fail (std::string const & message_a)
+{
+	if (!streaming)
+	{
+		error_response (response, message_a);
+	}
+	else
+	{
+		// Part of the document and its headers are out, ending the chunked stream would pass a truncated document off as complete
+		BOOST_LOG (node.log) << boost::str (boost::format ("RPC streamed response failed: %1%") % message_a);
+		response_abort ();
+	}
+}
+
 rai::payment_observer::payment_observer (std::function<void(boost::property_tree::ptree const &)> const & response_a, rai::rpc & rpc_a, rai::account const & account_a, rai::amount const & amount_a) :
 rpc (rpc_a),
 account (account_a),
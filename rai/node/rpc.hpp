@@ -5,7 +5,9 @@
 #include <boost/beast.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <rai/node/json.hpp>
 #include <rai/node/utility.hpp>
+#include <deque>
 #include <unordered_map>
 
 namespace rai
@@ -47,6 +49,16 @@ public:
 	bool enable_control;
 	uint64_t frontier_request_limit;
 	uint64_t chain_request_limit;
+	/** Seconds a kept alive connection may sit idle waiting for its next request */
+	uint64_t keepalive_timeout;
+	/** Requests served on one connection before it is closed */
+	uint64_t keepalive_request_limit;
+	/** Threads running RPC handlers, apart from the node's io_threads */
+	unsigned handler_threads;
+	/** Handlers of one expensive action allowed to run at once */
+	uint64_t expensive_action_limit;
+	/** Per action overrides of the concurrency limit, 0 means unlimited */
+	std::unordered_map<std::string, uint64_t> action_limits;
 	rpc_secure_config secure;
 };
 enum class payment_status
@@ -61,6 +73,57 @@ enum class payment_status
 };
 class wallet;
 class payment_observer;
+class rpc_handler;
+enum class rpc_action_cost
+{
+	/** Point lookups and small responses */
+	cheap,
+	/** Scans the ledger or a wallet, or generates work */
+	expensive
+};
+/** Registry entry for an RPC action */
+class rpc_action
+{
+public:
+	std::function<void(rai::rpc_handler &)> handler;
+	/** Refused unless enable_control is set */
+	bool control;
+	/** Doesn't change ledger, wallet or node state */
+	bool read_only;
+	rai::rpc_action_cost cost;
+};
+/**
+ * Runs RPC handlers on threads of their own so slow requests don't hold up the node's io_service.
+ * Handlers of an action at its concurrency limit wait while later requests for other actions go ahead.
+ */
+class rpc_pool
+{
+public:
+	rpc_pool (rai::node &, unsigned);
+	~rpc_pool ();
+	/** Queues a handler for the action, limit_a is how many of the action may run at once with 0 meaning unlimited */
+	void add (std::string const &, uint64_t, std::function<void()> const &);
+	void stop ();
+	size_t size ();
+
+private:
+	class entry
+	{
+	public:
+		std::string action;
+		uint64_t limit;
+		std::chrono::steady_clock::time_point queued;
+		std::function<void()> handler;
+	};
+	void run ();
+	rai::node & node;
+	std::deque<entry> queue;
+	std::unordered_map<std::string, uint64_t> running;
+	bool stopped;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::vector<std::thread> threads;
+};
 class rpc
 {
 public:
@@ -74,6 +137,7 @@ public:
 	std::unordered_map<rai::account, std::shared_ptr<rai::payment_observer>> payment_observers;
 	rai::rpc_config config;
 	rai::node & node;
+	rai::rpc_pool pool;
 	bool on;
 	static uint16_t const rpc_port = rai::rai_network == rai::rai_networks::rai_live_network ? 29735 : 55000;
 };
@@ -82,8 +146,27 @@ class rpc_connection : public std::enable_shared_from_this<rai::rpc_connection>
 public:
 	rpc_connection (rai::node &, rai::rpc &);
 	virtual void parse_connection ();
+	/** Reads the next request, runs on strand */
 	virtual void read ();
 	virtual void write_result (std::string body, unsigned version);
+	/**
+	 * Writes part of a chunked response on the strand and waits for it so a handler thread never gets ahead of the client.
+	 * The header goes out with the first part and the last part ends the response. Returns true if the write failed or
+	 * didn't finish within chunk_timeout_s, a client that stopped reading has its connection dropped.
+	 */
+	bool write_chunk (std::string const &, bool, unsigned);
+	/** Drops the connection, for a streamed response that can't be finished */
+	void abort ();
+	/** Starts writing the buffer to the client, runs on strand */
+	virtual void write_buffer (std::shared_ptr<std::string>, std::function<void(boost::system::error_code const &)> const &);
+	/** Ends a connection that isn't kept alive once its response is out, runs on strand */
+	virtual void shutdown ();
+	/** Marks a read as started and arms the idle timeout, runs on strand */
+	void read_started ();
+	/** Resets request state once a response was written and the connection is kept alive */
+	void next_request ();
+	/** Closes the connection if it's still waiting for a request when the idle timeout fires, runs on strand */
+	void idle_check ();
 	std::shared_ptr<rai::node> node;
 	rai::rpc & rpc;
 	boost::asio::ip::tcp::socket socket;
@@ -91,6 +174,15 @@ public:
 	boost::beast::http::request<boost::beast::http::string_body> request;
 	boost::beast::http::response<boost::beast::http::string_body> res;
 	std::atomic_flag responded;
+	/** Requests read on this connection, pipelined requests are served in order from the same buffer */
+	std::atomic<uint64_t> requests;
+	std::atomic<bool> reading;
+	/** Reads, writes and the idle timer all complete on this strand so closing an idle socket can't race an operation on it */
+	boost::asio::io_service::strand strand;
+	boost::asio::steady_timer idle_timer;
+	/** Set once a chunked response sent its header */
+	bool streaming;
+	static unsigned constexpr chunk_timeout_s = 30;
 };
 class payment_observer : public std::enable_shared_from_this<rai::payment_observer>
 {
@@ -112,8 +204,20 @@ public:
 class rpc_handler : public std::enable_shared_from_this<rai::rpc_handler>
 {
 public:
-	rpc_handler (rai::node &, rai::rpc &, std::string const &, std::function<void(boost::property_tree::ptree const &)> const &);
+	rpc_handler (rai::node &, rai::rpc &, std::string const &, std::function<void(boost::property_tree::ptree const &)> const &, std::function<bool(std::string const &, bool)> const &, std::function<void()> const &);
 	void process_request ();
+	/** Runs the action's handler, answering with an error if it throws or dropping the connection if it was streaming */
+	void execute (rai::rpc_action const &);
+	/** Answers with an error, or drops the connection once the response started streaming */
+	void fail (std::string const &);
+	/** Concurrency limit for the action from the config, 0 means unlimited */
+	uint64_t action_limit (std::string const &, rai::rpc_action const &);
+	static std::unordered_map<std::string, rai::rpc_action> const & actions ();
+	/**
+	 * Writer streaming to response_chunk, the handler sends what finish () returns as the last piece.
+	 * Handlers send () pending pieces between read transactions so none is held while the client reads.
+	 */
+	rai::json_writer response_writer ();
 	void account_balance ();
 	void account_block_count ();
 	void account_count ();
@@ -134,6 +238,9 @@ public:
 	void accounts_frontiers ();
 	void accounts_pending ();
 	void available_supply ();
+	void backup ();
+	void backup_cancel ();
+	void backup_status ();
 	void block ();
 	void block_confirm ();
 	void blocks ();
@@ -182,6 +289,7 @@ public:
 	void search_pending ();
 	void search_pending_all ();
 	void send ();
+	void send_batch ();
 	void stats ();
 	void stop ();
 	void successors ();
@@ -375,6 +483,14 @@ public:
 	rai::rpc & rpc;
 	boost::property_tree::ptree request;
 	std::function<void(boost::property_tree::ptree const &)> response;
+	// Sends a document in pieces as it's written, the bool marks the last piece. Returns true once the client is gone
+	std::function<bool(std::string const &, bool)> response_chunk;
+	// Drops the connection when a response that already started streaming can't be finished
+	std::function<void()> response_abort;
+	// Set once response_writer sent a piece, the response can't be replaced by an error from then on
+	std::atomic<bool> streaming;
+	// Sorted ledger pages hold every listed account in memory before writing, their count defaults to and is capped at this
+	static uint64_t constexpr ledger_sorted_count_max = 4096;
 
 private:
 	bool find_token_hash (std::string const, rai::block_hash &);
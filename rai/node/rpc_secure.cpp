@@ -1,3 +1,4 @@
+#include <rai/node/json.hpp>
 #include <rai/node/node.hpp>
 #include <rai/node/rpc_secure.hpp>
 
@@ -119,18 +120,31 @@ void rai::rpc_connection_secure::parse_connection ()
 {
 	// Perform the SSL handshake
 	stream.async_handshake (boost::asio::ssl::stream_base::server,
-	std::bind (
+	strand.wrap (std::bind (
 	&rai::rpc_connection_secure::handle_handshake,
 	std::static_pointer_cast<rai::rpc_connection_secure> (shared_from_this ()),
-	std::placeholders::_1));
+	std::placeholders::_1)));
 }
 
 void rai::rpc_connection_secure::on_shutdown (const boost::system::error_code & error)
 {
-	// No-op. We initiate the shutdown (since the RPC server kills the connection after each request)
+	// No-op. We initiate the shutdown when the connection isn't kept alive or reached its request limit
 	// and we'll thus get an expected EOF error. If the client disconnects, a short-read error will be expected.
 }
 
+void rai::rpc_connection_secure::write_buffer (std::shared_ptr<std::string> buffer_a, std::function<void(boost::system::error_code const &)> const & callback_a)
+{
+	boost::asio::async_write (stream, boost::asio::buffer (*buffer_a), strand.wrap ([buffer_a, callback_a](boost::system::error_code const & ec, size_t) {
+		callback_a (ec);
+	}));
+}
+
+void rai::rpc_connection_secure::shutdown ()
+{
+	auto this_l (std::static_pointer_cast<rai::rpc_connection_secure> (shared_from_this ()));
+	stream.async_shutdown (strand.wrap (std::bind (&rai::rpc_connection_secure::on_shutdown, this_l, std::placeholders::_1)));
+}
+
 void rai::rpc_connection_secure::handle_handshake (const boost::system::error_code & error)
 {
 	if (!error)
@@ -146,47 +160,71 @@ void rai::rpc_connection_secure::handle_handshake (const boost::system::error_co
 void rai::rpc_connection_secure::read ()
 {
 	auto this_l (std::static_pointer_cast<rai::rpc_connection_secure> (shared_from_this ()));
-	boost::beast::http::async_read (stream, buffer, request, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+	read_started ();
+	boost::beast::http::async_read (stream, buffer, request, strand.wrap ([this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+		this_l->reading = false;
+		this_l->idle_timer.cancel ();
 		if (!ec)
 		{
-			this_l->node->background ([this_l]() {
-				auto start (std::chrono::steady_clock::now ());
-				auto version (this_l->request.version ());
-				auto response_handler ([this_l, version, start](boost::property_tree::ptree const & tree_a) {
-					std::stringstream ostream;
-					boost::property_tree::write_json (ostream, tree_a);
-					ostream.flush ();
-					auto body (ostream.str ());
-					this_l->write_result (body, version);
-					boost::beast::http::async_write (this_l->stream, this_l->res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
-						// Perform the SSL shutdown
-						this_l->stream.async_shutdown (
-						std::bind (
-						&rai::rpc_connection_secure::on_shutdown,
-						this_l,
-						std::placeholders::_1));
-					});
-
-					if (this_l->node->config.logging.log_rpc ())
-					{
-						BOOST_LOG (this_l->node->log) << boost::str (boost::format ("TLS: RPC request %2% completed in: %1% microseconds") % std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - start).count () % boost::io::group (std::hex, std::showbase, reinterpret_cast<uintptr_t> (this_l.get ())));
-					}
+			++this_l->requests;
+			auto start (std::chrono::steady_clock::now ());
+			auto version (this_l->request.version ());
+			auto write_body ([this_l, version, start](std::string const & body) {
+				this_l->write_result (body, version);
+				this_l->strand.dispatch ([this_l]() {
+					boost::beast::http::async_write (this_l->stream, this_l->res, this_l->strand.wrap ([this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+						if (!ec && this_l->res.keep_alive ())
+						{
+							this_l->next_request ();
+							this_l->read ();
+						}
+						else
+						{
+							// Perform the SSL shutdown
+							this_l->stream.async_shutdown (
+							this_l->strand.wrap (std::bind (
+							&rai::rpc_connection_secure::on_shutdown,
+							this_l,
+							std::placeholders::_1)));
+						}
+					}));
 				});
 
-				if (this_l->request.method () == boost::beast::http::verb::post)
+				if (this_l->node->config.logging.log_rpc ())
+				{
+					BOOST_LOG (this_l->node->log) << boost::str (boost::format ("TLS: RPC request %2% completed in: %1% microseconds") % std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - start).count () % boost::io::group (std::hex, std::showbase, reinterpret_cast<uintptr_t> (this_l.get ())));
+				}
+			});
+			auto response_handler ([write_body](boost::property_tree::ptree const & tree_a) {
+				write_body (rai::json_write (tree_a));
+			});
+			auto write_chunk ([this_l, version, write_body](std::string const & chunk_a, bool last_a) {
+				auto error (false);
+				if (!this_l->streaming && last_a)
 				{
-					auto handler (std::make_shared<rai::rpc_handler> (*this_l->node, this_l->rpc, this_l->request.body (), response_handler));
-					handler->process_request ();
+					// The whole document fit in one piece, it goes out as a plain response
+					write_body (chunk_a);
 				}
 				else
 				{
-					error_response (response_handler, "Can only POST requests");
+					error = this_l->write_chunk (chunk_a, last_a, version);
 				}
+				return error;
 			});
+
+			if (this_l->request.method () == boost::beast::http::verb::post)
+			{
+				auto handler (std::make_shared<rai::rpc_handler> (*this_l->node, this_l->rpc, this_l->request.body (), response_handler, write_chunk, [this_l]() { this_l->abort (); }));
+				handler->process_request ();
+			}
+			else
+			{
+				error_response (response_handler, "Can only POST requests");
+			}
 		}
-		else
+		else if (ec != boost::beast::http::error::end_of_stream && ec != boost::asio::error::operation_aborted)
 		{
 			BOOST_LOG (this_l->node->log) << "TLS: Read error: " << ec.message () << std::endl;
 		}
-	});
+	}));
 }
@@ -39,6 +39,8 @@ public:
 	rpc_connection_secure (rai::node &, rai::rpc_secure &);
 	virtual void parse_connection () override;
 	virtual void read () override;
+	virtual void write_buffer (std::shared_ptr<std::string>, std::function<void(boost::system::error_code const &)> const &) override;
+	virtual void shutdown () override;
 	/** The TLS handshake callback */
 	void handle_handshake (const boost::system::error_code & error);
 	/** The TLS async shutdown callback */
@@ -341,6 +341,18 @@ std::string rai::stat::type_to_string (uint32_t key)
 		case rai::stat::type::message:
 			res = "message";
 			break;
+		case rai::stat::type::election:
+			res = "election";
+			break;
+		case rai::stat::type::wallet_action:
+			res = "wallet_action";
+			break;
+		case rai::stat::type::work_cache:
+			res = "work_cache";
+			break;
+		case rai::stat::type::rpc:
+			res = "rpc";
+			break;
 	}
 	return res;
 }
@@ -357,6 +369,9 @@ std::string rai::stat::detail_to_string (uint32_t key)
 		case rai::stat::detail::bad_sender:
 			res = "bad_sender";
 			break;
+		case rai::stat::detail::throttled:
+			res = "throttled";
+			break;
 		case rai::stat::detail::bulk_pull:
 			res = "bulk_pull";
 			break;
@@ -375,6 +390,9 @@ std::string rai::stat::detail_to_string (uint32_t key)
 		case rai::stat::detail::confirm_req:
 			res = "confirm_req";
 			break;
+		case rai::stat::detail::confirm_req_batch:
+			res = "confirm_req_batch";
+			break;
 		case rai::stat::detail::frontier_req:
 			res = "frontier_req";
 			break;
@@ -432,6 +450,36 @@ std::string rai::stat::detail_to_string (uint32_t key)
 		case rai::stat::detail::vote_invalid:
 			res = "vote_invalid";
 			break;
+		case rai::stat::detail::admitted:
+			res = "admitted";
+			break;
+		case rai::stat::detail::backlogged:
+			res = "backlogged";
+			break;
+		case rai::stat::detail::evicted:
+			res = "evicted";
+			break;
+		case rai::stat::detail::dropped:
+			res = "dropped";
+			break;
+		case rai::stat::detail::confirmed:
+			res = "confirmed";
+			break;
+		case rai::stat::detail::queued:
+			res = "queued";
+			break;
+		case rai::stat::detail::executed:
+			res = "executed";
+			break;
+		case rai::stat::detail::latency_us:
+			res = "latency_us";
+			break;
+		case rai::stat::detail::hit:
+			res = "hit";
+			break;
+		case rai::stat::detail::miss:
+			res = "miss";
+			break;
 	}
 	return res;
 }
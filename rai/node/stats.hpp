@@ -184,7 +184,11 @@ public:
 		rollback,
 		bootstrap,
 		vote,
-		peering
+		peering,
+		election,
+		wallet_action,
+		work_cache,
+		rpc
 	};
 
 	/** Optional detail type */
@@ -195,6 +199,7 @@ public:
 		// error specific
 		bad_sender,
 		insufficient_work,
+		throttled,
 
 		// ledger, block, bootstrap
 		send,
@@ -210,6 +215,7 @@ public:
 		republish_vote,
 		confirm_req,
 		confirm_ack,
+		confirm_req_batch,
 		smart_contract_req,
 		smart_contract,
 		smart_contract_ack,
@@ -228,6 +234,22 @@ public:
 
 		// peering
 		handshake,
+
+		// election specific
+		admitted,
+		backlogged,
+		evicted,
+		dropped,
+		confirmed,
+
+		// wallet action and rpc specific, queue depth is queued less executed
+		queued,
+		executed,
+		latency_us,
+
+		// work cache specific, counted when send and receive actions build their block
+		hit,
+		miss,
 	};
 
 	/** Direction of the stat. If the direction is irrelevant, use in */
@@ -56,7 +56,40 @@ std::vector<boost::filesystem::path> rai::remove_temporary_directories ()
 	return all_unique_paths;
 }
 
-rai::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, int max_dbs)
+void rai::lmdb_config::serialize_json (boost::property_tree::ptree & tree_a) const
+{
+	tree_a.put ("map_size", std::to_string (map_size));
+	tree_a.put ("map_growth", std::to_string (map_growth));
+	tree_a.put ("max_readers", std::to_string (max_readers));
+	tree_a.put ("read_ahead", read_ahead);
+	tree_a.put ("meta_sync", meta_sync);
+	tree_a.put ("sync", sync);
+	tree_a.put ("write_map", write_map);
+}
+
+bool rai::lmdb_config::deserialize_json (boost::property_tree::ptree & tree_a)
+{
+	map_size = tree_a.get<uint64_t> ("map_size", map_size);
+	map_growth = tree_a.get<uint64_t> ("map_growth", map_growth);
+	max_readers = tree_a.get<unsigned> ("max_readers", max_readers);
+	read_ahead = tree_a.get<bool> ("read_ahead", read_ahead);
+	meta_sync = tree_a.get<bool> ("meta_sync", meta_sync);
+	sync = tree_a.get<bool> ("sync", sync);
+	write_map = tree_a.get<bool> ("write_map", write_map);
+	return map_size == 0 || max_readers == 0;
+}
+
+rai::mdb_env::mdb_env () :
+environment (nullptr),
+active (0),
+resizes (0)
+{
+}
+
+rai::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, int max_dbs, rai::lmdb_config const & config_a) :
+config (config_a),
+active (0),
+resizes (0)
 {
 	boost::system::error_code error;
 	if (path_a.has_parent_path ())
@@ -68,12 +101,19 @@ rai::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, i
 			assert (status1 == 0);
 			auto status2 (mdb_env_set_maxdbs (environment, max_dbs));
 			assert (status2 == 0);
-			auto status3 (mdb_env_set_mapsize (environment, 1ULL * 1024 * 1024 * 1024 * 128)); // 128 Gigabyte
+			auto status3 (mdb_env_set_mapsize (environment, config.map_size));
 			assert (status3 == 0);
+			auto status4 (mdb_env_set_maxreaders (environment, config.max_readers));
+			assert (status4 == 0);
 			// It seems if there's ever more threads than mdb_env_set_maxreaders has read slots available, we get failures on transaction creation unless MDB_NOTLS is specified
 			// This can happen if something like 256 io_threads are specified in the node config
-			auto status4 (mdb_env_open (environment, path_a.string ().c_str (), MDB_NOSUBDIR | MDB_NOTLS, 00600));
-			error_a = status4 != 0;
+			unsigned flags (MDB_NOSUBDIR | MDB_NOTLS);
+			flags |= config.read_ahead ? 0 : MDB_NORDAHEAD;
+			flags |= config.meta_sync ? 0 : MDB_NOMETASYNC;
+			flags |= config.sync ? 0 : MDB_NOSYNC;
+			flags |= config.write_map ? MDB_WRITEMAP : 0;
+			auto status5 (mdb_env_open (environment, path_a.string ().c_str (), flags, 00600));
+			error_a = status5 != 0;
 		}
 		else
 		{
@@ -101,6 +141,112 @@ rai::mdb_env::operator MDB_env * () const
 	return environment;
 }
 
+namespace
+{
+class mdb_cursor : public rai::store_cursor
+{
+public:
+	mdb_cursor (MDB_txn * transaction_a, MDB_dbi table_a)
+	{
+		auto status (mdb_cursor_open (transaction_a, table_a, &cursor));
+		assert (status == 0);
+	}
+	~mdb_cursor ()
+	{
+		mdb_cursor_close (cursor);
+	}
+	int get (MDB_val * key_a, MDB_val * value_a, MDB_cursor_op op_a) override
+	{
+		return mdb_cursor_get (cursor, key_a, value_a, op_a);
+	}
+	int put (MDB_val * key_a, MDB_val * value_a, unsigned flags_a) override
+	{
+		return mdb_cursor_put (cursor, key_a, value_a, flags_a);
+	}
+	MDB_cursor * cursor;
+};
+}
+
+MDB_txn * rai::mdb_env::begin (MDB_txn * parent_a, bool write_a)
+{
+	// A block_store opened on another backend leaves its environment closed
+	assert (environment != nullptr);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		if (write_a && parent_a == nullptr && active == 0 && config.map_growth != 0)
+		{
+			MDB_envinfo info;
+			auto status1 (mdb_env_info (environment, &info));
+			assert (status1 == 0);
+			MDB_stat stats;
+			auto status2 (mdb_env_stat (environment, &stats));
+			assert (status2 == 0);
+			uint64_t used ((info.me_last_pgno + 1) * stats.ms_psize);
+			// Growing ahead of need rather than on MDB_MAP_FULL, a write that hits a full map has already failed
+			if (info.me_mapsize < used + config.map_growth)
+			{
+				auto status3 (mdb_env_set_mapsize (environment, info.me_mapsize + config.map_growth));
+				assert (status3 == 0);
+				++resizes;
+			}
+		}
+		++active;
+	}
+	MDB_txn * result;
+	auto status (mdb_txn_begin (environment, parent_a, write_a ? 0 : MDB_RDONLY, &result));
+	assert (status == 0);
+	return result;
+}
+
+void rai::mdb_env::commit (MDB_txn * transaction_a)
+{
+	auto status (mdb_txn_commit (transaction_a));
+	assert (status == 0);
+	std::lock_guard<std::mutex> lock (mutex);
+	assert (active > 0);
+	--active;
+}
+
+int rai::mdb_env::open (MDB_txn * transaction_a, char const * name_a, unsigned flags_a, MDB_dbi * table_a)
+{
+	return mdb_dbi_open (transaction_a, name_a, flags_a, table_a);
+}
+
+int rai::mdb_env::flags (MDB_txn * transaction_a, MDB_dbi table_a, unsigned * flags_a)
+{
+	return mdb_dbi_flags (transaction_a, table_a, flags_a);
+}
+
+int rai::mdb_env::get (MDB_txn * transaction_a, MDB_dbi table_a, MDB_val * key_a, MDB_val * value_a)
+{
+	return mdb_get (transaction_a, table_a, key_a, value_a);
+}
+
+int rai::mdb_env::put (MDB_txn * transaction_a, MDB_dbi table_a, MDB_val * key_a, MDB_val * value_a, unsigned flags_a)
+{
+	return mdb_put (transaction_a, table_a, key_a, value_a, flags_a);
+}
+
+int rai::mdb_env::del (MDB_txn * transaction_a, MDB_dbi table_a, MDB_val * key_a, MDB_val * value_a)
+{
+	return mdb_del (transaction_a, table_a, key_a, value_a);
+}
+
+int rai::mdb_env::drop (MDB_txn * transaction_a, MDB_dbi table_a, int delete_a)
+{
+	return mdb_drop (transaction_a, table_a, delete_a);
+}
+
+int rai::mdb_env::stat (MDB_txn * transaction_a, MDB_dbi table_a, MDB_stat * stat_a)
+{
+	return mdb_stat (transaction_a, table_a, stat_a);
+}
+
+std::unique_ptr<rai::store_cursor> rai::mdb_env::cursor (MDB_txn * transaction_a, MDB_dbi table_a)
+{
+	return std::unique_ptr<rai::store_cursor> (new mdb_cursor (transaction_a, table_a));
+}
+
 rai::mdb_val::mdb_val () :
 value ({ 0, nullptr })
 {
@@ -155,17 +301,15 @@ rai::mdb_val::operator MDB_val const & () const
 	return value;
 }
 
-rai::transaction::transaction (rai::mdb_env & environment_a, MDB_txn * parent_a, bool write) :
+rai::transaction::transaction (rai::store_backend & environment_a, MDB_txn * parent_a, bool write) :
+handle (environment_a.begin (parent_a, write)),
 environment (environment_a)
 {
-	auto status (mdb_txn_begin (environment_a, parent_a, write ? 0 : MDB_RDONLY, &handle));
-	assert (status == 0);
 }
 
 rai::transaction::~transaction ()
 {
-	auto status (mdb_txn_commit (handle));
-	assert (status == 0);
+	environment.commit (handle);
 }
 
 rai::transaction::operator MDB_txn * () const
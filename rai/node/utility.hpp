@@ -3,6 +3,8 @@
 #include <array>
 #include <atomic>
 #include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <type_traits>
 
 #include <boost/filesystem.hpp>
@@ -102,15 +104,99 @@ bool fetch_object (T & object, boost::filesystem::path const & path_a, std::fstr
 }
 
 /**
- * RAII wrapper for MDB_env
+ * LMDB environment settings from the optional 'lmdb' node of config.json
+ * The defaults are the settings nodes have always run with
  */
-class mdb_env
+class lmdb_config
 {
 public:
-	mdb_env (bool &, boost::filesystem::path const &, int max_dbs = 128);
+	void serialize_json (boost::property_tree::ptree &) const;
+	bool deserialize_json (boost::property_tree::ptree &);
+
+	/** Initial map size in bytes, the data file only takes the space it uses */
+	uint64_t map_size{ 128ULL * 1024 * 1024 * 1024 };
+
+	/** Bytes added to the map when less than this much of it is left, 0 disables growth */
+	uint64_t map_growth{ 32ULL * 1024 * 1024 * 1024 };
+
+	/** Concurrent read transactions, LMDB's own default is 126 */
+	unsigned max_readers{ 126 };
+
+	/** False sets MDB_NORDAHEAD. Helps random block lookups once the ledger no longer fits in RAM, slows full table scans. */
+	bool read_ahead{ true };
+
+	/** False sets MDB_NOMETASYNC. A system crash can lose the last committed transaction, the database stays intact. */
+	bool meta_sync{ true };
+
+	/** False sets MDB_NOSYNC. A system crash can lose recent transactions, and with write_map corrupt the database. Only for replicas that can be rebuilt. */
+	bool sync{ true };
+
+	/** True sets MDB_WRITEMAP. Cheaper commits, but a stray write through a pointer in to the map corrupts the database. */
+	bool write_map{ false };
+};
+
+/**
+ * Positioned on one table of a \ref store_backend, mirrors mdb_cursor_get / mdb_cursor_put
+ * Backends support MDB_FIRST, MDB_LAST, MDB_NEXT, MDB_NEXT_DUP, MDB_SET_RANGE and MDB_GET_CURRENT moves and
+ * MDB_CURRENT, MDB_APPEND and MDB_APPENDDUP puts
+ */
+class store_cursor
+{
+public:
+	virtual ~store_cursor () = default;
+	virtual int get (MDB_val *, MDB_val *, MDB_cursor_op) = 0;
+	virtual int put (MDB_val *, MDB_val *, unsigned) = 0;
+};
+
+/**
+ * Ordered key/value tables with transactions, the storage block_store is written against.
+ * Calls mirror the LMDB API they were lifted from: MDB_val byte ranges, MDB_dbi table handles, LMDB flags
+ * and LMDB status codes (0, MDB_NOTFOUND, MDB_KEYEXIST). Keys compare byte wise, MDB_DUPSORT tables
+ * hold several values per key. An MDB_txn * is an opaque handle only the backend that began it can use.
+ */
+class store_backend
+{
+public:
+	virtual ~store_backend () = default;
+	virtual MDB_txn * begin (MDB_txn *, bool) = 0;
+	virtual void commit (MDB_txn *) = 0;
+	virtual int open (MDB_txn *, char const *, unsigned, MDB_dbi *) = 0;
+	virtual int flags (MDB_txn *, MDB_dbi, unsigned *) = 0;
+	virtual int get (MDB_txn *, MDB_dbi, MDB_val *, MDB_val *) = 0;
+	virtual int put (MDB_txn *, MDB_dbi, MDB_val *, MDB_val *, unsigned) = 0;
+	virtual int del (MDB_txn *, MDB_dbi, MDB_val *, MDB_val *) = 0;
+	virtual int drop (MDB_txn *, MDB_dbi, int) = 0;
+	virtual int stat (MDB_txn *, MDB_dbi, MDB_stat *) = 0;
+	virtual std::unique_ptr<rai::store_cursor> cursor (MDB_txn *, MDB_dbi) = 0;
+};
+
+/**
+ * RAII wrapper for MDB_env, the LMDB store_backend
+ */
+class mdb_env : public rai::store_backend
+{
+public:
+	mdb_env ();
+	mdb_env (bool &, boost::filesystem::path const &, int max_dbs = 128, rai::lmdb_config const & = rai::lmdb_config ());
 	~mdb_env ();
 	operator MDB_env * () const;
+	// A top level write transaction first grows the map when it is running out
+	MDB_txn * begin (MDB_txn *, bool) override;
+	void commit (MDB_txn *) override;
+	int open (MDB_txn *, char const *, unsigned, MDB_dbi *) override;
+	int flags (MDB_txn *, MDB_dbi, unsigned *) override;
+	int get (MDB_txn *, MDB_dbi, MDB_val *, MDB_val *) override;
+	int put (MDB_txn *, MDB_dbi, MDB_val *, MDB_val *, unsigned) override;
+	int del (MDB_txn *, MDB_dbi, MDB_val *, MDB_val *) override;
+	int drop (MDB_txn *, MDB_dbi, int) override;
+	int stat (MDB_txn *, MDB_dbi, MDB_stat *) override;
+	std::unique_ptr<rai::store_cursor> cursor (MDB_txn *, MDB_dbi) override;
 	MDB_env * environment;
+	rai::lmdb_config config;
+	std::mutex mutex;
+	// LMDB only allows resizing the map while the process has no transaction open
+	size_t active;
+	uint64_t resizes;
 };
 
 /**
@@ -133,16 +219,16 @@ public:
 };
 
 /**
- * RAII wrapper of MDB_txn where the constructor starts the transaction
+ * RAII wrapper of a store_backend transaction where the constructor starts the transaction
  * and the destructor commits it.
  */
 class transaction
 {
 public:
-	transaction (rai::mdb_env &, MDB_txn *, bool);
+	transaction (rai::store_backend &, MDB_txn *, bool);
 	~transaction ();
 	operator MDB_txn * () const;
 	MDB_txn * handle;
-	rai::mdb_env & environment;
+	rai::store_backend & environment;
 };
 }
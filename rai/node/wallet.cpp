@@ -277,7 +277,7 @@ environment (transaction_a.environment)
 	if (!init_a)
 	{
 		MDB_val junk;
-		assert (mdb_get (transaction_a, handle, rai::mdb_val (version_special), &junk) == MDB_NOTFOUND);
+		assert (environment.get (transaction_a, handle, rai::mdb_val (version_special), &junk) == MDB_NOTFOUND);
 		boost::property_tree::ptree wallet_l;
 		std::stringstream istream (json_a);
 		try
@@ -310,11 +310,11 @@ environment (transaction_a.environment)
 				init_a = true;
 			}
 		}
-		init_a |= mdb_get (transaction_a, handle, rai::mdb_val (version_special), &junk) != 0;
-		init_a |= mdb_get (transaction_a, handle, rai::mdb_val (wallet_key_special), &junk) != 0;
-		init_a |= mdb_get (transaction_a, handle, rai::mdb_val (salt_special), &junk) != 0;
-		init_a |= mdb_get (transaction_a, handle, rai::mdb_val (check_special), &junk) != 0;
-		init_a |= mdb_get (transaction_a, handle, rai::mdb_val (representative_special), &junk) != 0;
+		init_a |= environment.get (transaction_a, handle, rai::mdb_val (version_special), &junk) != 0;
+		init_a |= environment.get (transaction_a, handle, rai::mdb_val (wallet_key_special), &junk) != 0;
+		init_a |= environment.get (transaction_a, handle, rai::mdb_val (salt_special), &junk) != 0;
+		init_a |= environment.get (transaction_a, handle, rai::mdb_val (check_special), &junk) != 0;
+		init_a |= environment.get (transaction_a, handle, rai::mdb_val (representative_special), &junk) != 0;
 		rai::raw_key key;
 		key.data.clear ();
 		password.value_set (key);
@@ -335,7 +335,7 @@ environment (transaction_a.environment)
 	{
 		int version_status;
 		MDB_val version_value;
-		version_status = mdb_get (transaction_a, handle, rai::mdb_val (version_special), &version_value);
+		version_status = environment.get (transaction_a, handle, rai::mdb_val (version_special), &version_value);
 		if (version_status == MDB_NOTFOUND)
 		{
 			version_put (transaction_a, version_current);
@@ -387,7 +387,7 @@ void rai::wallet_store::initialize (MDB_txn * transaction_a, bool & init_a, std:
 {
 	assert (strlen (path_a.c_str ()) == path_a.size ());
 	auto error (0);
-	error |= mdb_dbi_open (transaction_a, path_a.c_str (), MDB_CREATE, &handle);
+	error |= environment.open (transaction_a, path_a.c_str (), MDB_CREATE, &handle);
 	init_a = error != 0;
 }
 
@@ -427,7 +427,7 @@ void rai::wallet_store::insert_watch (MDB_txn * transaction_a, rai::public_key c
 
 void rai::wallet_store::erase (MDB_txn * transaction_a, rai::public_key const & pub)
 {
-	auto status (mdb_del (transaction_a, handle, rai::mdb_val (pub), nullptr));
+	auto status (environment.del (transaction_a, handle, rai::mdb_val (pub), nullptr));
 	assert (status == 0);
 }
 
@@ -435,7 +435,7 @@ rai::wallet_value rai::wallet_store::entry_get_raw (MDB_txn * transaction_a, rai
 {
 	rai::wallet_value result;
 	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, handle, rai::mdb_val (pub_a), value));
+	auto status (environment.get (transaction_a, handle, rai::mdb_val (pub_a), value));
 	if (status == 0)
 	{
 		result = rai::wallet_value (value);
@@ -450,7 +450,7 @@ rai::wallet_value rai::wallet_store::entry_get_raw (MDB_txn * transaction_a, rai
 
 void rai::wallet_store::entry_put_raw (MDB_txn * transaction_a, rai::public_key const & pub_a, rai::wallet_value const & entry_a)
 {
-	auto status (mdb_put (transaction_a, handle, rai::mdb_val (pub_a), entry_a.val (), 0));
+	auto status (environment.put (transaction_a, handle, rai::mdb_val (pub_a), entry_a.val (), 0));
 	assert (status == 0);
 }
 
@@ -539,7 +539,7 @@ bool rai::wallet_store::exists (MDB_txn * transaction_a, rai::public_key const &
 void rai::wallet_store::serialize_json (MDB_txn * transaction_a, std::string & string_a)
 {
 	boost::property_tree::ptree tree;
-	for (rai::store_iterator i (transaction_a, handle), n (nullptr); i != n; ++i)
+	for (rai::store_iterator i (environment, transaction_a, handle), n (nullptr); i != n; ++i)
 	{
 		tree.put (rai::uint256_union (i->first.uint256 ()).to_string (), rai::wallet_value (i->second).key.to_string ());
 	}
@@ -759,9 +759,10 @@ rai::public_key rai::wallet::deterministic_insert (MDB_txn * transaction_a, bool
 	if (store.valid_password (transaction_a))
 	{
 		key = store.deterministic_insert (transaction_a);
+		node.wallets.representative_insert (transaction_a, shared_from_this (), key);
 		if (generate_work_a)
 		{
-			work_ensure (key, key);
+			work_ensure (key);
 		}
 	}
 	return key;
@@ -780,9 +781,10 @@ rai::public_key rai::wallet::insert_adhoc (MDB_txn * transaction_a, rai::raw_key
 	if (store.valid_password (transaction_a))
 	{
 		key = store.insert_adhoc (transaction_a, key_a);
+		node.wallets.representative_insert (transaction_a, shared_from_this (), key);
 		if (generate_work_a)
 		{
-			work_ensure (key, node.ledger.latest_root (transaction_a, key));
+			work_ensure (key);
 		}
 	}
 	return key;
@@ -826,6 +828,14 @@ bool rai::wallet::import (std::string const & json_a, std::string const & passwo
 	{
 		error = store.import (transaction, *temp);
 	}
+	if (!error)
+	{
+		node.wallets.compute_representatives (transaction);
+		auto this_l (shared_from_this ());
+		node.background ([this_l]() {
+			this_l->node.wallets.work.add_wallet (this_l);
+		});
+	}
 	temp->destroy (transaction);
 	return error;
 }
@@ -838,7 +848,7 @@ void rai::wallet::serialize (std::string & json_a)
 
 void rai::wallet_store::destroy (MDB_txn * transaction_a)
 {
-	auto status (mdb_drop (transaction_a, handle, 1));
+	auto status (environment.drop (transaction_a, handle, 1));
 	assert (status == 0);
 }
 
@@ -849,7 +859,7 @@ std::shared_ptr<rai::block> rai::wallet::receive_action (rai::block const & send
 	std::shared_ptr<rai::block> block;
 	if (node.config.receive_minimum.number () <= amount_a.number ())
 	{
-		rai::transaction transaction (node.ledger.store.environment, nullptr, false);
+		rai::transaction transaction (node.ledger.store.backend, nullptr, false);
 		rai::pending_info pending_info;
 		if (node.store.block_exists (transaction, hash))
 		{
@@ -902,13 +912,18 @@ std::shared_ptr<rai::block> rai::wallet::receive_action (rai::block const & send
 	{
 		if (rai::work_validate (*block))
 		{
+			node.stats.inc (rai::stat::type::work_cache, rai::stat::detail::miss);
 			node.work_generate_blocking (*block);
 		}
+		else
+		{
+			node.stats.inc (rai::stat::type::work_cache, rai::stat::detail::hit);
+		}
 		node.process_active (block);
 		node.block_processor.flush ();
 		if (generate_work_a)
 		{
-			work_ensure (account, block->hash ());
+			work_ensure (account);
 		}
 	}
 	return block;
@@ -946,7 +961,7 @@ std::shared_ptr<rai::block> rai::wallet::change_action (rai::account const & sou
 		node.block_processor.flush ();
 		if (generate_work_a)
 		{
-			work_ensure (source_a, block->hash ());
+			work_ensure (source_a);
 		}
 	}
 	return block;
@@ -967,7 +982,7 @@ std::shared_ptr<rai::block> rai::wallet::send_action (rai::account const & sourc
 		if (id_mdb_val)
 		{
 			rai::mdb_val result;
-			auto status (mdb_get (transaction, node.wallets.send_action_ids, *id_mdb_val, result));
+			auto status (node.store.backend.get (transaction, node.wallets.send_action_ids, *id_mdb_val, result));
 			if (status == 0)
 			{
 				auto hash (result.uint256 ());
@@ -1006,7 +1021,7 @@ std::shared_ptr<rai::block> rai::wallet::send_action (rai::account const & sourc
 						block.reset (new rai::state_block (source_a, info.head, rep_block->representative (), balance - amount_a, account_a, token_hash_a, prv, source_a, cached_work));
 						if (id_mdb_val)
 						{
-							auto status (mdb_put (transaction, node.wallets.send_action_ids, *id_mdb_val, rai::mdb_val (block->hash ()), 0));
+							auto status (node.store.backend.put (transaction, node.wallets.send_action_ids, *id_mdb_val, rai::mdb_val (block->hash ()), 0));
 							if (status != 0)
 							{
 								block = nullptr;
@@ -1022,18 +1037,163 @@ std::shared_ptr<rai::block> rai::wallet::send_action (rai::account const & sourc
 	{
 		if (rai::work_validate (*block))
 		{
+			node.stats.inc (rai::stat::type::work_cache, rai::stat::detail::miss);
 			node.work_generate_blocking (*block);
 		}
+		else
+		{
+			node.stats.inc (rai::stat::type::work_cache, rai::stat::detail::hit);
+		}
 		node.process_active (block);
 		node.block_processor.flush ();
 		if (generate_work_a)
 		{
-			work_ensure (source_a, block->hash ());
+			work_ensure (source_a);
 		}
 	}
 	return block;
 }
 
+std::vector<std::shared_ptr<rai::block>> rai::wallet::send_batch_action (rai::account const & source_a, std::vector<rai::send_batch_entry> const & entries_a, bool generate_work_a)
+{
+	std::vector<std::shared_ptr<rai::block>> result (entries_a.size ());
+	// Blocks created by this batch in chain order, each one's work root is the hash of the one before it on the same token chain
+	std::vector<std::shared_ptr<rai::block>> created;
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		if (entries_a.size () <= send_batch_max && store.valid_password (transaction) && store.find (transaction, source_a) != store.end ())
+		{
+			rai::raw_key prv;
+			auto error (store.fetch (transaction, source_a, prv));
+			assert (!error);
+			uint64_t cached_work (0);
+			store.work_get (transaction, source_a, cached_work);
+			// Frontier and representative of each token chain, advanced as the batch appends to it
+			std::unordered_map<rai::block_hash, std::pair<rai::account_info, rai::account>> chains;
+			// Ids recorded by earlier entries, their blocks aren't in the ledger until the batch is processed
+			std::unordered_map<std::string, std::shared_ptr<rai::block>> ids;
+			for (size_t i (0), n (entries_a.size ()); i < n; ++i)
+			{
+				auto & entry (entries_a[i]);
+				boost::optional<rai::mdb_val> id_mdb_val;
+				auto error (false);
+				auto repeated (entry.id ? ids.find (*entry.id) : ids.end ());
+				if (repeated != ids.end ())
+				{
+					result[i] = repeated->second;
+					error = true;
+				}
+				else if (entry.id)
+				{
+					id_mdb_val = rai::mdb_val (entry.id->size (), const_cast<char *> (entry.id->data ()));
+					rai::mdb_val existing;
+					auto status (node.store.backend.get (transaction, node.wallets.send_action_ids, *id_mdb_val, existing));
+					if (status == 0)
+					{
+						result[i] = node.store.block_get (transaction, existing.uint256 ());
+						if (result[i] != nullptr)
+						{
+							node.network.republish_block (transaction, result[i]);
+							error = true;
+						}
+						// Otherwise the block never made it in to the ledger, the send is created again under the same id as send_action does
+					}
+					else if (status != MDB_NOTFOUND)
+					{
+						error = true;
+					}
+				}
+				if (!error)
+				{
+					auto chain (chains.find (entry.token));
+					if (chain == chains.end ())
+					{
+						rai::account_info info;
+						if (!node.ledger.store.accounts_get (transaction, source_a, entry.token, info))
+						{
+							std::shared_ptr<rai::block> rep_block (node.ledger.store.block_get (transaction, info.rep_block));
+							assert (rep_block != nullptr);
+							chain = chains.insert (std::make_pair (entry.token, std::make_pair (info, rep_block->representative ()))).first;
+						}
+					}
+					if (chain != chains.end ())
+					{
+						auto & info (chain->second.first);
+						auto balance (info.balance.number ());
+						if (!balance.is_zero () && balance >= entry.amount)
+						{
+							std::shared_ptr<rai::block> block (new rai::state_block (source_a, info.head, chain->second.second, balance - entry.amount, entry.destination, entry.token, prv, source_a, created.empty () ? cached_work : 0));
+							auto status (id_mdb_val ? node.store.backend.put (transaction, node.wallets.send_action_ids, *id_mdb_val, rai::mdb_val (block->hash ()), 0) : 0);
+							if (status == 0)
+							{
+								info.head = block->hash ();
+								info.balance = balance - entry.amount;
+								result[i] = block;
+								created.push_back (block);
+								if (entry.id)
+								{
+									ids[*entry.id] = block;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	if (!created.empty ())
+	{
+		if (rai::work_validate (*created.front ()))
+		{
+			node.stats.inc (rai::stat::type::work_cache, rai::stat::detail::miss);
+		}
+		else
+		{
+			node.stats.inc (rai::stat::type::work_cache, rai::stat::detail::hit);
+		}
+		// Every root is known up front, so work for the following blocks is generated while earlier ones are processed
+		std::deque<std::shared_ptr<std::promise<uint64_t>>> pending;
+		size_t requested (0);
+		for (auto & block : created)
+		{
+			while (requested < created.size () && pending.size () < send_batch_work_window)
+			{
+				auto work (std::make_shared<std::promise<uint64_t>> ());
+				auto & next (created[requested]);
+				if (rai::work_validate (*next))
+				{
+					node.work_generate (next->root (), [work](uint64_t work_a) {
+						work->set_value (work_a);
+					});
+				}
+				else
+				{
+					work->set_value (next->block_work ());
+				}
+				pending.push_back (work);
+				++requested;
+			}
+			block->block_work_set (pending.front ()->get_future ().get ());
+			pending.pop_front ();
+			node.process_active (block);
+		}
+		node.block_processor.flush ();
+		if (generate_work_a)
+		{
+			work_ensure (source_a);
+		}
+	}
+	return result;
+}
+
+void rai::wallet::send_batch_async (rai::account const & source_a, std::vector<rai::send_batch_entry> const & entries_a, std::function<void(std::vector<std::shared_ptr<rai::block>> const &)> const & action_a, bool generate_work_a)
+{
+	this->node.wallets.queue_wallet_action (rai::wallets::high_priority, source_a, [this, source_a, entries_a, action_a, generate_work_a]() {
+		auto blocks (send_batch_action (source_a, entries_a, generate_work_a));
+		action_a (blocks);
+	});
+}
+
 bool rai::wallet::change_sync (rai::account const & source_a, rai::account const & representative_a)
 {
 	std::promise<bool> result;
@@ -1046,7 +1206,7 @@ bool rai::wallet::change_sync (rai::account const & source_a, rai::account const
 
 void rai::wallet::change_async (rai::account const & source_a, rai::account const & representative_a, std::function<void(std::shared_ptr<rai::block>)> const & action_a, bool generate_work_a)
 {
-	node.wallets.queue_wallet_action (rai::wallets::high_priority, [this, source_a, representative_a, action_a, generate_work_a]() {
+	node.wallets.queue_wallet_action (rai::wallets::high_priority, source_a, [this, source_a, representative_a, action_a, generate_work_a]() {
 		auto block (change_action (source_a, representative_a, generate_work_a));
 		action_a (block);
 	});
@@ -1065,7 +1225,12 @@ bool rai::wallet::receive_sync (std::shared_ptr<rai::block> block_a, rai::accoun
 void rai::wallet::receive_async (std::shared_ptr<rai::block> block_a, rai::account const & representative_a, rai::uint128_t const & amount_a, std::function<void(std::shared_ptr<rai::block>)> const & action_a, bool generate_work_a)
 {
 	//assert (dynamic_cast<rai::send_block *> (block_a.get ()) != nullptr);
-	node.wallets.queue_wallet_action (amount_a, [this, block_a, representative_a, amount_a, action_a, generate_work_a]() {
+	rai::account account;
+	{
+		rai::transaction transaction (node.store.backend, nullptr, false);
+		account = node.ledger.block_destination (transaction, *block_a);
+	}
+	node.wallets.queue_wallet_action (amount_a, account, [this, block_a, representative_a, amount_a, action_a, generate_work_a]() {
 		auto block (receive_action (*static_cast<rai::block *> (block_a.get ()), representative_a, amount_a, generate_work_a));
 		action_a (block);
 	});
@@ -1083,7 +1248,7 @@ rai::block_hash rai::wallet::send_sync (rai::account const & source_a, rai::acco
 
 void rai::wallet::send_async (rai::account const & source_a, rai::account const & account_a, rai::block_hash const & token_hash_a, rai::uint128_t const & amount_a, std::function<void(std::shared_ptr<rai::block>)> const & action_a, bool generate_work_a, boost::optional<std::string> id_a)
 {
-	this->node.wallets.queue_wallet_action (rai::wallets::high_priority, [this, source_a, account_a, token_hash_a, amount_a, action_a, generate_work_a, id_a]() {
+	this->node.wallets.queue_wallet_action (rai::wallets::high_priority, source_a, [this, source_a, account_a, token_hash_a, amount_a, action_a, generate_work_a, id_a]() {
 		auto block (send_action (source_a, account_a, token_hash_a, amount_a, generate_work_a, id_a));
 		action_a (block);
 	});
@@ -1105,12 +1270,9 @@ void rai::wallet::work_update (MDB_txn * transaction_a, rai::account const & acc
 	}
 }
 
-void rai::wallet::work_ensure (rai::account const & account_a, rai::block_hash const & hash_a)
+void rai::wallet::work_ensure (rai::account const & account_a)
 {
-	auto this_l (shared_from_this ());
-	node.wallets.queue_wallet_action (rai::wallets::generate_priority, [this_l, account_a, hash_a] {
-		this_l->work_cache_blocking (account_a, hash_a);
-	});
+	node.wallets.work.active (shared_from_this (), account_a);
 }
 
 bool rai::wallet::search_pending ()
@@ -1120,7 +1282,7 @@ bool rai::wallet::search_pending ()
 	if (!result)
 	{
 		BOOST_LOG (node.log) << "Beginning pending block search";
-		rai::transaction transaction (node.store.environment, nullptr, false);
+		rai::transaction transaction (node.store.backend, nullptr, false);
 		for (auto i (store.begin (transaction)), n (store.end ()); i != n; ++i)
 		{
 			rai::account account (i->first.uint256 ());
@@ -1214,21 +1376,167 @@ void rai::wallet::work_cache_blocking (rai::account const & account_a, rai::bloc
 	}
 }
 
+rai::work_cache::work_cache (rai::node & node_a) :
+activity (0),
+node (node_a),
+stopped (false),
+thread ([this]() { run (); })
+{
+}
+
+rai::work_cache::~work_cache ()
+{
+	stop ();
+}
+
+void rai::work_cache::active (std::shared_ptr<rai::wallet> const & wallet_a, rai::account const & account_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	insert (rai::work_cache_entry{ account_a, wallet_a, std::make_pair (++activity, rai::uint128_t (0)) });
+}
+
+void rai::work_cache::add (std::shared_ptr<rai::wallet> const & wallet_a, rai::account const & account_a, rai::uint128_t const & balance_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	insert (rai::work_cache_entry{ account_a, wallet_a, std::make_pair (uint64_t (0), balance_a) });
+}
+
+void rai::work_cache::insert (rai::work_cache_entry const & entry_a)
+{
+	auto existing (requests.find (entry_a.account));
+	if (existing == requests.end ())
+	{
+		requests.insert (entry_a);
+		condition.notify_all ();
+	}
+	else if (existing->priority < entry_a.priority)
+	{
+		requests.modify (existing, [&entry_a](rai::work_cache_entry & entry) {
+			entry.priority = entry_a.priority;
+		});
+	}
+}
+
+void rai::work_cache::add_wallet (std::shared_ptr<rai::wallet> const & wallet_a)
+{
+	rai::transaction transaction (node.store.backend, nullptr, false);
+	auto cutoff (rai::seconds_since_epoch () - std::min (rai::seconds_since_epoch (), seed_age));
+	size_t queued (0);
+	for (auto i (wallet_a->store.begin (transaction)), n (wallet_a->store.end ()); i != n && queued < seed_max; ++i)
+	{
+		rai::account account (i->first.uint256 ());
+		rai::account_info info;
+		if (!node.store.accounts_get (transaction, account, rai::chain_token_type, info) && (!info.balance.is_zero () || info.modified >= cutoff))
+		{
+			uint64_t work (0);
+			// Only queue accounts whose persisted work doesn't match their frontier
+			if (wallet_a->store.work_get (transaction, account, work) || rai::work_validate (node.ledger.latest_root (transaction, account), work))
+			{
+				add (wallet_a, account, info.balance.number ());
+				++queued;
+			}
+		}
+	}
+}
+
+void rai::work_cache::frontier (rai::account const & account_a)
+{
+	std::shared_ptr<rai::wallet> wallet;
+	auto wallets (node.wallets.items_copy ());
+	{
+		rai::transaction transaction (node.store.backend, nullptr, false);
+		for (auto i (wallets.begin ()), n (wallets.end ()); wallet == nullptr && i != n; ++i)
+		{
+			if ((*i)->store.exists (transaction, account_a))
+			{
+				wallet = *i;
+			}
+		}
+	}
+	if (wallet != nullptr)
+	{
+		active (wallet, account_a);
+	}
+}
+
+void rai::work_cache::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		if (!requests.empty ())
+		{
+			auto & priority (requests.get<1> ());
+			auto first (priority.begin ());
+			auto entry (*first);
+			priority.erase (first);
+			lock.unlock ();
+			rai::block_hash root (0);
+			auto valid (true);
+			{
+				rai::transaction transaction (node.store.backend, nullptr, false);
+				if (entry.wallet->store.exists (transaction, entry.account))
+				{
+					root = node.ledger.latest_root (transaction, entry.account);
+					uint64_t work (0);
+					valid = !entry.wallet->store.work_get (transaction, entry.account, work) && !rai::work_validate (root, work);
+				}
+			}
+			if (!valid)
+			{
+				// work_update discards the result if the frontier moved while generating, the move queues the account again
+				entry.wallet->work_cache_blocking (entry.account, root);
+			}
+			lock.lock ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
+void rai::work_cache::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
+	if (thread.joinable ())
+	{
+		thread.join ();
+	}
+}
+
+rai::wallet_representative::wallet_representative (std::shared_ptr<rai::wallet> const & wallet_a) :
+wallet (wallet_a),
+decrypted (false)
+{
+	prv.data.clear ();
+}
+
 rai::wallets::wallets (bool & error_a, rai::node & node_a) :
 observer ([](bool) {}),
 node (node_a),
-stopped (false),
-thread ([this]() { do_wallet_actions (); })
+work (node_a),
+stopped (false)
 {
+	// Everything the node constructed before the wallets, mostly opening and upgrading the store
+	node.startup.phase ("store");
+	for (size_t i (0); i < action_threads; ++i)
+	{
+		threads.push_back (std::thread ([this]() { do_wallet_actions (); }));
+	}
 	if (!error_a)
 	{
-		rai::transaction transaction (node.store.environment, nullptr, true);
-		auto status (mdb_dbi_open (transaction, nullptr, MDB_CREATE, &handle));
-		status |= mdb_dbi_open (transaction, "send_action_ids", MDB_CREATE, &send_action_ids);
+		rai::transaction transaction (node.store.backend, nullptr, true);
+		auto status (node.store.backend.open (transaction, nullptr, MDB_CREATE, &handle));
+		status |= node.store.backend.open (transaction, "send_action_ids", MDB_CREATE, &send_action_ids);
 		assert (status == 0);
 		std::string beginning (rai::uint256_union (0).to_string ());
 		std::string end ((rai::uint256_union (rai::uint256_t (0) - rai::uint256_t (1))).to_string ());
-		for (rai::store_iterator i (transaction, handle, rai::mdb_val (beginning.size (), const_cast<char *> (beginning.c_str ()))), n (transaction, handle, rai::mdb_val (end.size (), const_cast<char *> (end.c_str ()))); i != n; ++i)
+		for (rai::store_iterator i (node.store.backend, transaction, handle, rai::mdb_val (beginning.size (), const_cast<char *> (beginning.c_str ()))), n (node.store.backend, transaction, handle, rai::mdb_val (end.size (), const_cast<char *> (end.c_str ()))); i != n; ++i)
 		{
 			rai::uint256_union id;
 			std::string text (reinterpret_cast<char const *> (i->first.data ()), i->first.size ());
@@ -1240,6 +1548,7 @@ thread ([this]() { do_wallet_actions (); })
 			{
 				node_a.background ([wallet]() {
 					wallet->enter_initial_password ();
+					wallet->node.wallets.work.add_wallet (wallet);
 				});
 				items[id] = wallet;
 			}
@@ -1248,7 +1557,9 @@ thread ([this]() { do_wallet_actions (); })
 				// Couldn't open wallet
 			}
 		}
+		compute_representatives (transaction);
 	}
+	node.startup.phase ("wallets");
 }
 
 rai::wallets::~wallets ()
@@ -1273,12 +1584,15 @@ std::shared_ptr<rai::wallet> rai::wallets::create (rai::uint256_union const & id
 	std::shared_ptr<rai::wallet> result;
 	bool error;
 	{
-		rai::transaction transaction (node.store.environment, nullptr, true);
+		rai::transaction transaction (node.store.backend, nullptr, true);
 		result = std::make_shared<rai::wallet> (error, transaction, node, id_a.to_string ());
 	}
 	if (!error)
 	{
-		items[id_a] = result;
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			items[id_a] = result;
+		}
 		node.background ([result]() {
 			result->enter_initial_password ();
 		});
@@ -1309,11 +1623,21 @@ void rai::wallets::search_pending_all ()
 
 void rai::wallets::destroy (rai::uint256_union const & id_a)
 {
-	rai::transaction transaction (node.store.environment, nullptr, true);
+	rai::transaction transaction (node.store.backend, nullptr, true);
 	auto existing (items.find (id_a));
 	assert (existing != items.end ());
 	auto wallet (existing->second);
-	items.erase (existing);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		items.erase (existing);
+	}
+	{
+		std::lock_guard<std::mutex> lock (representatives_mutex);
+		for (auto i (representatives.begin ()), n (representatives.end ()); i != n;)
+		{
+			i = i->second.wallet == wallet ? representatives.erase (i) : std::next (i);
+		}
+	}
 	wallet->store.destroy (transaction);
 }
 
@@ -1322,16 +1646,39 @@ void rai::wallets::do_wallet_actions ()
 	std::unique_lock<std::mutex> lock (mutex);
 	while (!stopped)
 	{
-		if (!actions.empty ())
+		// Highest priority action whose account isn't already being worked on by another thread
+		auto first (actions.begin ());
+		while (first != actions.end () && actions_active.find (first->second.account) != actions_active.end ())
+		{
+			++first;
+		}
+		if (first != actions.end ())
 		{
-			auto first (actions.begin ());
-			auto current (std::move (first->second));
+			auto account (first->second.account);
+			auto current (std::move (first->second.action));
+			auto latency (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - first->second.queued));
 			actions.erase (first);
+			actions_active.insert (account);
+			auto starting (actions_active.size () == 1);
 			lock.unlock ();
-			observer (true);
+			node.stats.inc (rai::stat::type::wallet_action, rai::stat::detail::executed);
+			node.stats.add (rai::stat::type::wallet_action, rai::stat::detail::latency_us, rai::stat::dir::in, latency.count (), true);
+			if (starting)
+			{
+				observer (true);
+			}
 			current ();
-			observer (false);
 			lock.lock ();
+			actions_active.erase (account);
+			auto finished (actions_active.empty ());
+			// Actions queued behind this account can run now
+			condition.notify_all ();
+			if (finished)
+			{
+				lock.unlock ();
+				observer (false);
+				lock.lock ();
+			}
 		}
 		else
 		{
@@ -1340,48 +1687,135 @@ void rai::wallets::do_wallet_actions ()
 	}
 }
 
-void rai::wallets::queue_wallet_action (rai::uint128_t const & amount_a, std::function<void()> const & action_a)
+void rai::wallets::queue_wallet_action (rai::uint128_t const & amount_a, rai::account const & account_a, std::function<void()> const & action_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	actions.insert (std::make_pair (amount_a, std::move (action_a)));
-	condition.notify_all ();
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		actions.insert (std::make_pair (amount_a, rai::wallet_action{ account_a, std::move (action_a), std::chrono::steady_clock::now () }));
+		condition.notify_all ();
+	}
+	node.stats.inc (rai::stat::type::wallet_action, rai::stat::detail::queued);
 }
 
 void rai::wallets::foreach_representative (MDB_txn * transaction_a, std::function<void(rai::public_key const & pub_a, rai::raw_key const & prv_a)> const & action_a)
 {
-	for (auto i (items.begin ()), n (items.end ()); i != n; ++i)
+	std::lock_guard<std::mutex> lock (representatives_mutex);
+	for (auto i (representatives.begin ()), n (representatives.end ()); i != n;)
 	{
-		auto & wallet (*i->second);
-		for (auto j (wallet.store.begin (transaction_a)), m (wallet.store.end ()); j != m; ++j)
+		auto & representative (i->second);
+		auto & wallet (*representative.wallet);
+		if (wallet.store.exists (transaction_a, i->first))
 		{
-			rai::account account (j->first.uint256 ());
-			if (!node.ledger.weight (transaction_a, account).is_zero ())
+			if (!node.ledger.weight (transaction_a, i->first).is_zero ())
 			{
 				if (wallet.store.valid_password (transaction_a))
 				{
-					rai::raw_key prv;
-					auto error (wallet.store.fetch (transaction_a, j->first.uint256 (), prv));
-					if (!error)
+					if (!representative.decrypted)
 					{
-						action_a (j->first.uint256 (), prv);
+						auto error (wallet.store.fetch (transaction_a, i->first, representative.prv));
+						representative.decrypted = !error;
+						if (error)
+						{
+							BOOST_LOG (node.log) << boost::str (boost::format ("Can not fetch representative %1% from wallet") % i->first.to_account ());
+						}
 					}
-					else
+					if (representative.decrypted)
 					{
-						BOOST_LOG (node.log) << boost::str (boost::format ("Can not fetch account %1% from wallet %2%") % j->first.uint256 ().to_account () % i->first.to_string ());
+						action_a (i->first, representative.prv);
 					}
 				}
 				else
 				{
+					// Wallet was locked since the key was decrypted, don't keep it around
+					representative.prv.data.clear ();
+					representative.decrypted = false;
 					static auto last_log = std::chrono::steady_clock::time_point ();
 					if (last_log < std::chrono::steady_clock::now () - std::chrono::seconds (60))
 					{
 						last_log = std::chrono::steady_clock::now ();
-						BOOST_LOG (node.log) << boost::str (boost::format ("Representative locked inside wallet %1%") % i->first.to_string ());
+						BOOST_LOG (node.log) << boost::str (boost::format ("Representative %1% locked inside wallet") % i->first.to_account ());
 					}
 				}
 			}
+			++i;
+		}
+		else
+		{
+			i = representatives.erase (i);
+		}
+	}
+}
+
+void rai::wallets::compute_representatives (MDB_txn * transaction_a)
+{
+	std::unordered_map<rai::account, rai::wallet_representative> representatives_l;
+	for (auto i (items.begin ()), n (items.end ()); i != n; ++i)
+	{
+		for (auto j (i->second->store.begin (transaction_a)), m (i->second->store.end ()); j != m; ++j)
+		{
+			rai::account account (j->first.uint256 ());
+			if (!node.ledger.weight (transaction_a, account).is_zero ())
+			{
+				representatives_l.emplace (std::piecewise_construct, std::forward_as_tuple (account), std::forward_as_tuple (i->second));
+			}
 		}
 	}
+	std::lock_guard<std::mutex> lock (representatives_mutex);
+	representatives.swap (representatives_l);
+}
+
+void rai::wallets::observe_representative (MDB_txn * transaction_a, rai::account const & account_a)
+{
+	if (!account_a.is_zero ())
+	{
+		auto known (false);
+		{
+			std::lock_guard<std::mutex> lock (representatives_mutex);
+			known = representatives.find (account_a) != representatives.end ();
+		}
+		auto wallets (known ? std::vector<std::shared_ptr<rai::wallet>> () : items_copy ());
+		for (auto i (wallets.begin ()), n (wallets.end ()); !known && i != n; ++i)
+		{
+			if ((*i)->store.exists (transaction_a, account_a))
+			{
+				known = true;
+				representative_insert (transaction_a, *i, account_a);
+			}
+		}
+	}
+}
+
+void rai::wallets::representative_keys_clear (rai::wallet const & wallet_a)
+{
+	std::lock_guard<std::mutex> lock (representatives_mutex);
+	for (auto & i : representatives)
+	{
+		if (i.second.wallet.get () == &wallet_a)
+		{
+			i.second.prv.data.clear ();
+			i.second.decrypted = false;
+		}
+	}
+}
+
+std::vector<std::shared_ptr<rai::wallet>> rai::wallets::items_copy ()
+{
+	std::vector<std::shared_ptr<rai::wallet>> result;
+	std::lock_guard<std::mutex> lock (mutex);
+	for (auto & i : items)
+	{
+		result.push_back (i.second);
+	}
+	return result;
+}
+
+void rai::wallets::representative_insert (MDB_txn * transaction_a, std::shared_ptr<rai::wallet> const & wallet_a, rai::account const & account_a)
+{
+	if (!node.ledger.weight (transaction_a, account_a).is_zero ())
+	{
+		std::lock_guard<std::mutex> lock (representatives_mutex);
+		representatives.emplace (std::piecewise_construct, std::forward_as_tuple (account_a), std::forward_as_tuple (wallet_a));
+	}
 }
 
 bool rai::wallets::exists (MDB_txn * transaction_a, rai::public_key const & account_a)
@@ -1401,24 +1835,32 @@ void rai::wallets::stop ()
 		stopped = true;
 		condition.notify_all ();
 	}
-	if (thread.joinable ())
+	work.stop ();
+	for (auto & thread : threads)
 	{
-		thread.join ();
+		if (thread.joinable ())
+		{
+			thread.join ();
+		}
 	}
 }
 
-rai::uint128_t const rai::wallets::generate_priority = std::numeric_limits<rai::uint128_t>::max ();
 rai::uint128_t const rai::wallets::high_priority = std::numeric_limits<rai::uint128_t>::max () - 1;
+size_t constexpr rai::wallets::action_threads;
+size_t constexpr rai::work_cache::seed_max;
+uint64_t constexpr rai::work_cache::seed_age;
+size_t constexpr rai::wallet::send_batch_work_window;
+size_t constexpr rai::wallet::send_batch_max;
 
 rai::store_iterator rai::wallet_store::begin (MDB_txn * transaction_a)
 {
-	rai::store_iterator result (transaction_a, handle, rai::mdb_val (rai::uint256_union (special_count)));
+	rai::store_iterator result (environment, transaction_a, handle, rai::mdb_val (rai::uint256_union (special_count)));
 	return result;
 }
 
 rai::store_iterator rai::wallet_store::begin (MDB_txn * transaction_a, rai::uint256_union const & key)
 {
-	rai::store_iterator result (transaction_a, handle, rai::mdb_val (key));
+	rai::store_iterator result (environment, transaction_a, handle, rai::mdb_val (key));
 	return result;
 }
 
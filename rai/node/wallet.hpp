@@ -10,6 +10,11 @@
 #include <thread>
 #include <unordered_set>
 
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index_container.hpp>
+
 namespace rai
 {
 // The fan spreads a key out over the heap to decrease the likelihood of it being recovered by memory inspection
@@ -114,11 +119,20 @@ public:
 	static unsigned const kdf_test_work = 8;
 	static unsigned const kdf_work = rai::rai_network == rai::rai_networks::rai_test_network ? kdf_test_work : kdf_full_work;
 	rai::kdf & kdf;
-	rai::mdb_env & environment;
+	rai::store_backend & environment;
 	MDB_dbi handle;
 	std::recursive_mutex mutex;
 };
 class node;
+// One payment of a send batch, the optional id makes the entry idempotent the same way send ids do
+class send_batch_entry
+{
+public:
+	rai::account destination;
+	rai::block_hash token;
+	rai::uint128_t amount;
+	boost::optional<std::string> id;
+};
 // A wallet is a set of account keys encrypted by a common encryption key
 class wallet : public std::enable_shared_from_this<rai::wallet>
 {
@@ -126,6 +140,8 @@ public:
 	std::shared_ptr<rai::block> change_action (rai::account const &, rai::account const &, bool = true);
 	std::shared_ptr<rai::block> receive_action (rai::block const &, rai::account const &, rai::uint128_union const &, bool = true);
 	std::shared_ptr<rai::block> send_action (rai::account const &, rai::account const &, rai::block_hash const &, rai::uint128_t const &, bool = true, boost::optional<std::string> = {});
+	// Batches of more than send_batch_max entries are refused as a whole, every entry comes back null
+	std::vector<std::shared_ptr<rai::block>> send_batch_action (rai::account const &, std::vector<rai::send_batch_entry> const &, bool = true);
 	wallet (bool &, rai::transaction &, rai::node &, std::string const &);
 	wallet (bool &, rai::transaction &, rai::node &, std::string const &, std::string const &);
 	void enter_initial_password ();
@@ -145,10 +161,11 @@ public:
 	void receive_async (std::shared_ptr<rai::block>, rai::account const &, rai::uint128_t const &, std::function<void(std::shared_ptr<rai::block>)> const &, bool = true);
 	rai::block_hash send_sync (rai::account const &, rai::account const &, rai::block_hash const &, rai::uint128_t const &);
 	void send_async (rai::account const &, rai::account const &, rai::block_hash const &, rai::uint128_t const &, std::function<void(std::shared_ptr<rai::block>)> const &, bool = true, boost::optional<std::string> = {});
+	void send_batch_async (rai::account const &, std::vector<rai::send_batch_entry> const &, std::function<void(std::vector<std::shared_ptr<rai::block>> const &)> const &, bool = true);
 	void work_apply (rai::account const &, std::function<void(uint64_t)>);
 	void work_cache_blocking (rai::account const &, rai::block_hash const &);
 	void work_update (MDB_txn *, rai::account const &, rai::block_hash const &, uint64_t);
-	void work_ensure (rai::account const &, rai::block_hash const &);
+	void work_ensure (rai::account const &);
 	bool search_pending ();
 	void init_free_accounts (MDB_txn *);
 	/** Changes the wallet seed and returns the first account */
@@ -157,6 +174,65 @@ public:
 	std::function<void(bool, bool)> lock_observer;
 	rai::wallet_store store;
 	rai::node & node;
+	// How many blocks of a send batch have work requested ahead of the one being processed
+	static size_t constexpr send_batch_work_window = 16;
+	// Most entries a send batch can have, the whole batch is built in one wallet write transaction
+	static size_t constexpr send_batch_max = 1024;
+};
+// A wallet account that has held voting weight, its key is decrypted on first use and dropped when the wallet locks
+class wallet_representative
+{
+public:
+	wallet_representative (std::shared_ptr<rai::wallet> const &);
+	std::shared_ptr<rai::wallet> wallet;
+	rai::raw_key prv;
+	bool decrypted;
+};
+class work_cache_entry
+{
+public:
+	rai::account account;
+	std::shared_ptr<rai::wallet> wallet;
+	// Sequence of the account's latest activity, 0 if none seen, then balance
+	std::pair<uint64_t, rai::uint128_t> priority;
+};
+// Keeps proof of work ready for the frontier of every wallet account, recently active accounts first then by balance
+class work_cache
+{
+public:
+	work_cache (rai::node &);
+	~work_cache ();
+	void active (std::shared_ptr<rai::wallet> const &, rai::account const &);
+	void add (std::shared_ptr<rai::wallet> const &, rai::account const &, rai::uint128_t const &);
+	void add_wallet (std::shared_ptr<rai::wallet> const &);
+	void frontier (rai::account const &);
+	void run ();
+	void stop ();
+	// Accounts add_wallet queues, idle ones without a balance get work when they're next used
+	static size_t constexpr seed_max = 4096;
+	static uint64_t constexpr seed_age = 7 * 24 * 60 * 60;
+	boost::multi_index_container<
+	rai::work_cache_entry,
+	boost::multi_index::indexed_by<
+	boost::multi_index::hashed_unique<boost::multi_index::member<rai::work_cache_entry, rai::account, &rai::work_cache_entry::account>>,
+	boost::multi_index::ordered_non_unique<boost::multi_index::member<rai::work_cache_entry, std::pair<uint64_t, rai::uint128_t>, &rai::work_cache_entry::priority>, std::greater<std::pair<uint64_t, rai::uint128_t>>>>>
+	requests;
+	uint64_t activity;
+	std::mutex mutex;
+	std::condition_variable condition;
+	rai::node & node;
+	bool stopped;
+	std::thread thread;
+
+private:
+	void insert (rai::work_cache_entry const &);
+};
+class wallet_action
+{
+public:
+	rai::account account;
+	std::function<void()> action;
+	std::chrono::steady_clock::time_point queued;
 };
 // The wallets set is all the wallets a node controls.  A node may contain multiple wallets independently encrypted and operated.
 class wallets
@@ -170,22 +246,36 @@ public:
 	void search_pending_all ();
 	void destroy (rai::uint256_union const &);
 	void do_wallet_actions ();
-	void queue_wallet_action (rai::uint128_t const &, std::function<void()> const &);
+	void queue_wallet_action (rai::uint128_t const &, rai::account const &, std::function<void()> const &);
 	void foreach_representative (MDB_txn *, std::function<void(rai::public_key const &, rai::raw_key const &)> const &);
+	void compute_representatives (MDB_txn *);
+	void observe_representative (MDB_txn *, rai::account const &);
+	void representative_insert (MDB_txn *, std::shared_ptr<rai::wallet> const &, rai::account const &);
+	// Drops representative keys decrypted from the wallet, called when it's locked or its password changes
+	void representative_keys_clear (rai::wallet const &);
 	bool exists (MDB_txn *, rai::public_key const &);
+	// Wallets in items, for threads other than the one creating and destroying them
+	std::vector<std::shared_ptr<rai::wallet>> items_copy ();
 	void stop ();
 	std::function<void(bool)> observer;
+	// Changed under mutex
 	std::unordered_map<rai::uint256_union, std::shared_ptr<rai::wallet>> items;
-	std::multimap<rai::uint128_t, std::function<void()>, std::greater<rai::uint128_t>> actions;
+	std::multimap<rai::uint128_t, rai::wallet_action, std::greater<rai::uint128_t>> actions;
+	// Accounts with an action running, their other actions wait so each account's blocks are built in queue order
+	std::unordered_set<rai::account> actions_active;
+	// Accounts from any wallet that have carried voting weight, so voting doesn't scan every wallet account
+	std::unordered_map<rai::account, rai::wallet_representative> representatives;
+	std::mutex representatives_mutex;
 	std::mutex mutex;
 	std::condition_variable condition;
 	rai::kdf kdf;
 	MDB_dbi handle;
 	MDB_dbi send_action_ids;
 	rai::node & node;
+	rai::work_cache work;
 	bool stopped;
-	std::thread thread;
-	static rai::uint128_t const generate_priority;
+	std::vector<std::thread> threads;
 	static rai::uint128_t const high_priority;
+	static size_t constexpr action_threads = 4;
 };
 }
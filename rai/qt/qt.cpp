@@ -108,7 +108,7 @@ wallet (wallet_a)
 
 void rai_qt::self_pane::refresh_balance ()
 {
-	rai::transaction transaction (wallet.node.store.environment, nullptr, false);
+	rai::transaction transaction (wallet.node.store.backend, nullptr, false);
 	std::vector<rai::account_info> infos;
 	auto error (wallet.node.store.accounts_get (transaction, wallet.account, infos));
 	std::string final_text ("");
@@ -619,7 +619,7 @@ public:
 
 void rai_qt::history::refresh ()
 {
-	rai::transaction transaction (ledger.store.environment, nullptr, false);
+	rai::transaction transaction (ledger.store.backend, nullptr, false);
 	model->removeRows (0, model->rowCount ());
 	std::vector<rai::account_info> infos;
 	ledger.store.accounts_get (transaction, account, infos);
@@ -678,7 +678,7 @@ wallet (wallet_a)
 		rai::block_hash hash_l;
 		if (!hash_l.decode_hex (hash->text ().toStdString ()))
 		{
-			rai::transaction transaction (this->wallet.node.store.environment, nullptr, false);
+			rai::transaction transaction (this->wallet.node.store.backend, nullptr, false);
 			auto block_l (this->wallet.node.store.block_get (transaction, hash_l));
 			if (block_l != nullptr)
 			{
@@ -703,7 +703,7 @@ wallet (wallet_a)
 		auto error (block.decode_hex (hash->text ().toStdString ()));
 		if (!error)
 		{
-			rai::transaction transaction (this->wallet.node.store.environment, nullptr, false);
+			rai::transaction transaction (this->wallet.node.store.backend, nullptr, false);
 			if (this->wallet.node.store.block_exists (transaction, block))
 			{
 				rebroadcast->setEnabled (false);
@@ -722,7 +722,7 @@ wallet (wallet_a)
 void rai_qt::block_viewer::rebroadcast_action (rai::uint256_union const & hash_a)
 {
 	auto done (true);
-	rai::transaction transaction (wallet.node.ledger.store.environment, nullptr, false);
+	rai::transaction transaction (wallet.node.ledger.store.backend, nullptr, false);
 	auto block (wallet.node.store.block_get (transaction, hash_a));
 	if (block != nullptr)
 	{
@@ -779,7 +779,7 @@ wallet (wallet_a)
 			show_line_ok (*account_line);
 			this->history.refresh ();
 			std::vector<rai::account_info> infos;
-			rai::transaction transaction (this->wallet.node.store.environment, nullptr, false);
+			rai::transaction transaction (this->wallet.node.store.backend, nullptr, false);
 			this->wallet.node.store.accounts_get (transaction, account, infos);
 			std::string final_text ("");
 			for (const auto & info : infos)
@@ -922,7 +922,7 @@ std::string rai_qt::status::text ()
 	size_t unchecked (0);
 	std::string count_string;
 	{
-		rai::transaction transaction (wallet.wallet_m->node.store.environment, nullptr, false);
+		rai::transaction transaction (wallet.wallet_m->node.store.backend, nullptr, false);
 		auto size (wallet.wallet_m->node.store.block_count (transaction));
 		unchecked = wallet.wallet_m->node.store.unchecked_count (transaction);
 		count_string = std::to_string (size.sum ());
@@ -1085,7 +1085,7 @@ wallet (wallet_a)
 					contents << stream.rdbuf ();
 					const auto abi = rai::hex_string_to_stream (contents.str ());
 
-					rai::transaction transaction (this->wallet.wallet_m->node.store.environment, nullptr, true);
+					rai::transaction transaction (this->wallet.wallet_m->node.store.backend, nullptr, true);
 					rai::raw_key key;
 					if (!wallet.wallet_m->store.fetch (transaction, sc_owner_account, key))
 					{
@@ -1314,7 +1314,7 @@ void rai_qt::wallet::start ()
 
 					if (!parse_error)
 					{
-						rai::transaction transaction (this_l->node.store.environment, nullptr, false);
+						rai::transaction transaction (this_l->node.store.backend, nullptr, false);
 						auto balance (this_l->wallet_m->node.ledger.account_balance (transaction, this_l->account, token_type));
 						if (actual <= balance)
 						{
@@ -1484,7 +1484,7 @@ void rai_qt::wallet::start ()
 			this_l->application.postEvent (&this_l->processor, new eventloop_event ([this_w, account_a]() {
 				if (auto this_l = this_w.lock ())
 				{
-					rai::transaction transaction (this_l->wallet_m->node.store.environment, nullptr, false);
+					rai::transaction transaction (this_l->wallet_m->node.store.backend, nullptr, false);
 					rai::account_info info;
 					auto error (this_l->wallet_m->node.store.account_get (transaction, account_a, info));
 					if (!error)
@@ -1725,6 +1725,7 @@ wallet (wallet_a)
 				if (new_password->text () == retype_password->text ())
 				{
 					this->wallet.wallet_m->store.rekey (transaction, std::string (new_password->text ().toLocal8Bit ()));
+					this->wallet.node.wallets.representative_keys_clear (*this->wallet.wallet_m);
 					new_password->clear ();
 					retype_password->clear ();
 					retype_password->setPlaceholderText ("Retype password");
@@ -1820,6 +1821,7 @@ wallet (wallet_a)
 			rai::raw_key empty;
 			empty.data.clear ();
 			this->wallet.wallet_m->store.password.value_set (empty);
+			this->wallet.node.wallets.representative_keys_clear (*this->wallet.wallet_m);
 			update_locked (true, true);
 			lock_toggle->setText ("Unlock");
 			password->setEnabled (1);
@@ -1872,7 +1874,7 @@ wallet (wallet_a)
 
 void rai_qt::settings::refresh_representative ()
 {
-	rai::transaction transaction (this->wallet.wallet_m->node.store.environment, nullptr, false);
+	rai::transaction transaction (this->wallet.wallet_m->node.store.backend, nullptr, false);
 	rai::account_info info;
 	auto error (this->wallet.wallet_m->node.store.account_get (transaction, this->wallet.account, info));
 	if (!error)
@@ -2082,7 +2084,7 @@ void rai_qt::advanced_actions::refresh_peers ()
 void rai_qt::advanced_actions::refresh_ledger ()
 {
 	ledger_model->removeRows (0, ledger_model->rowCount ());
-	rai::transaction transaction (wallet.node.store.environment, nullptr, false);
+	rai::transaction transaction (wallet.node.store.backend, nullptr, false);
 	for (auto i (wallet.node.ledger.store.latest_begin (transaction)), j (wallet.node.ledger.store.latest_end ()); i != j; ++i)
 	{
 		QList<QStandardItem *> items;
@@ -2334,7 +2336,7 @@ void rai_qt::block_creation::create_send ()
 			error = destination_l.decode_account (destination->text ().toStdString ());
 			if (!error)
 			{
-				rai::transaction transaction (wallet.node.store.environment, nullptr, false);
+				rai::transaction transaction (wallet.node.store.backend, nullptr, false);
 				rai::raw_key key;
 				if (!wallet.wallet_m->store.fetch (transaction, account_l, key))
 				{
@@ -2389,7 +2391,7 @@ void rai_qt::block_creation::create_receive ()
 	auto error (source_l.decode_hex (source->text ().toStdString ()));
 	if (!error)
 	{
-		rai::transaction transaction (wallet.node.store.environment, nullptr, false);
+		rai::transaction transaction (wallet.node.store.backend, nullptr, false);
 		auto block_l (wallet.node.store.block_get (transaction, source_l));
 		if (block_l != nullptr)
 		{
@@ -2463,7 +2465,7 @@ void rai_qt::block_creation::create_change ()
 		error = representative_l.decode_account (representative->text ().toStdString ());
 		if (!error)
 		{
-			rai::transaction transaction (wallet.node.store.environment, nullptr, false);
+			rai::transaction transaction (wallet.node.store.backend, nullptr, false);
 			rai::account_info info;
 			auto error (wallet.node.store.account_get (transaction, account_l, info));
 			if (!error)
@@ -2515,7 +2517,7 @@ void rai_qt::block_creation::create_open ()
 		error = representative_l.decode_account (representative->text ().toStdString ());
 		if (!error)
 		{
-			rai::transaction transaction (wallet.node.store.environment, nullptr, false);
+			rai::transaction transaction (wallet.node.store.backend, nullptr, false);
 			auto block_l (wallet.node.store.block_get (transaction, source_l));
 			if (block_l != nullptr)
 			{
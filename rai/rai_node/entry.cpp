@@ -1,6 +1,10 @@
+#include <rai/memory_backend.hpp>
+#include <rai/node/json.hpp>
 #include <rai/node/node.hpp>
 #include <rai/node/testing.hpp>
 #include <rai/rai_node/daemon.hpp>
+#include <rai/snapshot.hpp>
+#include <rai/validator.hpp>
 
 #include <argon2.h>
 
@@ -25,6 +29,7 @@ int main (int argc, char * const * argv)
 		("sc_owner_account_key",boost::program_options::value<std::string> (), "sc owner account for smart contract block")
 		("abi",boost::program_options::value<std::string> (), "smart contract block abi")
 		("debug_dump_representatives", "List representatives and weights")
+		("debug_validate_ledger", "Cross check balances, chain heads, heights, frontiers, pending entries and representative weights, <threads> partitions the accounts")
 		("debug_account_count", "Display the number of accounts")
 		("debug_mass_activity", "Generates fake debug activity")
 		("debug_profile_generate", "Profile work generation")
@@ -33,9 +38,22 @@ int main (int argc, char * const * argv)
 		("debug_profile_kdf", "Profile kdf function")
 		("debug_verify_profile", "Profile signature verification")
 		("debug_profile_sign", "Profile signature generation")
+		("debug_profile_tally", "Profile election tallying, full recount against running totals")
+		("debug_profile_peers", "Profile peer table updates and fanout queries made per received message")
+		("debug_profile_serialize", "Profile publish serialization for each block type, vector streams against pooled buffers")
+		("debug_profile_votes", "Profile confirm_req handling with a 100k account wallet holding one representative")
+		("debug_profile_rpc", "Profile RPC requests/s with a connection per request against kept alive and pipelined connections")
+		("debug_profile_json", "Profile writing and reading a ledger RPC sized response, ptree and write_json/read_json against rai::json_writer/json_read")
+		("debug_profile_delegators", "Profile delegators and delegators_count RPCs on a 100k account ledger against a full accounts scan")
+		("debug_profile_history", "Profile account_history pages at increasing offsets into a 100k block chain with and without the history index")
+		("debug_profile_snapshot", "Profile ledger snapshot export and import against bootstrapping the same ledger from a peer")
+		("debug_profile_bulk_load", "Profile loading 1m random keyed block_info entries with mdb_put against rai::bulk_load, time and resulting pages")
+		("debug_profile_store_backend", "Profile block_put, block_get and a full blocks scan of 100k state blocks on the LMDB and in memory store backends")
+		("debug_profile_pruning", "Profile pruning a generated ledger of confirmed state chains, time and disk and table page savings")
+		("debug_profile_lmdb", "Profile random account reads and small write transactions under each lmdb config preset, on a copy of <data_path>/data.ldb when present")
 		("platform", boost::program_options::value<std::string> (), "Defines the <platform> for OpenCL commands")
 		("device", boost::program_options::value<std::string> (), "Defines <device> for OpenCL command")
-		("threads", boost::program_options::value<std::string> (), "Defines <threads> count for OpenCL command");
+		("threads", boost::program_options::value<std::string> (), "Defines <threads> count for OpenCL and ledger validation commands");
 	// clang-format on
 
 	boost::program_options::variables_map vm;
@@ -54,7 +72,7 @@ int main (int argc, char * const * argv)
 	else if (vm.count ("debug_block_count"))
 	{
 		rai::inactive_node node (data_path);
-		rai::transaction transaction (node.node->store.environment, nullptr, false);
+		rai::transaction transaction (node.node->store.backend, nullptr, false);
 		std::cout << boost::str (boost::format ("Block count: %1%\n") % node.node->store.block_count (transaction).sum ());
 	}
 	else if (vm.count ("debug_bootstrap_generate"))
@@ -149,7 +167,7 @@ int main (int argc, char * const * argv)
 	else if (vm.count ("debug_dump_representatives"))
 	{
 		rai::inactive_node node (data_path);
-		rai::transaction transaction (node.node->store.environment, nullptr, false);
+		rai::transaction transaction (node.node->store.backend, nullptr, false);
 		rai::uint128_t total;
 		for (auto i (node.node->store.representation_begin (transaction)), n (node.node->store.representation_end ()); i != n; ++i)
 		{
@@ -173,10 +191,40 @@ int main (int argc, char * const * argv)
 			std::cout << boost::str (boost::format ("%1% %2% %3%\n") % i->first.to_account () % i->second.convert_to<std::string> () % total.convert_to<std::string> ());
 		}
 	}
+	else if (vm.count ("debug_validate_ledger"))
+	{
+		auto threads (std::max (1u, std::thread::hardware_concurrency ()));
+		if (vm.count ("threads") == 1)
+		{
+			try
+			{
+				threads = boost::lexical_cast<unsigned> (vm["threads"].as<std::string> ());
+			}
+			catch (boost::bad_lexical_cast & e)
+			{
+				std::cerr << "Invalid threads count\n";
+				result = -1;
+			}
+		}
+		if (result == 0)
+		{
+			rai::inactive_node node (data_path);
+			rai::ledger_validator validator (node.node->ledger);
+			auto begin (std::chrono::steady_clock::now ());
+			auto error (validator.validate (threads));
+			auto end (std::chrono::steady_clock::now ());
+			for (auto & i : validator.errors)
+			{
+				std::cerr << i << '\n';
+			}
+			std::cout << boost::str (boost::format ("%1% token accounts, %2% blocks and %3% pending entries checked by %4% threads in %5%ms, %6% mismatches\n") % validator.accounts % validator.blocks % validator.pending % threads % std::chrono::duration_cast<std::chrono::milliseconds> (end - begin).count () % validator.errors_total);
+			result = error ? -1 : 0;
+		}
+	}
 	else if (vm.count ("debug_account_count"))
 	{
 		rai::inactive_node node (data_path);
-		rai::transaction transaction (node.node->store.environment, nullptr, false);
+		rai::transaction transaction (node.node->store.backend, nullptr, false);
 		std::cout << boost::str (boost::format ("Frontier count: %1%\n") % node.node->store.account_count (transaction));
 	}
 	else if (vm.count ("debug_mass_activity"))
@@ -353,6 +401,755 @@ int main (int argc, char * const * argv)
 			std::cerr << boost::str (boost::format ("%|1$ 12d|\n") % std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count ());
 		}
 	}
+	else if (vm.count ("debug_profile_tally"))
+	{
+		size_t const rep_count (500);
+		size_t const vote_count (100000);
+		rai::keypair key;
+		auto block1 (std::make_shared<rai::send_block> (0, key.pub, 1, key.prv, key.pub, 0));
+		auto block2 (std::make_shared<rai::send_block> (0, key.pub, 2, key.prv, key.pub, 0));
+		std::vector<std::shared_ptr<rai::vote>> reps;
+		std::unordered_map<rai::account, rai::uint128_t> weights;
+		rai::votes votes (block1);
+		for (size_t i (0); i < rep_count; ++i)
+		{
+			auto vote (std::make_shared<rai::vote> ());
+			vote->account = rai::keypair ().pub;
+			vote->block = block1;
+			vote->sequence = 0;
+			weights[vote->account] = rai::Gqlc_ratio * (i + 1);
+			votes.vote (vote, weights[vote->account]);
+			reps.push_back (vote);
+		}
+		std::cerr << boost::str (boost::format ("Starting tally profiling with %1% representatives\n") % rep_count);
+		for (uint64_t i (0); true; ++i)
+		{
+			rai::uint128_t full (0);
+			auto begin1 (std::chrono::high_resolution_clock::now ());
+			for (size_t j (0); j < vote_count; ++j)
+			{
+				auto & vote (reps[j % rep_count]);
+				vote->block = vote->block == block1 ? block2 : block1;
+				votes.rep_votes[vote->account] = vote->block;
+				// Same work as ledger::tally, with weights looked up from memory instead of the store
+				std::unordered_map<std::shared_ptr<rai::block>, rai::uint128_t, rai::shared_ptr_block_hash, rai::shared_ptr_block_hash> totals;
+				for (auto & k : votes.rep_votes)
+				{
+					totals[k.second] += weights[k.first];
+				}
+				rai::tally_t tally;
+				for (auto & k : totals)
+				{
+					tally[k.second] = k.first;
+				}
+				full += tally.begin ()->first;
+			}
+			auto end1 (std::chrono::high_resolution_clock::now ());
+			rai::votes running (block1);
+			for (auto & vote : reps)
+			{
+				running.vote (vote, weights[vote->account]);
+			}
+			rai::uint128_t incremental (0);
+			auto begin2 (std::chrono::high_resolution_clock::now ());
+			for (size_t j (0); j < vote_count; ++j)
+			{
+				auto & vote (reps[j % rep_count]);
+				vote->block = vote->block == block1 ? block2 : block1;
+				running.vote (vote, weights[vote->account]);
+				incremental += running.top ().first;
+			}
+			auto end2 (std::chrono::high_resolution_clock::now ());
+			std::cerr << boost::str (boost::format ("Full recount: %|1$ 12d|us incremental: %|2$ 12d|us for %3% votes\n") % std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count () % std::chrono::duration_cast<std::chrono::microseconds> (end2 - begin2).count () % vote_count);
+		}
+	}
+	else if (vm.count ("debug_profile_peers"))
+	{
+		size_t const peer_count (1000);
+		size_t const message_count (1000000);
+		auto thread_count (std::max (8u, std::thread::hardware_concurrency ()));
+		rai::peer_container peers (rai::endpoint (boost::asio::ip::address_v6::loopback (), 1));
+		std::vector<rai::endpoint> endpoints;
+		for (size_t i (0); i < peer_count; ++i)
+		{
+			endpoints.push_back (rai::endpoint (boost::asio::ip::address_v6::loopback (), 10000 + i));
+			peers.insert (endpoints.back (), rai::protocol_version);
+			peers.rep_response (endpoints.back (), rai::keypair ().pub, rai::amount (i));
+		}
+		std::cerr << boost::str (boost::format ("Starting peer profiling with %1% peers on %2% threads\n") % peer_count % thread_count);
+		for (uint64_t i (0); true; ++i)
+		{
+			auto begin1 (std::chrono::high_resolution_clock::now ());
+			std::vector<std::thread> threads;
+			for (auto j (0u); j < thread_count; ++j)
+			{
+				threads.push_back (std::thread ([&peers, &endpoints, j, message_count, thread_count]() {
+					// Same peer table calls network_message_visitor makes, a publish fanning out every fourth message
+					for (size_t k (j); k < message_count; k += thread_count)
+					{
+						auto & endpoint (endpoints[k % endpoints.size ()]);
+						peers.contacted (endpoint, rai::protocol_version);
+						peers.insert (endpoint, rai::protocol_version);
+						if (k % 4 == 0)
+						{
+							peers.list_fanout ();
+						}
+						else if (k % 4 == 1)
+						{
+							peers.representatives (std::numeric_limits<size_t>::max ());
+						}
+					}
+				}));
+			}
+			for (auto & thread : threads)
+			{
+				thread.join ();
+			}
+			auto end1 (std::chrono::high_resolution_clock::now ());
+			auto us (std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count ());
+			std::cerr << boost::str (boost::format ("%|1$ 12d| messages/s\n") % (message_count * 1000000 / std::max<int64_t> (us, 1)));
+		}
+	}
+	else if (vm.count ("debug_profile_serialize"))
+	{
+		size_t const message_count (1000000);
+		rai::keypair key;
+		std::vector<std::pair<std::string, std::shared_ptr<rai::block>>> blocks;
+		blocks.push_back (std::make_pair ("send", std::make_shared<rai::send_block> (1, key.pub, 2, key.prv, key.pub, 3)));
+		blocks.push_back (std::make_pair ("receive", std::make_shared<rai::receive_block> (1, 2, key.prv, key.pub, 3)));
+		blocks.push_back (std::make_pair ("open", std::make_shared<rai::open_block> (1, key.pub, key.pub, key.prv, key.pub, 3)));
+		blocks.push_back (std::make_pair ("change", std::make_shared<rai::change_block> (1, key.pub, key.prv, key.pub, 3)));
+		blocks.push_back (std::make_pair ("state", std::make_shared<rai::state_block> (key.pub, 1, key.pub, 2, 3, rai::chain_token_type, key.prv, key.pub, 4)));
+		std::cerr << "Starting serialization profiling\n";
+		for (uint64_t i (0); true; ++i)
+		{
+			for (auto & block : blocks)
+			{
+				rai::publish message (block.second);
+				size_t bytes1 (0);
+				auto begin1 (std::chrono::high_resolution_clock::now ());
+				for (size_t j (0); j < message_count; ++j)
+				{
+					std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
+					{
+						rai::vectorstream stream (*bytes);
+						message.serialize (stream);
+					}
+					bytes1 += bytes->size ();
+				}
+				auto end1 (std::chrono::high_resolution_clock::now ());
+				size_t bytes2 (0);
+				auto begin2 (std::chrono::high_resolution_clock::now ());
+				for (size_t j (0); j < message_count; ++j)
+				{
+					auto bytes (rai::message_buffers ().serialize (message));
+					bytes2 += bytes->size ();
+				}
+				auto end2 (std::chrono::high_resolution_clock::now ());
+				assert (bytes1 == bytes2);
+				auto us1 (std::max<int64_t> (1, std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count ()));
+				auto us2 (std::max<int64_t> (1, std::chrono::duration_cast<std::chrono::microseconds> (end2 - begin2).count ()));
+				std::cerr << boost::str (boost::format ("%|1$-8| vector: %|2$ 10d| msg/s pooled: %|3$ 10d| msg/s\n") % block.first % (message_count * 1000000 / us1) % (message_count * 1000000 / us2));
+			}
+		}
+	}
+	else if (vm.count ("debug_profile_votes"))
+	{
+		size_t const account_count (100000);
+		size_t const request_count (1000);
+		rai::system system (24000, 1);
+		auto & node (*system.nodes[0]);
+		auto wallet (system.wallet (0));
+		wallet->insert_adhoc (rai::test_genesis_key.prv);
+		std::shared_ptr<rai::block> block;
+		{
+			rai::transaction transaction (node.store.backend, nullptr, true);
+			for (size_t i (0); i < account_count; ++i)
+			{
+				wallet->store.deterministic_insert (transaction);
+			}
+			block = node.store.block_get (transaction, node.ledger.latest (transaction, rai::test_genesis_key.pub));
+		}
+		rai::confirm_req message (block);
+		rai::endpoint endpoint (boost::asio::ip::address_v6::loopback (), 10000);
+		std::cerr << boost::str (boost::format ("Starting vote profiling with %1% wallet accounts\n") % account_count);
+		for (uint64_t i (0); true; ++i)
+		{
+			auto begin1 (std::chrono::high_resolution_clock::now ());
+			{
+				// One full wallet scan, what every vote used to cost
+				rai::transaction transaction (node.store.backend, nullptr, false);
+				node.wallets.compute_representatives (transaction);
+			}
+			auto end1 (std::chrono::high_resolution_clock::now ());
+			for (size_t j (0); j < request_count; ++j)
+			{
+				node.process_message (message, endpoint);
+			}
+			auto end2 (std::chrono::high_resolution_clock::now ());
+			std::cerr << boost::str (boost::format ("Wallet scan: %|1$ 12d|us %2% confirm_req: %|3$ 12d|us\n") % std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count () % request_count % std::chrono::duration_cast<std::chrono::microseconds> (end2 - end1).count ());
+		}
+	}
+	else if (vm.count ("debug_profile_rpc"))
+	{
+		size_t const request_count (10000);
+		size_t const pipeline_depth (16);
+		rai::system system (24000, 1);
+		rai::rpc_config config (true);
+		config.keepalive_request_limit = std::numeric_limits<uint64_t>::max ();
+		rai::rpc rpc (system.service, *system.nodes[0], config);
+		rpc.start ();
+		boost::asio::io_service::work work (system.service);
+		std::vector<std::thread> runners;
+		for (auto i (0u); i < std::max (4u, std::thread::hardware_concurrency ()); ++i)
+		{
+			runners.push_back (std::thread ([&system]() { system.service.run (); }));
+		}
+		boost::asio::io_service client_service;
+		rai::tcp_endpoint endpoint (boost::asio::ip::address_v6::loopback (), config.port);
+		boost::beast::http::request<boost::beast::http::string_body> request (boost::beast::http::verb::post, "/", 11);
+		request.body () = "{\"action\": \"block_count\"}";
+		request.prepare_payload ();
+		// Sends request_count requests with up to depth_a written ahead of the responses read, on connections serving per_connection_a requests each
+		auto profile ([&client_service, &endpoint, &request, request_count](size_t per_connection_a, size_t depth_a) {
+			auto begin (std::chrono::high_resolution_clock::now ());
+			for (size_t sent (0); sent < request_count;)
+			{
+				boost::asio::ip::tcp::socket socket (client_service);
+				socket.connect (endpoint);
+				boost::beast::flat_buffer buffer;
+				auto connection_end (std::min (request_count, sent + per_connection_a));
+				size_t received (sent);
+				while (received < connection_end)
+				{
+					for (; sent < connection_end && sent - received < depth_a; ++sent)
+					{
+						request.keep_alive (sent + 1 < connection_end);
+						boost::beast::http::write (socket, request);
+					}
+					boost::beast::http::response<boost::beast::http::string_body> response;
+					boost::beast::http::read (socket, buffer, response);
+					++received;
+				}
+			}
+			auto us (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::high_resolution_clock::now () - begin).count ());
+			return request_count * 1000000 / std::max<int64_t> (us, 1);
+		});
+		std::cerr << boost::str (boost::format ("Starting RPC profiling with %1% requests per run\n") % request_count);
+		for (uint64_t i (0); true; ++i)
+		{
+			auto close (profile (1, 1));
+			auto keepalive (profile (request_count, 1));
+			auto pipelined (profile (request_count, pipeline_depth));
+			std::cerr << boost::str (boost::format ("Connection per request: %|1$ 8d| req/s keep-alive: %|2$ 8d| req/s pipelined: %|3$ 8d| req/s\n") % close % keepalive % pipelined);
+		}
+	}
+	else if (vm.count ("debug_profile_json"))
+	{
+		size_t const account_count (100000);
+		std::vector<std::pair<rai::account, rai::account_info>> accounts;
+		for (size_t i (0); i < account_count; ++i)
+		{
+			rai::account account (i + 1);
+			rai::account_info info;
+			info.head = rai::block_hash (i * 3 + 1);
+			info.rep_block = rai::block_hash (i * 3 + 2);
+			info.open_block = rai::block_hash (i * 3 + 3);
+			info.balance = rai::uint128_t (i) * rai::Mqlc_ratio;
+			info.modified = 1500000000 + i;
+			info.block_count = i % 100 + 1;
+			accounts.push_back (std::make_pair (account, info));
+		}
+		// Same members the ledger RPC writes for each account
+		auto fields ([](rai::account_info const & info_a, std::function<void(std::string const &, std::string const &)> const & put_a) {
+			put_a ("frontier", info_a.head.to_string ());
+			put_a ("open_block", info_a.open_block.to_string ());
+			put_a ("representative_block", info_a.rep_block.to_string ());
+			std::string balance;
+			rai::uint128_union (info_a.balance).encode_dec (balance);
+			put_a ("balance", balance);
+			put_a ("modified_timestamp", std::to_string (info_a.modified));
+			put_a ("block_count", std::to_string (info_a.block_count));
+		});
+		auto make_tree ([&accounts, &fields]() {
+			boost::property_tree::ptree response_l;
+			boost::property_tree::ptree accounts_l;
+			for (auto & i : accounts)
+			{
+				boost::property_tree::ptree entry;
+				fields (i.second, [&entry](std::string const & key_a, std::string const & value_a) { entry.put (key_a, value_a); });
+				accounts_l.push_back (std::make_pair (i.first.to_account (), entry));
+			}
+			response_l.add_child ("accounts", accounts_l);
+			return response_l;
+		});
+		std::cerr << boost::str (boost::format ("Starting JSON profiling with %1% accounts\n") % account_count);
+		for (uint64_t i (0); true; ++i)
+		{
+			auto begin1 (std::chrono::high_resolution_clock::now ());
+			std::string text1;
+			{
+				auto tree (make_tree ());
+				std::stringstream stream;
+				boost::property_tree::write_json (stream, tree);
+				text1 = stream.str ();
+			}
+			auto end1 (std::chrono::high_resolution_clock::now ());
+			auto text2 (rai::json_write (make_tree ()));
+			auto end2 (std::chrono::high_resolution_clock::now ());
+			std::string text3;
+			{
+				rai::json_writer writer;
+				writer.begin_object ("accounts");
+				for (auto & i : accounts)
+				{
+					writer.begin_object (i.first.to_account ());
+					fields (i.second, [&writer](std::string const & key_a, std::string const & value_a) { writer.value (key_a, value_a); });
+					writer.end ();
+				}
+				writer.end ();
+				text3 = writer.finish ();
+			}
+			auto end3 (std::chrono::high_resolution_clock::now ());
+			assert (text1 == text2 && text1 == text3);
+			{
+				boost::property_tree::ptree tree;
+				std::stringstream stream (text1);
+				boost::property_tree::read_json (stream, tree);
+			}
+			auto end4 (std::chrono::high_resolution_clock::now ());
+			{
+				boost::property_tree::ptree tree;
+				rai::json_read (text1, tree);
+			}
+			auto end5 (std::chrono::high_resolution_clock::now ());
+			std::cerr << boost::str (boost::format ("%1% bytes write_json: %|2$ 8d|us json_write: %|3$ 8d|us json_writer: %|4$ 8d|us read_json: %|5$ 8d|us json_read: %|6$ 8d|us\n") % text1.size () % std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count () % std::chrono::duration_cast<std::chrono::microseconds> (end2 - end1).count () % std::chrono::duration_cast<std::chrono::microseconds> (end3 - end2).count () % std::chrono::duration_cast<std::chrono::microseconds> (end4 - end3).count () % std::chrono::duration_cast<std::chrono::microseconds> (end5 - end4).count ());
+		}
+	}
+	else if (vm.count ("debug_profile_delegators"))
+	{
+		size_t const account_count (100000);
+		size_t const representative_count (100);
+		rai::system system (24000, 1);
+		auto & node (*system.nodes[0]);
+		rai::keypair key;
+		std::vector<rai::account> representatives;
+		for (size_t i (0); i < representative_count; ++i)
+		{
+			representatives.push_back (rai::keypair ().pub);
+		}
+		{
+			rai::transaction transaction (node.store.backend, nullptr, true);
+			for (size_t i (0); i < account_count; ++i)
+			{
+				rai::account account (i + 1);
+				rai::open_block open (i + 1, representatives[i % representative_count], account, key.prv, key.pub, 0);
+				auto hash (open.hash ());
+				node.store.block_put (transaction, hash, open);
+				node.store.account_put (transaction, hash, rai::account_info (hash, hash, hash, rai::amount (i), 0, 1, rai::chain_token_type, account));
+			}
+		}
+		rai::rpc_config config (true);
+		rai::rpc rpc (system.service, node, config);
+		rpc.start ();
+		boost::asio::io_service::work work (system.service);
+		std::vector<std::thread> runners;
+		for (auto i (0u); i < std::max (4u, std::thread::hardware_concurrency ()); ++i)
+		{
+			runners.push_back (std::thread ([&system]() { system.service.run (); }));
+		}
+		boost::asio::io_service client_service;
+		rai::tcp_endpoint endpoint (boost::asio::ip::address_v6::loopback (), config.port);
+		auto post ([&client_service, &endpoint](std::string const & body_a) {
+			boost::asio::ip::tcp::socket socket (client_service);
+			socket.connect (endpoint);
+			boost::beast::http::request<boost::beast::http::string_body> request (boost::beast::http::verb::post, "/", 11);
+			request.body () = body_a;
+			request.prepare_payload ();
+			boost::beast::http::write (socket, request);
+			boost::beast::flat_buffer buffer;
+			boost::beast::http::response<boost::beast::http::string_body> response;
+			boost::beast::http::read (socket, buffer, response);
+			return response.body ().size ();
+		});
+		auto representative (representatives[0].to_account ());
+		std::cerr << boost::str (boost::format ("Starting delegators profiling with %1% accounts and %2% representatives\n") % account_count % representative_count);
+		for (uint64_t i (0); true; ++i)
+		{
+			auto begin1 (std::chrono::high_resolution_clock::now ());
+			uint64_t scanned (0);
+			{
+				// What both actions cost before the representative index
+				rai::transaction transaction (node.store.backend, nullptr, false);
+				for (auto j (node.store.latest_begin (transaction)), n (node.store.latest_end ()); j != n; ++j)
+				{
+					rai::account_info info (j->second);
+					auto block (node.store.block_get (transaction, info.rep_block));
+					if (block != nullptr && block->representative () == representatives[0])
+					{
+						++scanned;
+					}
+				}
+			}
+			auto end1 (std::chrono::high_resolution_clock::now ());
+			auto size (post (boost::str (boost::format ("{\"action\": \"delegators\", \"account\": \"%1%\"}") % representative)));
+			auto end2 (std::chrono::high_resolution_clock::now ());
+			post (boost::str (boost::format ("{\"action\": \"delegators_count\", \"account\": \"%1%\"}") % representative));
+			auto end3 (std::chrono::high_resolution_clock::now ());
+			std::cerr << boost::str (boost::format ("%1% delegators full scan: %|2$ 10d|us delegators: %|3$ 10d|us (%4% bytes) delegators_count: %|5$ 10d|us\n") % scanned % std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count () % std::chrono::duration_cast<std::chrono::microseconds> (end2 - end1).count () % size % std::chrono::duration_cast<std::chrono::microseconds> (end3 - end2).count ());
+		}
+	}
+	else if (vm.count ("debug_profile_history"))
+	{
+		uint64_t const block_count (100000);
+		rai::system system (24000, 1);
+		auto & node (*system.nodes[0]);
+		rai::keypair key;
+		rai::block_hash head;
+		{
+			rai::transaction transaction (node.store.backend, nullptr, true);
+			node.store.history_build (transaction);
+			node.ledger.history_index = true;
+			rai::open_block open (1, key.pub, key.pub, key.prv, key.pub, 0);
+			head = open.hash ();
+			node.store.block_put (transaction, head, open);
+			node.ledger.change_latest (transaction, key.pub, rai::chain_token_type, head, head, 0, 1);
+			for (uint64_t i (2); i <= block_count; ++i)
+			{
+				rai::change_block change (head, key.pub, key.prv, key.pub, 0);
+				head = change.hash ();
+				node.store.block_put (transaction, head, change);
+				node.ledger.change_latest (transaction, key.pub, rai::chain_token_type, head, head, 0, i);
+			}
+		}
+		rai::rpc_config config (true);
+		rai::rpc rpc (system.service, node, config);
+		rpc.start ();
+		boost::asio::io_service::work work (system.service);
+		std::vector<std::thread> runners;
+		for (auto i (0u); i < std::max (4u, std::thread::hardware_concurrency ()); ++i)
+		{
+			runners.push_back (std::thread ([&system]() { system.service.run (); }));
+		}
+		boost::asio::io_service client_service;
+		rai::tcp_endpoint endpoint (boost::asio::ip::address_v6::loopback (), config.port);
+		auto page ([&client_service, &endpoint, &head](uint64_t offset_a) {
+			auto begin (std::chrono::high_resolution_clock::now ());
+			boost::asio::ip::tcp::socket socket (client_service);
+			socket.connect (endpoint);
+			boost::beast::http::request<boost::beast::http::string_body> request (boost::beast::http::verb::post, "/", 11);
+			request.body () = boost::str (boost::format ("{\"action\": \"account_history\", \"token\": \"Root_Token\", \"head\": \"%1%\", \"count\": \"10\", \"offset\": \"%2%\", \"raw\": \"true\"}") % head.to_string () % offset_a);
+			request.prepare_payload ();
+			boost::beast::http::write (socket, request);
+			boost::beast::flat_buffer buffer;
+			boost::beast::http::response<boost::beast::http::string_body> response;
+			boost::beast::http::read (socket, buffer, response);
+			return std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::high_resolution_clock::now () - begin).count ();
+		});
+		std::cerr << boost::str (boost::format ("Starting history profiling with %1% blocks, 10 entries per page\n") % block_count);
+		for (uint64_t i (0); true; ++i)
+		{
+			for (uint64_t offset (10); offset < block_count; offset *= 10)
+			{
+				node.ledger.history_index = false;
+				auto walked (page (offset));
+				node.ledger.history_index = true;
+				auto indexed (page (offset));
+				std::cerr << boost::str (boost::format ("Offset %|1$ 8d| walked: %|2$ 10d|us indexed: %|3$ 10d|us\n") % offset % walked % indexed);
+			}
+		}
+	}
+	else if (vm.count ("debug_profile_snapshot"))
+	{
+		uint32_t const activity_count (10000);
+		rai::system system (24000, 1);
+		auto & node (*system.nodes[0]);
+		system.generate_mass_activity (activity_count, node);
+		uint64_t block_count (0);
+		{
+			rai::transaction transaction (node.store.backend, nullptr, false);
+			block_count = node.store.block_count (transaction).sum ();
+		}
+		std::cerr << boost::str (boost::format ("Starting snapshot profiling with %1% blocks\n") % block_count);
+		for (uint64_t i (0); true; ++i)
+		{
+			auto begin1 (std::chrono::high_resolution_clock::now ());
+			std::stringstream stream;
+			{
+				rai::transaction transaction (node.store.backend, nullptr, false);
+				rai::ledger_snapshot snapshot (node.store);
+				auto error (snapshot.write (transaction, stream));
+				assert (!error);
+			}
+			auto end1 (std::chrono::high_resolution_clock::now ());
+			{
+				auto error (false);
+				rai::block_store store (error, rai::unique_path ());
+				assert (!error);
+				rai::ledger_snapshot snapshot (store);
+				error = snapshot.read (stream);
+				assert (!error);
+			}
+			auto end2 (std::chrono::high_resolution_clock::now ());
+			rai::node_init init1;
+			auto node1 (std::make_shared<rai::node> (init1, system.service, 24001 + i % 1000, rai::unique_path (), system.alarm, system.logging, system.work));
+			node1->bootstrap_initiator.bootstrap (node.network.endpoint ());
+			for (auto done (false); !done;)
+			{
+				system.poll ();
+				rai::transaction transaction (node1->store.backend, nullptr, false);
+				done = node1->store.block_count (transaction).sum () >= block_count;
+			}
+			auto end3 (std::chrono::high_resolution_clock::now ());
+			node1->stop ();
+			std::cerr << boost::str (boost::format ("%1% bytes export: %|2$ 10d|us import: %|3$ 10d|us bootstrap: %|4$ 10d|us\n") % stream.str ().size () % std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count () % std::chrono::duration_cast<std::chrono::microseconds> (end2 - end1).count () % std::chrono::duration_cast<std::chrono::microseconds> (end3 - end2).count ());
+		}
+	}
+	else if (vm.count ("debug_profile_bulk_load"))
+	{
+		size_t const entry_count (1000000);
+		std::vector<rai::block_hash> hashes (entry_count);
+		for (auto & hash : hashes)
+		{
+			rai::random_pool.GenerateBlock (hash.bytes.data (), hash.bytes.size ());
+		}
+		// Loads every entry in to a fresh store's blocks_info, returns microseconds taken and the table's page count
+		auto profile ([&hashes](bool bulk_a) {
+			auto error (false);
+			rai::block_store store (error, rai::unique_path ());
+			assert (!error);
+			auto begin (std::chrono::high_resolution_clock::now ());
+			MDB_stat stats;
+			{
+				rai::transaction transaction (store.backend, nullptr, true);
+				{
+					rai::bulk_load bulk (store.backend, transaction);
+					for (size_t i (0); i < hashes.size (); ++i)
+					{
+						rai::block_info info (hashes[i], rai::amount (i));
+						if (bulk_a)
+						{
+							bulk.put (store.blocks_info, rai::mdb_val (hashes[i]), info.val ());
+						}
+						else
+						{
+							store.block_info_put (transaction, hashes[i], info);
+						}
+					}
+				}
+				mdb_stat (transaction, store.blocks_info, &stats);
+			}
+			auto us (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::high_resolution_clock::now () - begin).count ());
+			return std::make_pair (us, stats.ms_branch_pages + stats.ms_leaf_pages);
+		});
+		std::cerr << boost::str (boost::format ("Starting bulk load profiling with %1% entries\n") % entry_count);
+		for (uint64_t i (0); true; ++i)
+		{
+			auto put (profile (false));
+			auto bulk (profile (true));
+			std::cerr << boost::str (boost::format ("mdb_put: %|1$ 10d|us %|2$ 8d| pages bulk_load: %|3$ 10d|us %|4$ 8d| pages\n") % put.first % put.second % bulk.first % bulk.second);
+		}
+	}
+	else if (vm.count ("debug_profile_store_backend"))
+	{
+		size_t const block_count (100000);
+		rai::keypair key;
+		std::vector<std::unique_ptr<rai::state_block>> blocks;
+		for (size_t i (0); i < block_count; ++i)
+		{
+			blocks.push_back (std::unique_ptr<rai::state_block> (new rai::state_block (key.pub, i == 0 ? 0 : blocks.back ()->hash (), key.pub, i, 0, rai::chain_token_type, key.prv, key.pub, 0)));
+		}
+		// Microseconds to write, read back and scan every block
+		auto profile ([&blocks](rai::block_store & store_a) {
+			std::array<uint64_t, 3> result;
+			auto begin (std::chrono::high_resolution_clock::now ());
+			{
+				rai::transaction transaction (store_a.backend, nullptr, true);
+				for (auto & block : blocks)
+				{
+					store_a.block_put (transaction, block->hash (), *block);
+				}
+			}
+			result[0] = std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::high_resolution_clock::now () - begin).count ();
+			begin = std::chrono::high_resolution_clock::now ();
+			rai::transaction transaction (store_a.backend, nullptr, false);
+			for (auto & block : blocks)
+			{
+				auto existing (store_a.block_get (transaction, block->hash ()));
+				assert (existing != nullptr);
+			}
+			result[1] = std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::high_resolution_clock::now () - begin).count ();
+			begin = std::chrono::high_resolution_clock::now ();
+			size_t count (0);
+			for (rai::store_iterator i (store_a.backend, transaction, store_a.state_blocks), n (nullptr); i != n; ++i)
+			{
+				++count;
+			}
+			assert (count == blocks.size ());
+			result[2] = std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::high_resolution_clock::now () - begin).count ();
+			return result;
+		});
+		std::cerr << boost::str (boost::format ("Starting store backend profiling with %1% blocks\n") % block_count);
+		while (true)
+		{
+			auto error (false);
+			rai::block_store lmdb (error, rai::unique_path ());
+			assert (!error);
+			rai::block_store memory (error, std::unique_ptr<rai::store_backend> (new rai::memory_backend));
+			assert (!error);
+			auto lmdb_l (profile (lmdb));
+			auto memory_l (profile (memory));
+			std::cerr << boost::str (boost::format ("lmdb put: %|1$ 9d|us get: %|2$ 9d|us scan: %|3$ 9d|us memory put: %|4$ 9d|us get: %|5$ 9d|us scan: %|6$ 9d|us\n") % lmdb_l[0] % lmdb_l[1] % lmdb_l[2] % memory_l[0] % memory_l[1] % memory_l[2]);
+		}
+	}
+	else if (vm.count ("debug_profile_lmdb"))
+	{
+		auto source_path (data_path / "data.ldb");
+		auto generated (!boost::filesystem::exists (source_path));
+		if (generated)
+		{
+			source_path = rai::unique_path ();
+			auto error (false);
+			rai::block_store store (error, source_path);
+			assert (!error);
+			rai::transaction transaction (store.backend, nullptr, true);
+			for (size_t i (0); i < 200000; ++i)
+			{
+				rai::keypair key;
+				rai::block_hash hash;
+				rai::random_pool.GenerateBlock (hash.bytes.data (), hash.bytes.size ());
+				store.account_put (transaction, key.pub, rai::account_info (hash, 0, hash, rai::amount (i), 0, 1, hash, key.pub));
+			}
+		}
+		std::vector<rai::account> accounts;
+		{
+			auto error (false);
+			rai::block_store store (error, source_path);
+			assert (!error);
+			rai::transaction transaction (store.backend, nullptr, false);
+			for (auto i (store.latest_begin (transaction)), n (store.latest_end ()); i != n && accounts.size () < 100000; ++i)
+			{
+				accounts.push_back (i->first.uint256 ());
+			}
+		}
+		std::vector<std::pair<std::string, rai::lmdb_config>> presets;
+		presets.push_back (std::make_pair ("default", rai::lmdb_config ()));
+		rai::lmdb_config config;
+		config.read_ahead = false;
+		presets.push_back (std::make_pair ("no_read_ahead", config));
+		config.meta_sync = false;
+		presets.push_back (std::make_pair ("no_meta_sync", config));
+		config.write_map = true;
+		presets.push_back (std::make_pair ("write_map", config));
+		config.sync = false;
+		presets.push_back (std::make_pair ("no_sync", config));
+		std::cerr << boost::str (boost::format ("Starting lmdb profiling on %1% with %2% accounts\n") % (generated ? "a generated ledger" : source_path.string ()) % accounts.size ());
+		while (true)
+		{
+			for (auto & preset : presets)
+			{
+				// Every preset starts from an identical compacted copy so page layout doesn't favour the first one
+				auto path (rai::unique_path ());
+				{
+					auto error (false);
+					rai::mdb_env source (error, source_path);
+					assert (!error);
+					auto status (mdb_env_copy2 (source, path.string ().c_str (), MDB_CP_COMPACT));
+					assert (status == 0);
+				}
+				auto error (false);
+				rai::block_store store (error, path, 128, preset.second);
+				assert (!error);
+				auto begin (std::chrono::high_resolution_clock::now ());
+				{
+					rai::transaction transaction (store.backend, nullptr, false);
+					for (size_t i (0); i < accounts.size (); ++i)
+					{
+						rai::account_info info;
+						store.account_get (transaction, accounts[rai::random_pool.GenerateWord32 (0, accounts.size () - 1)], info);
+					}
+				}
+				auto reads (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::high_resolution_clock::now () - begin).count ());
+				begin = std::chrono::high_resolution_clock::now ();
+				size_t const writes_count (1000);
+				for (size_t i (0); i < writes_count; ++i)
+				{
+					rai::transaction transaction (store.backend, nullptr, true);
+					for (size_t j (0); j < 16; ++j)
+					{
+						rai::block_hash hash;
+						rai::random_pool.GenerateBlock (hash.bytes.data (), hash.bytes.size ());
+						store.block_info_put (transaction, hash, rai::block_info (hash, rai::amount (j)));
+					}
+				}
+				auto writes (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::high_resolution_clock::now () - begin).count ());
+				std::cerr << boost::str (boost::format ("%|1$-14s| reads: %|2$ 10d|us writes: %|3$ 10d|us (%4% transactions)\n") % preset.first % reads % writes % writes_count);
+			}
+		}
+	}
+	else if (vm.count ("debug_profile_pruning"))
+	{
+		size_t const account_count (1000);
+		uint64_t const chain_length (100);
+		uint64_t const depth (10);
+		// Disk is the size of a compacted copy, memory the pages of the tables pruning touches
+		auto measure ([](rai::block_store & store_a) {
+			auto path (rai::unique_path ());
+			auto status (mdb_env_copy2 (store_a.environment, path.string ().c_str (), MDB_CP_COMPACT));
+			assert (status == 0);
+			auto disk (boost::filesystem::file_size (path));
+			boost::filesystem::remove (path);
+			rai::transaction transaction (store_a.backend, nullptr, false);
+			uint64_t memory (0);
+			for (auto table : { store_a.state_blocks, store_a.blocks_info, store_a.heights, store_a.pruned })
+			{
+				MDB_stat stats;
+				store_a.backend.stat (transaction, table, &stats);
+				memory += (stats.ms_branch_pages + stats.ms_leaf_pages + stats.ms_overflow_pages) * stats.ms_psize;
+			}
+			return std::make_pair (disk, memory);
+		});
+		std::cerr << boost::str (boost::format ("Starting pruning profiling with %1% accounts of %2% confirmed state blocks, depth %3%\n") % account_count % chain_length % depth);
+		while (true)
+		{
+			auto error (false);
+			rai::block_store store (error, rai::unique_path ());
+			assert (!error);
+			rai::stat stats;
+			rai::ledger ledger (store, stats);
+			{
+				rai::transaction transaction (store.backend, nullptr, true);
+				for (size_t i (0); i < account_count; ++i)
+				{
+					rai::keypair key;
+					rai::block_hash previous (0);
+					rai::block_hash link;
+					rai::random_pool.GenerateBlock (link.bytes.data (), link.bytes.size ());
+					for (uint64_t height (1); height <= chain_length; ++height)
+					{
+						rai::state_block block (key.pub, previous, key.pub, rai::amount (i), height == 1 ? link : rai::uint256_union (0), rai::chain_token_type, key.prv, key.pub, 0);
+						previous = block.hash ();
+						store.block_put (transaction, previous, block);
+						ledger.change_latest (transaction, key.pub, rai::chain_token_type, previous, previous, rai::amount (i), height, true);
+					}
+					ledger.confirm (transaction, previous);
+				}
+			}
+			auto before (measure (store));
+			uint64_t pruned (0);
+			auto begin (std::chrono::high_resolution_clock::now ());
+			{
+				rai::transaction transaction (store.backend, nullptr, true);
+				for (auto i (store.latest_begin (transaction)), n (store.latest_end ()); i != n; ++i)
+				{
+					pruned += ledger.prune (transaction, i->first.uint256 (), depth);
+				}
+			}
+			auto elapsed (std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::high_resolution_clock::now () - begin).count ());
+			auto after (measure (store));
+			std::cerr << boost::str (boost::format ("Pruned %1% blocks in %2%ms, disk %3% -> %4% bytes, table pages %5% -> %6% bytes\n") % pruned % elapsed % before.first % after.first % before.second % after.second);
+		}
+	}
 	else if (vm.count ("version"))
 	{
 		std::cout << "Version " << RAIBLOCKS_VERSION_MAJOR << "." << RAIBLOCKS_VERSION_MINOR << std::endl;
@@ -0,0 +1,183 @@
+#include <rai/snapshot.hpp>
+
+#include <istream>
+#include <ostream>
+
+uint32_t constexpr rai::ledger_snapshot::format_version;
+size_t constexpr rai::ledger_snapshot::entry_max;
+std::array<char, 8> const rai::ledger_snapshot::magic = { { 'q', 'l', 'c', 'l', 'e', 'd', 'g', 'r' } };
+
+rai::ledger_snapshot::ledger_snapshot (rai::block_store & store_a) :
+store (store_a),
+entries (0)
+{
+}
+
+std::vector<std::pair<uint8_t, MDB_dbi>> rai::ledger_snapshot::tables ()
+{
+	// Ids are part of the format, new tables get new ids
+	return {
+		{ 1, store.frontiers },
+		{ 2, store.accounts },
+		{ 3, store.send_blocks },
+		{ 4, store.receive_blocks },
+		{ 5, store.open_blocks },
+		{ 6, store.change_blocks },
+		{ 7, store.state_blocks },
+		{ 8, store.pending },
+		{ 9, store.blocks_info },
+		{ 10, store.representation },
+		{ 11, store.checksum },
+		{ 12, store.token_accounts },
+		{ 13, store.assets },
+		{ 14, store.smart_contract },
+		{ 15, store.abi },
+		{ 16, store.delegators },
+		{ 17, store.heights },
+		{ 18, store.confirmed },
+		{ 19, store.pruned }
+	};
+}
+
+bool rai::ledger_snapshot::write (MDB_txn * transaction_a, std::ostream & stream_a)
+{
+	blake2b_state hash;
+	blake2b_init (&hash, sizeof (rai::uint256_union));
+	auto put ([&stream_a, &hash](void const * data_a, size_t size_a) {
+		stream_a.write (reinterpret_cast<char const *> (data_a), size_a);
+		blake2b_update (&hash, reinterpret_cast<uint8_t const *> (data_a), size_a);
+	});
+	put (magic.data (), magic.size ());
+	uint32_t format_version_l (format_version);
+	put (&format_version_l, sizeof (format_version_l));
+	int32_t store_version (store.version_get (transaction_a));
+	put (&store_version, sizeof (store_version));
+	entries = 0;
+	for (auto & table : tables ())
+	{
+		MDB_stat stats;
+		auto status (store.backend.stat (transaction_a, table.second, &stats));
+		assert (status == 0);
+		uint64_t count (stats.ms_entries);
+		put (&table.first, sizeof (table.first));
+		put (&count, sizeof (count));
+		for (rai::store_iterator i (store.backend, transaction_a, table.second), n (nullptr); i != n && !stream_a.fail (); ++i)
+		{
+			uint32_t key_size (i->first.size ());
+			put (&key_size, sizeof (key_size));
+			put (i->first.data (), key_size);
+			uint32_t value_size (i->second.size ());
+			put (&value_size, sizeof (value_size));
+			put (i->second.data (), value_size);
+			++entries;
+		}
+	}
+	uint8_t end (0);
+	put (&end, sizeof (end));
+	rai::uint256_union digest;
+	blake2b_final (&hash, digest.bytes.data (), digest.bytes.size ());
+	stream_a.write (reinterpret_cast<char const *> (digest.bytes.data ()), digest.bytes.size ());
+	stream_a.flush ();
+	return stream_a.fail ();
+}
+
+bool rai::ledger_snapshot::read (std::istream & stream_a)
+{
+	blake2b_state hash;
+	blake2b_init (&hash, sizeof (rai::uint256_union));
+	auto get ([&stream_a, &hash](void * data_a, size_t size_a) {
+		stream_a.read (reinterpret_cast<char *> (data_a), size_a);
+		auto result (static_cast<size_t> (stream_a.gcount ()) != size_a);
+		if (!result)
+		{
+			blake2b_update (&hash, reinterpret_cast<uint8_t const *> (data_a), size_a);
+		}
+		return result;
+	});
+	auto tables_l (tables ());
+	entries = 0;
+	rai::transaction transaction (store.backend, nullptr, true);
+	auto error (store.latest_begin (transaction) != store.latest_end ());
+	std::array<char, 8> magic_l;
+	error = error || get (magic_l.data (), magic_l.size ()) || magic_l != magic;
+	uint32_t format_version_l;
+	error = error || get (&format_version_l, sizeof (format_version_l)) || format_version_l != format_version;
+	int32_t store_version;
+	error = error || get (&store_version, sizeof (store_version)) || store_version != store.version_get (transaction);
+	auto loading (!error);
+	if (loading)
+	{
+		// Fresh stores seed some tables, e.g. the checksum, appends need them empty
+		for (auto & table : tables_l)
+		{
+			store.backend.drop (transaction, table.second, 0);
+		}
+	}
+	uint8_t id (0);
+	error = error || get (&id, sizeof (id));
+	auto table (tables_l.begin ());
+	std::vector<uint8_t> key;
+	std::vector<uint8_t> value;
+	while (!error && id != 0)
+	{
+		// Tables arrive in the order they were written, which also rejects repeats
+		while (table != tables_l.end () && table->first != id)
+		{
+			++table;
+		}
+		error = table == tables_l.end ();
+		uint64_t count (0);
+		error = error || get (&count, sizeof (count));
+		for (uint64_t i (0); !error && i < count; ++i)
+		{
+			uint32_t key_size;
+			error = get (&key_size, sizeof (key_size)) || key_size == 0 || key_size > entry_max;
+			if (!error)
+			{
+				key.resize (key_size);
+				error = get (key.data (), key.size ());
+			}
+			uint32_t value_size;
+			error = error || get (&value_size, sizeof (value_size)) || value_size > entry_max;
+			if (!error)
+			{
+				value.resize (value_size);
+				error = get (value.data (), value.size ());
+			}
+			if (!error)
+			{
+				// Keys were written in key order so every insert lands at the end of the table, out of order input fails with MDB_KEYEXIST
+				auto status (store.backend.put (transaction, table->second, rai::mdb_val (key.size (), key.data ()), rai::mdb_val (value.size (), value.data ()), MDB_APPEND));
+				error = status != 0;
+				++entries;
+			}
+		}
+		if (!error)
+		{
+			++table;
+			error = get (&id, sizeof (id));
+		}
+	}
+	if (!error)
+	{
+		rai::uint256_union digest;
+		blake2b_final (&hash, digest.bytes.data (), digest.bytes.size ());
+		rai::uint256_union expected;
+		stream_a.read (reinterpret_cast<char *> (expected.bytes.data ()), expected.bytes.size ());
+		error = static_cast<size_t> (stream_a.gcount ()) != expected.bytes.size () || digest != expected;
+	}
+	if (error && loading)
+	{
+		// Never leave a partially loaded ledger behind
+		for (auto & i : tables_l)
+		{
+			store.backend.drop (transaction, i.second, 0);
+		}
+		store.checksum_put (transaction, 0, 0, 0);
+	}
+	if (error)
+	{
+		entries = 0;
+	}
+	return error;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <rai/blockstore.hpp>
+
+#include <array>
+#include <iosfwd>
+
+namespace rai
+{
+/**
+ * Copies the ledger tables of a block_store to and from a stream so new nodes can be provisioned without bootstrapping.
+ * Layout: magic, format version, store version, then for each table its id, entry count and length prefixed key/value
+ * pairs in key order, a zero table id and a blake2b digest of everything before the digest.
+ * Wallets, votes, unchecked blocks and the optional history index are not part of a snapshot.
+ */
+class ledger_snapshot
+{
+public:
+	ledger_snapshot (rai::block_store &);
+	// Streams every ledger table as seen by the read transaction, true if the stream failed
+	bool write (MDB_txn *, std::ostream &);
+	// Loads a snapshot in to a store without accounts using in order MDB_APPEND inserts, true on error and the ledger is left empty
+	bool read (std::istream &);
+	std::vector<std::pair<uint8_t, MDB_dbi>> tables ();
+	rai::block_store & store;
+	// Entries copied by the last write or read
+	uint64_t entries;
+	static uint32_t constexpr format_version = 1;
+	static size_t constexpr entry_max = 16 * 1024 * 1024;
+	static std::array<char, 8> const magic;
+};
+}
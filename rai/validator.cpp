@@ -0,0 +1,339 @@
+#include <rai/validator.hpp>
+
+#include <rai/blockstore.hpp>
+
+#include <thread>
+#include <unordered_map>
+
+size_t constexpr rai::ledger_validator::errors_max;
+
+namespace
+{
+class validator_range
+{
+public:
+	validator_range (rai::ledger & ledger_a, rai::uint256_t const & lower_a, rai::uint256_t const & upper_a, bool last_a) :
+	ledger (ledger_a),
+	store (ledger_a.store),
+	lower (lower_a),
+	upper (upper_a),
+	last (last_a),
+	accounts (0),
+	blocks (0),
+	pending (0),
+	errors_total (0)
+	{
+	}
+	bool in_range (rai::uint256_union const & key_a)
+	{
+		return last || key_a.number () < upper;
+	}
+	void error (std::string const & message_a)
+	{
+		if (errors.size () < rai::ledger_validator::errors_max)
+		{
+			errors.push_back (message_a);
+		}
+		++errors_total;
+	}
+	void run ()
+	{
+		rai::transaction transaction (store.backend, nullptr, false);
+		for (auto i (store.latest_begin (transaction, rai::uint256_union (lower))), n (store.latest_end ()); i != n && in_range (i->first.uint256 ()); ++i)
+		{
+			token_account (transaction, i->first.uint256 (), rai::account_info (i->second));
+		}
+		for (rai::store_iterator i (store.backend, transaction, store.accounts, rai::mdb_val (rai::uint256_union (lower))), n (nullptr); i != n && in_range (i->first.uint256 ()); ++i)
+		{
+			account (transaction, i->first.uint256 (), i->second);
+		}
+		for (rai::store_iterator i (store.backend, transaction, store.frontiers, rai::mdb_val (rai::uint256_union (lower))), n (nullptr); i != n && in_range (i->first.uint256 ()); ++i)
+		{
+			frontier (transaction, i->first.uint256 ());
+		}
+		for (auto i (store.block_info_begin (transaction, rai::uint256_union (lower))), n (store.block_info_end ()); i != n && in_range (i->first.uint256 ()); ++i)
+		{
+			block_info (transaction, i->first.uint256 (), rai::block_info (i->second));
+		}
+		for (auto i (store.pending_begin (transaction, rai::pending_key (rai::uint256_union (lower), 0))), n (store.pending_end ()); i != n; ++i)
+		{
+			rai::pending_key key (i->first);
+			if (!in_range (key.account))
+			{
+				break;
+			}
+			pending_entry (transaction, key, rai::pending_info (i->second));
+		}
+	}
+	void token_account (MDB_txn * transaction_a, rai::account const & token_account_a, rai::account_info const & info_a)
+	{
+		++accounts;
+		auto name (token_account_a.to_string ());
+		if (info_a.open_block != token_account_a)
+		{
+			error (boost::str (boost::format ("Token account %1% has open block %2%") % name % info_a.open_block.to_string ()));
+		}
+		// Head down to the open block or the pruned part of the chain, every block at the height it's indexed at
+		auto height (info_a.block_count);
+		auto hash (info_a.head);
+		auto done (false);
+		while (!done)
+		{
+			auto view (store.block_view_get (transaction_a, hash));
+			if (!view.exists ())
+			{
+				error (boost::str (boost::format ("Token account %1% is missing block %2% at height %3%") % name % hash.to_string () % height));
+				done = true;
+			}
+			else
+			{
+				++blocks;
+				rai::history_key key (0, 0);
+				if (store.block_height_get (transaction_a, hash, key) || key.account != token_account_a || key.height () != height)
+				{
+					error (boost::str (boost::format ("Block %1% of token account %2% isn't indexed at height %3%") % hash.to_string () % name % height));
+				}
+				hash = view.previous ();
+				--height;
+				if (hash.is_zero ())
+				{
+					if (view.hash != token_account_a || height != 0)
+					{
+						error (boost::str (boost::format ("Token account %1% chain ends at %2% with %3% blocks unaccounted for") % name % view.hash.to_string () % height));
+					}
+					done = true;
+				}
+				else if (height == 0)
+				{
+					error (boost::str (boost::format ("Token account %1% has more than %2% blocks") % name % info_a.block_count));
+					done = true;
+				}
+				else if (store.pruned_exists (transaction_a, hash))
+				{
+					// The newest pruned block keeps the balance the rest of the chain counts from
+					rai::block_info anchor;
+					if (store.block_info_get (transaction_a, hash, anchor) || anchor.account != info_a.account)
+					{
+						error (boost::str (boost::format ("Token account %1% is pruned below height %2% without a balance anchor") % name % (height + 1)));
+					}
+					done = true;
+				}
+			}
+		}
+		auto head (store.block_view_get (transaction_a, info_a.head));
+		if (head.exists ())
+		{
+			auto balance (ledger.balance (transaction_a, info_a.head));
+			if (balance != info_a.balance.number ())
+			{
+				error (boost::str (boost::format ("Token account %1% balance %2% doesn't match head balance %3%") % name % info_a.balance.to_string_dec () % rai::amount (balance).to_string_dec ()));
+			}
+			if (head.type != rai::block_type::state && store.frontier_get (transaction_a, info_a.head).is_zero ())
+			{
+				error (boost::str (boost::format ("Token account %1% head %2% has no frontier") % name % info_a.head.to_string ()));
+			}
+		}
+		auto confirmed (store.confirmed_height_get (transaction_a, token_account_a));
+		if (confirmed > info_a.block_count)
+		{
+			error (boost::str (boost::format ("Token account %1% confirmed height %2% is above its block count %3%") % name % confirmed % info_a.block_count));
+		}
+		std::vector<rai::account_info> infos;
+		auto listed (false);
+		if (!store.accounts_get (transaction_a, info_a.account, infos))
+		{
+			for (auto & i : infos)
+			{
+				listed = listed || i.open_block == token_account_a;
+			}
+		}
+		if (!listed)
+		{
+			error (boost::str (boost::format ("Token account %1% isn't listed under account %2%") % name % info_a.account.to_account ()));
+		}
+		supply[info_a.token_type] += info_a.balance.number ();
+		// Only chain token state blocks carry weight, see block_store::representation_add
+		auto rep (store.block_view_get (transaction_a, info_a.rep_block));
+		if (!rep.exists ())
+		{
+			error (boost::str (boost::format ("Token account %1% is missing representative block %2%") % name % info_a.rep_block.to_string ()));
+		}
+		else if (rep.type == rai::block_type::state && rep.token_hash () == rai::chain_token_type)
+		{
+			weights[rep.representative ()] += info_a.balance.number ();
+		}
+	}
+	void account (MDB_txn * transaction_a, rai::account const & account_a, rai::mdb_val const & value_a)
+	{
+		// Packed open block hashes of the account's token accounts
+		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value_a.data ()), value_a.size ());
+		rai::block_hash token_account;
+		while (!rai::read (stream, token_account))
+		{
+			rai::account_info info;
+			if (store.account_get (transaction_a, token_account, info))
+			{
+				error (boost::str (boost::format ("Account %1% lists missing token account %2%") % account_a.to_account () % token_account.to_string ()));
+			}
+			else if (info.account != account_a)
+			{
+				error (boost::str (boost::format ("Account %1% lists token account %2% of %3%") % account_a.to_account () % token_account.to_string () % info.account.to_account ()));
+			}
+		}
+	}
+	void frontier (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+	{
+		rai::history_key key (0, 0);
+		rai::account_info info;
+		if (store.block_height_get (transaction_a, hash_a, key) || store.account_get (transaction_a, key.account, info) || info.head != hash_a)
+		{
+			error (boost::str (boost::format ("Frontier %1% isn't the head of an account") % hash_a.to_string ()));
+		}
+	}
+	void block_info (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_info const & info_a)
+	{
+		auto exists (store.block_exists (transaction_a, hash_a));
+		if (!exists && !store.pruned_exists (transaction_a, hash_a))
+		{
+			error (boost::str (boost::format ("Block info %1% has no block") % hash_a.to_string ()));
+		}
+		// A pruned anchor is the balance itself, it's checked from the chain it ends
+		else if (exists && ledger.balance (transaction_a, hash_a) != info_a.balance.number ())
+		{
+			error (boost::str (boost::format ("Block info %1% balance %2% doesn't match the block") % hash_a.to_string () % info_a.balance.to_string_dec ()));
+		}
+	}
+	void pending_entry (MDB_txn * transaction_a, rai::pending_key const & key_a, rai::pending_info const & info_a)
+	{
+		++pending;
+		supply[info_a.token_type] += info_a.amount.number ();
+		auto view (store.block_view_get (transaction_a, key_a.hash));
+		if (!view.exists ())
+		{
+			if (!store.pruned_exists (transaction_a, key_a.hash))
+			{
+				error (boost::str (boost::format ("Pending %1% has no send block") % key_a.hash.to_string ()));
+			}
+		}
+		else if (view.type == rai::block_type::state && view.token_hash () != info_a.token_type)
+		{
+			error (boost::str (boost::format ("Pending %1% token %2% doesn't match the send") % key_a.hash.to_string () % info_a.token_type.to_string ()));
+		}
+		else if (!store.pruned_exists (transaction_a, view.previous ()) && ledger.amount (transaction_a, key_a.hash) != info_a.amount.number ())
+		{
+			// Once the previous block is pruned the amount can't be worked out
+			error (boost::str (boost::format ("Pending %1% amount %2% doesn't match the send") % key_a.hash.to_string () % info_a.amount.to_string_dec ()));
+		}
+	}
+	rai::ledger & ledger;
+	rai::block_store & store;
+	rai::uint256_t lower;
+	rai::uint256_t upper;
+	bool last;
+	uint64_t accounts;
+	uint64_t blocks;
+	uint64_t pending;
+	std::vector<std::string> errors;
+	uint64_t errors_total;
+	std::unordered_map<rai::account, rai::uint128_t> weights;
+	// Head balances plus pending amounts for each token
+	std::unordered_map<rai::block_hash, rai::uint128_t> supply;
+};
+}
+
+rai::ledger_validator::ledger_validator (rai::ledger & ledger_a) :
+ledger (ledger_a),
+accounts (0),
+blocks (0),
+pending (0),
+errors_total (0)
+{
+}
+
+bool rai::ledger_validator::validate (unsigned threads_a)
+{
+	auto count (std::max (1u, threads_a));
+	rai::uint256_t step (std::numeric_limits<rai::uint256_t>::max () / count);
+	std::vector<std::unique_ptr<validator_range>> ranges;
+	for (unsigned i (0); i < count; ++i)
+	{
+		ranges.push_back (std::unique_ptr<validator_range> (new validator_range (ledger, step * i, step * (i + 1), i + 1 == count)));
+	}
+	std::vector<std::thread> threads;
+	for (auto & i : ranges)
+	{
+		auto range (i.get ());
+		threads.push_back (std::thread ([range]() {
+			range->run ();
+		}));
+	}
+	for (auto & i : threads)
+	{
+		i.join ();
+	}
+	errors.clear ();
+	accounts = 0;
+	blocks = 0;
+	pending = 0;
+	errors_total = 0;
+	std::unordered_map<rai::account, rai::uint128_t> weights;
+	std::unordered_map<rai::block_hash, rai::uint128_t> supply;
+	for (auto & i : ranges)
+	{
+		errors.insert (errors.end (), i->errors.begin (), i->errors.end ());
+		errors_total += i->errors_total;
+		accounts += i->accounts;
+		blocks += i->blocks;
+		pending += i->pending;
+		for (auto & j : i->weights)
+		{
+			weights[j.first] += j.second;
+		}
+		for (auto & j : i->supply)
+		{
+			supply[j.first] += j.second;
+		}
+	}
+	auto error ([this](std::string const & message_a) {
+		errors.push_back (message_a);
+		++errors_total;
+	});
+	rai::transaction transaction (ledger.store.backend, nullptr, false);
+	for (auto i (ledger.store.representation_begin (transaction)), n (ledger.store.representation_end ()); i != n; ++i)
+	{
+		rai::account representative (i->first.uint256 ());
+		auto stored (ledger.store.representation_get (transaction, representative));
+		auto existing (weights.find (representative));
+		auto calculated (existing != weights.end () ? existing->second : rai::uint128_t (0));
+		if (stored != calculated)
+		{
+			error (boost::str (boost::format ("Representative %1% weight %2% doesn't match calculated %3%") % representative.to_account () % rai::amount (stored).to_string_dec () % rai::amount (calculated).to_string_dec ()));
+		}
+		if (existing != weights.end ())
+		{
+			weights.erase (existing);
+		}
+	}
+	for (auto & i : weights)
+	{
+		if (i.second != 0)
+		{
+			error (boost::str (boost::format ("Representative %1% has no weight entry, calculated %2%") % i.first.to_account () % rai::amount (i.second).to_string_dec ()));
+		}
+	}
+	// Every token's supply is issued by its genesis block and only moves between balances and pending entries
+	for (auto & i : rai::map_genesis_blocks)
+	{
+		rai::genesis genesis (i.second.front ());
+		if (ledger.block_or_pruned_exists (transaction, genesis.hash ()))
+		{
+			auto token (genesis.state->hashables.token_hash);
+			auto total (supply[token]);
+			if (total != genesis.state->hashables.balance.number ())
+			{
+				error (boost::str (boost::format ("Token %1% balances and pending add up to %2%, issued %3%") % token.to_string () % rai::amount (total).to_string_dec () % genesis.state->hashables.balance.to_string_dec ()));
+			}
+		}
+	}
+	return errors_total != 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <rai/ledger.hpp>
+
+#include <string>
+#include <vector>
+
+namespace rai
+{
+/**
+ * Cross checks the ledger tables against each other, e.g. after a crash or an upgrade.
+ * The key space is split in to one range per thread and each thread walks its range of token_accounts, accounts,
+ * frontiers, blocks_info and pending in a read transaction of its own. Representative weights and token supplies
+ * span ranges so they're summed per range and compared once every range is done.
+ * Each thread reads its own snapshot, run it against a ledger nothing is writing to.
+ */
+class ledger_validator
+{
+public:
+	ledger_validator (rai::ledger &);
+	// True if any mismatch was found, mismatches are in errors
+	bool validate (unsigned);
+	rai::ledger & ledger;
+	std::vector<std::string> errors;
+	uint64_t accounts;
+	uint64_t blocks;
+	uint64_t pending;
+	// Each range stops recording mismatches after this many, counting carries on
+	static size_t constexpr errors_max = 1000;
+	uint64_t errors_total;
+};
+}